@@ -0,0 +1,234 @@
+// Copyright (c)       2014 Martin Stumpf
+//
+// Distributed under the Boost Software License, Version 1.0. (See accompanying
+// file LICENSE_1_0.txt or copy at http://www.boost.org/LICENSE_1_0.txt)
+
+#include <hpx/hpx.hpp>
+#include <hpx/hpx_init.hpp>
+#include <hpx/include/iostreams.hpp>
+#include <hpx/include/parallel_algorithm.hpp>
+#include <hpx/util/high_resolution_timer.hpp>
+
+#include "../../../opencl.hpp"
+
+#include <boost/bind.hpp>
+
+#include <algorithm>
+#include <cstdlib>
+#include <functional>
+#include <string>
+#include <vector>
+
+/*
+ * Compares the device side algorithms with the hpx::parallel
+ * algorithms on the host.
+ *
+ * On a CPU device (e.g. POCL) both run on the same cores, which
+ * compares the algorithms themselves.
+ */
+
+using hpx::opencl::device;
+using hpx::opencl::buffer;
+using hpx::opencl::event;
+
+// runs one algorithm, prints the average time
+template <typename Algorithm>
+static void run_benchmark(std::string name, Algorithm algorithm,
+                          size_t num_iterations)
+{
+
+    // the first run builds the kernels
+    algorithm();
+
+    hpx::util::high_resolution_timer timer;
+    for(size_t i = 0; i < num_iterations; i++)
+    {
+        algorithm();
+    }
+    double time = timer.elapsed() / num_iterations;
+
+    hpx::cout << name << ": " << time * 1000.0 << " ms" << hpx::endl;
+
+}
+
+///////////////////////////////////////////////////
+// host
+//
+
+static void host_reduce(std::vector<cl_int> const& data)
+{
+    hpx::parallel::reduce(hpx::parallel::par, data.begin(), data.end(),
+                          cl_int(0), std::plus<cl_int>());
+}
+
+static void host_scan(std::vector<cl_int> const& data,
+                      std::vector<cl_int> & result)
+{
+    hpx::parallel::inclusive_scan(hpx::parallel::par, data.begin(), data.end(),
+                                  result.begin(), cl_int(0),
+                                  std::plus<cl_int>());
+}
+
+// hpx::parallel has no sort yet
+static void host_sort(std::vector<cl_int> const& data,
+                      std::vector<cl_int> & result)
+{
+    std::copy(data.begin(), data.end(), result.begin());
+    std::sort(result.begin(), result.end());
+}
+
+static cl_int host_transform_op(cl_int x)
+{
+    return 3 * x + 1;
+}
+
+static void host_transform(std::vector<cl_int> const& data,
+                           std::vector<cl_int> & result)
+{
+    hpx::parallel::transform(hpx::parallel::par, data.begin(), data.end(),
+                             result.begin(), &host_transform_op);
+}
+
+///////////////////////////////////////////////////
+// device
+//
+
+static void device_reduce(device cldevice, buffer input, size_t size)
+{
+    hpx::opencl::reduce<cl_int>(cldevice, input, 0, size).get();
+}
+
+static void device_scan(device cldevice, buffer input, buffer output,
+                        size_t size)
+{
+    hpx::opencl::inclusive_scan<cl_int>(cldevice, input, 0, size,
+                                        output, 0).get().await();
+}
+
+static void device_sort(device cldevice, buffer input, buffer output,
+                        size_t size)
+{
+    event copied = output.enqueue_copy(input, 0, 0, size * sizeof(cl_int))
+                                                                        .get();
+    std::vector<hpx::lcos::shared_future<event>> dependencies;
+    dependencies.push_back(hpx::lcos::make_ready_future(copied));
+    hpx::opencl::radix_sort<cl_int>(cldevice, output, 0, size,
+                                    dependencies).get().await();
+}
+
+static void device_transform(device cldevice, buffer input, buffer output,
+                             size_t size)
+{
+    hpx::opencl::transform<cl_int, cl_int>(cldevice, input, 0, size,
+                                           output, 0, "3 * x + 1")
+                                                            .get().await();
+}
+
+// returns the CPU devices, or the GPU devices, or any devices
+static std::vector<device> find_devices(bool use_gpu)
+{
+
+    std::vector<device> devices = hpx::opencl::get_devices(hpx::find_here(),
+                        use_gpu ? CL_DEVICE_TYPE_GPU : CL_DEVICE_TYPE_CPU,
+                        "OpenCL 1.1").get();
+    if(devices.empty())
+        devices = hpx::opencl::get_devices(hpx::find_here(),
+                                CL_DEVICE_TYPE_ALL, "OpenCL 1.1").get();
+
+    return devices;
+
+}
+
+int hpx_main(boost::program_options::variables_map & vm)
+{
+
+    size_t size = vm["size"].as<std::size_t>();
+    size_t num_iterations = vm["iterations"].as<std::size_t>();
+
+    std::vector<device> devices = find_devices(vm.count("gpu") > 0);
+    if(devices.empty())
+    {
+        hpx::cerr << "No OpenCL device found." << hpx::endl;
+        return hpx::finalize();
+    }
+    device cldevice = devices[0];
+
+    hpx::cout << "Device:   "
+              << device::device_info_to_string(
+                                cldevice.get_device_info(CL_DEVICE_NAME))
+              << hpx::endl;
+    hpx::cout << "Elements: " << size
+              << ", threads: " << hpx::get_os_thread_count() << hpx::endl;
+
+    // random integers
+    std::vector<cl_int> data(size);
+    for(size_t i = 0; i < size; i++)
+    {
+        data[i] = (cl_int)(std::rand() - RAND_MAX / 2);
+    }
+    std::vector<cl_int> result(size);
+
+    buffer input = cldevice.create_buffer(CL_MEM_READ_WRITE,
+                                          size * sizeof(cl_int));
+    buffer output = cldevice.create_buffer(CL_MEM_READ_WRITE,
+                                           size * sizeof(cl_int));
+    input.enqueue_write(0, size * sizeof(cl_int), data.data()).get().await();
+
+    run_benchmark("reduce    host  ",
+                  boost::bind(&host_reduce, boost::cref(data)),
+                  num_iterations);
+    run_benchmark("reduce    device",
+                  boost::bind(&device_reduce, cldevice, input, size),
+                  num_iterations);
+
+    run_benchmark("scan      host  ",
+                  boost::bind(&host_scan, boost::cref(data),
+                              boost::ref(result)),
+                  num_iterations);
+    run_benchmark("scan      device",
+                  boost::bind(&device_scan, cldevice, input, output, size),
+                  num_iterations);
+
+    run_benchmark("sort      host  ",
+                  boost::bind(&host_sort, boost::cref(data),
+                              boost::ref(result)),
+                  num_iterations);
+    run_benchmark("sort      device",
+                  boost::bind(&device_sort, cldevice, input, output, size),
+                  num_iterations);
+
+    run_benchmark("transform host  ",
+                  boost::bind(&host_transform, boost::cref(data),
+                              boost::ref(result)),
+                  num_iterations);
+    run_benchmark("transform device",
+                  boost::bind(&device_transform, cldevice, input, output,
+                              size),
+                  num_iterations);
+
+    return hpx::finalize();
+
+}
+
+//////////////////////////////////////////////////////////////////////////////
+int main(int argc, char* argv[])
+{
+    // Configure application-specific options
+    boost::program_options::options_description cmdline(
+                                "Usage: " HPX_APPLICATION_STRING " [options]");
+    cmdline.add_options()
+        ( "size"
+        , boost::program_options::value<std::size_t>()->default_value(1 << 22)
+        , "the number of elements") ;
+
+    cmdline.add_options()
+        ( "iterations"
+        , boost::program_options::value<std::size_t>()->default_value(10)
+        , "the number of runs per measurement") ;
+
+    cmdline.add_options()
+        ( "gpu"
+        , "run on a GPU instead of a CPU device") ;
+
+    return hpx::init(cmdline, argc, argv);
+}
@@ -0,0 +1,171 @@
+// Copyright (c)       2014 Martin Stumpf
+//
+// Distributed under the Boost Software License, Version 1.0. (See accompanying
+// file LICENSE_1_0.txt or copy at http://www.boost.org/LICENSE_1_0.txt)
+
+#ifndef BENCHMARK_HPXCL_FUSED_HPP_
+#define BENCHMARK_HPXCL_FUSED_HPP_
+
+#include "../../../opencl.hpp"
+#include "timer.hpp"
+
+using namespace hpx::opencl;
+using hpx::lcos::shared_future;
+
+static device   hpxcl_fused_device;
+static buffer   hpxcl_fused_buffer_a;
+static buffer   hpxcl_fused_buffer_b;
+static buffer   hpxcl_fused_buffer_c;
+static buffer   hpxcl_fused_buffer_z;
+
+// The whole calculation as one expression: log((exp(b) + a) * (2 * c))
+static shared_future<event>
+hpxcl_fused_enqueue(size_t size, std::vector<shared_future<event>> dependencies)
+{
+
+    expression::terminal<float> a = lazy<float>(hpxcl_fused_buffer_a);
+    expression::terminal<float> b = lazy<float>(hpxcl_fused_buffer_b);
+    expression::terminal<float> c = lazy<float>(hpxcl_fused_buffer_c);
+
+    return evaluate(hpxcl_fused_device, hpxcl_fused_buffer_z, size,
+                    log((exp(b) + a) * (2.0f * c)),
+                    dependencies);
+
+}
+
+static void hpxcl_fused_initialize( hpx::naming::id_type node_id, 
+                                    size_t vector_size)
+{
+
+    // Query all devices on local node
+    std::vector<device> devices = get_devices( node_id, 
+                                               CL_DEVICE_TYPE_GPU,
+                                               "OpenCL 1.1" ).get();
+
+    size_t device_id = 0;
+    // print device
+    hpx::cout << "Device:" << hpx::endl;
+    {
+        
+        device cldevice = devices[device_id];
+
+        // Query name
+        std::string device_name = device::device_info_to_string(
+                                    cldevice.get_device_info(CL_DEVICE_NAME));
+        std::string device_vendor = device::device_info_to_string(
+                                    cldevice.get_device_info(CL_DEVICE_VENDOR));
+
+        hpx::cout << "    " << device_name << " (" << device_vendor << ")"
+                  << hpx::endl;
+
+    }
+
+    // Select a device
+    hpxcl_fused_device = devices[device_id];
+
+    // Generate buffers, no intermediate buffers needed
+    hpxcl_fused_buffer_a = hpxcl_fused_device.create_buffer(
+                                    CL_MEM_READ_ONLY,
+                                    vector_size * sizeof(float));
+    hpxcl_fused_buffer_b = hpxcl_fused_device.create_buffer(
+                                    CL_MEM_READ_ONLY,
+                                    vector_size * sizeof(float));
+    hpxcl_fused_buffer_c = hpxcl_fused_device.create_buffer(
+                                    CL_MEM_READ_ONLY,
+                                    vector_size * sizeof(float));
+    hpxcl_fused_buffer_z = hpxcl_fused_device.create_buffer(
+                                    CL_MEM_WRITE_ONLY,
+                                    vector_size * sizeof(float));
+
+    // Run once to build the generated kernel outside of the measurement
+    hpxcl_fused_enqueue(vector_size, std::vector<shared_future<event>>())
+                                                                .get().await();
+
+}
+
+static boost::shared_ptr<std::vector<char>>
+hpxcl_fused_calculate(std::vector<float> &a,
+                      std::vector<float> &b,
+                      std::vector<float> &c,
+                      double* t_nonblock,
+                      double* t_sync,
+                      double* t_finish)
+{
+    // do nothing if matrices are wrong
+    if(a.size() != b.size() || b.size() != c.size())
+    {
+        return boost::shared_ptr<std::vector<char>>();
+    }
+
+    size_t size = a.size();
+
+    // copy data to gpu
+    std::vector<shared_future<event>> write_events;
+    write_events.push_back(
+           hpxcl_fused_buffer_a.enqueue_write(0, size*sizeof(float), a.data()));
+    write_events.push_back(
+           hpxcl_fused_buffer_b.enqueue_write(0, size*sizeof(float), b.data()));
+    write_events.push_back(
+           hpxcl_fused_buffer_c.enqueue_write(0, size*sizeof(float), c.data()));
+
+    // wait for write to finish
+    BOOST_FOREACH(shared_future<event> & write_event, write_events)
+    {
+        write_event.get().await();
+    }
+
+    // start time measurement
+    timer_start();
+
+    // run the fused kernel
+    shared_future<event> kernel_event_future =
+                                    hpxcl_fused_enqueue(size, write_events);
+
+    ////////// UNTIL HERE ALL CALLS WERE NON-BLOCKING /////////////////////////
+
+    // get time of non-blocking calls
+    *t_nonblock = timer_stop();
+
+    // wait for all nonblocking calls to finish
+    event kernel_event = kernel_event_future.get();
+
+    // get time of synchronization
+    *t_sync = timer_stop();
+
+    // wait for the end of the execution
+    kernel_event.await();
+
+    // get total time of execution
+    *t_finish = timer_stop();
+ 
+    // enqueue result read
+    shared_future<event> read_event_future = 
+                       hpxcl_fused_buffer_z.enqueue_read(0, size*sizeof(float),
+                                                         kernel_event);
+
+    // wait for enqueue_read to return the event
+    event read_event = read_event_future.get();
+
+    // wait for calculation to complete and return data
+    boost::shared_ptr<std::vector<char>> data_ptr = read_event.get_data().get();
+   
+    // return the computed data
+    return data_ptr;
+
+}
+
+static void hpxcl_fused_shutdown()
+{
+
+    // release buffers
+    hpxcl_fused_buffer_a = buffer();
+    hpxcl_fused_buffer_b = buffer();
+    hpxcl_fused_buffer_c = buffer();
+    hpxcl_fused_buffer_z = buffer();
+
+    // delete device
+    hpxcl_fused_device = device();
+
+}
+
+#endif //BENCHMARK_HPXCL_FUSED_HPP_
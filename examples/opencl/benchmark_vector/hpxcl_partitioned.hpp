@@ -0,0 +1,189 @@
+// Copyright (c)       2014 Martin Stumpf
+//
+// Distributed under the Boost Software License, Version 1.0. (See accompanying
+// file LICENSE_1_0.txt or copy at http://www.boost.org/LICENSE_1_0.txt)
+
+#ifndef BENCHMARK_HPXCL_PARTITIONED_HPP_
+#define BENCHMARK_HPXCL_PARTITIONED_HPP_
+
+#include "../../../opencl.hpp"
+#include "timer.hpp"
+
+using namespace hpx::opencl;
+using hpx::lcos::shared_future;
+
+static partitioned_buffer<float>   hpxcl_partitioned_buffer_a;
+static partitioned_buffer<float>   hpxcl_partitioned_buffer_b;
+static partitioned_buffer<float>   hpxcl_partitioned_buffer_c;
+static partitioned_buffer<float>   hpxcl_partitioned_buffer_z;
+
+// The write events of the inputs, one per segment
+static std::vector<event>   hpxcl_partitioned_events_a;
+static std::vector<event>   hpxcl_partitioned_events_b;
+static std::vector<event>   hpxcl_partitioned_events_c;
+
+// Runs the fused calculation on one segment
+static hpx::lcos::future<event>
+hpxcl_partitioned_enqueue_segment(size_t i, std::vector<event>)
+{
+
+    typedef partitioned_buffer<float>::segment segment;
+    segment const& seg_a = hpxcl_partitioned_buffer_a.get_segment(i);
+    segment const& seg_b = hpxcl_partitioned_buffer_b.get_segment(i);
+    segment const& seg_c = hpxcl_partitioned_buffer_c.get_segment(i);
+    segment const& seg_z = hpxcl_partitioned_buffer_z.get_segment(i);
+
+    std::vector<shared_future<event>> dependencies;
+    if(!hpxcl_partitioned_events_a.empty())
+    {
+        dependencies.push_back(
+                hpx::lcos::make_ready_future(hpxcl_partitioned_events_a[i]));
+        dependencies.push_back(
+                hpx::lcos::make_ready_future(hpxcl_partitioned_events_b[i]));
+        dependencies.push_back(
+                hpx::lcos::make_ready_future(hpxcl_partitioned_events_c[i]));
+    }
+
+    expression::terminal<float> a = lazy<float>(seg_a.buffer);
+    expression::terminal<float> b = lazy<float>(seg_b.buffer);
+    expression::terminal<float> c = lazy<float>(seg_c.buffer);
+
+    return evaluate(seg_z.device, seg_z.buffer, seg_z.count,
+                    log((exp(b) + a) * (2.0f * c)),
+                    dependencies);
+
+}
+
+static void hpxcl_partitioned_initialize(size_t vector_size)
+{
+
+    // Query all devices of all localities
+    std::vector<device> devices = get_all_devices( CL_DEVICE_TYPE_GPU,
+                                                   "OpenCL 1.1" ).get();
+
+    // print devices
+    hpx::cout << "Devices:" << hpx::endl;
+    for(size_t i = 0; i < devices.size(); i++)
+    {
+
+        device cldevice = devices[i];
+
+        // Query name
+        std::string device_name = device::device_info_to_string(
+                                    cldevice.get_device_info(CL_DEVICE_NAME));
+        std::string device_vendor = device::device_info_to_string(
+                                    cldevice.get_device_info(CL_DEVICE_VENDOR));
+
+        hpx::cout << "    " << device_name << " (" << device_vendor << ")"
+                  << hpx::endl;
+
+    }
+
+    // Spread the vectors over all devices
+    hpxcl_partitioned_buffer_a = partitioned_buffer<float>(
+                                    devices, CL_MEM_READ_ONLY, vector_size);
+    hpxcl_partitioned_buffer_b = partitioned_buffer<float>(
+                                    devices, CL_MEM_READ_ONLY, vector_size);
+    hpxcl_partitioned_buffer_c = partitioned_buffer<float>(
+                                    devices, CL_MEM_READ_ONLY, vector_size);
+    hpxcl_partitioned_buffer_z = partitioned_buffer<float>(
+                                    devices, CL_MEM_WRITE_ONLY, vector_size);
+
+    // Run once to build the generated kernels outside of the measurement
+    std::vector<event> events = hpxcl_partitioned_buffer_z.for_each_segment(
+                            &hpxcl_partitioned_enqueue_segment).get();
+    for(size_t i = 0; i < events.size(); i++)
+    {
+        events[i].await();
+    }
+
+}
+
+static boost::shared_ptr<std::vector<char>>
+hpxcl_partitioned_calculate(std::vector<float> &a,
+                            std::vector<float> &b,
+                            std::vector<float> &c,
+                            double* t_nonblock,
+                            double* t_sync,
+                            double* t_finish)
+{
+    // do nothing if matrices are wrong
+    if(a.size() != b.size() || b.size() != c.size())
+    {
+        return boost::shared_ptr<std::vector<char>>();
+    }
+
+    size_t size = a.size();
+
+    // scatter data to the gpus
+    hpxcl_partitioned_events_a =
+                    hpxcl_partitioned_buffer_a.enqueue_write(a.data()).get();
+    hpxcl_partitioned_events_b =
+                    hpxcl_partitioned_buffer_b.enqueue_write(b.data()).get();
+    hpxcl_partitioned_events_c =
+                    hpxcl_partitioned_buffer_c.enqueue_write(c.data()).get();
+
+    // wait for write to finish
+    for(size_t i = 0; i < hpxcl_partitioned_events_a.size(); i++)
+    {
+        hpxcl_partitioned_events_a[i].await();
+        hpxcl_partitioned_events_b[i].await();
+        hpxcl_partitioned_events_c[i].await();
+    }
+
+    // start time measurement
+    timer_start();
+
+    // run the fused kernel on every segment
+    hpx::lcos::future<std::vector<event>> kernel_events_future =
+                hpxcl_partitioned_buffer_z.for_each_segment(
+                                        &hpxcl_partitioned_enqueue_segment);
+
+    ////////// UNTIL HERE ALL CALLS WERE NON-BLOCKING /////////////////////////
+
+    // get time of non-blocking calls
+    *t_nonblock = timer_stop();
+
+    // wait for all nonblocking calls to finish
+    std::vector<event> kernel_events = kernel_events_future.get();
+
+    // get time of synchronization
+    *t_sync = timer_stop();
+
+    // wait for the end of the execution
+    for(size_t i = 0; i < kernel_events.size(); i++)
+    {
+        kernel_events[i].await();
+    }
+
+    // get total time of execution
+    *t_finish = timer_stop();
+
+    // gather the result
+    boost::shared_ptr<std::vector<char>> data_ptr =
+                boost::make_shared<std::vector<char>>(size * sizeof(float));
+    hpxcl_partitioned_buffer_z.enqueue_read_to(
+                                    reinterpret_cast<float*>(data_ptr->data()),
+                                    kernel_events).get();
+
+    hpxcl_partitioned_events_a.clear();
+    hpxcl_partitioned_events_b.clear();
+    hpxcl_partitioned_events_c.clear();
+
+    // return the computed data
+    return data_ptr;
+
+}
+
+static void hpxcl_partitioned_shutdown()
+{
+
+    // release buffers
+    hpxcl_partitioned_buffer_a = partitioned_buffer<float>();
+    hpxcl_partitioned_buffer_b = partitioned_buffer<float>();
+    hpxcl_partitioned_buffer_c = partitioned_buffer<float>();
+    hpxcl_partitioned_buffer_z = partitioned_buffer<float>();
+
+}
+
+#endif //BENCHMARK_HPXCL_PARTITIONED_HPP_
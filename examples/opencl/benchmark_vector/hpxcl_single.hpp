@@ -211,6 +211,7 @@ hpxcl_single_calculate(std::vector<float> &a,
     work_size<1> dim;
     dim[0].offset = 0;
     dim[0].size = size;
+    dim[0].local_size = auto_local_size;
 
     // run exp kernel
     shared_future<event> kernel_exp_event =
@@ -10,6 +10,8 @@
 #include "timer.hpp"
 #include "directcl.hpp"
 #include "hpxcl_single.hpp"
+#include "hpxcl_fused.hpp"
+#include "hpxcl_partitioned.hpp"
 #include "hpx_helpers.hpp"
 
 #include <string>
@@ -128,6 +130,50 @@ int hpx_main(int argc, char* argv[])
 
 
 
+        ////////////////////////////////////////////
+        // HPXCL local fused calculation
+        //
+        hpx::cout << hpx::endl;
+        hpx::cout << "///////////////////////////////////////" << hpx::endl;
+        hpx::cout << "// HPXCL local fused" << hpx::endl;
+        hpx::cout << "//" << hpx::endl;
+
+        // initializes
+        hpx::cout << "Initializing ..." << hpx::endl;
+        hpxcl_fused_initialize(hpx::find_here(), vector_size);
+
+        // main calculation with benchmark
+        hpx::cout << "Running calculation ..." << hpx::endl;
+        double time_hpxcl_fused_nonblock;
+        double time_hpxcl_fused_sync;
+        double time_hpxcl_fused_total;
+        boost::shared_ptr<std::vector<char>> z_hpxcl_fused =
+                             hpxcl_fused_calculate(a, b, c,
+                                                   &time_hpxcl_fused_nonblock,
+                                                   &time_hpxcl_fused_sync,
+                                                   &time_hpxcl_fused_total);
+
+        // shuts down
+        hpx::cout << "Shutting down ..." << hpx::endl;
+        hpxcl_fused_shutdown();
+
+        // checks for correct result
+        check_for_correct_result((float*)(z_hpxcl_fused->data()),
+                                 (*z_hpxcl_fused).size()/sizeof(float),
+                                 z.data(), z.size());
+        
+        // Prints the benchmark statistics
+        hpx::cout << hpx::endl;
+        hpx::cout << "    Nonblocking calls:       " << time_hpxcl_fused_nonblock
+                  << " ms" << hpx::endl;
+        hpx::cout << "    Synchronization:         " << time_hpxcl_fused_sync
+                  << " ms" << hpx::endl;
+        hpx::cout << "    Total Calculation Time:  " << time_hpxcl_fused_total
+                  << " ms" << hpx::endl;
+        hpx::cout << hpx::endl;
+
+
+
         ////////////////////////////////////////////
         // HPXCL remote calculation
         //
@@ -176,9 +222,43 @@ int hpx_main(int argc, char* argv[])
         // HPXCL distributed calculation
         //
         hpx::cout << hpx::endl;
-        //hpx::cout << "///////////////////////////////////////" << hpx::endl;
-        //hpx::cout << "// HPXCL distributed" << hpx::endl;
-        //hpx::cout << "//" << hpx::endl;
+        hpx::cout << "///////////////////////////////////////" << hpx::endl;
+        hpx::cout << "// HPXCL distributed" << hpx::endl;
+        hpx::cout << "//" << hpx::endl;
+
+        // initializes
+        hpx::cout << "Initializing ..." << hpx::endl;
+        hpxcl_partitioned_initialize(vector_size);
+
+        // main calculation with benchmark
+        hpx::cout << "Running calculation ..." << hpx::endl;
+        double time_hpxcl_distributed_nonblock;
+        double time_hpxcl_distributed_sync;
+        double time_hpxcl_distributed_total;
+        boost::shared_ptr<std::vector<char>> z_hpxcl_distributed =
+                     hpxcl_partitioned_calculate(a, b, c,
+                                                 &time_hpxcl_distributed_nonblock,
+                                                 &time_hpxcl_distributed_sync,
+                                                 &time_hpxcl_distributed_total);
+
+        // shuts down
+        hpx::cout << "Shutting down ..." << hpx::endl;
+        hpxcl_partitioned_shutdown();
+
+        // checks for correct result
+        check_for_correct_result((float*)(z_hpxcl_distributed->data()),
+                                 (*z_hpxcl_distributed).size()/sizeof(float),
+                                 z.data(), z.size());
+        
+        // Prints the benchmark statistics
+        hpx::cout << hpx::endl;
+        hpx::cout << "    Nonblocking calls:       "
+                  << time_hpxcl_distributed_nonblock << " ms" << hpx::endl;
+        hpx::cout << "    Synchronization:         "
+                  << time_hpxcl_distributed_sync << " ms" << hpx::endl;
+        hpx::cout << "    Total Calculation Time:  "
+                  << time_hpxcl_distributed_total << " ms" << hpx::endl;
+        hpx::cout << hpx::endl;
 
 
 
@@ -6,14 +6,25 @@
 #ifndef HPX_UTILS_LOCAL_FIFO_
 #define HPX_UTILS_LOCAL_FIFO_
 
-#include <queue>
+#include <deque>
 #include <hpx/lcos/local/spinlock.hpp>
 #include <hpx/lcos/local/condition_variable.hpp>
 
+#include <boost/atomic.hpp>
+
+#include "../../../opencl/lockfree_fifo.hpp"
+
+// The number of items that get queued without taking a lock.
+// Big enough to hold all tiles of an image.
+#define MANDELBROT_FIFO_CAPACITY 16384
+
+// An unbounded queue, push never blocks.
+// Items go to a lock-free ring, if it is full they go to a locked
+// overflow queue until the consumers drained it.
 template <typename T>
 class fifo
 {
-    
+
     typedef hpx::lcos::local::spinlock lock_type;
     typedef hpx::lcos::local::condition_variable cond_type;
 
@@ -31,19 +42,29 @@ public:
     ~fifo();
 
 private:
-    std::queue<T> queue;
-    lock_type     lock;
-    cond_type     cond_var;
+    // takes an item without blocking, the ring holds the older items
+    bool try_pop(T*);
+
+private:
+    hpx::opencl::lockfree_fifo<T> ring;
 
-    volatile bool finished;
-    
+    std::deque<T>              overflow;
+    lock_type                  overflow_lock;
+    boost::atomic<std::size_t> overflow_size;
+
+    lock_type                  wait_lock;
+    cond_type                  cond_var;
+    boost::atomic<std::size_t> waiting_consumers;
+
+    boost::atomic<bool> finished;
 
 };
 
 template<typename T>
 fifo<T>::fifo()
+  : ring(MANDELBROT_FIFO_CAPACITY), overflow_size(0), waiting_consumers(0),
+    finished(false)
 {
-    finished = false;
 }
 
 template<typename T>
@@ -56,53 +77,95 @@ template<typename T>
 void fifo<T>::push(const T &item)
 {
 
-    // lock class
-    boost::lock_guard<lock_type> locallock(lock);
-
     // check wether fifo is already in finished state
     if(finished)
     {
         HPX_THROW_EXCEPTION(hpx::invalid_status, "fifo::push()",
                             "fifo::finish() already called!");
     }
-    
-    // push item
-    queue.push(item);
 
-    // signal waiting threads that new item is available
+    // Nothing overflowed, the ring alone keeps the order
+    if(overflow_size.load() > 0 || !ring.try_push(item))
+    {
+        // Once items overflowed, new ones have to queue up behind them.
+        // The check and the push happen under the lock, so an item never
+        // gets into the ring while one whose push already returned still
+        // waits in the overflow.
+        boost::lock_guard<lock_type> locallock(overflow_lock);
+        if(!overflow.empty() || !ring.try_push(item))
+        {
+            overflow.push_back(item);
+            overflow_size++;
+        }
+    }
+
+    // signal waiting threads that new item is available,
+    // pairs with the fence in pop
+    boost::atomic_thread_fence(boost::memory_order_seq_cst);
+    if(waiting_consumers.load() == 0)
+        return;
+
+    boost::lock_guard<lock_type> locallock(wait_lock);
     cond_var.notify_one();
-    
+
+}
+
+template<typename T>
+bool fifo<T>::try_pop(T* item)
+{
+
+    if(ring.try_pop(item))
+        return true;
+
+    if(overflow_size.load() == 0)
+        return false;
+
+    boost::lock_guard<lock_type> locallock(overflow_lock);
+    if(overflow.empty())
+        return false;
+
+    *item = overflow.front();
+    overflow.pop_front();
+    overflow_size--;
+
+    return true;
+
 }
 
 template<typename T>
 bool fifo<T>::pop(T* item)
 {
 
+    if(try_pop(item))
+        return true;
+
     // lock class
-    boost::lock_guard<lock_type> locallock(lock);
+    boost::lock_guard<lock_type> locallock(wait_lock);
+
+    waiting_consumers++;
+    boost::atomic_thread_fence(boost::memory_order_seq_cst);
 
     // wait for queue to not be empty
-    while(queue.empty())
+    while(!try_pop(item))
     {
-        
+
         // check wether fifo is already in finished state
         if(finished)
+        {
+            waiting_consumers--;
             return false;
+        }
 
         // wait for something to change
-        cond_var.wait(lock);
+        cond_var.wait(wait_lock);
 
     }
 
-    // Retrieve element from queue
-    *item = queue.front();
-
-    // Remove element from queue
-    queue.pop();
+    waiting_consumers--;
 
     // Return success
     return true;
-    
+
 }
 
 template<typename T>
@@ -110,7 +173,7 @@ void fifo<T>::finish()
 {
 
     // lock class
-    boost::lock_guard<lock_type> locallock(lock);
+    boost::lock_guard<lock_type> locallock(wait_lock);
 
     finished = true;
 
@@ -119,18 +182,4 @@ void fifo<T>::finish()
 }
 
 
-
-
-
-
-
-
-
-
-
-
-
-
-
 #endif
-
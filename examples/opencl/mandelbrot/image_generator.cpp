@@ -9,6 +9,7 @@
 #include "../../../opencl.hpp"
 
 #include <hpx/lcos/when_all.hpp>
+#include <hpx/util/high_resolution_clock.hpp>
 
 #include <cmath>
 
@@ -77,16 +78,28 @@ image_generator::
 add_worker(hpx::opencl::device & device, size_t num_parallel_kernels)
 {
 
+        // register the worker at the scheduler
+        size_t worker_id = workqueue->add_worker(
+                            hpx::get_colocation_id(device.get_gid()).get());
+
+        // create the tile size controller of the device
+        boost::shared_ptr<tile_controller> controller =
+                                        boost::make_shared<tile_controller>();
+
         // create request callback function for worker
         boost::function<bool(boost::shared_ptr<workload>*)> request_new_work = 
-               boost::bind(&work_queue<boost::shared_ptr<workload>>::request,
-                           &(*workqueue),
+               boost::bind(&image_generator::request_work,
+                           this,
+                           worker_id,
+                           controller,
                            _1); 
 
         // create deliver callback function for worker
         boost::function<void(boost::shared_ptr<workload>&)> deliver_done_work = 
-               boost::bind(&work_queue<boost::shared_ptr<workload>>::deliver,
-                           &(*workqueue),
+               boost::bind(&image_generator::deliver_work,
+                           this,
+                           worker_id,
+                           controller,
                            _1); 
 
 
@@ -106,6 +119,76 @@ add_worker(hpx::opencl::device & device, size_t num_parallel_kernels)
 
 }
 
+bool
+image_generator::
+request_work(size_t worker_id,
+             boost::shared_ptr<tile_controller> controller,
+             boost::shared_ptr<workload>* next_workload)
+{
+
+    // get work from the queue
+    if(!workqueue->request(worker_id, next_workload))
+        return false;
+
+    boost::shared_ptr<workload> & current = *next_workload;
+
+    // split adaptive workloads
+    if(current->target_duration > 0.0)
+    {
+        size_t lines = controller->get_tile_lines(current->target_duration);
+        if(lines < current->num_pixels_y)
+        {
+            // the rest goes back to the queue, for this or any other device
+            boost::shared_ptr<workload> rest =
+                       boost::make_shared<workload>(
+                                    current->num_pixels_x,
+                                    current->num_pixels_y - lines,
+                                    current->topleft_x
+                                            + current->vert_pixdist_x * lines,
+                                    current->topleft_y
+                                            + current->vert_pixdist_y * lines,
+                                    current->hor_pixdist_x,
+                                    current->hor_pixdist_y,
+                                    current->vert_pixdist_x,
+                                    current->vert_pixdist_y,
+                                    current->img_id,
+                                    current->pos_in_img_x,
+                                    current->pos_in_img_y + lines,
+                                    current->line_offset);
+            rest->target_duration = current->target_duration;
+            rest->img_data = current->img_data;
+            workqueue->add_work(rest);
+
+            current->num_pixels_y = lines;
+        }
+    }
+
+    // start the latency measurement
+    current->occupancy = controller->tile_started();
+    current->request_time = hpx::util::high_resolution_clock::now();
+
+    return true;
+
+}
+
+void
+image_generator::
+deliver_work(size_t worker_id,
+             boost::shared_ptr<tile_controller> controller,
+             boost::shared_ptr<workload>& done_workload)
+{
+
+    // stop the latency measurement
+    double latency = (hpx::util::high_resolution_clock::now()
+                        - done_workload->request_time) * 1e-9;
+    controller->tile_finished(done_workload->num_pixels_y, latency,
+                              done_workload->occupancy);
+
+    // hand in the result
+    workqueue->deliver(worker_id, done_workload);
+
+}
+
 void
 image_generator::
 wait_for_startup_finished()
@@ -187,8 +270,9 @@ retrieve_worker_main(intptr_t parent_, bool verbose)
             img_ready = parent->images_ready[img_id];
         }
 
-        // copy data to img_data
-        if(img_data)
+        // copy data to img_data, if the worker did not write it
+        // to the image directly
+        if(img_data && done_workload->pixeldata)
         {
             size_t start_x = done_workload->pos_in_img_x;
             size_t start_y = done_workload->pos_in_img_y;
@@ -209,8 +293,11 @@ retrieve_worker_main(intptr_t parent_, bool verbose)
             }
         }
 
-        // decrease the number of work packets left
-        size_t current_img_countdown = --(*img_countdown);
+        // decrease the number of pixels left.
+        // counts pixels instead of tiles, as adaptive tiles vary in size.
+        size_t current_img_countdown = 
+                         (*img_countdown) -= done_workload->num_pixels_x
+                                             * done_workload->num_pixels_y;
         if(verbose) hpx::cout << "retrieved workload " << current_img_countdown << ": "
                               << done_workload->pos_in_img_x
                               << ":" 
@@ -293,6 +380,48 @@ compute_image(double posx,
               size_t tile_height)
 {
 
+    return compute_image_impl(posx, posy, zoom, rotation,
+                              img_width, img_height,
+                              benchmark, tile_width, tile_height, 0.0);
+
+}
+
+hpx::lcos::future<boost::shared_ptr<std::vector<char>>>
+image_generator::
+compute_image_adaptive(double posx,
+                       double posy,
+                       double zoom,
+                       double rotation,
+                       size_t img_width,
+                       size_t img_height,
+                       bool benchmark,
+                       double target_duration)
+{
+
+    BOOST_ASSERT(target_duration > 0.0);
+
+    // one single workload, it gets split by the requesting devices
+    return compute_image_impl(posx, posy, zoom, rotation,
+                              img_width, img_height,
+                              benchmark, img_width, img_height,
+                              target_duration);
+
+}
+
+hpx::lcos::future<boost::shared_ptr<std::vector<char>>>
+image_generator::
+compute_image_impl(double posx,
+                   double posy,
+                   double zoom,
+                   double rotation,
+                   size_t img_width,
+                   size_t img_height,
+                   bool benchmark,
+                   size_t tile_width,
+                   size_t tile_height,
+                   double target_duration)
+{
+
     // calculate image id
     size_t img_id = next_image_id++;
 
@@ -346,9 +475,9 @@ compute_image(double posx,
     img_data = boost::make_shared <std::vector <char> >
                                     (img_width * img_height * 3 * sizeof(char));
 
-    // create a new countdown variable
+    // create a new countdown variable, counts the pixels left
     boost::shared_ptr<std::atomic<size_t>> img_countdown = 
-              boost::make_shared<std::atomic<size_t>>(num_tiles_x * num_tiles_y);
+              boost::make_shared<std::atomic<size_t>>(img_width * img_height);
 
     // create a new ready event lock
     boost::shared_ptr<hpx::lcos::local::event> img_ready =
@@ -397,6 +526,9 @@ compute_image(double posx,
                                                     x,
                                                     y,
                                                     img_width);
+            row->target_duration = target_duration;
+            // let the workers write straight into the image
+            row->img_data = img_data;
             workqueue->add_work(row);
         }
     }
@@ -17,6 +17,7 @@
 #include "work_queue.hpp"
 #include "workload.hpp"
 #include "mandelbrotworker.hpp"
+#include "tile_controller.hpp"
 #include <atomic>
 
 /* 
@@ -71,7 +72,46 @@ class image_generator
                       size_t tile_width,
                       size_t tile_height);
 
+        // computes an image with adaptive tile sizes.
+        // every device gets tiles sized so that one kernel runs for about
+        // target_duration seconds.
+        hpx::lcos::future<boost::shared_ptr<std::vector<char>>>
+        compute_image_adaptive(double pos_x,
+                               double pos_y,
+                               double zoom,
+                               double rotation,
+                               size_t img_width,
+                               size_t img_height,
+                               bool benchmark, // purges output
+                               double target_duration);
+
     private:
+        // the implementation of compute_image.
+        // target_duration > 0 enables adaptive tiling.
+        hpx::lcos::future<boost::shared_ptr<std::vector<char>>>
+        compute_image_impl(double pos_x,
+                           double pos_y,
+                           double zoom,
+                           double rotation,
+                           size_t img_width,
+                           size_t img_height,
+                           bool benchmark,
+                           size_t tile_width,
+                           size_t tile_height,
+                           double target_duration);
+
+        // the request callback of the workers.
+        // splits adaptive workloads to the size chosen by the controller.
+        bool request_work(size_t worker_id,
+                          boost::shared_ptr<tile_controller> controller,
+                          boost::shared_ptr<workload>* next_workload);
+
+        // the deliver callback of the workers.
+        // feeds the tile latency back to the controller.
+        void deliver_work(size_t worker_id,
+                          boost::shared_ptr<tile_controller> controller,
+                          boost::shared_ptr<workload>& done_workload);
+
         // the main worker function, runs the main work loop
         static void retrieve_worker_main(
            intptr_t parent_,
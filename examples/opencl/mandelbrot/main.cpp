@@ -107,6 +107,37 @@ void grainsize_bench(std::vector<hpx::opencl::device> devices,
 
             }
 
+            // compare with adaptive tiling
+            for(double target_ms = 1.0; target_ms <= 64.0; target_ms *= 2.0)
+            {
+                hpx::cerr << "Starting adaptive test with target kernel "
+                          << "duration " << target_ms << " ms ..." << hpx::endl;
+
+                double total_time = 0.0;
+                for(size_t i = 0; i < num_iterations + 1; i++)
+                {
+                    if(i >= 1) timer_start();
+
+                    img_gen.compute_image_adaptive(posx,
+                                                   posy,
+                                                   zoom,
+                                                   0.0,
+                                                   img_x,
+                                                   img_y,
+                                                   true,
+                                                   target_ms / 1000.0).get();
+
+                    if(i >= 1) total_time += timer_stop();
+                }
+
+                double time = total_time / (double)num_iterations;
+
+                hpx::cerr << "Time: " << time << " ms" << hpx::endl;
+                hpx::cout << "adaptive-" << target_ms
+                          << "\t" << time
+                          << hpx::endl;
+            }
+
             hpx::cerr << "Done." << hpx::endl;
             img_gen.shutdown();
 
@@ -200,6 +231,7 @@ int hpx_main(boost::program_options::variables_map & vm)
     std::size_t num_kernels = 0;
     bool verbose = false;
     bool benchmark = false;
+    double adaptive_target_duration = 0.0;
 
     // Print help message on wrong argument count
     if (vm.count("num-parallel-kernels"))
@@ -208,13 +240,18 @@ int hpx_main(boost::program_options::variables_map & vm)
         verbose = true;
     if (vm.count("bench"))
         benchmark = true;
+    if (vm.count("adaptive-tiles"))
+        adaptive_target_duration = vm["adaptive-tiles"].as<double>() / 1000.0;
 
     // The main scope
     {
 
-        // get all devices
+        // get all devices, the fastest first
+        hpx::opencl::device_selection_criteria criteria;
+        criteria.device_type = CL_DEVICE_TYPE_GPU | CL_DEVICE_TYPE_ACCELERATOR;
+        criteria.required_cl_version = "OpenCL 1.1";
         std::vector<hpx::opencl::device> devices = 
-           hpx::opencl::get_all_devices(CL_DEVICE_TYPE_GPU | CL_DEVICE_TYPE_ACCELERATOR, "OpenCL 1.1").get();
+           hpx::opencl::select_devices(criteria).get();
 
         // Check whether there are any devices
         if(devices.size() < 1)
@@ -254,16 +291,27 @@ int hpx_main(boost::program_options::variables_map & vm)
             timer_start();
     
             // queue image
-            boost::shared_ptr<std::vector<char>> img_data =
-                img_gen.compute_image(posx,
-                                      posy,
-                                      zoom,
-                                      0.0,
-                                      img_x,
-                                      img_y,
-                                      false,
-                                      img_x,
-                                      4).get();
+            boost::shared_ptr<std::vector<char>> img_data;
+            if(adaptive_target_duration > 0.0)
+                img_data = img_gen.compute_image_adaptive(posx,
+                                                          posy,
+                                                          zoom,
+                                                          0.0,
+                                                          img_x,
+                                                          img_y,
+                                                          false,
+                                                  adaptive_target_duration
+                                                          ).get();
+            else
+                img_data = img_gen.compute_image(posx,
+                                                 posy,
+                                                 zoom,
+                                                 0.0,
+                                                 img_x,
+                                                 img_y,
+                                                 false,
+                                                 img_x,
+                                                 4).get();
             
             // stop timer
             double time = timer_stop();
@@ -322,5 +370,11 @@ int main(int argc, char* argv[])
         ( "bench"
         , "runs benchmark") ;
 
+    cmdline.add_options()
+        ( "adaptive-tiles"
+        , boost::program_options::value<double>()
+        , "enables adaptive tile sizes, with the given target kernel "
+          "duration in ms") ;
+
     return hpx::init(cmdline, argc, argv);
 }
@@ -23,9 +23,11 @@ mandelbrotworker::mandelbrotworker(
                          deliver_done_work_,
                          bool verbose_,
                          size_t workpacket_size_hint_x,
-                         size_t workpacket_size_hint_y)
+                         size_t workpacket_size_hint_y,
+                         size_t pipeline_depth_)
     : verbose(verbose_),
       id(id_counter++),
+      pipeline_depth(pipeline_depth_ > 0 ? pipeline_depth_ : 1),
       device(device_),
       worker_initialized(boost::make_shared<hpx::lcos::local::event>()),
       request_new_work(request_new_work_),
@@ -69,10 +71,61 @@ mandelbrotworker::wait_for_startup_finished()
 }
 
 #define KERNEL_INPUT_ARGUMENT_COUNT 6
+
+// one stage of the worker pipeline.
+// every slot has its own buffers, so tiles in different slots can be
+// processed by the device at the same time.
+struct pipeline_slot
+{
+    // the calculation dimensions, need to stay valid until the upload
+    // is finished
+    double args[KERNEL_INPUT_ARGUMENT_COUNT];
+
+    // the buffers of this slot
+    hpx::opencl::buffer input_buffer;
+    hpx::opencl::buffer output_buffer;
+    hpx::opencl::buffer precalc_buffer;
+
+    // triggers when the tile of this slot got delivered.
+    // invalid if the slot is free.
+    hpx::lcos::future<void> tile_delivered;
+};
+
+void
+mandelbrotworker::deliver_tile(boost::shared_ptr<workload> done_workload,
+                               hpx::lcos::future<hpx::opencl::event> read_event)
+{
+
+    // wait for calculation result to arrive
+    boost::shared_ptr<std::vector<char>> readdata =
+                                        read_event.get().get_data().get();
+
+    // copy calculation result to output buffer
+    done_workload->pixeldata = readdata;
+    
+    // return calculated workload to work manager workload
+    deliver_done_work(done_workload);
+
+}
+
+void
+mandelbrotworker::deliver_tile_direct(boost::shared_ptr<workload> done_workload,
+                                      hpx::lcos::future<void> read_future)
+{
+
+    // wait for calculation result to arrive in the image
+    read_future.get();
+
+    // return calculated workload to work manager workload
+    deliver_done_work(done_workload);
+
+}
+
 size_t
 mandelbrotworker::worker_main(
                     hpx::opencl::kernel precalc_kernel,
                     hpx::opencl::kernel kernel,
+                    size_t pipeline_depth,
                     size_t workpacket_size_hint_x,
                     size_t workpacket_size_hint_y
            )
@@ -86,7 +139,8 @@ mandelbrotworker::worker_main(
                                         * workpacket_size_hint_y 
                                         * 3 * sizeof(char),
                                         verbose,
-                                        CL_MEM_WRITE_ONLY); 
+                                        CL_MEM_WRITE_ONLY,
+                                        pipeline_depth); 
 
         // initialize buffermanager for precalc buffer
         mandelbrotworker_buffermanager precalc_buffermanager(
@@ -95,40 +149,21 @@ mandelbrotworker::worker_main(
                                         * (workpacket_size_hint_y + 2)
                                         * sizeof(char),
                                         verbose,
-                                        CL_MEM_READ_WRITE); 
+                                        CL_MEM_READ_WRITE,
+                                        pipeline_depth); 
 
         // counts how much work has been done
         size_t num_work = 0;
 
-        // attach output buffer
-        size_t current_buffer_size = workpacket_size_hint_x
-                                     * workpacket_size_hint_y
-                                     * 3 * sizeof(char);
-        hpx::opencl::buffer output_buffer = buffermanager.get_buffer( 
-                                                    current_buffer_size );
-
-        // attach precalc buffer
-        size_t current_precalc_size = (workpacket_size_hint_x + 2)
-                                      * (workpacket_size_hint_y + 2)
-                                      * sizeof(char);
-        hpx::opencl::buffer precalc_buffer = precalc_buffermanager.get_buffer(
-                                                    current_precalc_size );
-
-        // create input buffer
-        hpx::opencl::buffer input_buffer = device.create_buffer(
-                                                     CL_MEM_READ_ONLY,
-                                                     KERNEL_INPUT_ARGUMENT_COUNT * sizeof(double));
-    
-        // connect buffers to kernel 
-        kernel.set_arg(0, precalc_buffer);
-        kernel.set_arg(1, output_buffer);
-        kernel.set_arg(2, input_buffer);
-    
-        // connect buffers to precalc kernel 
-        precalc_kernel.set_arg(0, precalc_buffer);
-        precalc_kernel.set_arg(1, input_buffer);
-    
-    
+        // create the pipeline slots
+        std::vector<pipeline_slot> slots(pipeline_depth);
+        for(size_t i = 0; i < pipeline_depth; i++)
+        {
+            slots[i].input_buffer = device.create_buffer(
+                                     CL_MEM_READ_ONLY,
+                                     KERNEL_INPUT_ARGUMENT_COUNT * sizeof(double));
+        }
+
         // main loop
         boost::shared_ptr<workload> next_workload;
         hpx::opencl::work_size<2> dim;
@@ -137,12 +172,36 @@ mandelbrotworker::worker_main(
         dim[0].local_size = 8;
         dim[1].local_size = 8;
 
+        // the main kernel needs 8x8 work groups, the precalc kernel
+        // works with any work group size.
         hpx::opencl::work_size<2> precalc_dim;
         precalc_dim[0].offset = 0;
         precalc_dim[1].offset = 0;
-
-        while(request_new_work(&next_workload))
+        precalc_dim[0].local_size = hpx::opencl::auto_local_size;
+        precalc_dim[1].local_size = hpx::opencl::auto_local_size;
+
+        // the slots get used round robin.
+        // while the device computes the tile of one slot, the other slots
+        // upload their input or download their results.
+        size_t current_slot = 0;
+        while(true)
         {
+
+            pipeline_slot & slot = slots[current_slot];
+
+            // wait for the old tile of the slot to get delivered,
+            // its buffers get reused now
+            if(slot.tile_delivered.valid())
+            {
+                slot.tile_delivered.get();
+                slot.tile_delivered = hpx::lcos::future<void>();
+                num_work++;
+            }
+
+            // get new work.
+            // all running tiles deliver themselves, so blocking is ok here.
+            if(!request_new_work(&next_workload))
+                break;
             
             // calculate output buffer size
             size_t needed_buffer_size = next_workload->num_pixels_x
@@ -150,82 +209,112 @@ mandelbrotworker::worker_main(
                                         * 3
                                         * sizeof(char);
 
-            // change output buffer if needed buffersize changed
-            if (current_buffer_size != needed_buffer_size)
-            {
-                // query new buffer
-                output_buffer = buffermanager.get_buffer( needed_buffer_size );
-
-                // attach new buffer
-                kernel.set_arg(1, output_buffer);
-
-                // update current buffer size
-                current_buffer_size = needed_buffer_size;
-            }
+            // get the output buffer of the slot
+            slot.output_buffer = buffermanager.get_buffer(needed_buffer_size,
+                                                          current_slot);
                                         
             // calculate precalc buffer size
             size_t needed_precalc_size = (next_workload->num_pixels_x + 2)
                                         * (next_workload->num_pixels_y + 2)
                                         * sizeof(char);
 
-            // change precalc buffer if needed precalcsize changed
-            if (current_precalc_size != needed_precalc_size)
-            {
-                // query new buffer
-                precalc_buffer = precalc_buffermanager.get_buffer(
-                                                         needed_precalc_size );
-
-                // attach new buffer
-                kernel.set_arg(0, precalc_buffer);
-                precalc_kernel.set_arg(0, precalc_buffer);
-
-                // update current buffer size
-                current_precalc_size = needed_precalc_size;
-            }
+            // get the precalc buffer of the slot
+            slot.precalc_buffer = precalc_buffermanager.get_buffer(
+                                                         needed_precalc_size,
+                                                         current_slot);
  
             // read calculation dimensions
-            double args[KERNEL_INPUT_ARGUMENT_COUNT];
-            args[0] = next_workload->topleft_x;
-            args[1] = next_workload->topleft_y;
-            args[2] = next_workload->hor_pixdist_x;
-            args[3] = next_workload->hor_pixdist_y;
-            args[4] = next_workload->vert_pixdist_x;
-            args[5] = next_workload->vert_pixdist_y;
+            slot.args[0] = next_workload->topleft_x;
+            slot.args[1] = next_workload->topleft_y;
+            slot.args[2] = next_workload->hor_pixdist_x;
+            slot.args[3] = next_workload->hor_pixdist_y;
+            slot.args[4] = next_workload->vert_pixdist_x;
+            slot.args[5] = next_workload->vert_pixdist_y;
     
             // send calculation dimensions to gpu
             hpx::lcos::shared_future<hpx::opencl::event> ev1 = 
-                          input_buffer.enqueue_write(0, KERNEL_INPUT_ARGUMENT_COUNT*sizeof(double), args);
+                          slot.input_buffer.enqueue_write(0,
+                                    KERNEL_INPUT_ARGUMENT_COUNT*sizeof(double),
+                                    slot.args);
             
-            // run precalculation
+            // run precalculation.
+            // the kernels are shared between all workers, so the buffers
+            // get attached per launch.
             precalc_dim[0].size = next_workload->num_pixels_x + 2;
             precalc_dim[1].size = next_workload->num_pixels_y + 2;
+            hpx::opencl::launch_desc precalc_launch(precalc_dim);
+            precalc_launch.set_arg(0, slot.precalc_buffer);
+            precalc_launch.set_arg(1, slot.input_buffer);
             hpx::lcos::shared_future<hpx::opencl::event> ev2 = 
-                                      precalc_kernel.enqueue(precalc_dim, ev1);
+                          precalc_kernel.enqueue_launch(precalc_launch, ev1);
 
              // run calculation
             dim[0].size = next_workload->num_pixels_x * 8;
             dim[1].size = next_workload->num_pixels_y * 8;
+            hpx::opencl::launch_desc launch(dim);
+            launch.set_arg(0, slot.precalc_buffer);
+            launch.set_arg(1, slot.output_buffer);
+            launch.set_arg(2, slot.input_buffer);
             hpx::lcos::shared_future<hpx::opencl::event> ev3 = 
-                                                       kernel.enqueue(dim, ev2);
-    
-            // query calculation result 
-            hpx::opencl::event ev4 =
-                    output_buffer.enqueue_read(0, current_buffer_size, ev3).get();
-    
-            // wait for calculation result to arrive
-            boost::shared_ptr<std::vector<char>> readdata = ev4.get_data().get();
+                                         kernel.enqueue_launch(launch, ev2);
     
-            // copy calculation result to output buffer
-            next_workload->pixeldata = readdata;
-            
-            // return calculated workload to work manager workload
-            deliver_done_work(next_workload);
+            // query calculation result.
+            // deliver the tile as soon as the result arrived,
+            // don't wait for it here
+            if(next_workload->img_data)
+            {
+                // read the tile rows directly to their place in the image
+                size_t tile_line_size = next_workload->num_pixels_x
+                                        * 3 * sizeof(char);
+                size_t img_line_size = next_workload->line_offset
+                                        * 3 * sizeof(char);
+                char* tile_start = next_workload->img_data->data()
+                                   + next_workload->pos_in_img_y * img_line_size
+                                   + next_workload->pos_in_img_x
+                                        * 3 * sizeof(char);
+
+                hpx::lcos::future<void> read_future =
+                    slot.output_buffer.enqueue_read_rect_to(0,
+                                                    tile_line_size,
+                                                    next_workload->num_pixels_y,
+                                                    tile_line_size,
+                                                    tile_start,
+                                                    img_line_size,
+                                                    ev3);
+
+                slot.tile_delivered = read_future.then(
+                        hpx::util::bind(&mandelbrotworker::deliver_tile_direct,
+                                        this,
+                                        next_workload,
+                                        hpx::util::placeholders::_1));
+            }
+            else
+            {
+                hpx::lcos::future<hpx::opencl::event> ev4 =
+                    slot.output_buffer.enqueue_read(0, needed_buffer_size, ev3);
+
+                slot.tile_delivered = ev4.then(
+                        hpx::util::bind(&mandelbrotworker::deliver_tile,
+                                        this,
+                                        next_workload,
+                                        hpx::util::placeholders::_1));
+            }
 
-            // count number of workloads
-            num_work++;
+            // continue with the next slot
+            current_slot = (current_slot + 1) % pipeline_depth;
     
         }
 
+        // wait for the remaining tiles
+        for(size_t i = 0; i < pipeline_depth; i++)
+        {
+            if(slots[i].tile_delivered.valid())
+            {
+                slots[i].tile_delivered.get();
+                num_work++;
+            }
+        }
+
         return num_work;
 
 }
@@ -240,12 +329,12 @@ mandelbrotworker::worker_starter(
 
     try{
 
-        std::string device_vendor = device.device_info_to_string(
-                                    device.get_device_info(CL_DEVICE_VENDOR));
-        std::string device_name = device.device_info_to_string(
-                                  device.get_device_info(CL_DEVICE_NAME));
-        std::string device_version = device.device_info_to_string(
-                                     device.get_device_info(CL_DEVICE_VERSION));
+        // query all properties at once
+        hpx::opencl::device_properties properties =
+                                            device.get_device_properties().get();
+        std::string const& device_vendor = properties.vendor;
+        std::string const& device_name = properties.name;
+        std::string const& device_version = properties.version;
 
         // print device name
         hpx::cerr << "#" << id << ": "
@@ -264,25 +353,28 @@ mandelbrotworker::worker_starter(
             hpx::cout << "#" << id << ": " << "compiling done." << hpx::endl;
     
         
+        // create kernel, shared between all workers
+        hpx::opencl::kernel kernel = 
+                   mandelbrot_program.get_kernel_pool("mandelbrot_alias_8x8",
+                                                      num_workers);
+
+        // create precalc kernel, shared between all workers
+        hpx::opencl::kernel precalc_kernel = 
+                   mandelbrot_program.get_kernel_pool("precompute_mandelbrot",
+                                                      num_workers);
+
         // start workers
         std::vector<hpx::lcos::future<size_t>> worker_futures;
         for(size_t i = 0; i < num_workers; i++)
         {
          
-            // create kernel
-            hpx::opencl::kernel kernel = 
-                       mandelbrot_program.create_kernel("mandelbrot_alias_8x8");
-
-            // create precalc kernel
-            hpx::opencl::kernel precalc_kernel = 
-                       mandelbrot_program.create_kernel("precompute_mandelbrot");
-
             // start worker
             hpx::lcos::future<size_t> worker_future = 
                                       hpx::async(&mandelbrotworker::worker_main,
                                                  this,
                                                  precalc_kernel,
                                                  kernel,
+                                                 pipeline_depth,
                                                  workpacket_size_hint_x,
                                                  workpacket_size_hint_y);
 
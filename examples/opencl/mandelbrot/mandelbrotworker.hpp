@@ -35,7 +35,8 @@ class mandelbrotworker
                          deliver_done_work,
                          bool verbose,
                          size_t workpacket_size_hint_x,
-                         size_t workpacket_size_hint_y);
+                         size_t workpacket_size_hint_y,
+                         size_t pipeline_depth = 2);
 
         // waits for the worker to finish
         void join();
@@ -48,13 +49,23 @@ class mandelbrotworker
 
     private:
         // the main worker function, runs the main work loop
+        // every worker keeps pipeline_depth tiles in flight
         size_t worker_main(
            hpx::opencl::kernel precalc_kernel,
            hpx::opencl::kernel kernel,
+           size_t pipeline_depth,
            size_t workpacket_size_hint_x,
            size_t workpacket_size_hint_y
            );
 
+        // waits for the result of a tile and delivers it
+        void deliver_tile(boost::shared_ptr<workload> done_workload,
+                          hpx::lcos::future<hpx::opencl::event> read_event);
+
+        // delivers a tile that got written to the image directly
+        void deliver_tile_direct(boost::shared_ptr<workload> done_workload,
+                                 hpx::lcos::future<void> read_future);
+
         // the startup function, initializes the kernel and starts the workers
         void worker_starter(
            size_t num_workers,
@@ -66,6 +77,7 @@ class mandelbrotworker
     private:
         const bool verbose;
         const unsigned int id;
+        const size_t pipeline_depth;
         hpx::opencl::device device;
         hpx::lcos::shared_future<void> worker_finished;
         boost::shared_ptr<hpx::lcos::local::event> worker_initialized;
@@ -10,28 +10,43 @@ mandelbrotworker_buffermanager::
 mandelbrotworker_buffermanager(hpx::opencl::device device_,
                                size_t initial_buffer_size,
                                bool verbose_,
-                               cl_mem_flags memflags_) 
+                               cl_mem_flags memflags_,
+                               size_t num_slots) 
                 : device(device_), verbose(verbose_), memflags(memflags_)
 {
 
-    // allocate the initial buffer, to improve runtime speed
-    allocate_buffer(initial_buffer_size);
+    // allocate the initial buffers, to improve runtime speed
+    for(size_t slot = 0; slot < num_slots; slot++)
+        allocate_buffer(initial_buffer_size, slot);
 
 }
 
 hpx::opencl::buffer
 mandelbrotworker_buffermanager::
-get_buffer(size_t size)
+get_buffer(size_t size, size_t slot)
 {
 
-    // search for an already allocated buffer of the correct size
-    buffer_map_type::iterator it = buffers.find(size);
+    // search for the smallest allocated buffer of the slot that fits
+    buffer_map_type::iterator it = buffers.lower_bound(
+                                                std::make_pair(slot, size));
 
-    // if no buffer is found, allocate a new one
-    if(it == buffers.end())
+    // if no buffer fits, allocate a new one.
+    // adaptive tiling asks for continuously varying sizes, round up to a
+    // power of two to not reallocate on every small growth.
+    if(it == buffers.end() || it->first.first != slot)
     {
-        allocate_buffer(size);
-        it = buffers.find(size);
+        // all remaining buffers of the slot are too small, free them.
+        // buffers still used by running commands stay alive until these
+        // finished.
+        buffers.erase(buffers.lower_bound(std::make_pair(slot, size_t(0))),
+                      it);
+
+        size_t new_size = 1;
+        while(new_size < size)
+            new_size *= 2;
+
+        allocate_buffer(new_size, slot);
+        it = buffers.find(std::make_pair(slot, new_size));
     }
 
     // make sure that we now have a buffer
@@ -46,21 +61,20 @@ get_buffer(size_t size)
 
 void
 mandelbrotworker_buffermanager::
-allocate_buffer(size_t size)
+allocate_buffer(size_t size, size_t slot)
 {
 
     if(verbose) hpx::cout << "allocating opencl buffer of size " 
                           << size << " bytes ..." << hpx::endl;
 
     // make sure no buffer of the given size already exists
-    BOOST_ASSERT(buffers.find(size) == buffers.end());
+    BOOST_ASSERT(buffers.find(std::make_pair(slot, size)) == buffers.end());
     
     // allocate a buffer
     hpx::opencl::buffer new_buffer =
                             device.create_buffer(memflags, size);
     
     // add the buffer to the map
-    buffers.insert( std::pair<size_t, hpx::opencl::buffer>(size, new_buffer) );
+    buffers.insert( std::make_pair(std::make_pair(slot, size), new_buffer) );
 
 }
-                      
@@ -9,6 +9,7 @@
 #include "../../../opencl.hpp"
 
 #include <map>
+#include <utility>
 
 /* 
  * a worker.
@@ -20,24 +21,32 @@ class mandelbrotworker_buffermanager
 
     public:
         // initializes the buffermanager
+        // num_slots: the number of independent buffer sets, for
+        //            pipelining
         mandelbrotworker_buffermanager(hpx::opencl::device device_,
                                        size_t initial_buffer_size,
                                        bool verbose,
-                                       cl_mem_flags memflags);
+                                       cl_mem_flags memflags,
+                                       size_t num_slots = 1);
 
-        // get a buffer
+        // get a buffer of at least the given size.
+        // different slots never share a buffer.
+        // a slot keeps its smallest fitting buffer; if none fits, a bigger
+        // one gets allocated and the smaller ones of the slot get freed.
         hpx::opencl::buffer
-        get_buffer(size_t buffersize);
+        get_buffer(size_t buffersize, size_t slot = 0);
 
     // private functions
     private:
-        void allocate_buffer(size_t size);
+        void allocate_buffer(size_t size, size_t slot);
 
 
     // private attributes
     private:
         hpx::opencl::device device;
-        typedef std::map<size_t, hpx::opencl::buffer> buffer_map_type;
+        // key: (slot, size)
+        typedef std::map<std::pair<size_t, size_t>, hpx::opencl::buffer>
+                buffer_map_type;
         buffer_map_type buffers;
         bool verbose;
         cl_mem_flags memflags;
@@ -33,6 +33,12 @@ int hpx_main(boost::program_options::variables_map & vm)
     if (vm.count("v"))
         verbose = true;
 
+    // the tile cache
+    std::size_t cache_size = vm["tile-cache-size"].as<std::size_t>();
+    std::string cache_directory;
+    if (vm.count("tile-cache-dir"))
+        cache_directory = vm["tile-cache-dir"].as<std::string>();
+
     // The main scope
     {
 
@@ -60,7 +66,9 @@ int hpx_main(boost::program_options::variables_map & vm)
         hpx::opencl::examples::mandelbrot::requesthandler requesthandler(
                                                             tilesize_x,
                                                             tilesize_y,
-                                                            lines_per_gpu);
+                                                            lines_per_gpu,
+                                                  cache_size * 1024 * 1024,
+                                                            cache_directory);
 
    
         // create image_generator
@@ -116,6 +124,16 @@ int main(int argc, char* argv[])
         , boost::program_options::value<std::size_t>()->default_value(3)
         , "the number of parallel kernel invocations per gpu") ;
 
+    cmdline.add_options()
+        ( "tile-cache-size"
+        , boost::program_options::value<std::size_t>()->default_value(64)
+        , "the memory of the tile cache, in MB") ;
+
+    cmdline.add_options()
+        ( "tile-cache-dir"
+        , boost::program_options::value<std::string>()
+        , "a directory for tiles evicted from the tile cache (optional)") ;
+
     cmdline.add_options()
         ( "v"
         , "verbose output") ;
@@ -482,15 +482,18 @@ retrieve_worker_main(intptr_t parent_, bool verbose)
         if(current_img_countdown == 0)
         {
 
-            // convert to png
+            // convert to png.
+            // the encoding is on the critical path of the request,
+            // so encode on multiple threads and prefer speed over size.
             if(img_request->stillValid())
             {
                 size_t png_size;
                 boost::shared_array<char> png_data = 
-                                   create_png(img_request->data,
-                                              img_request->tilesize_x,
-                                              img_request->tilesize_y,
-                                              &png_size);
+                                   create_png_parallel(img_request->data,
+                                                       img_request->tilesize_x,
+                                                       img_request->tilesize_y,
+                                                       &png_size,
+                                                       png_profile_fast);
                 
                 // remove old data
                 img_request->data = boost::make_shared<std::vector<char>>
@@ -7,14 +7,22 @@
 
 #include <hpx/include/iostreams.hpp>
 
+#include <boost/thread/locks.hpp>
+#include <boost/make_shared.hpp>
+#include <boost/foreach.hpp>
+
 using namespace hpx::opencl::examples::mandelbrot;
 
 requesthandler::requesthandler(size_t tilesize_x_,
                                size_t tilesize_y_,
-                               size_t lines_per_gpu_) :
+                               size_t lines_per_gpu_,
+                               size_t cache_size,
+                               std::string cache_directory) :
                                     tilesize_x(tilesize_x_),
                                     tilesize_y(tilesize_y_),
-                                    lines_per_gpu(lines_per_gpu_)
+                                    lines_per_gpu(lines_per_gpu_),
+                                    cache(cache_size, cache_directory),
+                                    num_queued_tiles(0)
 {
     
     
@@ -31,17 +39,244 @@ requesthandler::submit_request(boost::shared_ptr<request> request)
         return;
     }
 
-    // add missing data in request
-    request->tilesize_x = tilesize_x;
-    request->tilesize_y = tilesize_y;
-    request->lines_per_gpu = lines_per_gpu;
-    request->img_countdown = tilesize_y/lines_per_gpu;
+    // answer from the cache, if the tile was computed before
+    tile_key key(request->zoom, request->posx, request->posy,
+                 tilesize_x, tilesize_y);
+    boost::shared_ptr<std::vector<char>> cached_tile = cache.get(key);
+    if(cached_tile)
+    {
+        request->done(cached_tile);
+        return;
+    }
+
+    {
+        boost::lock_guard<hpx::lcos::local::spinlock> l(lock);
+
+        // share the computation if the tile is already pending
+        pending_tile_map::iterator it = pending_tiles.find(key);
+        if(it != pending_tiles.end())
+        {
+            it->second->subscribers.push_back(request);
+            return;
+        }
+
+        boost::shared_ptr<pending_tile> tile =
+                                        boost::make_shared<pending_tile>(key);
+        tile->subscribers.push_back(request);
+        pending_tiles.insert(pending_tile_map::value_type(key, tile));
+
+        // the computation is a request of its own,
+        // it answers all subscribers of the tile
+        boost::shared_ptr<hpx::opencl::examples::mandelbrot::request>
+        computation = boost::make_shared<
+                            hpx::opencl::examples::mandelbrot::request>();
+        computation->zoom = request->zoom;
+        computation->posx = request->posx;
+        computation->posy = request->posy;
+        computation->user_ip = request->user_ip;
+        computation->tilesize_x = tilesize_x;
+        computation->tilesize_y = tilesize_y;
+        computation->lines_per_gpu = lines_per_gpu;
+        computation->img_countdown = tilesize_y/lines_per_gpu;
+        computation->done = boost::bind(&requesthandler::tile_finished,
+                                        this, key, _1);
+        computation->abort = boost::bind(&requesthandler::tile_aborted,
+                                         this, key);
+        computation->stillValid = boost::bind(&requesthandler::tile_still_valid,
+                                              this, key);
+
+        // hand the request to an hpx thread    
+        queue_tile_locked(computation);
+        tiles_available.notify_one();
+    }
 
     hpx::cout << "Request submitted: " << request->zoom << hpx::endl;
       
-    // hand the request to an hpx thread    
-    new_requests.push(request);
-    
+}
+
+std::vector<boost::shared_ptr<request>>
+requesthandler::remove_pending_tile(tile_key const& key)
+{
+
+    std::vector<boost::shared_ptr<request>> subscribers;
+
+    boost::lock_guard<hpx::lcos::local::spinlock> l(lock);
+
+    pending_tile_map::iterator it = pending_tiles.find(key);
+    if(it != pending_tiles.end())
+    {
+        subscribers.swap(it->second->subscribers);
+        pending_tiles.erase(it);
+    }
+
+    return subscribers;
+
+}
+
+void
+requesthandler::tile_finished(tile_key key,
+                              boost::shared_ptr<std::vector<char>> png_data)
+{
+
+    cache.put(key, png_data);
+
+    // answer all clients that are still connected
+    std::vector<boost::shared_ptr<request>> subscribers =
+                                                    remove_pending_tile(key);
+    BOOST_FOREACH(boost::shared_ptr<request> & subscriber, subscribers)
+    {
+        if(subscriber->stillValid())
+            subscriber->done(png_data);
+        else
+            subscriber->abort();
+    }
+
+}
+
+void
+requesthandler::tile_aborted(tile_key key)
+{
+
+    std::vector<boost::shared_ptr<request>> subscribers =
+                                                    remove_pending_tile(key);
+    BOOST_FOREACH(boost::shared_ptr<request> & subscriber, subscribers)
+    {
+        subscriber->abort();
+    }
+
+}
+
+bool
+requesthandler::tile_still_valid(tile_key key)
+{
+
+    std::vector<boost::shared_ptr<request>> aborted;
+    bool valid = false;
+
+    {
+        boost::lock_guard<hpx::lcos::local::spinlock> l(lock);
+
+        pending_tile_map::iterator it = pending_tiles.find(key);
+        if(it != pending_tiles.end())
+            valid = remove_invalid_subscribers_locked(*(it->second), aborted);
+    }
+
+    BOOST_FOREACH(boost::shared_ptr<request> & subscriber, aborted)
+    {
+        subscriber->abort();
+    }
+
+    return valid;
+
+}
+
+bool
+requesthandler::remove_invalid_subscribers_locked(pending_tile & tile,
+                        std::vector<boost::shared_ptr<request>> & aborted)
+{
+
+    std::vector<boost::shared_ptr<request>>::iterator it =
+                                                    tile.subscribers.begin();
+    while(it != tile.subscribers.end())
+    {
+        if((*it)->stillValid())
+        {
+            ++it;
+        }
+        else
+        {
+            aborted.push_back(*it);
+            it = tile.subscribers.erase(it);
+        }
+    }
+
+    return !tile.subscribers.empty();
+
+}
+
+void
+requesthandler::queue_tile_locked(boost::shared_ptr<request> const& tile)
+{
+
+    zoom_level & level = queued_tiles[tile->user_ip][tile->zoom];
+    level.tiles.push_back(tile);
+    level.sum_x += tile->posx;
+    level.sum_y += tile->posy;
+    num_queued_tiles++;
+
+}
+
+void
+requesthandler::dequeue_tile_locked(client_queue_map::iterator client,
+                            client_queue::iterator level,
+                            std::list<boost::shared_ptr<request>>::iterator tile)
+{
+
+    level->second.sum_x -= (*tile)->posx;
+    level->second.sum_y -= (*tile)->posy;
+    level->second.tiles.erase(tile);
+    num_queued_tiles--;
+
+    if(level->second.tiles.empty())
+        client->second.erase(level);
+    if(client->second.empty())
+        queued_tiles.erase(client);
+
+}
+
+bool
+requesthandler::tile_has_subscribers_locked(request const& tile,
+                        std::vector<boost::shared_ptr<request>> & aborted)
+{
+
+    tile_key key(tile.zoom, tile.posx, tile.posy, tilesize_x, tilesize_y);
+    pending_tile_map::iterator it = pending_tiles.find(key);
+    if(it == pending_tiles.end())
+        return false;
+
+    if(remove_invalid_subscribers_locked(*(it->second), aborted))
+        return true;
+
+    pending_tiles.erase(it);
+    return false;
+
+}
+
+void
+requesthandler::prune_client_locked(client_queue_map::iterator client,
+                        std::vector<boost::shared_ptr<request>> & aborted)
+{
+
+    client_queue::iterator level = client->second.begin();
+    while(level != client->second.end())
+    {
+        zoom_level & tiles = level->second;
+        std::list<boost::shared_ptr<request>>::iterator it =
+                                                        tiles.tiles.begin();
+        while(it != tiles.tiles.end())
+        {
+            if(tile_has_subscribers_locked(**it, aborted))
+            {
+                ++it;
+            }
+            else
+            {
+                tiles.sum_x -= (*it)->posx;
+                tiles.sum_y -= (*it)->posy;
+                it = tiles.tiles.erase(it);
+                num_queued_tiles--;
+            }
+        }
+
+        if(tiles.tiles.empty())
+            client->second.erase(level++);
+        else
+            ++level;
+    }
+
+    if(client->second.empty())
+        queued_tiles.erase(client);
+
 }
 
 boost::shared_ptr<request>
@@ -49,19 +284,85 @@ requesthandler::query_request()
 {
 
     boost::shared_ptr<request> ret;
+    std::vector<boost::shared_ptr<request>> aborted;
 
-    // take a new request out of the queue
-    while(true)
     {
-        if(!new_requests.pop(&ret))
-            return boost::shared_ptr<request>(); 
-        if(ret->stillValid())
+        boost::unique_lock<hpx::lcos::local::spinlock> l(lock);
+
+        while(!ret)
         {
-            return ret;
+
+            if(num_queued_tiles == 0)
+            {
+                // answer the disconnected clients before going to sleep
+                if(!aborted.empty())
+                {
+                    l.unlock();
+                    BOOST_FOREACH(boost::shared_ptr<request> & subscriber,
+                                  aborted)
+                    {
+                        subscriber->abort();
+                    }
+                    aborted.clear();
+                    l.lock();
+                    continue;
+                }
+
+                tiles_available.wait(lock);
+                continue;
+            }
+
+            // the clients take turns, so a client that zooms in deeply
+            // doesn't wait for all others
+            client_queue_map::iterator client =
+                                        queued_tiles.upper_bound(last_client);
+            if(client == queued_tiles.end())
+                client = queued_tiles.begin();
+
+            // prefer its lowest zoom level,
+            // then the tile closest to the center of its viewport
+            client_queue::iterator level = client->second.begin();
+            zoom_level & tiles = level->second;
+            double center_x = tiles.sum_x / tiles.tiles.size();
+            double center_y = tiles.sum_y / tiles.tiles.size();
+
+            std::list<boost::shared_ptr<request>>::iterator best =
+                                                        tiles.tiles.end();
+            double best_distance = 0.0;
+            for(std::list<boost::shared_ptr<request>>::iterator it =
+                    tiles.tiles.begin(); it != tiles.tiles.end(); ++it)
+            {
+                double dx = (*it)->posx - center_x;
+                double dy = (*it)->posy - center_y;
+                double distance = dx * dx + dy * dy;
+
+                if(best == tiles.tiles.end() || distance < best_distance)
+                {
+                    best = it;
+                    best_distance = distance;
+                }
+            }
+
+            // cancel the tiles of disconnected clients,
+            // before they reach the device
+            if(!tile_has_subscribers_locked(**best, aborted))
+            {
+                // the client is probably gone, drop all of its dead tiles
+                prune_client_locked(client, aborted);
+                continue;
+            }
+
+            last_client = client->first;
+            ret = *best;
+            dequeue_tile_locked(client, level, best);
         }
-        ret->abort();
     }
 
-}
+    BOOST_FOREACH(boost::shared_ptr<request> & subscriber, aborted)
+    {
+        subscriber->abort();
+    }
 
+    return ret;
 
+}
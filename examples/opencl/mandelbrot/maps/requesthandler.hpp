@@ -10,8 +10,13 @@
 #include <string>
 
 #include "maps_image_generator.hpp"
-#include "../fifo.hpp"
+#include "tile_cache.hpp"
 #include <atomic>
+#include <list>
+#include <map>
+
+#include <hpx/lcos/local/spinlock.hpp>
+#include <hpx/lcos/local/condition_variable.hpp>
 
 #include <boost/shared_ptr.hpp>
 
@@ -41,21 +46,103 @@ class requesthandler
 
 public:
     // constructor
+    //   cache_size:      the memory of the tile cache, in bytes
+    //   cache_directory: the spill directory of the tile cache,
+    //                    empty to keep tiles in memory only
     requesthandler(size_t tilesize_x_,
                    size_t tilesize_y_,
-                   size_t lines_per_gpu);
+                   size_t lines_per_gpu,
+                   size_t cache_size = 64 * 1024 * 1024,
+                   std::string cache_directory = "");
 
     void submit_request(boost::shared_ptr<request> request);
 
+    // returns the most important queued tile of the next client,
+    // the clients take turns.
+    // blocks if there is none.
     boost::shared_ptr<request> query_request();     
 
 
+private:
+    // a tile that is queued or in computation,
+    // together with all client requests waiting for it
+    struct pending_tile
+    {
+        pending_tile(tile_key key_) : key(key_) {}
+
+        tile_key key;
+        std::vector<boost::shared_ptr<request>> subscribers;
+    };
+
+    typedef std::map<tile_key, boost::shared_ptr<pending_tile>>
+                pending_tile_map;
+
+    // the queued tiles of one zoom level of a client
+    struct zoom_level
+    {
+        zoom_level() : sum_x(0.0), sum_y(0.0) {}
+
+        std::list<boost::shared_ptr<request>> tiles;
+        // the sum of the tile positions. the center of the tiles is
+        // an estimate of the center of the viewport.
+        double sum_x;
+        double sum_y;
+    };
+
+    // the queued tiles of a client, lowest zoom level first
+    typedef std::map<long, zoom_level> client_queue;
+    typedef std::map<std::string, client_queue> client_queue_map;
+
+    // the callbacks of the computation of a pending tile
+    void tile_finished(tile_key key,
+                       boost::shared_ptr<std::vector<char>> png_data);
+    void tile_aborted(tile_key key);
+    bool tile_still_valid(tile_key key);
+
+    // removes the disconnected subscribers of a tile.
+    // returns false if none is left.
+    // needs the lock, the removed subscribers get appended to aborted.
+    bool remove_invalid_subscribers_locked(pending_tile & tile,
+                        std::vector<boost::shared_ptr<request>> & aborted);
+
+    // removes a tile from the list of pending tiles, returns its subscribers.
+    std::vector<boost::shared_ptr<request>> remove_pending_tile(
+                                                        tile_key const& key);
+
+    // adds and removes queued tiles. need the lock.
+    void queue_tile_locked(boost::shared_ptr<request> const& tile);
+    void dequeue_tile_locked(client_queue_map::iterator client,
+                             client_queue::iterator level,
+                             std::list<boost::shared_ptr<request>>::iterator
+                                                                        tile);
+
+    // removes the disconnected subscribers of a queued tile, and the
+    // pending tile if none is left. returns false in that case.
+    // needs the lock, the removed subscribers get appended to aborted.
+    bool tile_has_subscribers_locked(request const& tile,
+                        std::vector<boost::shared_ptr<request>> & aborted);
+
+    // removes all queued tiles of a client that nobody waits for any more.
+    // needs the lock, the removed subscribers get appended to aborted.
+    void prune_client_locked(client_queue_map::iterator client,
+                        std::vector<boost::shared_ptr<request>> & aborted);
+
 private:
     size_t tilesize_x;
     size_t tilesize_y;
     size_t lines_per_gpu;
-    fifo<boost::shared_ptr<request>> new_requests;
-    
+    tile_cache cache;
+
+    // protects pending_tiles and queued_tiles
+    hpx::lcos::local::spinlock lock;
+    hpx::lcos::local::condition_variable tiles_available;
+    // all tiles that are queued or in computation
+    pending_tile_map pending_tiles;
+    // the computations that did not start yet, by client
+    client_queue_map queued_tiles;
+    size_t num_queued_tiles;
+    // the client that got the last tile
+    std::string last_client;
 
 };
 
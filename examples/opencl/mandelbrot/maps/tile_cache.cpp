@@ -0,0 +1,225 @@
+// Copyright (c)       2014 Martin Stumpf
+//
+// Distributed under the Boost Software License, Version 1.0. (See accompanying
+// file LICENSE_1_0.txt or copy at http://www.boost.org/LICENSE_1_0.txt)
+
+#include "tile_cache.hpp"
+
+#include <boost/thread/locks.hpp>
+#include <boost/make_shared.hpp>
+#include <boost/foreach.hpp>
+
+#include <fstream>
+#include <iterator>
+#include <sstream>
+
+using namespace hpx::opencl::examples::mandelbrot;
+
+tile_key::tile_key(long zoom_, long posx_, long posy_,
+                   size_t tilesize_x_, size_t tilesize_y_)
+    : zoom(zoom_), posx(posx_), posy(posy_),
+      tilesize_x(tilesize_x_), tilesize_y(tilesize_y_)
+{
+}
+
+bool
+tile_key::operator<(tile_key const& other) const
+{
+
+    if(zoom != other.zoom) return zoom < other.zoom;
+    if(posx != other.posx) return posx < other.posx;
+    if(posy != other.posy) return posy < other.posy;
+    if(tilesize_x != other.tilesize_x) return tilesize_x < other.tilesize_x;
+    return tilesize_y < other.tilesize_y;
+
+}
+
+std::string
+tile_key::filename() const
+{
+
+    std::stringstream name;
+    name << zoom << "_" << posx << "_" << posy << "_"
+         << tilesize_x << "x" << tilesize_y << ".png";
+    return name.str();
+
+}
+
+tile_cache::tile_cache(size_t max_memory_, std::string spill_directory_)
+    : max_memory(max_memory_),
+      spill_directory(spill_directory_),
+      memory_used(0),
+      num_hits(0),
+      num_misses(0)
+{
+}
+
+boost::shared_ptr<std::vector<char>>
+tile_cache::get(tile_key const& key)
+{
+
+    bool on_disk = false;
+
+    // look in memory
+    {
+        boost::lock_guard<hpx::lcos::local::spinlock> l(lock);
+
+        entry_map::iterator it = entries_by_key.find(key);
+        if(it != entries_by_key.end())
+        {
+            // mark as most recently used
+            entries.splice(entries.begin(), entries, it->second);
+            num_hits++;
+            return it->second->second;
+        }
+
+        on_disk = (spilled.find(key) != spilled.end());
+    }
+
+    if(!on_disk)
+    {
+        num_misses++;
+        return boost::shared_ptr<std::vector<char>>();
+    }
+
+    // look on disk
+    boost::shared_ptr<std::vector<char>> data = read_from_disk(key);
+    if(!data)
+    {
+        num_misses++;
+        return data;
+    }
+
+    // bring it back to memory
+    std::vector<entry> evicted;
+    {
+        boost::lock_guard<hpx::lcos::local::spinlock> l(lock);
+        insert_locked(key, data, evicted);
+    }
+    write_to_disk(evicted);
+
+    num_hits++;
+    return data;
+
+}
+
+void
+tile_cache::put(tile_key const& key, boost::shared_ptr<std::vector<char>> data)
+{
+
+    BOOST_ASSERT(data);
+
+    std::vector<entry> evicted;
+    {
+        boost::lock_guard<hpx::lcos::local::spinlock> l(lock);
+        insert_locked(key, data, evicted);
+    }
+    write_to_disk(evicted);
+
+}
+
+void
+tile_cache::insert_locked(tile_key const& key,
+                          boost::shared_ptr<std::vector<char>> data,
+                          std::vector<entry> & evicted)
+{
+
+    // tiles bigger than the whole cache only go to disk
+    if(data->size() > max_memory)
+    {
+        evicted.push_back(entry(key, data));
+        return;
+    }
+
+    // replace an old version
+    entry_map::iterator it = entries_by_key.find(key);
+    if(it != entries_by_key.end())
+    {
+        memory_used -= it->second->second->size();
+        entries.erase(it->second);
+        entries_by_key.erase(it);
+    }
+
+    // add as most recently used
+    entries.push_front(entry(key, data));
+    entries_by_key.insert(entry_map::value_type(key, entries.begin()));
+    memory_used += data->size();
+
+    // evict the least recently used tiles
+    while(memory_used > max_memory)
+    {
+        entry & last = entries.back();
+        memory_used -= last.second->size();
+        entries_by_key.erase(last.first);
+        evicted.push_back(last);
+        entries.pop_back();
+    }
+
+}
+
+boost::shared_ptr<std::vector<char>>
+tile_cache::read_from_disk(tile_key const& key)
+{
+
+    std::ifstream file((spill_directory + "/" + key.filename()).c_str(),
+                       std::ios::in | std::ios::binary);
+    if(!file)
+        return boost::shared_ptr<std::vector<char>>();
+
+    boost::shared_ptr<std::vector<char>> data =
+                                    boost::make_shared<std::vector<char>>();
+    data->assign(std::istreambuf_iterator<char>(file),
+                 std::istreambuf_iterator<char>());
+    if(file.bad() || data->empty())
+        return boost::shared_ptr<std::vector<char>>();
+
+    return data;
+
+}
+
+void
+tile_cache::write_to_disk(std::vector<entry> const& evicted)
+{
+
+    if(spill_directory.empty())
+        return;
+
+    BOOST_FOREACH(entry const& e, evicted)
+    {
+
+        // tiles are immutable, so every tile has to be written only once
+        {
+            boost::lock_guard<hpx::lcos::local::spinlock> l(lock);
+            if(spilled.find(e.first) != spilled.end())
+                continue;
+        }
+
+        std::ofstream file((spill_directory + "/" + e.first.filename()).c_str(),
+                           std::ios::out | std::ios::binary
+                                         | std::ios::trunc);
+        if(!file)
+            continue;
+
+        file.write(e.second->data(), e.second->size());
+        file.close();
+        if(!file)
+            continue;
+
+        boost::lock_guard<hpx::lcos::local::spinlock> l(lock);
+        spilled.insert(e.first);
+
+    }
+
+}
+
+size_t
+tile_cache::get_num_hits() const
+{
+    return num_hits;
+}
+
+size_t
+tile_cache::get_num_misses() const
+{
+    return num_misses;
+}
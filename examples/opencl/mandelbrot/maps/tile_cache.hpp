@@ -0,0 +1,102 @@
+// Copyright (c)       2014 Martin Stumpf
+//
+// Distributed under the Boost Software License, Version 1.0. (See accompanying
+// file LICENSE_1_0.txt or copy at http://www.boost.org/LICENSE_1_0.txt)
+
+#ifndef HPXCL_MANDELBROT_TILE_CACHE_HPP_
+#define HPXCL_MANDELBROT_TILE_CACHE_HPP_
+
+#include <hpx/lcos/local/spinlock.hpp>
+
+#include <boost/shared_ptr.hpp>
+
+#include <atomic>
+#include <list>
+#include <map>
+#include <set>
+#include <string>
+#include <vector>
+
+
+namespace hpx { namespace opencl { namespace examples { namespace mandelbrot {
+
+// identifies a tile
+struct tile_key
+{
+public:
+    tile_key(long zoom, long posx, long posy,
+             size_t tilesize_x, size_t tilesize_y);
+
+    bool operator<(tile_key const& other) const;
+
+    // the file name of the tile in the spill directory
+    std::string filename() const;
+
+    long zoom;
+    long posx;
+    long posy;
+    size_t tilesize_x;
+    size_t tilesize_y;
+};
+
+/*
+ * A memory bounded cache of encoded tiles.
+ *
+ * Keeps the most recently used tiles in memory. If a spill directory
+ * is given, evicted tiles get written there and are read back on demand.
+ */
+class tile_cache
+{
+
+public:
+    // max_memory:      the maximal size of all tiles in memory, in bytes
+    // spill_directory: the directory for evicted tiles, empty to disable
+    tile_cache(size_t max_memory, std::string spill_directory = "");
+
+    // returns the tile, or an empty pointer if it is not cached
+    boost::shared_ptr<std::vector<char>> get(tile_key const& key);
+
+    // adds a tile. the data must not be modified afterwards.
+    void put(tile_key const& key, boost::shared_ptr<std::vector<char>> data);
+
+    // statistics
+    size_t get_num_hits() const;
+    size_t get_num_misses() const;
+
+private:
+    typedef std::pair<tile_key, boost::shared_ptr<std::vector<char>>> entry;
+    typedef std::list<entry> lru_list;
+    typedef std::map<tile_key, lru_list::iterator> entry_map;
+
+    // adds a tile to memory, returns the tiles that got evicted.
+    // needs the lock.
+    void insert_locked(tile_key const& key,
+                       boost::shared_ptr<std::vector<char>> data,
+                       std::vector<entry> & evicted);
+
+    // the disk tier. don't call these with the lock held,
+    // only the bookkeeping of the spilled tiles is done under the lock.
+    boost::shared_ptr<std::vector<char>> read_from_disk(tile_key const& key);
+    void write_to_disk(std::vector<entry> const& evicted);
+
+private:
+    const size_t max_memory;
+    const std::string spill_directory;
+
+    hpx::lcos::local::spinlock lock;
+    // most recently used first
+    lru_list entries;
+    entry_map entries_by_key;
+    size_t memory_used;
+    // the tiles in the spill directory.
+    // the directory is owned by the cache, older files get overwritten.
+    std::set<tile_key> spilled;
+
+    std::atomic<size_t> num_hits;
+    std::atomic<size_t> num_misses;
+
+};
+
+} } } }
+
+#endif
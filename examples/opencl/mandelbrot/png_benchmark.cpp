@@ -0,0 +1,292 @@
+// Copyright (c)       2014 Martin Stumpf
+//
+// Distributed under the Boost Software License, Version 1.0. (See accompanying
+// file LICENSE_1_0.txt or copy at http://www.boost.org/LICENSE_1_0.txt)
+
+#include <hpx/hpx.hpp>
+#include <hpx/hpx_init.hpp>
+#include <hpx/include/iostreams.hpp>
+#include <hpx/util/high_resolution_timer.hpp>
+
+#include "pngwriter.hpp"
+
+#include <boost/bind.hpp>
+#include <boost/make_shared.hpp>
+#include <boost/shared_ptr.hpp>
+
+#include <png.h>
+
+#include <cmath>
+#include <cstring>
+#include <string>
+
+/*
+ * Measures the png encoders on a mandelbrot image,
+ * without any OpenCL device involved.
+ * The output of the parallel encoder gets decoded with libpng and
+ * compared to the input first, the program fails if they differ.
+ */
+
+// computes a mandelbrot image on the cpu, similar to the kernel
+static boost::shared_ptr<std::vector<char>>
+create_test_image(size_t width, size_t height)
+{
+
+    boost::shared_ptr<std::vector<char>> img =
+                        boost::make_shared<std::vector<char>>(width * height * 3);
+
+    for(size_t y = 0; y < height; y++)
+    {
+        for(size_t x = 0; x < width; x++)
+        {
+            double c_re = -2.2 + 3.0 * x / width;
+            double c_im = -1.2 + 2.4 * y / height;
+            double z_re = 0.0;
+            double z_im = 0.0;
+            size_t iter = 0;
+            while(iter < 512 && z_re * z_re + z_im * z_im < 4.0)
+            {
+                double tmp = z_re * z_re - z_im * z_im + c_re;
+                z_im = 2.0 * z_re * z_im + c_im;
+                z_re = tmp;
+                iter++;
+            }
+
+            char* pixel = img->data() + (y * width + x) * 3;
+            pixel[0] = (char)((iter * 7) & 0xff);
+            pixel[1] = (char)((iter * 3) & 0xff);
+            pixel[2] = (char)((iter * 11) & 0xff);
+        }
+    }
+
+    return img;
+
+}
+
+// reads a png from memory
+struct png_read_state
+{
+    const char* data;
+    size_t size;
+    size_t pos;
+};
+
+static void
+png_read_from_mem(png_structp png_ptr, png_bytep data, png_size_t length)
+{
+    png_read_state* state = (png_read_state*) png_get_io_ptr(png_ptr);
+    if(state->pos + length > state->size)
+        png_error(png_ptr, "Read beyond the end of the png");
+    std::memcpy(data, state->data + state->pos, length);
+    state->pos += length;
+}
+
+// decodes the png with libpng and compares it to the image.
+// libpng checks the chunk crcs and zlib the checksum of the stream.
+static bool decodes_to(boost::shared_array<char> png, size_t png_size,
+                       boost::shared_ptr<std::vector<char>> img,
+                       size_t width, size_t height)
+{
+
+    png_structp png_ptr = png_create_read_struct(PNG_LIBPNG_VER_STRING,
+                                                 NULL, NULL, NULL);
+    if(png_ptr == NULL)
+        return false;
+    png_infop info_ptr = png_create_info_struct(png_ptr);
+    if(info_ptr == NULL)
+    {
+        png_destroy_read_struct(&png_ptr, NULL, NULL);
+        return false;
+    }
+
+    std::vector<char> decoded(width * height * 3);
+    std::vector<png_bytep> row_pointers(height);
+    for(size_t y = 0; y < height; y++)
+        row_pointers[y] = (png_bytep) decoded.data() + 3 * y * width;
+
+    if(setjmp(png_jmpbuf(png_ptr)))
+    {
+        png_destroy_read_struct(&png_ptr, &info_ptr, NULL);
+        return false;
+    }
+
+    png_read_state state = {png.get(), png_size, 0};
+    png_set_read_fn(png_ptr, &state, png_read_from_mem);
+    png_read_info(png_ptr, info_ptr);
+
+    if(png_get_image_width(png_ptr, info_ptr) != width
+       || png_get_image_height(png_ptr, info_ptr) != height
+       || png_get_bit_depth(png_ptr, info_ptr) != 8
+       || png_get_color_type(png_ptr, info_ptr) != PNG_COLOR_TYPE_RGB)
+    {
+        png_destroy_read_struct(&png_ptr, &info_ptr, NULL);
+        return false;
+    }
+
+    png_read_image(png_ptr, row_pointers.data());
+    png_read_end(png_ptr, NULL);
+    png_destroy_read_struct(&png_ptr, &info_ptr, NULL);
+
+    return state.pos == png_size
+        && std::memcmp(decoded.data(), img->data(), decoded.size()) == 0;
+
+}
+
+// encodes the image with several strip sizes in all profiles and decodes
+// it again, returns the number of failures.
+// the strip sizes cover single row strips, strips that don't divide the
+// height and strips that are longer than the deflate window.
+static size_t verify_parallel(size_t width, size_t height,
+                              size_t rows_per_strip)
+{
+
+    boost::shared_ptr<std::vector<char>> img =
+                                        create_test_image(width, height);
+
+    size_t strip_sizes[] = {0, 1, 7, 64, height - 1, height, rows_per_strip};
+    png_profile profiles[] = {png_profile_fast,
+                              png_profile_default,
+                              png_profile_small};
+
+    size_t num_failures = 0;
+    for(size_t i = 0; i < 3; i++)
+    {
+        for(size_t j = 0; j < sizeof(strip_sizes) / sizeof(size_t); j++)
+        {
+            size_t png_size = 0;
+            boost::shared_array<char> png =
+                    create_png_parallel(img, width, height, &png_size,
+                                        profiles[i], strip_sizes[j]);
+            if(!decodes_to(png, png_size, img, width, height))
+            {
+                hpx::cerr << "Error: " << width << "x" << height
+                          << " image with " << strip_sizes[j]
+                          << " rows per strip does not decode to the input!"
+                          << hpx::endl;
+                num_failures++;
+            }
+        }
+    }
+
+    return num_failures;
+
+}
+
+static const char* profile_name(png_profile profile)
+{
+    switch(profile)
+    {
+        case png_profile_fast:  return "fast";
+        case png_profile_small: return "small";
+        default:                return "default";
+    }
+}
+
+// runs one encoder, prints average time and size
+template <typename Encoder>
+static void run_benchmark(std::string name, Encoder encoder,
+                          size_t num_iterations)
+{
+
+    size_t png_size = 0;
+
+    hpx::util::high_resolution_timer timer;
+    for(size_t i = 0; i < num_iterations; i++)
+    {
+        encoder(&png_size);
+    }
+    double time = timer.elapsed() / num_iterations;
+
+    hpx::cout << name << ": " << time * 1000.0 << " ms, "
+              << png_size << " bytes" << hpx::endl;
+
+}
+
+static void encode_serial(boost::shared_ptr<std::vector<char>> img,
+                          size_t width, size_t height, png_profile profile,
+                          size_t* size)
+{
+    create_png(img, width, height, size, profile);
+}
+
+static void encode_parallel(boost::shared_ptr<std::vector<char>> img,
+                            size_t width, size_t height, png_profile profile,
+                            size_t rows_per_strip, size_t* size)
+{
+    create_png_parallel(img, width, height, size, profile, rows_per_strip);
+}
+
+int hpx_main(boost::program_options::variables_map & vm)
+{
+
+    size_t width = vm["width"].as<std::size_t>();
+    size_t height = vm["height"].as<std::size_t>();
+    size_t num_iterations = vm["iterations"].as<std::size_t>();
+    size_t rows_per_strip = vm["rows-per-strip"].as<std::size_t>();
+
+    hpx::cout << "image: " << width << "x" << height
+              << ", threads: " << hpx::get_os_thread_count() << hpx::endl;
+
+    // verify the encoder, also with a height that is no multiple of the
+    // strip sizes
+    size_t num_failures = verify_parallel(width, height, rows_per_strip)
+                        + verify_parallel(width, height + 13, rows_per_strip);
+    if(num_failures > 0)
+    {
+        hpx::finalize();
+        return 1;
+    }
+
+    boost::shared_ptr<std::vector<char>> img =
+                                        create_test_image(width, height);
+
+    png_profile profiles[] = {png_profile_fast,
+                              png_profile_default,
+                              png_profile_small};
+    for(size_t i = 0; i < 3; i++)
+    {
+        png_profile profile = profiles[i];
+
+        run_benchmark(std::string("libpng   ") + profile_name(profile),
+                      boost::bind(&encode_serial, img, width, height,
+                                  profile, _1),
+                      num_iterations);
+
+        run_benchmark(std::string("parallel ") + profile_name(profile),
+                      boost::bind(&encode_parallel, img, width, height,
+                                  profile, rows_per_strip, _1),
+                      num_iterations);
+    }
+
+    return hpx::finalize();
+
+}
+
+//////////////////////////////////////////////////////////////////////////////
+int main(int argc, char* argv[])
+{
+    // Configure application-specific options
+    boost::program_options::options_description cmdline(
+                                "Usage: " HPX_APPLICATION_STRING " [options]");
+    cmdline.add_options()
+        ( "width"
+        , boost::program_options::value<std::size_t>()->default_value(256)
+        , "the width of the image") ;
+
+    cmdline.add_options()
+        ( "height"
+        , boost::program_options::value<std::size_t>()->default_value(256)
+        , "the height of the image") ;
+
+    cmdline.add_options()
+        ( "iterations"
+        , boost::program_options::value<std::size_t>()->default_value(100)
+        , "the number of encodings per measurement") ;
+
+    cmdline.add_options()
+        ( "rows-per-strip"
+        , boost::program_options::value<std::size_t>()->default_value(0)
+        , "the strip size of the parallel encoder, 0 for automatic") ;
+
+    return hpx::init(cmdline, argc, argv);
+}
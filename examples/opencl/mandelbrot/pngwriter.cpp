@@ -7,11 +7,19 @@
 
 #include "pngwriter.hpp"
 
+#include <hpx/lcos/when_all.hpp>
+
+#include <boost/make_shared.hpp>
+#include <boost/foreach.hpp>
+
 #include <fstream>
 #include <png.h>
+#include <zlib.h>
 #include <cstdio>
 #include <cstdlib>
 #include <cstdint>
+#include <cstring>
+#include <algorithm>
 
 
 /* structure to store PNG image bytes */
@@ -19,6 +27,7 @@ struct mem_encode
 {
   char *buffer;
   size_t size;
+  size_t capacity;
 };
 
 
@@ -29,14 +38,16 @@ my_png_write_data(png_structp png_ptr, png_bytep data, png_size_t length)
   struct mem_encode* p=(struct mem_encode*)png_get_io_ptr(png_ptr); /* was png_ptr->io_ptr */
   size_t nsize = p->size + length;
 
-  /* allocate or grow buffer */
-  if(p->buffer)
-    p->buffer = (char *) realloc(p->buffer, nsize);
-  else
-    p->buffer = (char *) malloc(nsize);
-
-  if(!p->buffer)
-    png_error(png_ptr, "Write Error");
+  /* the buffer is preallocated, only grow it if the bound was too small */
+  if(nsize > p->capacity)
+  {
+    size_t ncapacity = std::max(nsize, 2 * p->capacity);
+    char* nbuffer = (char *) realloc(p->buffer, ncapacity);
+    if(!nbuffer)
+      png_error(png_ptr, "Write Error");
+    p->buffer = nbuffer;
+    p->capacity = ncapacity;
+  }
 
   /* copy new bytes to end of buffer */
   memcpy(p->buffer + p->size, data, length);
@@ -49,7 +60,53 @@ my_png_write_data(png_structp png_ptr, png_bytep data, png_size_t length)
 
 
 
-static mem_encode save_png_to_mem(boost::shared_ptr< std::vector<char> > data, size_t width, size_t height)
+// the zlib settings of a profile
+struct png_profile_settings
+{
+    int level;
+    int strategy;
+    // the png filter type of all rows
+    png_byte filter;
+};
+
+static png_profile_settings get_profile_settings(png_profile profile)
+{
+
+    png_profile_settings settings;
+    switch(profile)
+    {
+        case png_profile_fast:
+            settings.level = 1;
+            settings.strategy = Z_RLE;
+            settings.filter = 1; // sub
+            break;
+        case png_profile_small:
+            settings.level = 9;
+            settings.strategy = Z_FILTERED;
+            settings.filter = 2; // up
+            break;
+        default:
+            settings.level = Z_DEFAULT_COMPRESSION;
+            settings.strategy = Z_DEFAULT_STRATEGY;
+            settings.filter = 2; // up
+            break;
+    }
+    return settings;
+
+}
+
+// an upper bound for the size of the png
+static size_t png_size_bound(size_t width, size_t height)
+{
+
+    // filtered image data, plus zlib and png overhead
+    size_t raw_size = height * (1 + 3 * width);
+    return compressBound((uLong) raw_size) + 1024;
+
+}
+
+static mem_encode save_png_to_mem(boost::shared_ptr< std::vector<char> > data, size_t width, size_t height,
+                                  png_profile profile)
 {
 
     png_structp png_ptr = NULL;
@@ -88,6 +145,11 @@ static mem_encode save_png_to_mem(boost::shared_ptr< std::vector<char> > data, s
                  PNG_COMPRESSION_TYPE_DEFAULT,
                  PNG_FILTER_TYPE_DEFAULT);
 
+    /* Set compression profile. */
+    png_profile_settings settings = get_profile_settings(profile);
+    png_set_compression_level(png_ptr, settings.level);
+    png_set_compression_strategy(png_ptr, settings.strategy);
+
     /* Initialize the rows of png */
     bytes_per_row = (png_uint_32) (width * sizeof(char) * 3);
     row_pointers = (png_byte **)png_malloc(png_ptr, height * sizeof(png_byte *));
@@ -99,9 +161,17 @@ static mem_encode save_png_to_mem(boost::shared_ptr< std::vector<char> > data, s
     /* static */
     struct mem_encode state;
     
-    /* initialise - put this before png_write_png() call */
-    state.buffer = NULL;
+    /* initialise - put this before png_write_png() call.
+       preallocate, to not grow the buffer for every write */
+    state.capacity = png_size_bound(width, height);
+    state.buffer = (char *) malloc(state.capacity);
     state.size = 0;
+    if(!state.buffer)
+    {
+        png_free(png_ptr, row_pointers);
+        png_destroy_write_struct(&png_ptr, &info_ptr);
+        die("save_png_to_mem()", "Out of memory!");
+    }
     
     /* if my_png_flush() is not needed, change the arg to NULL */
     png_set_write_fn(png_ptr, &state, my_png_write_data, NULL);
@@ -123,14 +193,16 @@ static mem_encode save_png_to_mem(boost::shared_ptr< std::vector<char> > data, s
 }
 
 
-boost::shared_array<char> create_png(boost::shared_ptr< std::vector<char> > data, size_t width, size_t height, size_t * size)
+boost::shared_array<char> create_png(boost::shared_ptr< std::vector<char> > data, size_t width, size_t height, size_t * size,
+                                     png_profile profile)
 {
 
     // Create png in memory
-    mem_encode png_data = save_png_to_mem(data, width, height);
+    mem_encode png_data = save_png_to_mem(data, width, height, profile);
 
-    // Wrap png in shared_array for auto-deletion
-    boost::shared_array<char> png(png_data.buffer);
+    // Wrap png in shared_array for auto-deletion.
+    // the buffer got allocated with malloc.
+    boost::shared_array<char> png(png_data.buffer, &free);
 
     // write size to external variable
     *size = png_data.size;
@@ -140,6 +212,283 @@ boost::shared_array<char> create_png(boost::shared_ptr< std::vector<char> > data
 
 }
 
+///////////////////////////////////////////////////////////////////////////////
+// Parallel encoder
+//
+
+// one compressed strip of the image
+struct png_strip
+{
+    std::vector<char> compressed;
+    uLong adler;
+    size_t raw_size;
+};
+
+// writes a big endian 32 bit integer
+static char* write_uint32(char* dst, png_uint_32 value)
+{
+    dst[0] = (char)((value >> 24) & 0xff);
+    dst[1] = (char)((value >> 16) & 0xff);
+    dst[2] = (char)((value >> 8) & 0xff);
+    dst[3] = (char)(value & 0xff);
+    return dst + 4;
+}
+
+// writes a png chunk, the data can be given in two parts
+static char* write_chunk(char* dst, const char* type,
+                         const char* data1, size_t size1,
+                         const char* data2 = NULL, size_t size2 = 0)
+{
+
+    dst = write_uint32(dst, (png_uint_32)(size1 + size2));
+
+    char* crc_start = dst;
+    std::memcpy(dst, type, 4);
+    dst += 4;
+    if(size1 > 0) std::memcpy(dst, data1, size1);
+    dst += size1;
+    if(size2 > 0) std::memcpy(dst, data2, size2);
+    dst += size2;
+
+    uLong crc = crc32(0L, Z_NULL, 0);
+    crc = crc32(crc, (const Bytef*) crc_start, (uInt)(dst - crc_start));
+    return write_uint32(dst, (png_uint_32) crc);
+
+}
+
+// applies the png filter to the rows [row_begin, row_end)
+static void filter_rows(const unsigned char* image, unsigned char* filtered,
+                        size_t width, size_t row_begin, size_t row_end,
+                        png_byte filter)
+{
+
+    const size_t bpp = 3;
+    const size_t row_bytes = bpp * width;
+
+    for(size_t y = row_begin; y < row_end; y++)
+    {
+        const unsigned char* row = image + y * row_bytes;
+        const unsigned char* prev = (y > 0) ? row - row_bytes : NULL;
+        unsigned char* out = filtered + y * (row_bytes + 1);
+
+        // the first row has no predecessor, up is the same as none there
+        *out++ = filter;
+        if(filter == 1)
+        {
+            for(size_t i = 0; i < bpp; i++)
+                out[i] = row[i];
+            for(size_t i = bpp; i < row_bytes; i++)
+                out[i] = (unsigned char)(row[i] - row[i - bpp]);
+        }
+        else if(filter == 2 && prev != NULL)
+        {
+            for(size_t i = 0; i < row_bytes; i++)
+                out[i] = (unsigned char)(row[i] - prev[i]);
+        }
+        else
+        {
+            std::memcpy(out, row, row_bytes);
+        }
+    }
+
+}
+
+// compresses one strip to a raw deflate stream.
+// the strip gets flushed to a byte boundary, so all strips can get
+// concatenated, the last strip terminates the stream.
+static png_strip compress_strip(boost::shared_ptr<std::vector<unsigned char>> filtered,
+                                size_t offset, size_t size,
+                                png_profile_settings settings)
+{
+
+    const unsigned char* data = filtered->data();
+    bool last = (offset + size == filtered->size());
+
+    z_stream strm;
+    std::memset(&strm, 0, sizeof(strm));
+    if(deflateInit2(&strm, settings.level, Z_DEFLATED, -15, 8,
+                    settings.strategy) != Z_OK)
+    {
+        die("compress_strip()", "deflateInit2() failed!");
+    }
+
+    // continue the sliding window of the previous strip,
+    // keeps the compression ratio close to a single stream
+    if(offset > 0)
+    {
+        size_t dict_size = std::min<size_t>(offset, 32768);
+        deflateSetDictionary(&strm, data + offset - dict_size,
+                             (uInt) dict_size);
+    }
+
+    png_strip strip;
+    strip.raw_size = size;
+    strip.adler = adler32(adler32(0L, Z_NULL, 0), data + offset, (uInt) size);
+
+    // preallocate from the bound, plus the flush marker
+    strip.compressed.resize(deflateBound(&strm, (uLong) size) + 16);
+
+    strm.next_in = const_cast<Bytef*>(data + offset);
+    strm.avail_in = (uInt) size;
+    size_t produced = 0;
+    while(true)
+    {
+        strm.next_out = (Bytef*) strip.compressed.data() + produced;
+        strm.avail_out = (uInt)(strip.compressed.size() - produced);
+
+        int err = deflate(&strm, last ? Z_FINISH : Z_SYNC_FLUSH);
+        produced = strip.compressed.size() - strm.avail_out;
+
+        if(err == Z_STREAM_ERROR)
+        {
+            deflateEnd(&strm);
+            die("compress_strip()", "deflate() failed!");
+        }
+
+        // finished if all output got flushed
+        if(last ? (err == Z_STREAM_END)
+                : (strm.avail_in == 0 && strm.avail_out > 0))
+            break;
+
+        // only happens if the bound was too small
+        strip.compressed.resize(2 * strip.compressed.size());
+    }
+
+    deflateEnd(&strm);
+    strip.compressed.resize(produced);
+
+    return strip;
+
+}
+
+boost::shared_array<char> create_png_parallel(boost::shared_ptr< std::vector<char> > data, size_t width, size_t height, size_t * size,
+                                              png_profile profile,
+                                              size_t rows_per_strip)
+{
+
+    BOOST_ASSERT(data->size() >= 3 * width * height);
+    BOOST_ASSERT(width > 0 && height > 0);
+
+    png_profile_settings settings = get_profile_settings(profile);
+    const size_t filtered_row_size = 3 * width + 1;
+
+    // choose the strip size: two strips per thread,
+    // but not smaller than the deflate window
+    if(rows_per_strip == 0)
+    {
+        size_t num_threads = hpx::get_os_thread_count();
+        rows_per_strip = (height + 2 * num_threads - 1) / (2 * num_threads);
+        rows_per_strip = std::max(rows_per_strip,
+                                  (32768 + filtered_row_size - 1)
+                                        / filtered_row_size);
+    }
+    rows_per_strip = std::min(rows_per_strip, height);
+    size_t num_strips = (height + rows_per_strip - 1) / rows_per_strip;
+
+    // filter all strips.
+    // the compression of a strip needs the filtered end of the previous
+    // strip as dictionary, so filtering has to be finished first.
+    boost::shared_ptr<std::vector<unsigned char>> filtered =
+            boost::make_shared<std::vector<unsigned char>>(
+                                                height * filtered_row_size);
+    {
+        std::vector<hpx::lcos::future<void>> filter_futures;
+        filter_futures.reserve(num_strips);
+        for(size_t row = 0; row < height; row += rows_per_strip)
+        {
+            filter_futures.push_back(hpx::async(&filter_rows,
+                            (const unsigned char*) data->data(),
+                            filtered->data(),
+                            width,
+                            row,
+                            std::min(row + rows_per_strip, height),
+                            settings.filter));
+        }
+        hpx::wait_all(filter_futures);
+    }
+
+    // compress all strips
+    std::vector<hpx::lcos::future<png_strip>> strip_futures;
+    strip_futures.reserve(num_strips);
+    for(size_t row = 0; row < height; row += rows_per_strip)
+    {
+        size_t rows = std::min(rows_per_strip, height - row);
+        strip_futures.push_back(hpx::async(&compress_strip,
+                                           filtered,
+                                           row * filtered_row_size,
+                                           rows * filtered_row_size,
+                                           settings));
+    }
+    std::vector<png_strip> strips;
+    strips.reserve(num_strips);
+    BOOST_FOREACH(hpx::lcos::future<png_strip> & strip_future, strip_futures)
+    {
+        strips.push_back(strip_future.get());
+    }
+
+    // the zlib header, FLEVEL only informs about the compression level
+    char zlib_header[2];
+    zlib_header[0] = (char) 0x78;
+    if(settings.level == 1)
+        zlib_header[1] = (char) 0x01;
+    else if(settings.level == 9)
+        zlib_header[1] = (char) 0xda;
+    else
+        zlib_header[1] = (char) 0x9c;
+
+    // the zlib trailer, the checksum of all strips
+    uLong adler = adler32(0L, Z_NULL, 0);
+    BOOST_FOREACH(png_strip & strip, strips)
+    {
+        adler = adler32_combine(adler, strip.adler, (z_off_t) strip.raw_size);
+    }
+    char zlib_trailer[4];
+    write_uint32(zlib_trailer, (png_uint_32) adler);
+
+    // the header of the png
+    static const char png_signature[8] =
+                        {(char)137, 'P', 'N', 'G', '\r', '\n', 26, '\n'};
+    char ihdr[13];
+    write_uint32(ihdr, (png_uint_32) width);
+    write_uint32(ihdr + 4, (png_uint_32) height);
+    ihdr[8] = 8;                // bit depth
+    ihdr[9] = 2;                // color type rgb
+    ihdr[10] = 0;               // compression
+    ihdr[11] = 0;               // filter
+    ihdr[12] = 0;               // interlace
+
+    // every strip becomes an idat chunk,
+    // the zlib header and trailer get idat chunks of their own.
+    size_t total_size = sizeof(png_signature) + 12 + sizeof(ihdr)
+                      + 12 + sizeof(zlib_header)
+                      + 12 + sizeof(zlib_trailer)
+                      + 12;
+    BOOST_FOREACH(png_strip & strip, strips)
+    {
+        total_size += 12 + strip.compressed.size();
+    }
+
+    // assemble
+    boost::shared_array<char> png(new char[total_size]);
+    char* pos = png.get();
+    std::memcpy(pos, png_signature, sizeof(png_signature));
+    pos += sizeof(png_signature);
+    pos = write_chunk(pos, "IHDR", ihdr, sizeof(ihdr));
+    pos = write_chunk(pos, "IDAT", zlib_header, sizeof(zlib_header));
+    BOOST_FOREACH(png_strip & strip, strips)
+    {
+        pos = write_chunk(pos, "IDAT", strip.compressed.data(),
+                          strip.compressed.size());
+    }
+    pos = write_chunk(pos, "IDAT", zlib_trailer, sizeof(zlib_trailer));
+    pos = write_chunk(pos, "IEND", NULL, 0);
+    BOOST_ASSERT(pos == png.get() + total_size);
+
+    *size = total_size;
+    return png;
+
+}
+
 void png_write_to_file(boost::shared_array<char> png, size_t png_size, const char* filename)
 {
 
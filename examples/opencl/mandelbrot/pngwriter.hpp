@@ -12,10 +12,27 @@
 #include <boost/shared_ptr.hpp>
 #include <boost/shared_array.hpp>
 
+// the speed/size tradeoff of the png compression
+enum png_profile
+{
+    png_profile_fast,       // fastest encoding, biggest files
+    png_profile_default,    // the zlib defaults
+    png_profile_small       // smallest files, slowest encoding
+};
+
 // writes data to png file
 void save_png(boost::shared_ptr< std::vector<char> > data, size_t width, size_t height, const char* filename);
 
-boost::shared_array<char> create_png(boost::shared_ptr< std::vector<char> > data, size_t width, size_t height, size_t * size);
+boost::shared_array<char> create_png(boost::shared_ptr< std::vector<char> > data, size_t width, size_t height, size_t * size,
+                                     png_profile profile = png_profile_default);
+
+// encodes the png on multiple hpx threads.
+// the image gets split into strips of rows_per_strip rows that get
+// compressed independently and concatenated, like pigz does.
+// rows_per_strip = 0 chooses the strip size automatically.
+boost::shared_array<char> create_png_parallel(boost::shared_ptr< std::vector<char> > data, size_t width, size_t height, size_t * size,
+                                              png_profile profile = png_profile_default,
+                                              size_t rows_per_strip = 0);
 
 void png_write_to_file(boost::shared_array<char> png, size_t png_size, const char* filename);
 
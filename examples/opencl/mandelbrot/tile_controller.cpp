@@ -0,0 +1,96 @@
+// Copyright (c)       2014 Martin Stumpf
+//
+// Distributed under the Boost Software License, Version 1.0. (See accompanying
+// file LICENSE_1_0.txt or copy at http://www.boost.org/LICENSE_1_0.txt)
+
+#include "tile_controller.hpp"
+
+#include <boost/thread/locks.hpp>
+
+#include <algorithm>
+
+// weight of a new measurement in the running estimate
+#define TILE_CONTROLLER_SMOOTHING 0.3
+
+tile_controller::tile_controller(size_t min_lines_,
+                                 size_t max_lines_,
+                                 size_t initial_lines)
+    : min_lines(std::max<size_t>(min_lines_, 1)),
+      max_lines(std::max<size_t>(max_lines_, min_lines_)),
+      in_flight(0),
+      current_lines(initial_lines),
+      time_per_line(0.0)
+{
+
+    current_lines = std::max(current_lines, min_lines);
+    current_lines = std::min(current_lines, max_lines);
+
+}
+
+size_t
+tile_controller::get_tile_lines(double target_duration)
+{
+
+    boost::lock_guard<hpx::lcos::local::spinlock> l(lock);
+
+    // keep the initial size until something got measured
+    if(time_per_line <= 0.0 || target_duration <= 0.0)
+        return current_lines;
+
+    // the ideal size
+    double ideal_lines = target_duration / time_per_line;
+
+    // change by at most a factor of two per tile, to not overreact to
+    // single measurements
+    ideal_lines = std::min(ideal_lines, 2.0 * current_lines);
+    ideal_lines = std::max(ideal_lines, 0.5 * current_lines);
+
+    size_t lines = (size_t)(ideal_lines + 0.5);
+    lines = std::max(lines, min_lines);
+    lines = std::min(lines, max_lines);
+
+    current_lines = lines;
+    return lines;
+
+}
+
+size_t
+tile_controller::tile_started()
+{
+
+    return ++in_flight;
+
+}
+
+void
+tile_controller::tile_finished(size_t lines, double latency, size_t occupancy)
+{
+
+    in_flight--;
+
+    if(lines == 0 || latency <= 0.0)
+        return;
+
+    // the device works on all tiles in flight at once, so the latency
+    // contains the kernel times of the other tiles as well
+    double kernel_time = latency / std::max<size_t>(occupancy, 1);
+    double measured_time_per_line = kernel_time / lines;
+
+    boost::lock_guard<hpx::lcos::local::spinlock> l(lock);
+
+    if(time_per_line <= 0.0)
+        time_per_line = measured_time_per_line;
+    else
+        time_per_line = TILE_CONTROLLER_SMOOTHING * measured_time_per_line
+                      + (1.0 - TILE_CONTROLLER_SMOOTHING) * time_per_line;
+
+}
+
+double
+tile_controller::get_time_per_line()
+{
+
+    boost::lock_guard<hpx::lcos::local::spinlock> l(lock);
+    return time_per_line;
+
+}
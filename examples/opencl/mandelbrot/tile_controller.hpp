@@ -0,0 +1,60 @@
+// Copyright (c)       2014 Martin Stumpf
+//
+// Distributed under the Boost Software License, Version 1.0. (See accompanying
+// file LICENSE_1_0.txt or copy at http://www.boost.org/LICENSE_1_0.txt)
+
+#ifndef MANDELBROT_TILE_CONTROLLER_H_
+#define MANDELBROT_TILE_CONTROLLER_H_
+
+#include <hpx/lcos/local/spinlock.hpp>
+
+#include <atomic>
+#include <cstdlib>
+
+/*
+ * Chooses the tile size of one device for adaptive tiling.
+ *
+ * Measures the latency of every tile and the number of tiles in flight
+ * on the device, estimates the kernel time per image line and sizes the
+ * next tiles so that a kernel runs for the targeted duration.
+ */
+class tile_controller
+{
+
+    public:
+        tile_controller(size_t min_lines = 1,
+                        size_t max_lines = 4096,
+                        size_t initial_lines = 8);
+
+        // returns the number of lines the next tile should have
+        size_t get_tile_lines(double target_duration);
+
+        // call when a tile gets handed to the device.
+        // returns the number of tiles in flight, including this one.
+        size_t tile_started();
+
+        // call when a tile is finished.
+        //   lines:      the number of lines of the tile
+        //   latency:    the time between tile_started() and now, in seconds
+        //   occupancy:  the return value of the matching tile_started()
+        void tile_finished(size_t lines, double latency, size_t occupancy);
+
+        // the current estimate of the kernel time per line in seconds,
+        // 0 if nothing got measured yet
+        double get_time_per_line();
+
+    private:
+        const size_t min_lines;
+        const size_t max_lines;
+
+        // the tiles currently in flight on the device
+        std::atomic<size_t> in_flight;
+
+        // the current tile size and the running estimate
+        hpx::lcos::local::spinlock lock;
+        size_t current_lines;
+        double time_per_line;
+
+};
+
+#endif
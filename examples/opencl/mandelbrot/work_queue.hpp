@@ -6,6 +6,7 @@
 #ifndef MANDELBROT_WORK_QUEUE_H_
 #define MANDELBROT_WORK_QUEUE_H_
 
+#include "../../../opencl/work_scheduler.hpp"
 #include "fifo.hpp"
 #include <atomic>
 
@@ -18,6 +19,9 @@
  * so the master can receive the computed workload
  *
  * Therefore, this class needs to be completely threadsafe.
+ *
+ * The undone work gets distributed by a work stealing scheduler,
+ * so faster devices automatically get more work.
  */
 template <typename T>
 class work_queue
@@ -25,24 +29,34 @@ class work_queue
 
 public:
 
+    /**
+     * @brief Registers a new worker.
+     *
+     * @param locality The locality of the worker's device
+     * @return The id of the worker
+     */
+    size_t add_worker(hpx::naming::id_type locality);
+
     /**
      * @brief Sends an undone workload to a worker.
      *
      * Gets called by the workers.
      *
+     * @param worker The id of the worker
      * @param wp Returns a workload that needs computation
      * @return False on end of work
      */
-    bool request(T* wp);
+    bool request(size_t worker, T* wp);
 
     /**
      * @brief Hands in a finished workload from a worker
      *
      * Gets called by the workers.
      *
+     * @param worker The id of the worker
      * @param done_workload The ready computed workload 
      */
-    void deliver(const T &done_workload);
+    void deliver(size_t worker, const T &done_workload);
 
     /**
      * @brief Adds undone workloads to the work pool.
@@ -77,7 +91,7 @@ public:
 
 private:
     // holds the undone work
-    fifo<T> unfinished_work;
+    hpx::opencl::work_scheduler<T> unfinished_work;
 
     // holds the done work
     fifo<T> finished_work;
@@ -103,6 +117,14 @@ work_queue<T>::work_queue()
     finished = false;
 }
 
+template<typename T>
+size_t work_queue<T>::add_worker(hpx::naming::id_type locality)
+{
+
+    return unfinished_work.add_worker(locality);
+
+}
+
 template<typename T>
 void work_queue<T>::add_work(const T &undone_workload)
 {
@@ -111,12 +133,12 @@ void work_queue<T>::add_work(const T &undone_workload)
     BOOST_ASSERT(!finished);
 
     // Add the workload packet
-    unfinished_work.push(undone_workload);
+    unfinished_work.add_work(undone_workload);
 
 }
 
 template<typename T>
-bool work_queue<T>::request(T* undone_workload)
+bool work_queue<T>::request(size_t worker, T* undone_workload)
 {
 
     // Store number of workloads that are currently active
@@ -124,7 +146,7 @@ bool work_queue<T>::request(T* undone_workload)
     num_work++;
 
     // get new work packet
-    if(!unfinished_work.pop(undone_workload))
+    if(!unfinished_work.request(worker, undone_workload))
     {
         // set input queue state to finished.
         // from now on we will only wait for returned packets.
@@ -151,9 +173,13 @@ bool work_queue<T>::request(T* undone_workload)
 }
 
 template<typename T>
-void work_queue<T>::deliver(const T &done_workload)
+void work_queue<T>::deliver(size_t worker, const T &done_workload)
 {
     num_delivered++;
+
+    // update the throughput measurement of the worker
+    unfinished_work.work_done(worker);
+
     // add to finished queue
     finished_work.push(done_workload);
 
@@ -18,6 +18,7 @@ workload::workload(size_t num_pixels_x_,
                    size_t pos_in_img_y_,
                    size_t line_offset_)
                    : pixeldata(boost::shared_ptr<std::vector<char>>()),
+                     img_data(boost::shared_ptr<std::vector<char>>()),
                      num_pixels_x(num_pixels_x_),
                      num_pixels_y(num_pixels_y_),
                      topleft_x(topleft_x_),
@@ -29,7 +30,10 @@ workload::workload(size_t num_pixels_x_,
                      img_id(img_id_),
                      pos_in_img_x(pos_in_img_x_),
                      pos_in_img_y(pos_in_img_y_),
-                     line_offset(line_offset_)
+                     line_offset(line_offset_),
+                     target_duration(0.0),
+                     request_time(0),
+                     occupancy(0)
                    {};
 
  
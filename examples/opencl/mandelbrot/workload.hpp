@@ -11,6 +11,7 @@
 
 #include <hpx/config.hpp>
 #include <boost/shared_ptr.hpp>
+#include <boost/cstdint.hpp>
 
 /*
  * A workload, defines a mandelbrot line and will be filled by workers with
@@ -33,8 +34,12 @@ class workload
                  size_t pos_in_img_y_,
                  size_t line_offset_);
         
-        // Will hold the calculated pixels
+        // Will hold the calculated pixels.
+        // stays empty if they got written to img_data directly.
         boost::shared_ptr<std::vector<char>> pixeldata;
+        // the final image. if set, workers write the calculated pixels
+        // directly to their position in the image.
+        boost::shared_ptr<std::vector<char>> img_data;
         // the number of pixels on the rectangle
         size_t num_pixels_x;
         size_t num_pixels_y;
@@ -52,6 +57,12 @@ class workload
         size_t pos_in_img_x;
         size_t pos_in_img_y;
         size_t line_offset;
+        // adaptive tiling: the targeted kernel duration in seconds.
+        // 0 for fixed tiles, that won't get split.
+        double target_duration;
+        // adaptive tiling: statistics for the tile controller
+        boost::uint64_t request_time;
+        size_t occupancy;
 
 };
 
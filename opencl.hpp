@@ -10,8 +10,15 @@
     #include "opencl/device.hpp"
     #include "opencl/event.hpp"
     #include "opencl/buffer.hpp"
+    #include "opencl/typed_buffer.hpp"
+    #include "opencl/halo_exchange.hpp"
+    #include "opencl/partitioned_buffer.hpp"
+    #include "opencl/svm_allocator.hpp"
     #include "opencl/program.hpp"
     #include "opencl/kernel.hpp"
+    #include "opencl/expression.hpp"
+    #include "opencl/algorithms.hpp"
+    #include "opencl/executor.hpp"
     #include "opencl/std.hpp"
 
 #endif
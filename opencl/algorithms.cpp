@@ -0,0 +1,103 @@
+// Copyright (c)    2014 Martin Stumpf
+//
+// Distributed under the Boost Software License, Version 1.0. (See accompanying
+// file LICENSE_1_0.txt or copy at http://www.boost.org/LICENSE_1_0.txt)
+
+#include "algorithms.hpp"
+
+#include "device_properties.hpp"
+
+#include <algorithm>
+#include <sstream>
+
+// The work group size the algorithms prefer.
+// CPU devices run a work group on one core, so smaller groups
+// distribute better over the cores.
+#define ALGORITHM_WORK_GROUP_SIZE_GPU 256
+#define ALGORITHM_WORK_GROUP_SIZE_CPU 64
+
+size_t
+hpx::opencl::detail::get_algorithm_work_group_size(
+                                        hpx::opencl::device device,
+                                        size_t local_bytes_per_item)
+{
+
+    hpx::opencl::device_properties props =
+                                        device.get_device_properties().get();
+
+    size_t max_size = (props.type & CL_DEVICE_TYPE_CPU)
+                    ? ALGORITHM_WORK_GROUP_SIZE_CPU
+                    : ALGORITHM_WORK_GROUP_SIZE_GPU;
+
+    // the limits of the device
+    if(props.max_work_group_size > 0)
+        max_size = std::min(max_size, props.max_work_group_size);
+    if(!props.max_work_item_sizes.empty() && props.max_work_item_sizes[0] > 0)
+        max_size = std::min(max_size, props.max_work_item_sizes[0]);
+
+    // the kernels rely on a power of two
+    size_t size = 1;
+    while(size * 2 <= max_size)
+        size *= 2;
+
+    // leave half of the local memory for the implementation
+    if(props.local_mem_size > 0)
+    {
+        while(size > 1 && size * local_bytes_per_item * 2
+                                                    > props.local_mem_size)
+            size /= 2;
+    }
+
+    return size;
+
+}
+
+std::vector<hpx::opencl::kernel>
+hpx::opencl::detail::get_algorithm_kernels(
+                                hpx::opencl::device device,
+                                size_t & wg,
+                                std::vector<std::string> const& sources,
+                                std::vector<std::string> const& kernel_names)
+{
+
+    BOOST_ASSERT(sources.size() == kernel_names.size());
+
+    while(true)
+    {
+
+        std::ostringstream build_options;
+        build_options << "-D WG=" << wg;
+
+        // build all kernels at once
+        std::vector<hpx::lcos::shared_future<hpx::opencl::kernel>> futures;
+        futures.reserve(sources.size());
+        for(size_t i = 0; i < sources.size(); i++)
+        {
+            futures.push_back(hpx::opencl::get_cached_kernel(device,
+                                                       sources[i],
+                                                       kernel_names[i],
+                                                       build_options.str()));
+        }
+
+        // the registers and local memory of a kernel can limit the work
+        // group size below the limit of the device
+        std::vector<hpx::opencl::kernel> kernels;
+        kernels.reserve(sources.size());
+        size_t supported_size = wg;
+        for(size_t i = 0; i < futures.size(); i++)
+        {
+            kernels.push_back(futures[i].get());
+            supported_size = std::min(supported_size,
+                                kernels.back().get_work_group_size().get());
+        }
+
+        if(supported_size >= wg || wg == 1)
+            return kernels;
+
+        // the kernels rely on a power of two
+        while(wg > 1 && wg > supported_size)
+            wg /= 2;
+
+    }
+
+}
@@ -0,0 +1,865 @@
+// Copyright (c)    2014 Martin Stumpf
+//
+// Distributed under the Boost Software License, Version 1.0. (See accompanying
+// file LICENSE_1_0.txt or copy at http://www.boost.org/LICENSE_1_0.txt)
+
+#pragma once
+#ifndef HPX_OPENCL_ALGORITHMS_HPP_
+#define HPX_OPENCL_ALGORITHMS_HPP_
+
+#include "export_definitions.hpp"
+
+#include <hpx/hpx.hpp>
+#include <hpx/config.hpp>
+#include <hpx/lcos/future.hpp>
+
+#include <CL/cl.h>
+
+#include <boost/shared_ptr.hpp>
+#include <boost/static_assert.hpp>
+#include <boost/type_traits/is_integral.hpp>
+
+#include <algorithm>
+#include <limits>
+#include <sstream>
+#include <string>
+#include <vector>
+
+#include "buffer.hpp"
+#include "device.hpp"
+#include "event.hpp"
+#include "kernel.hpp"
+#include "kernel_cache.hpp"
+#include "launch_desc.hpp"
+#include "work_size.hpp"
+#include "expression.hpp"
+
+////////////////////////////////////////////////////////////////
+/// Parallel algorithms on the device
+///
+/// All algorithms work on a range of elements of a \ref buffer, given by
+/// the index of the first element and the number of elements. The element
+/// type has to be given explicitly, as buffers are untyped.
+///
+/// The kernels get generated for the element type, the operator and the
+/// work group size of the device, and are built only once per device.
+///
+/// Example:
+/// \code{.cpp}
+///     // the maximum of 1000 floats, starting at element 10
+///     float max = hpx::opencl::reduce<float>(device, buf, 10, 1000,
+///                                     hpx::opencl::maximum<float>()).get();
+///
+///     // sorts the first 1000 elements in place
+///     hpx::opencl::radix_sort<cl_uint>(device, keys, 0, 1000).get().await();
+/// \endcode
+///
+namespace hpx {
+namespace opencl {
+
+    ////////////////////////
+    /// @brief Binary operators for \ref reduce and the scans
+    ///
+    /// get() returns the OpenCL C expression that combines a and b,
+    /// identity() the neutral element of the operator.
+    ///
+    template <typename T>
+    struct plus
+    {
+        static const char* get() { return "a + b"; }
+        static T identity() { return T(0); }
+    };
+
+    template <typename T>
+    struct multiplies
+    {
+        static const char* get() { return "a * b"; }
+        static T identity() { return T(1); }
+    };
+
+    template <typename T>
+    struct minimum
+    {
+        static const char* get() { return "min(a, b)"; }
+        static T identity() { return std::numeric_limits<T>::max(); }
+    };
+
+    template <typename T>
+    struct maximum
+    {
+        static const char* get() { return "max(a, b)"; }
+        static T identity()
+        {
+            return std::numeric_limits<T>::is_integer
+                 ? std::numeric_limits<T>::min()
+                 : -std::numeric_limits<T>::max();
+        }
+    };
+
+    namespace detail {
+
+        /**
+         *  @brief Chooses the work group size of the algorithm kernels
+         *
+         *  A power of two that fits the limits of the device, including
+         *  the local memory.
+         *
+         *  @param device               The device.
+         *  @param local_bytes_per_item The local memory every work item
+         *                              needs.
+         */
+        HPX_OPENCL_EXPORT size_t
+        get_algorithm_work_group_size(hpx::opencl::device device,
+                                      size_t local_bytes_per_item);
+
+        /**
+         *  @brief Builds the kernels of an algorithm
+         *
+         *  The work group size gets defined as WG by the build options.
+         *  If a built kernel doesn't support work groups of that size,
+         *  all kernels get built again with the largest power of two
+         *  that all of them support.
+         *
+         *  @param device       The device.
+         *  @param wg           The work group size to try first, a power
+         *                      of two. Returns the size the kernels got
+         *                      built for.
+         *  @param sources      The source of every kernel.
+         *  @param kernel_names The name of every kernel.
+         *  @return             The kernels, in the order of the sources.
+         */
+        HPX_OPENCL_EXPORT std::vector<hpx::opencl::kernel>
+        get_algorithm_kernels(hpx::opencl::device device,
+                              size_t & wg,
+                              std::vector<std::string> const& sources,
+                              std::vector<std::string> const& kernel_names);
+
+        // The start of every algorithm kernel.
+        // WG gets defined by get_algorithm_kernels.
+        template <typename T>
+        std::string kernel_preamble()
+        {
+            std::ostringstream code;
+            if(boost::is_same<T, cl_double>::value)
+                code << "#pragma OPENCL EXTENSION cl_khr_fp64 : enable\n";
+            code << "typedef " << cl_type_name<T>::get() << " value_type;\n";
+            return code.str();
+        }
+
+        // The combine() function and the IDENTITY of an operator
+        template <typename T, typename Op>
+        std::string operator_definition()
+        {
+            std::ostringstream code;
+            code << "value_type combine(value_type a, value_type b)\n"
+                 << "{ return " << Op::get() << "; }\n"
+                 << "#define IDENTITY (";
+            expression::write_literal(code, Op::identity());
+            code << ")\n";
+            return code.str();
+        }
+
+        // A launch of whole work groups
+        inline hpx::opencl::launch_desc
+        make_group_launch(size_t num_groups, size_t work_group_size)
+        {
+            hpx::opencl::work_size<1> dim;
+            dim[0].offset = 0;
+            dim[0].size = num_groups * work_group_size;
+            dim[0].local_size = work_group_size;
+            return hpx::opencl::launch_desc(dim);
+        }
+
+        inline size_t
+        num_groups_for(size_t count, size_t work_group_size)
+        {
+            return std::max<size_t>(1, (count + work_group_size - 1)
+                                                        / work_group_size);
+        }
+
+        ///////////////////////////////////////////////////
+        // Kernel sources
+        //
+
+        // Every work item reduces a strided part of the range, then the
+        // work group reduces in local memory. Writes one value per group.
+        static const char* const reduce_source =
+        "__kernel void hpx_opencl_reduce(__global value_type* out,          \n"
+        "                                __global const value_type* in,     \n"
+        "                                ulong first,                       \n"
+        "                                ulong count)                       \n"
+        "{                                                                  \n"
+        "    __local value_type scratch[WG];                                \n"
+        "                                                                   \n"
+        "    size_t lid = get_local_id(0);                                  \n"
+        "                                                                   \n"
+        "    value_type acc = IDENTITY;                                     \n"
+        "    for(ulong i = get_global_id(0); i < count;                     \n"
+        "                                    i += get_global_size(0))       \n"
+        "        acc = combine(acc, in[first + i]);                         \n"
+        "    scratch[lid] = acc;                                            \n"
+        "    barrier(CLK_LOCAL_MEM_FENCE);                                  \n"
+        "                                                                   \n"
+        "    for(size_t s = WG / 2; s > 0; s >>= 1)                         \n"
+        "    {                                                              \n"
+        "        if(lid < s)                                                \n"
+        "            scratch[lid] = combine(scratch[lid], scratch[lid + s]);\n"
+        "        barrier(CLK_LOCAL_MEM_FENCE);                              \n"
+        "    }                                                              \n"
+        "                                                                   \n"
+        "    if(lid == 0)                                                   \n"
+        "        out[get_group_id(0)] = scratch[0];                         \n"
+        "}                                                                  \n";
+
+        // Scans every block of WG elements in local memory and writes the
+        // total of every block. EXCLUSIVE gets defined in front of it.
+        static const char* const scan_blocks_source =
+        "__kernel void hpx_opencl_scan_blocks(__global value_type* out,     \n"
+        "                                     __global value_type* sums,    \n"
+        "                                     __global const value_type* in,\n"
+        "                                     ulong in_first,               \n"
+        "                                     ulong count,                  \n"
+        "                                     ulong out_first)              \n"
+        "{                                                                  \n"
+        "    __local value_type scratch[WG];                                \n"
+        "                                                                   \n"
+        "    size_t lid = get_local_id(0);                                  \n"
+        "    ulong i = get_global_id(0);                                    \n"
+        "                                                                   \n"
+        "    scratch[lid] = (i < count) ? in[in_first + i] : IDENTITY;      \n"
+        "    barrier(CLK_LOCAL_MEM_FENCE);                                  \n"
+        "                                                                   \n"
+        "    for(size_t offset = 1; offset < WG; offset <<= 1)              \n"
+        "    {                                                              \n"
+        "        value_type v = scratch[lid];                               \n"
+        "        if(lid >= offset)                                          \n"
+        "            v = combine(scratch[lid - offset], v);                 \n"
+        "        barrier(CLK_LOCAL_MEM_FENCE);                              \n"
+        "        scratch[lid] = v;                                          \n"
+        "        barrier(CLK_LOCAL_MEM_FENCE);                              \n"
+        "    }                                                              \n"
+        "                                                                   \n"
+        "    if(i < count)                                                  \n"
+        "    {                                                              \n"
+        "#if EXCLUSIVE                                                      \n"
+        "        out[out_first + i] = (lid == 0) ? IDENTITY                 \n"
+        "                                        : scratch[lid - 1];        \n"
+        "#else                                                              \n"
+        "        out[out_first + i] = scratch[lid];                         \n"
+        "#endif                                                             \n"
+        "    }                                                              \n"
+        "    if(lid == WG - 1)                                              \n"
+        "        sums[get_group_id(0)] = scratch[lid];                      \n"
+        "}                                                                  \n";
+
+        // Adds the scanned block totals to the blocks
+        static const char* const scan_add_source =
+        "__kernel void hpx_opencl_scan_add(__global value_type* out,        \n"
+        "                                  __global const value_type* sums, \n"
+        "                                  ulong count,                     \n"
+        "                                  ulong out_first)                 \n"
+        "{                                                                  \n"
+        "    ulong i = get_global_id(0);                                    \n"
+        "                                                                   \n"
+        "    if(i < count)                                                  \n"
+        "        out[out_first + i] = combine(sums[get_group_id(0)],        \n"
+        "                                     out[out_first + i]);          \n"
+        "}                                                                  \n";
+
+        // The radix sort works on the key bits with a flipped sign bit,
+        // so signed keys sort correctly as unsigned ones.
+        static const char* const radix_common_source =
+        "#define RADIX_BITS 4                                               \n"
+        "#define RADIX 16                                                   \n"
+        "#define TO_BITS(key) (((key_bits)(key)) ^ SIGN_BIT)                \n"
+        "#define FROM_BITS(bits) ((value_type)((bits) ^ SIGN_BIT))          \n"
+        "#define DIGIT(bits, shift) ((uint)(((bits) >> (shift)) & (RADIX - 1)))\n";
+
+        // Counts the digits of every block, bucket by bucket
+        static const char* const radix_histogram_source =
+        "__kernel void hpx_opencl_radix_histogram(__global uint* histogram, \n"
+        "                                   __global const value_type* keys,\n"
+        "                                   ulong first,                    \n"
+        "                                   ulong count,                    \n"
+        "                                   uint shift)                     \n"
+        "{                                                                  \n"
+        "    __local uint counts[RADIX];                                    \n"
+        "                                                                   \n"
+        "    size_t lid = get_local_id(0);                                  \n"
+        "    ulong i = get_global_id(0);                                    \n"
+        "                                                                   \n"
+        "    for(size_t d = lid; d < RADIX; d += WG)                        \n"
+        "        counts[d] = 0;                                             \n"
+        "    barrier(CLK_LOCAL_MEM_FENCE);                                  \n"
+        "                                                                   \n"
+        "    if(i < count)                                                  \n"
+        "        atomic_inc(&counts[DIGIT(TO_BITS(keys[first + i]), shift)]);\n"
+        "    barrier(CLK_LOCAL_MEM_FENCE);                                  \n"
+        "                                                                   \n"
+        "    for(size_t d = lid; d < RADIX; d += WG)                        \n"
+        "        histogram[d * get_num_groups(0) + get_group_id(0)] =       \n"
+        "                                                        counts[d]; \n"
+        "}                                                                  \n";
+
+        // Sorts every block by the digit in local memory, one bit at a
+        // time, then writes every key to its bucket
+        static const char* const radix_scatter_source =
+        "__kernel void hpx_opencl_radix_scatter(__global value_type* out,   \n"
+        "                                   __global const value_type* keys,\n"
+        "                                   __global const uint* offsets,   \n"
+        "                                   ulong first,                    \n"
+        "                                   ulong count,                    \n"
+        "                                   ulong out_first,                \n"
+        "                                   uint shift)                     \n"
+        "{                                                                  \n"
+        "    __local key_bits local_keys[WG];                               \n"
+        "    __local key_bits sorted_keys[WG];                              \n"
+        "    __local uint flags[WG];                                        \n"
+        "    __local uint starts[RADIX];                                    \n"
+        "                                                                   \n"
+        "    size_t lid = get_local_id(0);                                  \n"
+        "    ulong i = get_global_id(0);                                    \n"
+        "                                                                   \n"
+        "    // the padding sorts behind everything else                    \n"
+        "    local_keys[lid] = (i < count) ? TO_BITS(keys[first + i])       \n"
+        "                                  : ~((key_bits)0);                \n"
+        "    barrier(CLK_LOCAL_MEM_FENCE);                                  \n"
+        "                                                                   \n"
+        "    for(uint bit = 0; bit < RADIX_BITS; bit++)                     \n"
+        "    {                                                              \n"
+        "        key_bits key = local_keys[lid];                            \n"
+        "        uint is_zero = ((key >> (shift + bit)) & 1) ? 0 : 1;       \n"
+        "        flags[lid] = is_zero;                                      \n"
+        "        barrier(CLK_LOCAL_MEM_FENCE);                              \n"
+        "                                                                   \n"
+        "        for(size_t offset = 1; offset < WG; offset <<= 1)          \n"
+        "        {                                                          \n"
+        "            uint v = flags[lid];                                   \n"
+        "            if(lid >= offset)                                      \n"
+        "                v += flags[lid - offset];                          \n"
+        "            barrier(CLK_LOCAL_MEM_FENCE);                          \n"
+        "            flags[lid] = v;                                        \n"
+        "            barrier(CLK_LOCAL_MEM_FENCE);                          \n"
+        "        }                                                          \n"
+        "                                                                   \n"
+        "        uint zeros_before = flags[lid] - is_zero;                  \n"
+        "        uint total_zeros = flags[WG - 1];                          \n"
+        "        uint pos = is_zero ? zeros_before                          \n"
+        "                           : total_zeros + ((uint)lid - zeros_before);\n"
+        "        sorted_keys[pos] = key;                                    \n"
+        "        barrier(CLK_LOCAL_MEM_FENCE);                              \n"
+        "        local_keys[lid] = sorted_keys[lid];                        \n"
+        "        barrier(CLK_LOCAL_MEM_FENCE);                              \n"
+        "    }                                                              \n"
+        "                                                                   \n"
+        "    key_bits key = local_keys[lid];                                \n"
+        "    uint digit = DIGIT(key, shift);                                \n"
+        "    if(lid == 0 || digit != DIGIT(local_keys[lid - 1], shift))     \n"
+        "        starts[digit] = (uint)lid;                                 \n"
+        "    barrier(CLK_LOCAL_MEM_FENCE);                                  \n"
+        "                                                                   \n"
+        "    ulong valid = count - get_group_id(0) * WG;                    \n"
+        "    if(lid < valid)                                                \n"
+        "    {                                                              \n"
+        "        uint dst = offsets[digit * get_num_groups(0)               \n"
+        "                           + get_group_id(0)]                      \n"
+        "                 + ((uint)lid - starts[digit]);                    \n"
+        "        out[out_first + dst] = FROM_BITS(key);                     \n"
+        "    }                                                              \n"
+        "}                                                                  \n";
+
+        // Applies an expression in x to every element
+        static const char* const transform_source =
+        "__kernel void hpx_opencl_transform(__global out_type* out,         \n"
+        "                                   __global const value_type* in,  \n"
+        "                                   ulong in_first,                 \n"
+        "                                   ulong count,                    \n"
+        "                                   ulong out_first)                \n"
+        "{                                                                  \n"
+        "    ulong i = get_global_id(0);                                    \n"
+        "                                                                   \n"
+        "    if(i < count)                                                  \n"
+        "    {                                                              \n"
+        "        value_type x = in[in_first + i];                           \n"
+        "        out[out_first + i] = (out_type)(TRANSFORM);                \n"
+        "    }                                                              \n"
+        "}                                                                  \n";
+
+        ///////////////////////////////////////////////////
+        // Implementations, they run as HPX threads and only wait for
+        // the enqueue calls, except where results get read back
+        //
+
+        template <typename T, typename Op>
+        T reduce_impl(hpx::opencl::device device,
+                      hpx::opencl::buffer input,
+                      size_t first,
+                      size_t count,
+                      std::vector<hpx::lcos::shared_future<hpx::opencl::event> >
+                                                                dependencies)
+        {
+
+            size_t wg = get_algorithm_work_group_size(device, sizeof(T));
+
+            std::vector<std::string> sources;
+            std::vector<std::string> kernel_names;
+            sources.push_back(kernel_preamble<T>()
+                              + operator_definition<T, Op>()
+                              + reduce_source);
+            kernel_names.push_back("hpx_opencl_reduce");
+            hpx::opencl::kernel kernel =
+                get_algorithm_kernels(device, wg, sources, kernel_names)[0];
+
+            // the first pass leaves at most one value per work item of
+            // the second pass
+            size_t num_groups = std::min(num_groups_for(count, wg), wg);
+
+            hpx::opencl::buffer partials = device.create_buffer(
+                                CL_MEM_READ_WRITE, num_groups * sizeof(T));
+            hpx::opencl::buffer result = device.create_buffer(
+                                CL_MEM_READ_WRITE, sizeof(T));
+
+            hpx::opencl::launch_desc launch1 = make_group_launch(num_groups, wg);
+            launch1.set_arg(0, partials);
+            launch1.set_arg(1, input);
+            launch1.set_arg_value(2, (cl_ulong) first);
+            launch1.set_arg_value(3, (cl_ulong) count);
+            hpx::opencl::event pass1 =
+                            kernel.enqueue_launch(launch1, dependencies).get();
+
+            hpx::opencl::launch_desc launch2 = make_group_launch(1, wg);
+            launch2.set_arg(0, result);
+            launch2.set_arg(1, partials);
+            launch2.set_arg_value(2, (cl_ulong) 0);
+            launch2.set_arg_value(3, (cl_ulong) num_groups);
+            hpx::opencl::event pass2 =
+                            kernel.enqueue_launch(launch2, pass1).get();
+
+            boost::shared_ptr<std::vector<char> > data =
+                result.enqueue_read(0, sizeof(T), pass2).get().get_data().get();
+
+            return *reinterpret_cast<const T*>(data->data());
+
+        }
+
+        template <typename T, typename Op>
+        hpx::opencl::event
+        scan_impl(hpx::opencl::device device,
+                  hpx::opencl::buffer input,
+                  size_t in_first,
+                  size_t count,
+                  hpx::opencl::buffer output,
+                  size_t out_first,
+                  bool exclusive,
+                  std::vector<hpx::lcos::shared_future<hpx::opencl::event> >
+                                                                dependencies)
+        {
+
+            size_t wg = get_algorithm_work_group_size(device, sizeof(T));
+
+            std::string common = kernel_preamble<T>()
+                               + operator_definition<T, Op>();
+
+            // both kernels need the same work group size
+            std::vector<std::string> sources;
+            std::vector<std::string> kernel_names;
+            sources.push_back(common
+                              + (exclusive ? "#define EXCLUSIVE 1\n"
+                                           : "#define EXCLUSIVE 0\n")
+                              + scan_blocks_source);
+            kernel_names.push_back("hpx_opencl_scan_blocks");
+            sources.push_back(common + scan_add_source);
+            kernel_names.push_back("hpx_opencl_scan_add");
+            std::vector<hpx::opencl::kernel> kernels =
+                get_algorithm_kernels(device, wg, sources, kernel_names);
+
+            size_t num_blocks = num_groups_for(count, wg);
+
+            hpx::opencl::buffer sums = device.create_buffer(
+                                CL_MEM_READ_WRITE, num_blocks * sizeof(T));
+
+            // scan every block
+            hpx::opencl::launch_desc blocks_launch =
+                                        make_group_launch(num_blocks, wg);
+            blocks_launch.set_arg(0, output);
+            blocks_launch.set_arg(1, sums);
+            blocks_launch.set_arg(2, input);
+            blocks_launch.set_arg_value(3, (cl_ulong) in_first);
+            blocks_launch.set_arg_value(4, (cl_ulong) count);
+            blocks_launch.set_arg_value(5, (cl_ulong) out_first);
+            hpx::opencl::event blocks_done = kernels[0]
+                            .enqueue_launch(blocks_launch, dependencies).get();
+
+            if(num_blocks == 1)
+                return blocks_done;
+
+            // the offsets of the blocks
+            std::vector<hpx::lcos::shared_future<hpx::opencl::event> >
+                                                            sums_dependencies;
+            sums_dependencies.push_back(
+                        hpx::lcos::make_ready_future(blocks_done));
+            hpx::opencl::event sums_done =
+                scan_impl<T, Op>(device, sums, 0, num_blocks, sums, 0, true,
+                                 sums_dependencies);
+
+            // add them to the blocks
+            hpx::opencl::launch_desc add_launch =
+                                        make_group_launch(num_blocks, wg);
+            add_launch.set_arg(0, output);
+            add_launch.set_arg(1, sums);
+            add_launch.set_arg_value(2, (cl_ulong) count);
+            add_launch.set_arg_value(3, (cl_ulong) out_first);
+            return kernels[1].enqueue_launch(add_launch, sums_done).get();
+
+        }
+
+        template <typename T>
+        std::string radix_key_definition()
+        {
+            BOOST_STATIC_ASSERT(boost::is_integral<T>::value);
+            BOOST_STATIC_ASSERT(sizeof(T) == 4 || sizeof(T) == 8);
+
+            std::ostringstream code;
+            code << "typedef " << (sizeof(T) == 8 ? "ulong" : "uint")
+                 << " key_bits;\n"
+                 << "#define SIGN_BIT ";
+            if(std::numeric_limits<T>::is_signed)
+                code << "(((key_bits)1) << " << (sizeof(T) * 8 - 1) << ")\n";
+            else
+                code << "((key_bits)0)\n";
+            code << radix_common_source;
+            return code.str();
+        }
+
+        template <typename T>
+        hpx::opencl::event
+        radix_sort_impl(hpx::opencl::device device,
+                        hpx::opencl::buffer data,
+                        size_t first,
+                        size_t count,
+                        std::vector<hpx::lcos::shared_future<hpx::opencl::event> >
+                                                                dependencies)
+        {
+
+            // the scatter kernel needs two keys and a flag per work item
+            size_t wg = get_algorithm_work_group_size(device,
+                                               2 * sizeof(T) + sizeof(cl_uint));
+
+            std::string common = kernel_preamble<T>()
+                               + radix_key_definition<T>();
+
+            // both kernels need the same work group size
+            std::vector<std::string> sources;
+            std::vector<std::string> kernel_names;
+            sources.push_back(common + radix_histogram_source);
+            kernel_names.push_back("hpx_opencl_radix_histogram");
+            sources.push_back(common + radix_scatter_source);
+            kernel_names.push_back("hpx_opencl_radix_scatter");
+            std::vector<hpx::opencl::kernel> kernels =
+                get_algorithm_kernels(device, wg, sources, kernel_names);
+
+            static const size_t radix = 16;
+            static const size_t num_passes = sizeof(T) * 8 / 4;
+
+            size_t num_blocks = num_groups_for(count, wg);
+
+            hpx::opencl::buffer temp = device.create_buffer(
+                            CL_MEM_READ_WRITE, std::max<size_t>(count, 1)
+                                                                * sizeof(T));
+            hpx::opencl::buffer histogram = device.create_buffer(
+                            CL_MEM_READ_WRITE, radix * num_blocks
+                                                            * sizeof(cl_uint));
+
+            // every pass moves the keys to the other buffer. the number
+            // of passes is even, so they end up where they started.
+            hpx::opencl::buffer src = data;
+            size_t src_first = first;
+            hpx::opencl::buffer dst = temp;
+            size_t dst_first = 0;
+
+            std::vector<hpx::lcos::shared_future<hpx::opencl::event> >
+                                                    pass_dependencies = dependencies;
+            hpx::opencl::event pass_done;
+            for(size_t pass = 0; pass < num_passes; pass++)
+            {
+
+                // count the digits
+                hpx::opencl::launch_desc histogram_launch =
+                                        make_group_launch(num_blocks, wg);
+                histogram_launch.set_arg(0, histogram);
+                histogram_launch.set_arg(1, src);
+                histogram_launch.set_arg_value(2, (cl_ulong) src_first);
+                histogram_launch.set_arg_value(3, (cl_ulong) count);
+                histogram_launch.set_arg_value(4, (cl_uint) (pass * 4));
+                hpx::opencl::event histogram_done = kernels[0]
+                        .enqueue_launch(histogram_launch, pass_dependencies)
+                        .get();
+
+                // the target position of every bucket of every block
+                std::vector<hpx::lcos::shared_future<hpx::opencl::event> >
+                                                        scan_dependencies;
+                scan_dependencies.push_back(
+                            hpx::lcos::make_ready_future(histogram_done));
+                hpx::opencl::event scan_done =
+                    scan_impl<cl_uint, plus<cl_uint> >(device,
+                                            histogram, 0, radix * num_blocks,
+                                            histogram, 0, true,
+                                            scan_dependencies);
+
+                // move the keys
+                hpx::opencl::launch_desc scatter_launch =
+                                        make_group_launch(num_blocks, wg);
+                scatter_launch.set_arg(0, dst);
+                scatter_launch.set_arg(1, src);
+                scatter_launch.set_arg(2, histogram);
+                scatter_launch.set_arg_value(3, (cl_ulong) src_first);
+                scatter_launch.set_arg_value(4, (cl_ulong) count);
+                scatter_launch.set_arg_value(5, (cl_ulong) dst_first);
+                scatter_launch.set_arg_value(6, (cl_uint) (pass * 4));
+                pass_done = kernels[1]
+                        .enqueue_launch(scatter_launch, scan_done).get();
+
+                pass_dependencies.clear();
+                pass_dependencies.push_back(
+                            hpx::lcos::make_ready_future(pass_done));
+
+                std::swap(src, dst);
+                std::swap(src_first, dst_first);
+
+            }
+
+            return pass_done;
+
+        }
+
+        template <typename T, typename U>
+        hpx::opencl::event
+        transform_impl(hpx::opencl::device device,
+                       hpx::opencl::buffer input,
+                       size_t in_first,
+                       size_t count,
+                       hpx::opencl::buffer output,
+                       size_t out_first,
+                       std::string op,
+                       std::vector<hpx::lcos::shared_future<hpx::opencl::event> >
+                                                                dependencies)
+        {
+
+            size_t wg = get_algorithm_work_group_size(device, 0);
+
+            std::ostringstream source;
+            if(boost::is_same<U, cl_double>::value
+                && !boost::is_same<T, cl_double>::value)
+                source << "#pragma OPENCL EXTENSION cl_khr_fp64 : enable\n";
+            source << kernel_preamble<T>()
+                   << "typedef " << cl_type_name<U>::get() << " out_type;\n"
+                   << "#define TRANSFORM " << op << "\n"
+                   << transform_source;
+
+            std::vector<std::string> sources;
+            std::vector<std::string> kernel_names;
+            sources.push_back(source.str());
+            kernel_names.push_back("hpx_opencl_transform");
+            hpx::opencl::kernel kernel =
+                get_algorithm_kernels(device, wg, sources, kernel_names)[0];
+
+            hpx::opencl::launch_desc launch =
+                        make_group_launch(num_groups_for(count, wg), wg);
+            launch.set_arg(0, output);
+            launch.set_arg(1, input);
+            launch.set_arg_value(2, (cl_ulong) in_first);
+            launch.set_arg_value(3, (cl_ulong) count);
+            launch.set_arg_value(4, (cl_ulong) out_first);
+
+            return kernel.enqueue_launch(launch, dependencies).get();
+
+        }
+
+    }
+
+    /**
+     *  @brief Combines all elements of a range
+     *
+     *  The operator needs to be associative and commutative, the
+     *  elements get combined in no particular order.
+     *
+     *  @tparam T           The element type.
+     *  @param device       The device of the buffer.
+     *  @param input        The buffer.
+     *  @param first        The index of the first element.
+     *  @param count        The number of elements.
+     *  @param op           The operator, e.g. \ref plus or \ref maximum.
+     *  @param dependencies The events to wait for.
+     *  @return             The result.
+     */
+    template <typename T, typename Op>
+    hpx::lcos::future<T>
+    reduce(hpx::opencl::device device, hpx::opencl::buffer input,
+           size_t first, size_t count, Op op,
+           std::vector<hpx::lcos::shared_future<hpx::opencl::event> >
+                dependencies =
+           std::vector<hpx::lcos::shared_future<hpx::opencl::event> >())
+    {
+        return hpx::async(&detail::reduce_impl<T, Op>, device, input,
+                          first, count, dependencies);
+    }
+
+    /**
+     *  @brief Sums up all elements of a range
+     */
+    template <typename T>
+    hpx::lcos::future<T>
+    reduce(hpx::opencl::device device, hpx::opencl::buffer input,
+           size_t first, size_t count,
+           std::vector<hpx::lcos::shared_future<hpx::opencl::event> >
+                dependencies =
+           std::vector<hpx::lcos::shared_future<hpx::opencl::event> >())
+    {
+        return reduce<T>(device, input, first, count, plus<T>(),
+                         dependencies);
+    }
+
+    /**
+     *  @brief Computes the inclusive prefix combination of a range
+     *
+     *  Element i of the output is the combination of the input elements
+     *  0 to i. The operator needs to be associative. Input and output
+     *  may be the same range.
+     *
+     *  @tparam T           The element type.
+     *  @param device       The device of the buffers.
+     *  @param input        The input buffer.
+     *  @param in_first     The index of the first input element.
+     *  @param count        The number of elements.
+     *  @param output       The output buffer.
+     *  @param out_first    The index of the first output element.
+     *  @param op           The operator, e.g. \ref plus.
+     *  @param dependencies The events to wait for.
+     *  @return             An \ref event that triggers upon completion.
+     */
+    template <typename T, typename Op>
+    hpx::lcos::future<hpx::opencl::event>
+    inclusive_scan(hpx::opencl::device device,
+                   hpx::opencl::buffer input, size_t in_first, size_t count,
+                   hpx::opencl::buffer output, size_t out_first, Op op,
+                   std::vector<hpx::lcos::shared_future<hpx::opencl::event> >
+                        dependencies =
+                   std::vector<hpx::lcos::shared_future<hpx::opencl::event> >())
+    {
+        return hpx::async(&detail::scan_impl<T, Op>, device, input, in_first,
+                          count, output, out_first, false, dependencies);
+    }
+
+    /**
+     *  @brief Computes the inclusive prefix sum of a range
+     */
+    template <typename T>
+    hpx::lcos::future<hpx::opencl::event>
+    inclusive_scan(hpx::opencl::device device,
+                   hpx::opencl::buffer input, size_t in_first, size_t count,
+                   hpx::opencl::buffer output, size_t out_first,
+                   std::vector<hpx::lcos::shared_future<hpx::opencl::event> >
+                        dependencies =
+                   std::vector<hpx::lcos::shared_future<hpx::opencl::event> >())
+    {
+        return inclusive_scan<T>(device, input, in_first, count, output,
+                                 out_first, plus<T>(), dependencies);
+    }
+
+    /**
+     *  @brief Computes the exclusive prefix combination of a range
+     *
+     *  Element i of the output is the combination of the input elements
+     *  0 to i-1, element 0 is the identity of the operator.
+     *  Otherwise the same as \ref inclusive_scan.
+     */
+    template <typename T, typename Op>
+    hpx::lcos::future<hpx::opencl::event>
+    exclusive_scan(hpx::opencl::device device,
+                   hpx::opencl::buffer input, size_t in_first, size_t count,
+                   hpx::opencl::buffer output, size_t out_first, Op op,
+                   std::vector<hpx::lcos::shared_future<hpx::opencl::event> >
+                        dependencies =
+                   std::vector<hpx::lcos::shared_future<hpx::opencl::event> >())
+    {
+        return hpx::async(&detail::scan_impl<T, Op>, device, input, in_first,
+                          count, output, out_first, true, dependencies);
+    }
+
+    /**
+     *  @brief Computes the exclusive prefix sum of a range
+     */
+    template <typename T>
+    hpx::lcos::future<hpx::opencl::event>
+    exclusive_scan(hpx::opencl::device device,
+                   hpx::opencl::buffer input, size_t in_first, size_t count,
+                   hpx::opencl::buffer output, size_t out_first,
+                   std::vector<hpx::lcos::shared_future<hpx::opencl::event> >
+                        dependencies =
+                   std::vector<hpx::lcos::shared_future<hpx::opencl::event> >())
+    {
+        return exclusive_scan<T>(device, input, in_first, count, output,
+                                 out_first, plus<T>(), dependencies);
+    }
+
+    /**
+     *  @brief Sorts a range of integers in place
+     *
+     *  A stable least significant digit radix sort, four bits per pass.
+     *  Works for 32 and 64 bit integers, signed and unsigned.
+     *  The range may contain at most 2^32 - 1 elements.
+     *
+     *  @tparam T           The element type.
+     *  @param device       The device of the buffer.
+     *  @param data         The buffer.
+     *  @param first        The index of the first element.
+     *  @param count        The number of elements.
+     *  @param dependencies The events to wait for.
+     *  @return             An \ref event that triggers upon completion.
+     */
+    template <typename T>
+    hpx::lcos::future<hpx::opencl::event>
+    radix_sort(hpx::opencl::device device, hpx::opencl::buffer data,
+               size_t first, size_t count,
+               std::vector<hpx::lcos::shared_future<hpx::opencl::event> >
+                    dependencies =
+               std::vector<hpx::lcos::shared_future<hpx::opencl::event> >())
+    {
+        return hpx::async(&detail::radix_sort_impl<T>, device, data, first,
+                          count, dependencies);
+    }
+
+    /**
+     *  @brief Applies an expression to every element of a range
+     *
+     *  @tparam T           The input element type.
+     *  @tparam U           The output element type.
+     *  @param device       The device of the buffers.
+     *  @param input        The input buffer.
+     *  @param in_first     The index of the first input element.
+     *  @param count        The number of elements.
+     *  @param output       The output buffer.
+     *  @param out_first    The index of the first output element.
+     *  @param op           An OpenCL C expression of the input element x,
+     *                      e.g. "x * x + 1.0f".
+     *  @param dependencies The events to wait for.
+     *  @return             An \ref event that triggers upon completion.
+     */
+    template <typename T, typename U>
+    hpx::lcos::future<hpx::opencl::event>
+    transform(hpx::opencl::device device,
+              hpx::opencl::buffer input, size_t in_first, size_t count,
+              hpx::opencl::buffer output, size_t out_first,
+              std::string const& op,
+              std::vector<hpx::lcos::shared_future<hpx::opencl::event> >
+                   dependencies =
+              std::vector<hpx::lcos::shared_future<hpx::opencl::event> >())
+    {
+        return hpx::async(&detail::transform_impl<T, U>, device, input,
+                          in_first, count, output, out_first, op,
+                          dependencies);
+    }
+
+}}
+
+#endif
@@ -12,11 +12,18 @@
 #include <hpx/util/portable_binary_oarchive.hpp>
 #include <boost/serialization/vector.hpp>
 
+#include "device.hpp"
 #include "event.hpp"
 
 #include "enqueue_overloads.hpp"
+#include "tools.hpp"
+
+#include <hpx/runtime/get_ptr.hpp>
+
+#include <cstring>
 
 using hpx::opencl::buffer;
+using hpx::opencl::is_local;
 
 
 
@@ -58,6 +65,10 @@ HPX_OPENCL_OVERLOAD_FUNCTION(buffer, enqueue_copy,
                              size_t dst_offset COMMA size_t size,
                              src COMMA src_offset COMMA dst_offset COMMA size);
 
+HPX_OPENCL_OVERLOAD_FUNCTION(buffer, migrate_to,
+                             hpx::opencl::device target,
+                             target);
+
 
 
 
@@ -140,4 +151,343 @@ buffer::enqueue_copy(buffer src, size_t src_offset, size_t dst_offset,
 
 }
 
+hpx::lcos::future<hpx::opencl::event>
+buffer::migrate_to(hpx::opencl::device target,
+                   std::vector<hpx::opencl::event> events) const
+{
+    BOOST_ASSERT(this->get_gid());
+    BOOST_ASSERT(target.get_gid());
+
+    // Run migrate_action
+    typedef hpx::opencl::server::buffer::migrate_action func;
+    return hpx::async<func>(this->get_gid(), target.get_gid(), events);
+
+}
+
+// Waits for the data of a migration, the buffer stays the same
+static buffer
+move_to_local_callback(buffer cl,
+                       hpx::lcos::future<hpx::opencl::event> event_future)
+{
+    event_future.get().await();
+    return cl;
+}
+
+// Creates the client of the new buffer, the data arrived already
+static buffer
+move_to_remote_callback(hpx::lcos::future<hpx::naming::id_type> gid_future)
+{
+    return buffer(hpx::lcos::make_ready_future(gid_future.get()));
+}
+
+hpx::lcos::future<buffer>
+buffer::move_to(hpx::opencl::device target,
+                std::vector<hpx::opencl::event> events) const
+{
+    BOOST_ASSERT(this->get_gid());
+    BOOST_ASSERT(target.get_gid());
+
+    // The buffer can follow devices on its own locality
+    if(hpx::naming::get_locality_id_from_gid(target.get_gid().get_gid())
+       == hpx::naming::get_locality_id_from_gid(this->get_gid().get_gid()))
+    {
+        return migrate_to(target, events).then(
+                    hpx::util::bind(&move_to_local_callback, *this,
+                                    hpx::util::placeholders::_1));
+    }
+
+    // Run migrate_remote_action
+    typedef hpx::opencl::server::buffer::migrate_remote_action func;
+    return hpx::async<func>(this->get_gid(), target.get_gid(), events).then(
+                    hpx::util::bind(&move_to_remote_callback,
+                                    hpx::util::placeholders::_1));
+
+}
+
+
+
+// ///////////////////////////////////////////////////////
+//  EVENT-LESS FUNCTION DEFINITIONS
+//
+
+// Rethrows exceptions of dependencies
+static void
+check_dependencies(hpx::lcos::future<std::vector<
+                        hpx::lcos::shared_future<void>
+                                                 >> & futures)
+{
+    std::vector<hpx::lcos::shared_future<void>> futures_list = futures.get();
+    BOOST_FOREACH(hpx::lcos::shared_future<void> & future, futures_list)
+    {
+        future.get();
+    }
+}
+
+// Fetches the data of a remote read
+static hpx::lcos::future<boost::shared_ptr<std::vector<char>>>
+enqueue_read_async_event_callback(hpx::lcos::future<hpx::opencl::event> event)
+{
+    return event.get().get_data();
+}
+
+// Waits for a remote write
+static hpx::lcos::future<void>
+enqueue_write_async_event_callback(hpx::lcos::future<hpx::opencl::event> event)
+{
+    return event.get().get_future();
+}
+
+static hpx::lcos::future<boost::shared_ptr<std::vector<char>>>
+enqueue_read_async_callback(buffer cl, size_t offset, size_t size,
+                            hpx::lcos::future<std::vector<
+                                hpx::lcos::shared_future<void>
+                                                         >> futures)
+{
+    check_dependencies(futures);
+    return cl.enqueue_read_async(offset, size);
+}
+
+static hpx::lcos::future<void>
+enqueue_write_async_callback(buffer cl, size_t offset, size_t size,
+                             const void* data,
+                             hpx::lcos::future<std::vector<
+                                hpx::lcos::shared_future<void>
+                                                          >> futures)
+{
+    check_dependencies(futures);
+    return cl.enqueue_write_async(offset, size, data);
+}
+
+hpx::lcos::future<boost::shared_ptr<std::vector<char>>>
+buffer::enqueue_read_async(size_t offset, size_t size) const
+{
+
+    BOOST_ASSERT(this->get_gid());
+
+    // Local buffers don't need an event component
+    if(is_local(this->get_gid()))
+    {
+        boost::shared_ptr<hpx::opencl::server::buffer> buffer_server =
+                hpx::get_ptr<hpx::opencl::server::buffer>(this->get_gid()).get();
+
+        return buffer_server->read_local(offset, size);
+    }
+
+    // Remote buffers send their data via the event component
+    return enqueue_read(offset, size).then(
+                    hpx::util::bind(&enqueue_read_async_event_callback,
+                                    hpx::util::placeholders::_1));
+
+}
+
+hpx::lcos::future<boost::shared_ptr<std::vector<char>>>
+buffer::enqueue_read_async(size_t offset, size_t size,
+               std::vector<hpx::lcos::shared_future<void>> dependencies) const
+{
+
+    return hpx::when_all(dependencies).then(
+        hpx::util::bind(
+            &enqueue_read_async_callback,
+            *this,
+            offset,
+            size,
+            hpx::util::placeholders::_1
+        )
+    );
+
+}
+
+hpx::lcos::future<void>
+buffer::enqueue_write_async(size_t offset, size_t size, const void* data) const
+{
+
+    BOOST_ASSERT(this->get_gid());
+
+    // Local buffers don't need an event component
+    if(is_local(this->get_gid()))
+    {
+        boost::shared_ptr<hpx::opencl::server::buffer> buffer_server =
+                hpx::get_ptr<hpx::opencl::server::buffer>(this->get_gid()).get();
+
+        // Make data pointer serializable
+        hpx::util::serialize_buffer<char>
+        serializable_data((char*)const_cast<void*>(data), size,
+                hpx::util::serialize_buffer<char>::init_mode::reference);
+
+        return buffer_server->write_local(offset, serializable_data);
+    }
+
+    // Remote buffers need an event component to wait for
+    return enqueue_write(offset, size, data).then(
+                    hpx::util::bind(&enqueue_write_async_event_callback,
+                                    hpx::util::placeholders::_1));
+
+}
+
+hpx::lcos::future<void>
+buffer::enqueue_write_async(size_t offset, size_t size, const void* data,
+               std::vector<hpx::lcos::shared_future<void>> dependencies) const
+{
+
+    return hpx::when_all(dependencies).then(
+        hpx::util::bind(
+            &enqueue_write_async_callback,
+            *this,
+            offset,
+            size,
+            data,
+            hpx::util::placeholders::_1
+        )
+    );
+
+}
+
+
+
+// ///////////////////////////////////////////////////////
+//  READ-TO-HOST-MEMORY FUNCTION DEFINITIONS
+//
+
+// Copies the rows of a remote read to their destination
+static void
+enqueue_read_rect_to_copy_callback(size_t row_size, size_t num_rows,
+                    size_t src_row_pitch, char* dst, size_t dst_row_pitch,
+                    hpx::lcos::future<boost::shared_ptr<std::vector<char>>>
+                                                                      data_future)
+{
+    boost::shared_ptr<std::vector<char>> data = data_future.get();
+    BOOST_ASSERT(data->size() >= (num_rows - 1) * src_row_pitch + row_size);
+
+    for(size_t row = 0; row < num_rows; row++)
+    {
+        std::memcpy(dst + row * dst_row_pitch,
+                    data->data() + row * src_row_pitch,
+                    row_size);
+    }
+}
+
+static hpx::lcos::future<void>
+enqueue_read_to_future_single_callback(buffer cl, size_t offset, size_t size,
+                    void* dst,
+                    hpx::lcos::shared_future<hpx::opencl::event> event)
+{
+    std::vector<hpx::opencl::event> events;
+    events.push_back(event.get());
+    return cl.enqueue_read_to(offset, size, dst, events);
+}
+
+static hpx::lcos::future<void>
+enqueue_read_rect_to_future_single_callback(buffer cl, size_t offset,
+                    size_t row_size, size_t num_rows, size_t buffer_row_pitch,
+                    void* dst, size_t dst_row_pitch,
+                    hpx::lcos::shared_future<hpx::opencl::event> event)
+{
+    std::vector<hpx::opencl::event> events;
+    events.push_back(event.get());
+    return cl.enqueue_read_rect_to(offset, row_size, num_rows,
+                                   buffer_row_pitch, dst, dst_row_pitch,
+                                   events);
+}
 
+hpx::lcos::future<void>
+buffer::enqueue_read_to(size_t offset, size_t size, void* dst) const
+{
+    std::vector<hpx::opencl::event> events(0);
+    return enqueue_read_to(offset, size, dst, events);
+}
+
+hpx::lcos::future<void>
+buffer::enqueue_read_to(size_t offset, size_t size, void* dst,
+                        std::vector<hpx::opencl::event> events) const
+{
+
+    BOOST_ASSERT(this->get_gid());
+
+    // Local buffers read directly to the destination
+    if(is_local(this->get_gid()))
+    {
+        boost::shared_ptr<hpx::opencl::server::buffer> buffer_server =
+                hpx::get_ptr<hpx::opencl::server::buffer>(this->get_gid()).get();
+
+        return buffer_server->read_to_local(offset, size, dst, events);
+    }
+
+    // Remote buffers send their data via the event component
+    return enqueue_read(offset, size, events).then(
+                    hpx::util::bind(&enqueue_read_async_event_callback,
+                                    hpx::util::placeholders::_1)
+                ).then(
+                    hpx::util::bind(&enqueue_read_rect_to_copy_callback,
+                                    size, 1, size, (char*)dst, size,
+                                    hpx::util::placeholders::_1));
+
+}
+
+hpx::lcos::future<void>
+buffer::enqueue_read_to(size_t offset, size_t size, void* dst,
+                  hpx::lcos::shared_future<hpx::opencl::event> event) const
+{
+    return event.then(
+            hpx::util::bind(&enqueue_read_to_future_single_callback,
+                            *this, offset, size, dst,
+                            hpx::util::placeholders::_1));
+}
+
+hpx::lcos::future<void>
+buffer::enqueue_read_rect_to(size_t offset, size_t row_size,
+                             size_t num_rows, size_t buffer_row_pitch,
+                             void* dst, size_t dst_row_pitch) const
+{
+    std::vector<hpx::opencl::event> events(0);
+    return enqueue_read_rect_to(offset, row_size, num_rows, buffer_row_pitch,
+                                dst, dst_row_pitch, events);
+}
+
+hpx::lcos::future<void>
+buffer::enqueue_read_rect_to(size_t offset, size_t row_size,
+                             size_t num_rows, size_t buffer_row_pitch,
+                             void* dst, size_t dst_row_pitch,
+                             std::vector<hpx::opencl::event> events) const
+{
+
+    BOOST_ASSERT(this->get_gid());
+    BOOST_ASSERT(num_rows > 0);
+    BOOST_ASSERT(buffer_row_pitch >= row_size && dst_row_pitch >= row_size);
+
+    // Local buffers read directly to the destination
+    if(is_local(this->get_gid()))
+    {
+        boost::shared_ptr<hpx::opencl::server::buffer> buffer_server =
+                hpx::get_ptr<hpx::opencl::server::buffer>(this->get_gid()).get();
+
+        return buffer_server->read_rect_to_local(offset, row_size, num_rows,
+                                                 buffer_row_pitch, dst,
+                                                 dst_row_pitch, events);
+    }
+
+    // Remote buffers send the whole area, including the gaps between
+    // the rows, and get copied row by row
+    size_t size = (num_rows - 1) * buffer_row_pitch + row_size;
+    return enqueue_read(offset, size, events).then(
+                    hpx::util::bind(&enqueue_read_async_event_callback,
+                                    hpx::util::placeholders::_1)
+                ).then(
+                    hpx::util::bind(&enqueue_read_rect_to_copy_callback,
+                                    row_size, num_rows, buffer_row_pitch,
+                                    (char*)dst, dst_row_pitch,
+                                    hpx::util::placeholders::_1));
+
+}
+
+hpx::lcos::future<void>
+buffer::enqueue_read_rect_to(size_t offset, size_t row_size,
+                             size_t num_rows, size_t buffer_row_pitch,
+                             void* dst, size_t dst_row_pitch,
+                  hpx::lcos::shared_future<hpx::opencl::event> event) const
+{
+    return event.then(
+            hpx::util::bind(&enqueue_read_rect_to_future_single_callback,
+                            *this, offset, row_size, num_rows,
+                            buffer_row_pitch, dst, dst_row_pitch,
+                            hpx::util::placeholders::_1));
+}
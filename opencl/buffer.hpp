@@ -208,6 +208,175 @@ namespace opencl {
             enqueue_write(size_t offset, size_t size, const void* data,
                std::vector<hpx::lcos::shared_future<hpx::opencl::event>> events) const;
             //@}
+
+            // Read/Write buffer, without events
+            /**
+             *  @name Reads data from the buffer, without event
+             *
+             *  This is a lightweight version of \ref enqueue_read.
+             *  If the buffer lives on the current locality, no \ref event
+             *  component gets created. The returned future is directly
+             *  connected to the OpenCL command.
+             *
+             *  @param offset   The start position of the area to read.
+             *  @param size     The size of the area to read.
+             *  @return         A future containing the data.
+             */
+            //@{
+            /**
+             *  @brief Starts task immediately.
+             */
+            hpx::lcos::future<boost::shared_ptr<std::vector<char>>>
+            enqueue_read_async(size_t offset, size_t size) const;
+
+            /**
+             *  @brief Depends on multiple futures
+             *
+             *  @param dependencies     The futures to wait for.
+             */
+            hpx::lcos::future<boost::shared_ptr<std::vector<char>>>
+            enqueue_read_async(size_t offset, size_t size,
+               std::vector<hpx::lcos::shared_future<void>> dependencies) const;
+            //@}
+
+            /**
+             *  @name Writes data to the buffer, without event
+             *
+             *  This is a lightweight version of \ref enqueue_write.
+             *  If the buffer lives on the current locality, no \ref event
+             *  component gets created. The returned future is directly
+             *  connected to the OpenCL command.
+             *
+             *  @param offset   The start position of the area to write to.
+             *  @param size     The size of the data to write.
+             *  @param data     The data to be written. Needs to stay valid
+             *                  until the returned future triggered.
+             *  @return         A future that triggers upon completion.
+             */
+            //@{
+            /**
+             *  @brief Starts task immediately.
+             */
+            hpx::lcos::future<void>
+            enqueue_write_async(size_t offset, size_t size,
+                                const void* data) const;
+
+            /**
+             *  @brief Depends on multiple futures
+             *
+             *  @param dependencies     The futures to wait for.
+             */
+            hpx::lcos::future<void>
+            enqueue_write_async(size_t offset, size_t size, const void* data,
+               std::vector<hpx::lcos::shared_future<void>> dependencies) const;
+            //@}
+
+            // Read buffer to host memory
+            /**
+             *  @name Reads data from the buffer into existing host memory
+             *
+             *  This is a zero-copy version of \ref enqueue_read_async.
+             *  If the buffer lives on the current locality, the device
+             *  writes directly to dst. Otherwise the data gets fetched
+             *  and copied to dst.
+             *
+             *  @param offset   The start position of the area to read.
+             *  @param size     The size of the area to read.
+             *  @param dst      The destination. Needs to stay valid
+             *                  until the returned future triggered.
+             *  @return         A future that triggers as soon as the data
+             *                  arrived in dst.
+             */
+            //@{
+            /**
+             *  @brief Starts task immediately.
+             */
+            hpx::lcos::future<void>
+            enqueue_read_to(size_t offset, size_t size, void* dst) const;
+
+            /**
+             *  @brief Depends on multiple events
+             *
+             *  @param events   A list of \ref event "events" that this task
+             *                  depends on.
+             */
+            hpx::lcos::future<void>
+            enqueue_read_to(size_t offset, size_t size, void* dst,
+                                  std::vector<hpx::opencl::event> events) const;
+
+            /**
+             *  @brief Depends on one future event
+             *
+             *  @param event    A future \ref event that this
+             *                  task depends on.
+             */
+            hpx::lcos::future<void>
+            enqueue_read_to(size_t offset, size_t size, void* dst,
+                      hpx::lcos::shared_future<hpx::opencl::event> event) const;
+            //@}
+
+            // Read rectangular area to host memory
+            /**
+             *  @name Reads rows of data from the buffer into existing
+             *        host memory
+             *
+             *  Reads num_rows rows of row_size bytes each. The rows are
+             *  buffer_row_pitch bytes apart in the buffer and get written
+             *  dst_row_pitch bytes apart to dst, e.g. a tile of an image.
+             *
+             *  Uses
+             *  <A HREF="http://www.khronos.org/registry/cl/sdk/1.1/docs/man/xht
+             *  ml/clEnqueueReadBufferRect.html">
+             *  clEnqueueReadBufferRect</A> if the buffer lives on the
+             *  current locality, the data gets copied to dst otherwise.
+             *
+             *  @param offset   The start position of the first row.
+             *  @param row_size The size of a row.
+             *  @param num_rows The number of rows.
+             *  @param buffer_row_pitch
+             *                  The distance between two rows in the buffer.
+             *  @param dst      The destination of the first row. Needs to
+             *                  stay valid until the returned future
+             *                  triggered.
+             *  @param dst_row_pitch
+             *                  The distance between two rows in dst.
+             *  @return         A future that triggers as soon as the data
+             *                  arrived in dst.
+             */
+            //@{
+            /**
+             *  @brief Starts task immediately.
+             */
+            hpx::lcos::future<void>
+            enqueue_read_rect_to(size_t offset, size_t row_size,
+                                 size_t num_rows, size_t buffer_row_pitch,
+                                 void* dst, size_t dst_row_pitch) const;
+
+            /**
+             *  @brief Depends on multiple events
+             *
+             *  @param events   A list of \ref event "events" that this task
+             *                  depends on.
+             */
+            hpx::lcos::future<void>
+            enqueue_read_rect_to(size_t offset, size_t row_size,
+                                 size_t num_rows, size_t buffer_row_pitch,
+                                 void* dst, size_t dst_row_pitch,
+                                  std::vector<hpx::opencl::event> events) const;
+
+            /**
+             *  @brief Depends on one future event
+             *
+             *  @param event    A future \ref event that this
+             *                  task depends on.
+             */
+            hpx::lcos::future<void>
+            enqueue_read_rect_to(size_t offset, size_t row_size,
+                                 size_t num_rows, size_t buffer_row_pitch,
+                                 void* dst, size_t dst_row_pitch,
+                      hpx::lcos::shared_future<hpx::opencl::event> event) const;
+            //@}
+
 #undef CL_VERSION_1_2            
 #ifdef CL_VERSION_1_2
             // Fill Buffer
@@ -392,8 +561,102 @@ namespace opencl {
                std::vector<hpx::lcos::shared_future<hpx::opencl::event>> events) const;
              //@}
 
+            // Move the buffer to another device
+            /**
+             *  @name Moves the buffer to another device
+             *
+             *  The buffer keeps its id, so all existing references stay
+             *  valid. Afterwards, all commands of the buffer run on the
+             *  target device.
+             *
+             *  Inside of a shared context, the memory gets migrated
+             *  natively. Otherwise, the data gets streamed in chunks to new
+             *  memory on the target device, so reading and writing of
+             *  different chunks overlap.
+             *
+             *  Commands of the buffer that get enqueued during the
+             *  migration wait for it. Kernels that got the buffer as
+             *  argument pick up the new memory on their next launch, but
+             *  must not run concurrently with the migration.
+             *
+             *  Only devices on the locality of the buffer are supported,
+             *  see \ref move_to for other localities.
+             *
+             *  @param target   The new \ref device of the buffer.
+             *  @return         An \ref event on the target device that
+             *                  triggers as soon as the data arrived.
+             */
+            //@{
+            /**
+             *  @brief Starts task immediately.
+             */
+            hpx::lcos::future<hpx::opencl::event>
+            migrate_to(hpx::opencl::device target) const;
+
+            /**
+             *  @brief Depends on one event
+             *
+             *  @param event    An \ref event of the current \ref device
+             *                  of the buffer.
+             */
+            hpx::lcos::future<hpx::opencl::event>
+            migrate_to(hpx::opencl::device target,
+                       hpx::opencl::event event) const;
+
+            /**
+             *  @brief Depends on multiple events
+             *
+             *  @param events   \ref event "Events" of the current
+             *                  \ref device of the buffer.
+             */
+            hpx::lcos::future<hpx::opencl::event>
+            migrate_to(hpx::opencl::device target,
+                       std::vector<hpx::opencl::event> events) const;
+
+            /**
+             *  @brief Depends on one future event
+             *
+             *  @param event    A future \ref event that this
+             *                  task depends on.
+             */
+            hpx::lcos::future<hpx::opencl::event>
+            migrate_to(hpx::opencl::device target,
+                       hpx::lcos::shared_future<hpx::opencl::event> event) const;
+
+            /**
+             *  @brief Depends on multiple future events
+             *
+             *  @param events   A list of future \ref event "events" that this
+             *                  task depends on.
+             */
+            hpx::lcos::future<hpx::opencl::event>
+            migrate_to(hpx::opencl::device target,
+               std::vector<hpx::lcos::shared_future<hpx::opencl::event>> events) const;
+            //@}
+
+            /**
+             *  @brief Moves the buffer to a device on any locality
+             *
+             *  On the locality of the buffer, this is \ref migrate_to and
+             *  the buffer stays the same.<BR>
+             *  HPX components can't move between localities, so for other
+             *  localities the data gets streamed in chunks to a new buffer
+             *  on the locality of the target device. The chunks are in
+             *  flight at the same time, so reading, sending and writing of
+             *  different chunks overlap. The old buffer keeps its content.
+             *
+             *  @param target   The new \ref device of the buffer.
+             *  @param events   \ref event "Events" of the current
+             *                  \ref device of the buffer.
+             *  @return         The buffer on the target device. The future
+             *                  triggers as soon as the data arrived.
+             */
+            hpx::lcos::future<buffer>
+            move_to(hpx::opencl::device target,
+                    std::vector<hpx::opencl::event> events =
+                                    std::vector<hpx::opencl::event>()) const;
+
             /* TODO
-             * clEnqueueReadBufferRect
              * clEnqueueWriteBufferRect
              * clEnqueueCopyBuffer
              * clEnqueueCopyBufferRect
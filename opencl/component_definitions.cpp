@@ -46,6 +46,9 @@ HPX_REGISTER_ACTION(device_type::wrapped_type::create_user_event_action,
                     device_create_user_event_action);
 //HPX_ACTION_USES_LARGE_STACK(device_create_user_event_action);
 
+HPX_REGISTER_ACTION(device_type::wrapped_type::enqueue_marker_action,
+                    device_enqueue_marker_action);
+
 HPX_REGISTER_ACTION(device_type::wrapped_type::get_device_info_action,
                     device_get_device_info_action);
 //HPX_ACTION_USES_LARGE_STACK(device_get_device_info_action);
@@ -54,6 +57,17 @@ HPX_REGISTER_ACTION(device_type::wrapped_type::get_platform_info_action,
                     device_get_platform_info_action);
 //HPX_ACTION_USES_LARGE_STACK(device_get_platform_info_action);
 
+HPX_REGISTER_ACTION(device_type::wrapped_type::get_device_properties_action,
+                    device_get_device_properties_action);
+HPX_REGISTER_ACTION(device_type::wrapped_type::get_pending_commands_action,
+                    device_get_pending_commands_action);
+HPX_REGISTER_ACTION(device_type::wrapped_type::measure_bandwidth_action,
+                    device_measure_bandwidth_action);
+HPX_REGISTER_ACTION(device_type::wrapped_type::enable_managed_memory_action,
+                    device_enable_managed_memory_action);
+HPX_REGISTER_ACTION(device_type::wrapped_type::get_managed_memory_usage_action,
+                    device_get_managed_memory_usage_action);
+
 
 
 
@@ -74,6 +88,10 @@ HPX_REGISTER_ACTION(buffer_type::wrapped_type::size_action,
                     buffer_size_action);
 HPX_REGISTER_ACTION(buffer_type::wrapped_type::copy_action,
                     buffer_copy_action);
+HPX_REGISTER_ACTION(buffer_type::wrapped_type::migrate_action,
+                    buffer_migrate_action);
+HPX_REGISTER_ACTION(buffer_type::wrapped_type::migrate_remote_action,
+                    buffer_migrate_remote_action);
 
 
 // EVENT
@@ -108,8 +126,20 @@ typedef hpx::components::managed_component<
 HPX_REGISTER_MINIMAL_COMPONENT_FACTORY(kernel_type, kernel);
 HPX_REGISTER_ACTION(kernel_type::wrapped_type::set_arg_action,
                     kernel_set_arg_action);
+#ifdef CL_VERSION_2_0
+HPX_REGISTER_ACTION(kernel_type::wrapped_type::set_arg_svm_action,
+                    kernel_set_arg_svm_action);
+#endif
 HPX_REGISTER_ACTION(kernel_type::wrapped_type::enqueue_action,
                     kernel_enqueue_action);
+HPX_REGISTER_ACTION(kernel_type::wrapped_type::enqueue_bulk_action,
+                    kernel_enqueue_bulk_action);
+HPX_REGISTER_ACTION(kernel_type::wrapped_type::enqueue_launch_action,
+                    kernel_enqueue_launch_action);
+HPX_REGISTER_ACTION(kernel_type::wrapped_type::autotune_action,
+                    kernel_autotune_action);
+HPX_REGISTER_ACTION(kernel_type::wrapped_type::get_work_group_size_action,
+                    kernel_get_work_group_size_action);
 
 
 
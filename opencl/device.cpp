@@ -110,6 +110,16 @@ device::create_user_event() const
     return hpx::async<func>(this->get_gid());
 }
 
+hpx::lcos::future<hpx::opencl::event>
+device::enqueue_marker(std::vector<hpx::opencl::event> events) const
+{
+    BOOST_ASSERT(this->get_gid());
+
+    typedef hpx::opencl::server::device::enqueue_marker_action func;
+
+    return hpx::async<func>(this->get_gid(), events);
+}
+
 hpx::lcos::future<std::vector<char>>
 device::get_device_info(cl_device_info info_type) const
 {
@@ -134,6 +144,66 @@ device::get_platform_info(cl_platform_info info_type) const
 
 }
 
+hpx::lcos::future<hpx::opencl::device_properties>
+device::get_device_properties() const
+{
+
+    BOOST_ASSERT(this->get_gid());
+
+    typedef hpx::opencl::server::device::get_device_properties_action func;
+
+    return hpx::async<func>(this->get_gid());
+
+}
+
+hpx::lcos::future<std::size_t>
+device::get_pending_commands() const
+{
+
+    BOOST_ASSERT(this->get_gid());
+
+    typedef hpx::opencl::server::device::get_pending_commands_action func;
+
+    return hpx::async<func>(this->get_gid());
+
+}
+
+hpx::lcos::future<double>
+device::measure_bandwidth() const
+{
+
+    BOOST_ASSERT(this->get_gid());
+
+    typedef hpx::opencl::server::device::measure_bandwidth_action func;
+
+    return hpx::async<func>(this->get_gid());
+
+}
+
+hpx::lcos::future<void>
+device::enable_managed_memory(std::size_t memory_limit)
+{
+
+    BOOST_ASSERT(this->get_gid());
+
+    typedef hpx::opencl::server::device::enable_managed_memory_action func;
+
+    return hpx::async<func>(this->get_gid(), memory_limit);
+
+}
+
+hpx::lcos::future<std::size_t>
+device::get_managed_memory_usage() const
+{
+
+    BOOST_ASSERT(this->get_gid());
+
+    typedef hpx::opencl::server::device::get_managed_memory_usage_action func;
+
+    return hpx::async<func>(this->get_gid());
+
+}
+
 std::string
 device::device_info_to_string(hpx::lcos::future<std::vector<char>> info)
 {
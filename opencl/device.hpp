@@ -57,6 +57,19 @@ namespace opencl {
              */
             hpx::lcos::future<hpx::opencl::event>
             create_user_event() const;
+
+            /**
+             *  @brief Combines events of this device into one
+             *
+             *  Unlike \ref create_future_event, the host is not involved,
+             *  the device itself waits for the events.
+             *
+             *  @param events   Events of this device.
+             *  @return An event that triggers as soon as all events
+             *          triggered.
+             */
+            hpx::lcos::future<hpx::opencl::event>
+            enqueue_marker(std::vector<hpx::opencl::event> events) const;
             
             /**
              *  @brief Queries device infos.
@@ -95,6 +108,70 @@ namespace opencl {
              */
             hpx::lcos::future<std::vector<char>>
             get_platform_info(cl_platform_info info_type) const;
+
+            /**
+             *  @brief Queries all static device and platform properties.
+             *
+             *  The properties get cached on device creation, so this
+             *  does not cause any OpenCL calls.<BR>
+             *  Prefer this over multiple calls to \ref get_device_info
+             *  if more than one property is needed.
+             *
+             *  @return The properties of the device.
+             */
+            hpx::lcos::future<hpx::opencl::device_properties>
+            get_device_properties() const;
+
+            /**
+             *  @brief Queries the current load of the device.
+             *
+             *  Commands get counted from the first call on, so the
+             *  first call always returns 0.
+             *
+             *  @return The number of kernel launches and buffer transfers
+             *          that are enqueued, but not yet finished.
+             */
+            hpx::lcos::future<std::size_t>
+            get_pending_commands() const;
+
+            /**
+             *  @brief Measures the host-device bandwidth.
+             *
+             *  The measurement transfers a few megabytes to and from the
+             *  device on the first call and gets cached afterwards.
+             *  It uses a separate command queue, so other commands of the
+             *  device don't have to wait for it.
+             *
+             *  @return The bandwidth in bytes per second.
+             */
+            hpx::lcos::future<double>
+            measure_bandwidth() const;
+
+            /**
+             *  @brief Lets buffers use more memory than the device has.
+             *
+             *  Affects all buffers created afterwards on this device.
+             *  If an allocation exceeds the memory limit or the device
+             *  runs out of memory, the least recently used buffers get
+             *  moved to host memory. They get moved back on their next
+             *  use, e.g. as a kernel argument or by a read.<BR>
+             *  Evicting a buffer only waits for the commands that use it,
+             *  but its content has to travel over the bus twice, so heavy
+             *  oversubscription runs noticeably slower.
+             *
+             *  @param memory_limit The device memory the buffers may use,
+             *                      in bytes. 0 uses the global memory size
+             *                      of the device.
+             */
+            hpx::lcos::future<void>
+            enable_managed_memory(std::size_t memory_limit = 0);
+
+            /**
+             *  @brief Queries the size of all managed buffers that currently
+             *         reside on the device, in bytes.
+             */
+            hpx::lcos::future<std::size_t>
+            get_managed_memory_usage() const;
             
             /** 
              *  @brief Converts device info data to a string
@@ -146,6 +223,12 @@ namespace opencl {
              *                  <A HREF="http://www.khronos.org/registry/cl/sdk/
              * 1.2/docs/man/xhtml/clCreateBuffer.html">
              *                  OpenCL Reference</A>.
+             *
+             *  The device memory gets created on the first use of the
+             *  buffer, so allocation errors show up there. If the first use
+             *  is a write of the whole buffer without dependencies, the data
+             *  gets passed directly to the allocation.
+             *
              *  @param size     The size of the buffer, in bytes.
              *  @return         A new \ref buffer object.
              *  @see            buffer
@@ -0,0 +1,156 @@
+// Copyright (c)    2014 Martin Stumpf
+//
+// Distributed under the Boost Software License, Version 1.0. (See accompanying
+// file LICENSE_1_0.txt or copy at http://www.boost.org/LICENSE_1_0.txt)
+
+#pragma once
+#ifndef HPX_OPENCL_DEVICE_PROPERTIES_HPP_
+#define HPX_OPENCL_DEVICE_PROPERTIES_HPP_
+
+#include <CL/cl.h>
+
+#include <boost/serialization/map.hpp>
+#include <boost/serialization/string.hpp>
+#include <boost/serialization/vector.hpp>
+#include <boost/serialization/utility.hpp>
+
+#include <map>
+#include <string>
+#include <vector>
+#include <utility>
+
+#include "fwd_declarations.hpp"
+
+namespace hpx {
+namespace opencl {
+
+    ////////////////////////
+    /// @brief The static properties of a \ref device.
+    ///
+    /// All properties get queried once on device creation, so accessing
+    /// them does not cause any OpenCL calls.
+    ///
+    /// Example:
+    /// \code{.cpp}
+    ///     hpx::opencl::device_properties props =
+    ///                                    device.get_device_properties().get();
+    ///
+    ///     hpx::cout << props.vendor << ": " << props.name << hpx::endl;
+    /// \endcode
+    ///
+    struct device_properties
+    {
+        public:
+            device_properties()
+              : type(0),
+                version_major(-1),
+                version_minor(0),
+                max_compute_units(0),
+                max_clock_frequency(0),
+                max_work_group_size(0),
+                global_mem_size(0),
+                global_mem_cache_size(0),
+                local_mem_size(0),
+                max_mem_alloc_size(0),
+                max_constant_buffer_size(0),
+                svm_capabilities(0),
+                queue_properties(0),
+                available(CL_FALSE),
+                host_unified_memory(CL_FALSE)
+            {}
+
+        public:
+            // Device properties
+            cl_device_type type;
+            std::string name;
+            std::string vendor;
+            std::string version;
+            std::string driver_version;
+            std::string profile;
+            std::string extensions;
+
+            // The parsed OpenCL version, -1 if not parsable
+            int version_major;
+            int version_minor;
+
+            // Compute capabilities
+            cl_uint max_compute_units;
+            cl_uint max_clock_frequency;
+            size_t max_work_group_size;
+            std::vector<size_t> max_work_item_sizes;
+
+            // Memory capabilities
+            cl_ulong global_mem_size;
+            cl_ulong global_mem_cache_size;
+            cl_ulong local_mem_size;
+            cl_ulong max_mem_alloc_size;
+            cl_ulong max_constant_buffer_size;
+
+            // The CL_DEVICE_SVM_CAPABILITIES of OpenCL 2.0 devices,
+            // 0 if shared virtual memory is not supported
+            cl_ulong svm_capabilities;
+
+            // Supported command queue properties
+            cl_command_queue_properties queue_properties;
+
+            cl_bool available;
+            cl_bool host_unified_memory;
+
+            // Platform properties
+            std::string platform_name;
+            std::string platform_vendor;
+            std::string platform_version;
+            std::string platform_profile;
+            std::string platform_extensions;
+
+            // The raw data of all cached info types, as returned by
+            // clGetDeviceInfo and clGetPlatformInfo
+            std::map<cl_uint, std::vector<char>> device_info;
+            std::map<cl_uint, std::vector<char>> platform_info;
+
+        private:
+            friend class boost::serialization::access;
+
+            template <typename Archive>
+            void serialize(Archive & ar, unsigned int version_)
+            {
+                ar & type;
+                ar & name;
+                ar & vendor;
+                ar & version;
+                ar & driver_version;
+                ar & profile;
+                ar & extensions;
+                ar & version_major;
+                ar & version_minor;
+                ar & max_compute_units;
+                ar & max_clock_frequency;
+                ar & max_work_group_size;
+                ar & max_work_item_sizes;
+                ar & global_mem_size;
+                ar & global_mem_cache_size;
+                ar & local_mem_size;
+                ar & max_mem_alloc_size;
+                ar & max_constant_buffer_size;
+                ar & svm_capabilities;
+                ar & queue_properties;
+                ar & available;
+                ar & host_unified_memory;
+                ar & platform_name;
+                ar & platform_vendor;
+                ar & platform_version;
+                ar & platform_profile;
+                ar & platform_extensions;
+                ar & device_info;
+                ar & platform_info;
+            }
+    };
+
+    // A device together with its properties,
+    // as returned by \ref get_all_devices_with_properties
+    typedef std::pair<hpx::opencl::device, hpx::opencl::device_properties>
+        device_with_properties;
+
+}}
+
+#endif
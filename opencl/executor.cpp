@@ -0,0 +1,180 @@
+// Copyright (c)    2014 Martin Stumpf
+//
+// Distributed under the Boost Software License, Version 1.0. (See accompanying
+// file LICENSE_1_0.txt or copy at http://www.boost.org/LICENSE_1_0.txt)
+
+#include "executor.hpp"
+
+#include "kernel_cache.hpp"
+
+#include <sstream>
+
+using hpx::opencl::loop_body;
+using hpx::opencl::execution_policy;
+
+///////////////////////////////////////////////////
+/// Local functions
+///
+
+// The launch over an index range, with one work item per index
+static hpx::opencl::work_size<1>
+range_work_size(size_t first, size_t last)
+{
+    hpx::opencl::work_size<1> dim;
+    dim[0].offset = first;
+    dim[0].size = last - first;
+    dim[0].local_size = hpx::opencl::auto_local_size;
+    return dim;
+}
+
+// OpenCL does not allow empty launches, so empty ranges return a marker
+// that triggers with the dependencies, or an event that already happened
+// if there are none
+static hpx::lcos::future<hpx::opencl::event>
+empty_range_event(execution_policy const& policy)
+{
+
+    hpx::opencl::executor const& exec = policy.get_executor();
+    std::vector<hpx::lcos::shared_future<hpx::opencl::event> > const&
+                                dependencies = policy.get_dependencies();
+
+    if(!dependencies.empty())
+    {
+        std::vector<hpx::opencl::event> events;
+        events.reserve(dependencies.size());
+        for(size_t i = 0; i < dependencies.size(); i++)
+        {
+            events.push_back(dependencies[i].get());
+        }
+        return exec.get_device().enqueue_marker(events);
+    }
+
+    hpx::opencl::event event = exec.get_device().create_user_event().get();
+    event.trigger();
+    return hpx::lcos::make_ready_future(event);
+
+}
+
+// Builds the loop kernel once per device and source, then launches it
+static hpx::lcos::future<hpx::opencl::event>
+run_loop(execution_policy const& policy, size_t first, size_t last,
+         std::string const& source,
+         std::vector<hpx::opencl::buffer> const& args)
+{
+
+    hpx::opencl::executor const& exec = policy.get_executor();
+    if(first >= last)
+        return empty_range_event(policy);
+
+    hpx::opencl::kernel kernel = hpx::opencl::get_cached_kernel(
+                            exec.get_device(), source, "hpx_opencl_loop").get();
+
+    hpx::opencl::launch_desc launch(range_work_size(first, last));
+    for(size_t i = 0; i < args.size(); i++)
+    {
+        launch.set_arg((cl_uint)i, args[i]);
+    }
+
+    return exec.async_execute(kernel, launch, policy.get_dependencies());
+
+}
+
+///////////////////////////////////////////////////
+/// Implementations
+///
+
+loop_body::loop_body(std::string source_)
+  : source(source_)
+{
+}
+
+std::string
+loop_body::generate_kernel(std::string const& statement,
+                   std::vector<std::string> const& extra_declarations) const
+{
+
+    std::vector<std::string> all_declarations = extra_declarations;
+    all_declarations.insert(all_declarations.end(), declarations.begin(),
+                            declarations.end());
+
+    std::ostringstream code;
+    code << "__kernel void hpx_opencl_loop(";
+    for(size_t i = 0; i < all_declarations.size(); i++)
+    {
+        if(i > 0)
+            code << ", ";
+        code << all_declarations[i];
+    }
+    code << ")\n"
+         << "{\n"
+         << "    size_t i = get_global_id(0);\n"
+         << "    " << statement << "\n"
+         << "}\n";
+
+    return code.str();
+
+}
+
+hpx::opencl::executor const&
+execution_policy::get_executor() const
+{
+
+    if(!has_executor)
+    {
+        HPX_THROW_EXCEPTION(hpx::bad_parameter,
+                            "hpx::opencl::execution_policy::get_executor()",
+                            "No executor given, use par.on(executor)!");
+    }
+
+    return exec;
+
+}
+
+hpx::lcos::future<hpx::opencl::event>
+hpx::opencl::for_each(execution_policy const& policy, size_t first,
+                      size_t last, loop_body const& body)
+{
+
+    std::string source = body.generate_kernel(
+                            "{ " + body.get_source() + " }",
+                            std::vector<std::string>());
+
+    return run_loop(policy, first, last, source, body.get_args());
+
+}
+
+hpx::lcos::future<hpx::opencl::event>
+hpx::opencl::for_each(execution_policy const& policy, size_t first,
+                      size_t last, hpx::opencl::kernel kernel)
+{
+
+    hpx::opencl::executor const& exec = policy.get_executor();
+    if(first >= last)
+        return empty_range_event(policy);
+
+    return exec.async_execute(kernel, range_work_size(first, last),
+                              policy.get_dependencies());
+
+}
+
+hpx::lcos::future<hpx::opencl::event>
+hpx::opencl::transform_loop(execution_policy const& policy, size_t first,
+                            size_t last, hpx::opencl::buffer output,
+                            std::string const& type_name,
+                            loop_body const& body)
+{
+
+    std::vector<std::string> output_declaration;
+    output_declaration.push_back("__global " + type_name + "* hpx_out");
+
+    std::string source = body.generate_kernel(
+                "hpx_out[i] = (" + type_name + ")(" + body.get_source() + ");",
+                output_declaration);
+
+    std::vector<hpx::opencl::buffer> args;
+    args.push_back(output);
+    args.insert(args.end(), body.get_args().begin(), body.get_args().end());
+
+    return run_loop(policy, first, last, source, args);
+
+}
@@ -0,0 +1,283 @@
+// Copyright (c)    2014 Martin Stumpf
+//
+// Distributed under the Boost Software License, Version 1.0. (See accompanying
+// file LICENSE_1_0.txt or copy at http://www.boost.org/LICENSE_1_0.txt)
+
+#pragma once
+#ifndef HPX_OPENCL_EXECUTOR_HPP_
+#define HPX_OPENCL_EXECUTOR_HPP_
+
+#include "export_definitions.hpp"
+
+#include <hpx/hpx.hpp>
+#include <hpx/config.hpp>
+#include <hpx/lcos/future.hpp>
+
+#include <string>
+#include <vector>
+
+#include "buffer.hpp"
+#include "device.hpp"
+#include "event.hpp"
+#include "kernel.hpp"
+#include "launch_desc.hpp"
+#include "work_size.hpp"
+#include "expression.hpp"
+
+namespace hpx {
+namespace opencl {
+
+    ////////////////////////
+    /// @brief Runs loops on a \ref device.
+    ///
+    /// The executor is the device side of an \ref execution_policy.
+    /// Loops get offloaded via \ref for_each and \ref transform, kernels
+    /// can also be run directly.
+    ///
+    /// Example:
+    /// \code{.cpp}
+    ///     hpx::opencl::executor exec(device);
+    ///
+    ///     // y = 2 * x + y
+    ///     hpx::opencl::event done = hpx::opencl::for_each(
+    ///             hpx::opencl::par.on(exec), 0, size,
+    ///             hpx::opencl::loop_body("y[i] = 2.0f * x[i] + y[i];")
+    ///                     .arg<float>("x", buffer_x)
+    ///                     .arg<float>("y", buffer_y)).get();
+    /// \endcode
+    ///
+    class HPX_OPENCL_EXPORT executor
+    {
+        public:
+            // Empty constructor, necessary for execution policies
+            // without executor
+            executor(){}
+
+            /**
+             *  @brief Creates an executor for a device
+             */
+            explicit executor(hpx::opencl::device device_)
+              : device(device_)
+            {}
+
+            /**
+             *  @brief Returns the device of the executor
+             */
+            hpx::opencl::device get_device() const
+            {
+                return device;
+            }
+
+            /**
+             *  @brief Runs a kernel with its own arguments
+             *
+             *  Uses \ref kernel::enqueue, so the kernel must not be used
+             *  by other threads at the same time.
+             *
+             *  @param kernel       The kernel.
+             *  @param size         The work dimensions.
+             *  @param dependencies The events to wait for.
+             *  @return             An \ref event that triggers upon
+             *                      completion.
+             */
+            template <size_t DIM>
+            hpx::lcos::future<hpx::opencl::event>
+            async_execute(hpx::opencl::kernel kernel,
+                          hpx::opencl::work_size<DIM> size,
+                          std::vector<hpx::lcos::shared_future<
+                                hpx::opencl::event> > dependencies =
+                          std::vector<hpx::lcos::shared_future<
+                                hpx::opencl::event> >()) const
+            {
+                return kernel.enqueue(size, dependencies);
+            }
+
+            /**
+             *  @brief Runs a kernel with the arguments of a launch
+             *
+             *  Uses \ref kernel::enqueue_launch, so kernel pools can be
+             *  shared between threads.
+             */
+            hpx::lcos::future<hpx::opencl::event>
+            async_execute(hpx::opencl::kernel kernel,
+                          hpx::opencl::launch_desc launch,
+                          std::vector<hpx::lcos::shared_future<
+                                hpx::opencl::event> > dependencies =
+                          std::vector<hpx::lcos::shared_future<
+                                hpx::opencl::event> >()) const
+            {
+                return kernel.enqueue_launch(launch, dependencies);
+            }
+
+        private:
+            hpx::opencl::device device;
+
+    };
+
+    ////////////////////////
+    /// @brief The body of a loop, as OpenCL C source.
+    ///
+    /// The body can use the loop index i and the buffers that got
+    /// declared via \ref arg.
+    ///
+    class HPX_OPENCL_EXPORT loop_body
+    {
+        public:
+            /**
+             *  @brief Creates a loop body
+             *
+             *  @param source   Statements for \ref for_each, an expression
+             *                  for \ref transform.
+             */
+            explicit loop_body(std::string source);
+
+            /**
+             *  @brief Adds a buffer argument
+             *
+             *  @tparam T       The element type of the buffer.
+             *  @param name     The name of the buffer in the body.
+             *  @param buffer   The buffer.
+             */
+            template <typename T>
+            loop_body& arg(std::string const& name, hpx::opencl::buffer buffer)
+            {
+                declarations.push_back(std::string("__global ")
+                                       + cl_type_name<T>::get() + "* " + name);
+                args.push_back(buffer);
+                return *this;
+            }
+
+            // Generates the kernel "hpx_opencl_loop" around a statement.
+            // The extra arguments come before the ones of the body.
+            std::string generate_kernel(std::string const& statement,
+                        std::vector<std::string> const& extra_declarations)
+                                                                        const;
+
+            std::string const& get_source() const { return source; }
+            std::vector<hpx::opencl::buffer> const& get_args() const
+            { return args; }
+
+        private:
+            std::string source;
+            std::vector<std::string> declarations;
+            std::vector<hpx::opencl::buffer> args;
+
+    };
+
+    ////////////////////////
+    /// @brief Execution policy that runs algorithms on an OpenCL device.
+    ///
+    /// Use \ref par and choose the device with \ref on.
+    ///
+    class HPX_OPENCL_EXPORT execution_policy
+    {
+        public:
+            execution_policy()
+              : has_executor(false)
+            {}
+
+            /**
+             *  @brief Returns a policy that runs on the given executor
+             */
+            execution_policy on(hpx::opencl::executor exec) const
+            {
+                execution_policy policy(*this);
+                policy.exec = exec;
+                policy.has_executor = true;
+                return policy;
+            }
+
+            /**
+             *  @brief Returns a policy whose algorithms wait for events
+             */
+            execution_policy after(
+                    std::vector<hpx::lcos::shared_future<hpx::opencl::event> >
+                                                        dependencies_) const
+            {
+                execution_policy policy(*this);
+                policy.dependencies = dependencies_;
+                return policy;
+            }
+
+            execution_policy after(
+                    hpx::lcos::shared_future<hpx::opencl::event> event) const
+            {
+                return after(std::vector<hpx::lcos::shared_future<
+                                        hpx::opencl::event> >(1, event));
+            }
+
+            /**
+             *  @brief Returns the executor, throws if there is none
+             */
+            hpx::opencl::executor const& get_executor() const;
+
+            std::vector<hpx::lcos::shared_future<hpx::opencl::event> > const&
+            get_dependencies() const
+            {
+                return dependencies;
+            }
+
+        private:
+            hpx::opencl::executor exec;
+            bool has_executor;
+            std::vector<hpx::lcos::shared_future<hpx::opencl::event> >
+                                                                dependencies;
+
+    };
+
+    /// @brief The OpenCL execution policy, see \ref execution_policy.
+    static const execution_policy par;
+
+    /**
+     *  @brief Runs a loop body for every index in [first, last)
+     *
+     *  @param policy   The policy, needs an executor.
+     *  @param first    The first index.
+     *  @param last     The index behind the last one.
+     *  @param body     The loop body, statements in the index i.
+     *  @return         An \ref event that triggers upon completion.
+     */
+    HPX_OPENCL_EXPORT hpx::lcos::future<hpx::opencl::event>
+    for_each(execution_policy const& policy, size_t first, size_t last,
+             loop_body const& body);
+
+    /**
+     *  @brief Runs a kernel for every index in [first, last)
+     *
+     *  The index is get_global_id(0). The kernel uses its own arguments,
+     *  see \ref executor::async_execute.
+     */
+    HPX_OPENCL_EXPORT hpx::lcos::future<hpx::opencl::event>
+    for_each(execution_policy const& policy, size_t first, size_t last,
+             hpx::opencl::kernel kernel);
+
+    // Implements transform, the statement assigns the result of the
+    // body to hpx_out[i]
+    HPX_OPENCL_EXPORT hpx::lcos::future<hpx::opencl::event>
+    transform_loop(execution_policy const& policy, size_t first, size_t last,
+                   hpx::opencl::buffer output, std::string const& type_name,
+                   loop_body const& body);
+
+    /**
+     *  @brief Computes output[i] for every index in [first, last)
+     *
+     *  @tparam T       The element type of the output.
+     *  @param policy   The policy, needs an executor.
+     *  @param first    The first index.
+     *  @param last     The index behind the last one.
+     *  @param output   The output buffer.
+     *  @param body     The loop body, an expression in the index i.
+     *  @return         An \ref event that triggers upon completion.
+     */
+    template <typename T>
+    hpx::lcos::future<hpx::opencl::event>
+    transform(execution_policy const& policy, size_t first, size_t last,
+              hpx::opencl::buffer output, loop_body const& body)
+    {
+        return transform_loop(policy, first, last, output,
+                              cl_type_name<T>::get(), body);
+    }
+
+}}
+
+#endif
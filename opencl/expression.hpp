@@ -0,0 +1,416 @@
+// Copyright (c)    2014 Martin Stumpf
+//
+// Distributed under the Boost Software License, Version 1.0. (See accompanying
+// file LICENSE_1_0.txt or copy at http://www.boost.org/LICENSE_1_0.txt)
+
+#pragma once
+#ifndef HPX_OPENCL_EXPRESSION_HPP_
+#define HPX_OPENCL_EXPRESSION_HPP_
+
+#include <hpx/hpx.hpp>
+#include <hpx/config.hpp>
+#include <hpx/lcos/future.hpp>
+
+#include <CL/cl.h>
+
+#include <boost/type_traits/is_base_of.hpp>
+#include <boost/type_traits/is_same.hpp>
+#include <boost/type_traits/is_floating_point.hpp>
+#include <boost/utility/enable_if.hpp>
+#include <boost/static_assert.hpp>
+
+#include <iomanip>
+#include <limits>
+#include <sstream>
+#include <string>
+#include <vector>
+
+#include "buffer.hpp"
+#include "device.hpp"
+#include "event.hpp"
+#include "kernel.hpp"
+#include "kernel_cache.hpp"
+#include "launch_desc.hpp"
+#include "work_size.hpp"
+
+namespace hpx {
+namespace opencl {
+
+    ////////////////////////
+    /// @brief The OpenCL C name of an element type
+    ///
+    template <typename T> struct cl_type_name;
+
+    template <> struct cl_type_name<cl_float>
+    { static const char* get() { return "float"; } };
+    template <> struct cl_type_name<cl_double>
+    { static const char* get() { return "double"; } };
+    template <> struct cl_type_name<cl_int>
+    { static const char* get() { return "int"; } };
+    template <> struct cl_type_name<cl_uint>
+    { static const char* get() { return "uint"; } };
+    template <> struct cl_type_name<cl_long>
+    { static const char* get() { return "long"; } };
+    template <> struct cl_type_name<cl_ulong>
+    { static const char* get() { return "ulong"; } };
+
+    ////////////////////////
+    /// @brief Lazy element-wise expressions over buffers
+    ///
+    /// Operators and functions on expressions don't compute anything,
+    /// they only build up the expression tree. \ref evaluate then
+    /// generates one kernel for the whole tree, so a chain of element-wise
+    /// operations reads every input once and writes only the result,
+    /// instead of passing intermediate buffers through global memory.
+    ///
+    /// Example:
+    /// \code{.cpp}
+    ///     using hpx::opencl::lazy;
+    ///
+    ///     auto a = lazy<float>(buffer_a);
+    ///     auto b = lazy<float>(buffer_b);
+    ///     auto c = lazy<float>(buffer_c);
+    ///
+    ///     // one kernel launch, instead of five
+    ///     hpx::opencl::event done = hpx::opencl::evaluate(
+    ///                         device, buffer_z, size,
+    ///                         log((exp(b) + a) * (2.0f * c))).get();
+    /// \endcode
+    ///
+    /// The generated program is cached per device and expression shape,
+    /// so evaluating the same expression on other buffers of the same
+    /// type does not compile again. Constants are kernel arguments, so
+    /// changing them does not compile again either.
+    ///
+    namespace expression {
+
+        // The base of all expression nodes
+        template <typename Derived>
+        struct node {};
+
+        template <typename E>
+        struct is_expression : boost::is_base_of<node<E>, E> {};
+
+        // Writes a constant as OpenCL C literal, for values that are part
+        // of the kernel shape
+        template <typename T>
+        void write_literal(std::ostream & code, T value)
+        {
+            if(boost::is_floating_point<T>::value)
+            {
+                code << std::scientific
+                     << std::setprecision(std::numeric_limits<T>::digits10 + 2)
+                     << value;
+                if(boost::is_same<T, cl_float>::value)
+                    code << "f";
+            }
+            else
+            {
+                const char* suffix =
+                      std::numeric_limits<T>::is_signed
+                    ? (sizeof(T) == 8 ? "l" : "")
+                    : (sizeof(T) == 8 ? "ul" : "u");
+
+                // the smallest value has no literal, its absolute value
+                // does not fit into the type
+                code << "((" << cl_type_name<T>::get() << ")";
+                if(std::numeric_limits<T>::is_signed
+                    && value == std::numeric_limits<T>::min())
+                    code << "(" << (value + 1) << suffix << " - 1)";
+                else
+                    code << value << suffix;
+                code << ")";
+            }
+        }
+
+        // The arguments of a generated kernel, in order of appearance
+        template <typename T>
+        struct arguments
+        {
+            std::vector<hpx::opencl::buffer> buffers;
+            std::vector<T> constants;
+        };
+
+        // A buffer, every element is read once per evaluation
+        template <typename T>
+        class terminal : public node<terminal<T> >
+        {
+            public:
+                typedef T value_type;
+
+                explicit terminal(hpx::opencl::buffer buffer_)
+                  : buffer(buffer_)
+                {}
+
+                void generate(std::ostream & code,
+                              arguments<value_type> & args) const
+                {
+                    code << "in" << args.buffers.size() << "[gid]";
+                    args.buffers.push_back(buffer);
+                }
+
+            private:
+                hpx::opencl::buffer buffer;
+        };
+
+        // A constant, gets passed as kernel argument
+        template <typename T>
+        class constant : public node<constant<T> >
+        {
+            public:
+                typedef T value_type;
+
+                explicit constant(T value_)
+                  : value(value_)
+                {}
+
+                void generate(std::ostream & code,
+                              arguments<value_type> & args) const
+                {
+                    code << "c" << args.constants.size();
+                    args.constants.push_back(value);
+                }
+
+            private:
+                T value;
+        };
+
+        // An infix operator
+        template <typename Op, typename L, typename R>
+        class binary : public node<binary<Op, L, R> >
+        {
+            BOOST_STATIC_ASSERT((boost::is_same<typename L::value_type,
+                                                typename R::value_type>::value));
+
+            public:
+                typedef typename L::value_type value_type;
+
+                binary(L const& l_, R const& r_)
+                  : l(l_), r(r_)
+                {}
+
+                void generate(std::ostream & code,
+                              arguments<value_type> & args) const
+                {
+                    code << "(";
+                    l.generate(code, args);
+                    code << " " << Op::get() << " ";
+                    r.generate(code, args);
+                    code << ")";
+                }
+
+            private:
+                L l;
+                R r;
+        };
+
+        // A prefix operator or built-in function with one argument
+        template <typename Fn, typename E>
+        class unary : public node<unary<Fn, E> >
+        {
+            public:
+                typedef typename E::value_type value_type;
+
+                explicit unary(E const& e_)
+                  : e(e_)
+                {}
+
+                void generate(std::ostream & code,
+                              arguments<value_type> & args) const
+                {
+                    code << Fn::get() << "(";
+                    e.generate(code, args);
+                    code << ")";
+                }
+
+            private:
+                E e;
+        };
+
+        // Generates the complete program. The buffers of the kernel
+        // arguments 1..n and the constants of the arguments n+1..n+m get
+        // appended to args.
+        template <typename E>
+        std::string generate_source(E const& e,
+                            arguments<typename E::value_type> & args)
+        {
+            typedef typename E::value_type value_type;
+            const char* type_name = cl_type_name<value_type>::get();
+
+            std::ostringstream body;
+            e.generate(body, args);
+
+            std::ostringstream code;
+            if(boost::is_same<value_type, cl_double>::value)
+                code << "#pragma OPENCL EXTENSION cl_khr_fp64 : enable\n";
+            code << "__kernel void hpx_opencl_fused(__global " << type_name
+                 << "* out";
+            for(std::size_t i = 0; i < args.buffers.size(); i++)
+            {
+                code << ", __global const " << type_name << "* in" << i;
+            }
+            for(std::size_t i = 0; i < args.constants.size(); i++)
+            {
+                code << ", const " << type_name << " c" << i;
+            }
+            code << ")\n"
+                 << "{\n"
+                 << "    size_t gid = get_global_id(0);\n"
+                 << "    out[gid] = " << body.str() << ";\n"
+                 << "}\n";
+
+            return code.str();
+        }
+
+        // Launches the fused kernel as soon as it is built
+        inline hpx::lcos::future<hpx::opencl::event>
+        launch_fused(hpx::opencl::launch_desc launch,
+                     std::vector<hpx::lcos::shared_future<hpx::opencl::event> >
+                                                                dependencies,
+                     hpx::lcos::shared_future<hpx::opencl::kernel> kernel_future)
+        {
+            return kernel_future.get().enqueue_launch(launch, dependencies);
+        }
+
+#define HPX_OPENCL_EXPRESSION_BINARY_OPERATOR(name, op)                     \
+        struct name { static const char* get() { return #op; } };          \
+                                                                            \
+        template <typename L, typename R>                                   \
+        typename boost::enable_if_c<is_expression<L>::value &&              \
+                                    is_expression<R>::value,                \
+                                    binary<name, L, R> >::type              \
+        operator op(L const& l, R const& r)                                 \
+        {                                                                   \
+            return binary<name, L, R>(l, r);                                \
+        }                                                                   \
+                                                                            \
+        template <typename L>                                               \
+        typename boost::enable_if<is_expression<L>,                         \
+                binary<name, L, constant<typename L::value_type> > >::type  \
+        operator op(L const& l, typename L::value_type r)                   \
+        {                                                                   \
+            typedef constant<typename L::value_type> R;                     \
+            return binary<name, L, R>(l, R(r));                             \
+        }                                                                   \
+                                                                            \
+        template <typename R>                                               \
+        typename boost::enable_if<is_expression<R>,                         \
+                binary<name, constant<typename R::value_type>, R> >::type   \
+        operator op(typename R::value_type l, R const& r)                   \
+        {                                                                   \
+            typedef constant<typename R::value_type> L;                     \
+            return binary<name, L, R>(L(l), r);                             \
+        }
+
+#define HPX_OPENCL_EXPRESSION_UNARY_FUNCTION(name, fn)                      \
+        struct name { static const char* get() { return #fn; } };          \
+                                                                            \
+        template <typename E>                                               \
+        typename boost::enable_if<is_expression<E>, unary<name, E> >::type  \
+        fn(E const& e)                                                      \
+        {                                                                   \
+            return unary<name, E>(e);                                       \
+        }
+
+        HPX_OPENCL_EXPRESSION_BINARY_OPERATOR(op_plus, +)
+        HPX_OPENCL_EXPRESSION_BINARY_OPERATOR(op_minus, -)
+        HPX_OPENCL_EXPRESSION_BINARY_OPERATOR(op_multiplies, *)
+        HPX_OPENCL_EXPRESSION_BINARY_OPERATOR(op_divides, /)
+
+        HPX_OPENCL_EXPRESSION_UNARY_FUNCTION(fn_exp, exp)
+        HPX_OPENCL_EXPRESSION_UNARY_FUNCTION(fn_log, log)
+        HPX_OPENCL_EXPRESSION_UNARY_FUNCTION(fn_sqrt, sqrt)
+        HPX_OPENCL_EXPRESSION_UNARY_FUNCTION(fn_sin, sin)
+        HPX_OPENCL_EXPRESSION_UNARY_FUNCTION(fn_cos, cos)
+        HPX_OPENCL_EXPRESSION_UNARY_FUNCTION(fn_fabs, fabs)
+
+#undef HPX_OPENCL_EXPRESSION_BINARY_OPERATOR
+#undef HPX_OPENCL_EXPRESSION_UNARY_FUNCTION
+
+        struct op_negate { static const char* get() { return "-"; } };
+
+        template <typename E>
+        typename boost::enable_if<is_expression<E>, unary<op_negate, E> >::type
+        operator-(E const& e)
+        {
+            return unary<op_negate, E>(e);
+        }
+
+    }
+
+    /**
+     *  @brief Wraps a buffer for use in lazy expressions
+     *
+     *  @tparam T       The element type of the buffer.
+     *  @param buffer   The buffer.
+     */
+    template <typename T>
+    expression::terminal<T>
+    lazy(hpx::opencl::buffer buffer)
+    {
+        return expression::terminal<T>(buffer);
+    }
+
+    /**
+     *  @brief Computes an expression with one fused kernel
+     *
+     *  All buffers of the expression and the result buffer need to
+     *  belong to the given device.
+     *
+     *  @param device       The device to compute on.
+     *  @param result       The buffer to write the result to.
+     *  @param num_elements The number of elements to compute.
+     *  @param expr         The expression.
+     *  @param dependencies The events to wait for, e.g. the writes of
+     *                      the input buffers.
+     *  @return             An \ref event that triggers upon completion.
+     */
+    template <typename E>
+    typename boost::enable_if<expression::is_expression<E>,
+                              hpx::lcos::future<hpx::opencl::event> >::type
+    evaluate(hpx::opencl::device device,
+             hpx::opencl::buffer result,
+             std::size_t num_elements,
+             E const& expr,
+             std::vector<hpx::lcos::shared_future<hpx::opencl::event> >
+                dependencies =
+             std::vector<hpx::lcos::shared_future<hpx::opencl::event> >())
+    {
+
+        // generate the kernel
+        expression::arguments<typename E::value_type> args;
+        std::string source = expression::generate_source(expr, args);
+
+        // the kernel only gets built once per expression shape
+        hpx::lcos::shared_future<hpx::opencl::kernel> kernel_future =
+                    get_cached_kernel(device, source, "hpx_opencl_fused");
+
+        // one work item per element
+        hpx::opencl::work_size<1> dim;
+        dim[0].offset = 0;
+        dim[0].size = num_elements;
+        dim[0].local_size = hpx::opencl::auto_local_size;
+
+        hpx::opencl::launch_desc launch(dim);
+        launch.set_arg(0, result);
+        for(std::size_t i = 0; i < args.buffers.size(); i++)
+        {
+            launch.set_arg((cl_uint)(i + 1), args.buffers[i]);
+        }
+        for(std::size_t i = 0; i < args.constants.size(); i++)
+        {
+            launch.set_arg_value((cl_uint)(args.buffers.size() + i + 1),
+                                 args.constants[i]);
+        }
+
+        return kernel_future.then(
+                hpx::util::bind(&expression::launch_fused,
+                                launch,
+                                dependencies,
+                                hpx::util::placeholders::_1));
+
+    }
+
+}}
+
+#endif
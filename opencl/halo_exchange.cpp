@@ -0,0 +1,265 @@
+// Copyright (c)    2014 Martin Stumpf
+//
+// Distributed under the Boost Software License, Version 1.0. (See accompanying
+// file LICENSE_1_0.txt or copy at http://www.boost.org/LICENSE_1_0.txt)
+
+#include "halo_exchange.hpp"
+
+#include <hpx/lcos/when_all.hpp>
+
+#include <algorithm>
+
+using hpx::opencl::halo_exchange;
+
+///////////////////////////////////////////////////
+/// Local functions
+///
+
+// The dependencies of one tile, events is empty or holds one event per tile
+static std::vector<hpx::opencl::event>
+tile_dependencies(std::vector<hpx::opencl::event> const& events, size_t tile)
+{
+    if(events.empty())
+        return std::vector<hpx::opencl::event>();
+
+    return std::vector<hpx::opencl::event>(1, events[tile]);
+}
+
+// Starts a copy after the destination tile is done
+static hpx::lcos::future<hpx::opencl::event>
+start_copy(hpx::opencl::buffer dst, hpx::opencl::buffer src,
+           size_t src_offset, size_t dst_offset, size_t size,
+           std::vector<hpx::opencl::event> src_events,
+           hpx::lcos::future<void> dst_ready)
+{
+    // Rethrows errors of the destination tile
+    dst_ready.get();
+
+    return dst.enqueue_copy(src, src_offset, dst_offset, size, src_events);
+}
+
+// The dependencies of a copy have to be events of the source device.
+// On a different device, the destination tile gets waited for on the host.
+static hpx::lcos::future<hpx::opencl::event>
+enqueue_copy(hpx::opencl::buffer dst, hpx::opencl::buffer src,
+             size_t src_offset, size_t dst_offset, size_t size,
+             std::vector<hpx::opencl::event> src_events,
+             std::vector<hpx::opencl::event> const& dst_events,
+             bool same_device)
+{
+    if(dst_events.empty())
+        return dst.enqueue_copy(src, src_offset, dst_offset, size,
+                                src_events);
+
+    if(same_device)
+    {
+        src_events.insert(src_events.end(), dst_events.begin(),
+                          dst_events.end());
+        return dst.enqueue_copy(src, src_offset, dst_offset, size,
+                                src_events);
+    }
+
+    return dst_events[0].get_future().then(
+                hpx::util::bind(&start_copy, dst, src, src_offset,
+                                dst_offset, size, src_events,
+                                hpx::util::placeholders::_1));
+}
+
+// Combines the copies of a tile into one event on its device.
+// Copies on the device of the tile get merged by the device itself,
+// only the ones on other devices are waited for through the host.
+static hpx::opencl::event
+merge_copy_events(hpx::opencl::device device,
+                  std::vector<hpx::opencl::event> fallback,
+                  std::vector<bool> on_device,
+                  hpx::lcos::future<std::vector<hpx::lcos::shared_future<
+                                    hpx::opencl::event> > > copies_future)
+{
+
+    std::vector<hpx::lcos::shared_future<hpx::opencl::event> > copies =
+                                                        copies_future.get();
+
+    // Nothing to wait for
+    if(copies.empty())
+    {
+        if(!fallback.empty())
+            return fallback[0];
+
+        hpx::opencl::event event = device.create_user_event().get();
+        event.trigger();
+        return event;
+    }
+
+    std::vector<hpx::opencl::event> wait_list;
+    std::vector<hpx::lcos::future<void> > remote;
+    for(size_t i = 0; i < copies.size(); i++)
+    {
+        if(on_device[i])
+            wait_list.push_back(copies[i].get());
+        else
+            remote.push_back(copies[i].get().get_future());
+    }
+
+    // Events of other contexts can't be part of a wait list
+    if(!remote.empty())
+    {
+        wait_list.push_back(
+                device.create_future_event(hpx::when_all(remote)).get());
+    }
+
+    if(wait_list.size() == 1)
+        return wait_list[0];
+
+    return device.enqueue_marker(wait_list).get();
+
+}
+
+// Collects the event of every tile
+static std::vector<hpx::opencl::event>
+get_tile_events(hpx::lcos::future<std::vector<
+                    hpx::lcos::future<hpx::opencl::event> > > events_future)
+{
+
+    std::vector<hpx::lcos::future<hpx::opencl::event> > futures =
+                                                        events_future.get();
+
+    std::vector<hpx::opencl::event> events;
+    events.reserve(futures.size());
+    for(size_t i = 0; i < futures.size(); i++)
+    {
+        events.push_back(futures[i].get());
+    }
+
+    return events;
+
+}
+
+
+///////////////////////////////////////////////////
+/// Implementations
+///
+
+halo_exchange::halo_exchange(size_t chunk_size_)
+  : chunk_size(chunk_size_)
+{
+
+    if(chunk_size == 0)
+    {
+        HPX_THROW_EXCEPTION(hpx::bad_parameter,
+                            "halo_exchange()",
+                            "Chunk size must not be zero!");
+    }
+
+}
+
+size_t
+halo_exchange::add_tile(hpx::opencl::device device,
+                        hpx::opencl::buffer buffer)
+{
+
+    tile new_tile;
+    new_tile.device = device;
+    new_tile.buffer = buffer;
+    tiles.push_back(new_tile);
+
+    return tiles.size() - 1;
+
+}
+
+void
+halo_exchange::add_region(size_t src_tile, size_t src_offset,
+                          size_t dst_tile, size_t dst_offset, size_t size)
+{
+
+    if(src_tile >= tiles.size() || dst_tile >= tiles.size())
+    {
+        HPX_THROW_EXCEPTION(hpx::bad_parameter,
+                            "halo_exchange::add_region()",
+                            "Unknown tile!");
+    }
+
+    region new_region;
+    new_region.src_tile = src_tile;
+    new_region.src_offset = src_offset;
+    new_region.dst_tile = dst_tile;
+    new_region.dst_offset = dst_offset;
+    new_region.size = size;
+
+    // Decide once how the region gets copied
+    hpx::naming::id_type src_device = tiles[src_tile].device.get_gid();
+    hpx::naming::id_type dst_device = tiles[dst_tile].device.get_gid();
+    new_region.same_device = (src_device == dst_device);
+    new_region.same_locality = new_region.same_device
+                            || (hpx::get_colocation_id(src_device).get()
+                                == hpx::get_colocation_id(dst_device).get());
+
+    regions.push_back(new_region);
+
+}
+
+hpx::lcos::future<std::vector<hpx::opencl::event> >
+halo_exchange::run(std::vector<hpx::opencl::event> const& events) const
+{
+
+    if(!events.empty() && events.size() != tiles.size())
+    {
+        HPX_THROW_EXCEPTION(hpx::bad_parameter,
+                            "halo_exchange::run()",
+                            "Need one event per tile!");
+    }
+
+    // The copies every tile takes part in, as source or destination,
+    // and whether they run on the device of the tile
+    std::vector<std::vector<hpx::lcos::shared_future<hpx::opencl::event> > >
+                                                    copies(tiles.size());
+    std::vector<std::vector<bool> > on_device(tiles.size());
+
+    for(size_t i = 0; i < regions.size(); i++)
+    {
+        region const& r = regions[i];
+        tile const& src = tiles[r.src_tile];
+        tile const& dst = tiles[r.dst_tile];
+
+        // Within a locality, one copy per region
+        size_t step = r.same_locality ? std::max<size_t>(r.size, 1)
+                                      : chunk_size;
+
+        for(size_t offset = 0; offset < r.size; offset += step)
+        {
+            size_t size = std::min(step, r.size - offset);
+
+            hpx::lcos::shared_future<hpx::opencl::event> copy =
+                enqueue_copy(dst.buffer, src.buffer,
+                             r.src_offset + offset, r.dst_offset + offset,
+                             size,
+                             tile_dependencies(events, r.src_tile),
+                             tile_dependencies(events, r.dst_tile),
+                             r.same_device);
+
+            // The copy runs on the device of the destination
+            copies[r.src_tile].push_back(copy);
+            on_device[r.src_tile].push_back(r.same_device);
+            if(r.dst_tile != r.src_tile)
+            {
+                copies[r.dst_tile].push_back(copy);
+                on_device[r.dst_tile].push_back(true);
+            }
+        }
+    }
+
+    std::vector<hpx::lcos::future<hpx::opencl::event> > merged;
+    merged.reserve(tiles.size());
+    for(size_t i = 0; i < tiles.size(); i++)
+    {
+        merged.push_back(hpx::when_all(copies[i]).then(
+                    hpx::util::bind(&merge_copy_events, tiles[i].device,
+                                    tile_dependencies(events, i),
+                                    on_device[i],
+                                    hpx::util::placeholders::_1)));
+    }
+
+    return hpx::when_all(merged).then(
+                hpx::util::bind(&get_tile_events,
+                                hpx::util::placeholders::_1));
+
+}
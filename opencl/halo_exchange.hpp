@@ -0,0 +1,135 @@
+// Copyright (c)    2014 Martin Stumpf
+//
+// Distributed under the Boost Software License, Version 1.0. (See accompanying
+// file LICENSE_1_0.txt or copy at http://www.boost.org/LICENSE_1_0.txt)
+
+#pragma once
+#ifndef HPX_OPENCL_HALO_EXCHANGE_HPP_
+#define HPX_OPENCL_HALO_EXCHANGE_HPP_
+
+#include "export_definitions.hpp"
+
+#include <hpx/hpx.hpp>
+#include <hpx/config.hpp>
+#include <hpx/lcos/future.hpp>
+
+#include <vector>
+
+#include "buffer.hpp"
+#include "device.hpp"
+#include "event.hpp"
+
+namespace hpx {
+namespace opencl {
+
+    ////////////////////////
+    /// @brief Exchanges regions between device resident tiles.
+    ///
+    /// The tiles and the copied regions get registered once, every
+    /// \ref run then performs all copies of one iteration.
+    ///
+    /// Each copy is a \ref buffer::enqueue_copy, which copies directly
+    /// if both tiles share a context and through host memory within a
+    /// process. Copies between localities get split into chunks that are
+    /// in flight at the same time, so reading, sending and writing of
+    /// different chunks overlap.
+    ///
+    /// Example:
+    /// \code{.cpp}
+    ///     hpx::opencl::halo_exchange exchange;
+    ///     size_t left = exchange.add_tile(device_a, buffer_a);
+    ///     size_t right = exchange.add_tile(device_b, buffer_b);
+    ///
+    ///     // the last row of the left tile to the top halo of the right one
+    ///     exchange.add_region(left, (rows - 1) * row_size,
+    ///                         right, 0, row_size);
+    ///
+    ///     for(size_t it = 0; it < num_iterations; it++)
+    ///     {
+    ///         events = run_stencil(events);
+    ///         events = exchange.run(events).get();
+    ///     }
+    /// \endcode
+    ///
+    class HPX_OPENCL_EXPORT halo_exchange
+    {
+        public:
+            /**
+             *  @brief Creates an empty exchange
+             *
+             *  @param chunk_size   The size of the chunks of copies between
+             *                      localities, in bytes.
+             */
+            explicit halo_exchange(size_t chunk_size = 256 * 1024);
+
+            /**
+             *  @brief Registers a tile
+             *
+             *  @param device   The device of the buffer.
+             *  @param buffer   The buffer that holds the tile.
+             *  @return         The index of the tile.
+             */
+            size_t add_tile(hpx::opencl::device device,
+                            hpx::opencl::buffer buffer);
+
+            /**
+             *  @brief Registers a region to copy in every \ref run
+             *
+             *  @param src_tile     The index of the source tile.
+             *  @param src_offset   The offset in the source buffer.
+             *  @param dst_tile     The index of the destination tile.
+             *  @param dst_offset   The offset in the destination buffer.
+             *  @param size         The size of the region, in bytes.
+             */
+            void add_region(size_t src_tile, size_t src_offset,
+                            size_t dst_tile, size_t dst_offset, size_t size);
+
+            size_t num_tiles() const { return tiles.size(); }
+            size_t num_regions() const { return regions.size(); }
+
+            /**
+             *  @brief Copies all regions
+             *
+             *  A region gets copied as soon as its source tile and its
+             *  destination tile are done, according to the given events.
+             *
+             *  @param events   Optional, one \ref event per tile to wait
+             *                  for, on the device of the tile.
+             *  @return         One \ref event per tile. It triggers as soon
+             *                  as all regions that get copied from or to
+             *                  the tile are done.
+             */
+            hpx::lcos::future<std::vector<hpx::opencl::event> >
+            run(std::vector<hpx::opencl::event> const& events =
+                                std::vector<hpx::opencl::event>()) const;
+
+        private:
+            struct tile
+            {
+                hpx::opencl::device device;
+                hpx::opencl::buffer buffer;
+            };
+
+            struct region
+            {
+                size_t src_tile;
+                size_t src_offset;
+                size_t dst_tile;
+                size_t dst_offset;
+                size_t size;
+
+                // Whether the tiles live on the same device or locality
+                bool same_device;
+                bool same_locality;
+            };
+
+        private:
+            size_t chunk_size;
+            std::vector<tile> tiles;
+            std::vector<region> regions;
+
+    };
+
+}}
+
+#endif
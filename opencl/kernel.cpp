@@ -14,6 +14,9 @@
 #include "buffer.hpp"
 #include "event.hpp"
 #include "enqueue_overloads.hpp"
+#include "tools.hpp"
+
+#include <hpx/runtime/get_ptr.hpp>
 
 using namespace hpx::opencl;
 
@@ -37,6 +40,36 @@ kernel::set_arg_async(cl_uint arg_index, buffer arg) const
 
 }
 
+#ifdef CL_VERSION_2_0
+void
+kernel::set_arg_svm(cl_uint arg_index, const void* ptr) const
+{
+
+    set_arg_svm_async(arg_index, ptr).get();
+
+}
+
+hpx::lcos::future<void>
+kernel::set_arg_svm_async(cl_uint arg_index, const void* ptr) const
+{
+    
+    BOOST_ASSERT(this->get_gid());
+
+    // The pointer is meaningless in other processes
+    if(!is_local(this->get_gid()))
+    {
+        HPX_THROW_EXCEPTION(hpx::bad_parameter,
+                            "kernel::set_arg_svm()",
+                            "SVM arguments need a kernel on this locality!");
+    }
+
+    typedef hpx::opencl::server::kernel::set_arg_svm_action func;
+
+    return hpx::async<func>(this->get_gid(), arg_index, (intptr_t)ptr);
+
+}
+#endif
+
 HPX_OPENCL_OVERLOAD_FUNCTION(kernel, enqueue,
                           cl_uint work_dim                     COMMA
                           const size_t *global_work_offset_ptr COMMA
@@ -59,6 +92,84 @@ kernel::enqueue(cl_uint work_dim,
 
 
 
+    // Serialize the dimensions
+    std::vector<std::vector<size_t>> args = 
+            pack_dimensions(work_dim, global_work_offset_ptr,
+                                      global_work_size_ptr,
+                                      local_work_size_ptr);
+
+    // Invoke server call
+    typedef hpx::opencl::server::kernel::enqueue_action func;
+    return hpx::async<func>(this->get_gid(), work_dim,
+                                             args,
+                                             events);
+
+}
+
+HPX_OPENCL_OVERLOAD_FUNCTION(kernel, enqueue_bulk,
+                          std::vector<hpx::opencl::launch_desc> launches,
+                          launches);
+
+// Extracts the aggregate event from the result of enqueue_bulk_with_events
+static hpx::opencl::event
+enqueue_bulk_callback(hpx::lcos::future<std::vector<hpx::opencl::event>>
+                                                                        events)
+{
+    return events.get()[0];
+}
+
+hpx::lcos::future<hpx::opencl::event>
+kernel::enqueue_bulk(std::vector<hpx::opencl::launch_desc> launches,
+                     std::vector<hpx::opencl::event> events) const
+{
+
+    BOOST_ASSERT(this->get_gid());
+
+    // Invoke server call, without per-launch events
+    typedef hpx::opencl::server::kernel::enqueue_bulk_action func;
+    return hpx::async<func>(this->get_gid(), launches, events, false).then(
+                    hpx::util::bind(&enqueue_bulk_callback,
+                                    util::placeholders::_1));
+
+}
+
+hpx::lcos::future<std::vector<hpx::opencl::event>>
+kernel::enqueue_bulk_with_events(std::vector<hpx::opencl::launch_desc> launches,
+                                 std::vector<hpx::opencl::event> events) const
+{
+
+    BOOST_ASSERT(this->get_gid());
+
+    // Invoke server call
+    typedef hpx::opencl::server::kernel::enqueue_bulk_action func;
+    return hpx::async<func>(this->get_gid(), launches, events, true);
+
+}
+
+HPX_OPENCL_OVERLOAD_FUNCTION(kernel, enqueue_launch,
+                          hpx::opencl::launch_desc launch,
+                          launch);
+
+hpx::lcos::future<hpx::opencl::event>
+kernel::enqueue_launch(hpx::opencl::launch_desc launch,
+                       std::vector<hpx::opencl::event> events) const
+{
+
+    BOOST_ASSERT(this->get_gid());
+
+    // Invoke server call
+    typedef hpx::opencl::server::kernel::enqueue_launch_action func;
+    return hpx::async<func>(this->get_gid(), launch, events);
+
+}
+
+std::vector<std::vector<size_t>>
+kernel::pack_dimensions(cl_uint work_dim,
+                        const size_t *global_work_offset_ptr,
+                        const size_t *global_work_size_ptr,
+                        const size_t *local_work_size_ptr)
+{
+
     // Serialize global_work_offset
     std::vector<size_t> global_work_offset(0);
     if(global_work_offset_ptr != NULL)
@@ -99,15 +210,83 @@ kernel::enqueue(cl_uint work_dim,
     args.push_back(global_work_size);
     args.push_back(local_work_size);
 
+    return args;
+
+}
+
+hpx::lcos::future<std::vector<size_t>>
+kernel::autotune_impl(cl_uint work_dim,
+                      std::vector<std::vector<size_t>> args) const
+{
+
+    BOOST_ASSERT(this->get_gid());
+
     // Invoke server call
+    typedef hpx::opencl::server::kernel::autotune_action func;
+    return hpx::async<func>(this->get_gid(), work_dim, args);
+
+}
+
+hpx::lcos::future<size_t>
+kernel::get_work_group_size() const
+{
+
+    BOOST_ASSERT(this->get_gid());
+
+    // Invoke server call
+    typedef hpx::opencl::server::kernel::get_work_group_size_action func;
+    return hpx::async<func>(this->get_gid());
+
+}
+
+// Converts the event of a remote enqueue to a future
+static hpx::lcos::future<void>
+enqueue_async_event_callback(hpx::lcos::future<hpx::opencl::event> event)
+{
+    return event.get().get_future();
+}
+
+hpx::lcos::future<void>
+kernel::enqueue_async_impl(cl_uint work_dim,
+                           std::vector<std::vector<size_t>> args) const
+{
+
+    BOOST_ASSERT(this->get_gid());
+
+    // Local kernels don't need an event component
+    if(hpx::opencl::is_local(this->get_gid()))
+    {
+        boost::shared_ptr<hpx::opencl::server::kernel> kernel_server =
+                hpx::get_ptr<hpx::opencl::server::kernel>(this->get_gid()).get();
+
+        return kernel_server->enqueue_local(work_dim, args);
+    }
+
+    // Remote kernels need an event component to wait for
     typedef hpx::opencl::server::kernel::enqueue_action func;
-    return hpx::async<func>(this->get_gid(), work_dim,
-                                             args,
-                                             events);
+    std::vector<hpx::opencl::event> events(0);
+    return hpx::async<func>(this->get_gid(), work_dim, args, events).then(
+                    hpx::util::bind(&enqueue_async_event_callback,
+                                    util::placeholders::_1));
 
 }
 
+hpx::lcos::future<void>
+kernel::enqueue_async_callback(kernel cl, cl_uint work_dim,
+                               std::vector<std::vector<size_t>> args,
+                               hpx::lcos::future<std::vector<
+                                    hpx::lcos::shared_future<void>
+                                                            >> futures)
+{
 
+    // Rethrow exceptions of dependencies
+    std::vector<hpx::lcos::shared_future<void>> futures_list = futures.get();
+    BOOST_FOREACH(hpx::lcos::shared_future<void> & future, futures_list)
+    {
+        future.get();
+    }
 
+    return cl.enqueue_async_impl(work_dim, args);
 
+}
 
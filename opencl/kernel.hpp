@@ -18,58 +18,14 @@
 #include <boost/serialization/vector.hpp>
 
 #include "event.hpp"
+#include "work_size.hpp"
+#include "launch_desc.hpp"
+#include "typed_buffer.hpp"
 #include "fwd_declarations.hpp"
 
 namespace hpx {
 namespace opencl {
 
-    ////////////////////////
-    /// @brief Kernel execution dimensions.
-    ///
-    /// This structure offers an alternative way to set and reuse kernel 
-    /// execution dimensions.
-    /// 
-    /// Example:
-    /// \code{.cpp}
-    ///     // Create work_size object
-    ///     hpx::opencl::work_size<1> dim;                                           
-    ///
-    ///     // Set dimensions. 
-    ///     dim[0].offset = 0;                                                       
-    ///     dim[0].size = 2048; 
-    ///     
-    ///     // Set local work size.
-    ///     // This can be left out.
-    ///     // OpenCL will then automatically determine the best local work size.
-    ///     dim[0].local_size = 64;
-    ///
-    ///     // Enqueue a kernel using the work_size object
-    ///     event kernel_event = kernel.enqueue(dim).get();
-    ///
-    /// \endcode
-    ///
-    template <size_t DIM>
-    struct work_size
-    {
-        private:
-        struct dimension
-        {
-            size_t offset;
-            size_t size;
-            size_t local_size;
-            dimension(){
-                offset = 0;
-                size = 0;
-                local_size = 0;
-            }
-        };
-        private:
-            // local_size be treated as NULL if all dimensions have local_size == 0
-            dimension dims[DIM];
-        public:
-            dimension& operator[](size_t idx){ return dims[idx]; }
-    };
-    
     /////////////////////////
     /// @brief An OpenCL kernel.
     ///
@@ -121,6 +77,74 @@ namespace opencl {
              */
             hpx::lcos::future<void>
             set_arg_async(cl_uint arg_index, hpx::opencl::buffer arg) const;
+
+            /**
+             *  @brief Sets a \ref typed_buffer as kernel argument
+             *
+             *  The kernel only sees the memory, the element type is not
+             *  checked against the kernel signature.
+             *
+             *  @param arg_index    The argument index to which the buffer will
+             *                      be connected.
+             *  @param arg          The \ref typed_buffer that will be
+             *                      connected.
+             */
+            template <typename T>
+            void
+            set_arg(cl_uint arg_index,
+                    hpx::opencl::typed_buffer<T> const& arg) const
+            {
+                set_arg(arg_index, arg.get_buffer());
+            }
+
+            /**
+             *  @brief Sets a \ref typed_buffer as kernel argument
+             *
+             *  This is the non-blocking version of \ref set_arg.
+             *
+             *  @param arg_index    The argument index to which the buffer will
+             *                      be connected.
+             *  @param arg          The \ref typed_buffer that will be
+             *                      connected.
+             *  @return             A future that will trigger upon completion.
+             */
+            template <typename T>
+            hpx::lcos::future<void>
+            set_arg_async(cl_uint arg_index,
+                          hpx::opencl::typed_buffer<T> const& arg) const
+            {
+                return set_arg_async(arg_index, arg.get_buffer());
+            }
+
+#ifdef CL_VERSION_2_0
+            /**
+             *  @brief Sets a shared virtual memory pointer as kernel argument
+             *
+             *  The kernel needs to be on the current locality, as SVM
+             *  pointers are only valid within one process.
+             *
+             *  @param arg_index    The argument index to which the pointer
+             *                      will be connected.
+             *  @param ptr          Memory from an \ref svm_allocator of
+             *                      the device of the kernel.
+             */
+            void
+            set_arg_svm(cl_uint arg_index, const void* ptr) const;
+
+            /**
+             *  @brief Sets a shared virtual memory pointer as kernel argument
+             *
+             *  This is the non-blocking version of \ref set_arg_svm.
+             *
+             *  @param arg_index    The argument index to which the pointer
+             *                      will be connected.
+             *  @param ptr          Memory from an \ref svm_allocator of
+             *                      the device of the kernel.
+             *  @return             A future that will trigger upon completion.
+             */
+            hpx::lcos::future<void>
+            set_arg_svm_async(cl_uint arg_index, const void* ptr) const;
+#endif
             
             // Runs the kernel
             /**
@@ -285,6 +309,213 @@ namespace opencl {
                std::vector<hpx::lcos::shared_future<hpx::opencl::event>> events) const;
              //@}
 
+            // Runs the kernel multiple times
+            /**
+             *  @name Starts multiple executions of a kernel at once.
+             *
+             *  All launches get submitted within a single action, which
+             *  saves parcel and component overhead for large numbers
+             *  of small launches.
+             *  
+             *  The launches have no dependencies between each other, they
+             *  only depend on the given events.
+             *
+             *  @param launches     The \ref launch_desc "launch descriptions".
+             *  @return             An \ref event that triggers upon
+             *                      completion of all launches.
+             */
+            //@{
+            /**
+             *  @brief Starts kernels immediately
+             */
+            hpx::lcos::future<hpx::opencl::event>
+            enqueue_bulk(std::vector<hpx::opencl::launch_desc> launches) const;
+
+            /**
+             *  @brief Depends on an event
+             *
+             *  @param event    The \ref event to wait for.
+             */
+            hpx::lcos::future<hpx::opencl::event>
+            enqueue_bulk(std::vector<hpx::opencl::launch_desc> launches,
+                         hpx::opencl::event event) const;
+
+            /**
+             *  @brief Depends on multiple events
+             *
+             *  @param events   The \ref event "events" to wait for.
+             */
+            hpx::lcos::future<hpx::opencl::event>
+            enqueue_bulk(std::vector<hpx::opencl::launch_desc> launches,
+                         std::vector<hpx::opencl::event> events) const;
+
+            /**
+             *  @brief Depends on one future event
+             *
+             *  @param event    The future \ref event to wait for.
+             */
+            hpx::lcos::future<hpx::opencl::event>
+            enqueue_bulk(std::vector<hpx::opencl::launch_desc> launches,
+                     hpx::lcos::shared_future<hpx::opencl::event> event) const;
+
+            /**
+             *  @brief Depends on multiple future events
+             *
+             *  @param events   The future \ref event "events" to wait for.
+             */
+            hpx::lcos::future<hpx::opencl::event>
+            enqueue_bulk(std::vector<hpx::opencl::launch_desc> launches,
+               std::vector<hpx::lcos::shared_future<hpx::opencl::event>> events) const;
+            //@}
+
+            // Runs the kernel with its own arguments
+            /**
+             *  @name Starts execution of a kernel with its own arguments.
+             *
+             *  The arguments given in the \ref launch_desc only apply to
+             *  this launch, the arguments set via \ref set_arg stay
+             *  untouched. Internally, every concurrent launch uses its own
+             *  OpenCL kernel object from the kernel pool, so multiple
+             *  workers can share one kernel without interfering.
+             *
+             *  @param launch   The \ref launch_desc "launch description".
+             *  @return         An \ref event that triggers upon completion.
+             *
+             *  @see program::get_kernel_pool
+             */
+            //@{
+            /**
+             *  @brief Starts kernel immediately
+             */
+            hpx::lcos::future<hpx::opencl::event>
+            enqueue_launch(hpx::opencl::launch_desc launch) const;
+
+            /**
+             *  @brief Depends on an event
+             *
+             *  @param event    The \ref event to wait for.
+             */
+            hpx::lcos::future<hpx::opencl::event>
+            enqueue_launch(hpx::opencl::launch_desc launch,
+                           hpx::opencl::event event) const;
+
+            /**
+             *  @brief Depends on multiple events
+             *
+             *  @param events   The \ref event "events" to wait for.
+             */
+            hpx::lcos::future<hpx::opencl::event>
+            enqueue_launch(hpx::opencl::launch_desc launch,
+                           std::vector<hpx::opencl::event> events) const;
+
+            /**
+             *  @brief Depends on one future event
+             *
+             *  @param event    The future \ref event to wait for.
+             */
+            hpx::lcos::future<hpx::opencl::event>
+            enqueue_launch(hpx::opencl::launch_desc launch,
+                     hpx::lcos::shared_future<hpx::opencl::event> event) const;
+
+            /**
+             *  @brief Depends on multiple future events
+             *
+             *  @param events   The future \ref event "events" to wait for.
+             */
+            hpx::lcos::future<hpx::opencl::event>
+            enqueue_launch(hpx::opencl::launch_desc launch,
+               std::vector<hpx::lcos::shared_future<hpx::opencl::event>> events) const;
+            //@}
+
+            /**
+             *  @brief Starts multiple executions of a kernel at once.
+             *
+             *  Same as \ref enqueue_bulk, but additionally creates one
+             *  \ref event per launch.
+             *
+             *  @param launches     The \ref launch_desc "launch descriptions".
+             *  @param events       The \ref event "events" to wait for.
+             *  @return             A list of \ref event "events".<BR>
+             *                      The first event triggers upon completion
+             *                      of all launches, followed by one event per
+             *                      launch.
+             */
+            hpx::lcos::future<std::vector<hpx::opencl::event>>
+            enqueue_bulk_with_events(
+                        std::vector<hpx::opencl::launch_desc> launches,
+                        std::vector<hpx::opencl::event> events) const;
+
+            /**
+             *  @brief Finds the fastest local work size for the given
+             *         dimensions.
+             *
+             *  Runs the kernel several times with different local work
+             *  sizes, using the arguments set via \ref set_arg.
+             *  The fastest local work size will then be used for all
+             *  following launches with the same global work size and
+             *  \ref auto_local_size.
+             *
+             *  <B>The kernel has to be idempotent</B>, as it gets executed
+             *  multiple times.
+             *
+             *  @param size     The work dimensions to tune for. The
+             *                  local sizes will be ignored.
+             *  @return         The chosen local work size. An empty list
+             *                  means that choosing the local work size
+             *                  is left to the OpenCL runtime.
+             */
+            template<size_t DIM>
+            hpx::lcos::future<std::vector<size_t>>
+            autotune(hpx::opencl::work_size<DIM> size) const;
+
+            /**
+             *  @brief The maximum work group size of the kernel
+             *
+             *  Depends on the resources the compiled kernel uses, so it
+             *  can be smaller than the limit of the device.
+             *
+             *  @return         CL_KERNEL_WORK_GROUP_SIZE of the kernel
+             *                  on its device.
+             */
+            hpx::lcos::future<size_t>
+            get_work_group_size() const;
+
+            // Runs the kernel, returns a plain future
+            /**
+             *  @name Starts execution of a kernel, without event.
+             *
+             *  This is a lightweight version of \ref enqueue.
+             *  If the kernel lives on the current locality, no \ref event
+             *  component gets created. The returned future is directly
+             *  connected to the OpenCL command.
+             *  An event component only gets created if the kernel lives
+             *  on a different locality.
+             *
+             *  @param size     The work dimensions on which the kernel should
+             *                  get executed on.
+             *  @return         A future that triggers upon completion.
+             */
+            //@{
+            /**
+             *  @brief Starts kernel immediately
+             */
+            template<size_t DIM>
+            hpx::lcos::future<void>
+            enqueue_async(hpx::opencl::work_size<DIM> size) const;
+
+            /**
+             *  @brief Depends on multiple futures
+             *
+             *  The kernel will not execute before the futures triggered.
+             *
+             *  @param dependencies     The futures to wait for.
+             */
+            template<size_t DIM>
+            hpx::lcos::future<void>
+            enqueue_async(hpx::opencl::work_size<DIM> size,
+               std::vector<hpx::lcos::shared_future<void>> dependencies) const;
+            //@}
+
         private:
             // LOCAL HELPER CALLBACK FUNCTIONS
             template<size_t DIM>
@@ -303,6 +534,38 @@ namespace opencl {
                                 hpx::lcos::shared_future<hpx::opencl::event>
                                                           >> futures);
 
+            static
+            hpx::lcos::future<void>
+            enqueue_async_callback(kernel cl, cl_uint work_dim,
+                            std::vector<std::vector<size_t>> args,
+                            hpx::lcos::future<std::vector<
+                                hpx::lcos::shared_future<void>
+                                                          >> futures);
+
+            // Converts the kernel dimensions to a serializable format
+            static
+            std::vector<std::vector<size_t>>
+            pack_dimensions(cl_uint work_dim,
+                            const size_t *global_work_offset,
+                            const size_t *global_work_size,
+                            const size_t *local_work_size);
+
+            // Converts a work_size to a serializable format
+            template<size_t DIM>
+            static
+            std::vector<std::vector<size_t>>
+            pack_dimensions(hpx::opencl::work_size<DIM> dim);
+
+            // Runs the autotuning
+            hpx::lcos::future<std::vector<size_t>>
+            autotune_impl(cl_uint work_dim,
+                          std::vector<std::vector<size_t>> args) const;
+
+            // Enqueues the kernel without creating a local event component
+            hpx::lcos::future<void>
+            enqueue_async_impl(cl_uint work_dim,
+                               std::vector<std::vector<size_t>> args) const;
+
     };
 
     template<size_t DIM>
@@ -437,6 +700,76 @@ namespace opencl {
         );
     }
 
+    template<size_t DIM>
+    std::vector<std::vector<size_t>>
+    kernel::pack_dimensions(hpx::opencl::work_size<DIM> dim)
+    {
+
+        // Casts everything to pointers
+        size_t global_work_offset[DIM];
+        size_t global_work_size[DIM];
+        size_t local_work_size_[DIM];
+        size_t *local_work_size = NULL;
+
+        // Write work_size to size_t arrays
+        for(size_t i = 0; i < DIM; i++)
+        {
+            global_work_offset[i] = dim[i].offset;
+            global_work_size[i] = dim[i].size;
+            local_work_size_[i] = dim[i].local_size;
+        }
+
+        // Checks for local_work_size == NULL
+        for(size_t i = 0; i < DIM; i++)
+        {
+            if(local_work_size_[i] != 0)
+            {
+                local_work_size = local_work_size_;
+                break;
+            }
+        }
+
+        return pack_dimensions(DIM, global_work_offset, global_work_size,
+                               local_work_size);
+
+    }
+
+    template<size_t DIM>
+    hpx::lcos::future<std::vector<size_t>>
+    kernel::autotune(hpx::opencl::work_size<DIM> size) const
+    {
+        // The local sizes get chosen by the autotuning
+        for(size_t i = 0; i < DIM; i++)
+        {
+            size[i].local_size = 0;
+        }
+
+        return autotune_impl(DIM, pack_dimensions(size));
+    }
+
+    template<size_t DIM>
+    hpx::lcos::future<void>
+    kernel::enqueue_async(hpx::opencl::work_size<DIM> size) const
+    {
+        return enqueue_async_impl(DIM, pack_dimensions(size));
+    }
+
+    template<size_t DIM>
+    hpx::lcos::future<void>
+    kernel::enqueue_async(hpx::opencl::work_size<DIM> size,
+               std::vector<hpx::lcos::shared_future<void>> dependencies) const
+    {
+        return hpx::when_all(dependencies).then(
+            hpx::util::bind(
+                &enqueue_async_callback,
+                *this,
+                static_cast<cl_uint>(DIM),
+                pack_dimensions(size),
+                util::placeholders::_1
+            )
+        );
+    }
+
 }}
 
 
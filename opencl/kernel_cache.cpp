@@ -0,0 +1,192 @@
+// Copyright (c)    2014 Martin Stumpf
+//
+// Distributed under the Boost Software License, Version 1.0. (See accompanying
+// file LICENSE_1_0.txt or copy at http://www.boost.org/LICENSE_1_0.txt)
+
+#include "kernel_cache.hpp"
+
+#include "device.hpp"
+#include "program.hpp"
+#include "kernel.hpp"
+
+#include <hpx/lcos/local/spinlock.hpp>
+#include <hpx/util/static.hpp>
+#include <hpx/runtime.hpp>
+
+#include <list>
+#include <map>
+#include <string>
+
+///////////////////////////////////////////////////
+/// STATIC STUFF
+///
+
+using hpx::lcos::local::spinlock;
+
+// serves as a unique tag to get the kernel cache
+struct global_kernel_cache_tag {};
+
+// The maximal number of cached kernels, the least recently used ones
+// get dropped first
+#define KERNEL_CACHE_CAPACITY 256
+
+// Identifies a kernel: the device, and the build options, kernel name and
+// source code separated by zero bytes
+typedef std::pair<hpx::naming::gid_type, std::string> kernel_cache_key;
+
+struct kernel_cache_entry
+{
+    hpx::lcos::shared_future<hpx::opencl::kernel> kernel;
+
+    // Tells builds of the same key apart, a failed build only removes
+    // its own entry
+    std::size_t build_id;
+
+    // The position in kernel_cache::lru
+    std::list<kernel_cache_key>::iterator lru_position;
+};
+
+struct kernel_cache
+{
+    kernel_cache() : next_build_id(0) {}
+
+    std::map<kernel_cache_key, kernel_cache_entry> entries;
+
+    // The least recently used key first
+    std::list<kernel_cache_key> lru;
+
+    std::size_t next_build_id;
+};
+
+// Will be set to true once the cache shutdown hook is set.
+static bool kernel_cache_shutdown_hook_initialized = false;
+
+// The static kernel cache, generating instances of this type will always
+// give the same cache
+typedef
+hpx::util::static_<kernel_cache,
+                   global_kernel_cache_tag>  static_kernel_cache_type;
+
+// The static kernel cache lock.
+// Only guards the cache, the builds run outside of the lock.
+typedef
+hpx::util::static_<spinlock,
+                   global_kernel_cache_tag>  static_kernel_cache_lock_type;
+
+// The shutdown hook for clearing the kernel cache on hpx::finalize()
+static void clear_kernel_cache()
+{
+
+    static_kernel_cache_lock_type cache_lock;
+    boost::lock_guard<spinlock> lock(cache_lock.get());
+
+    static_kernel_cache_type cache;
+    cache.get().entries.clear();
+    cache.get().lru.clear();
+
+}
+
+// Removes the entry of a failed build, unless it got replaced already
+static void remove_failed_build(kernel_cache_key const& key,
+                                std::size_t build_id)
+{
+
+    static_kernel_cache_lock_type cache_lock;
+    boost::lock_guard<spinlock> lock(cache_lock.get());
+
+    static_kernel_cache_type cache;
+    std::map<kernel_cache_key, kernel_cache_entry>::iterator it =
+                                                cache.get().entries.find(key);
+    if(it == cache.get().entries.end() || it->second.build_id != build_id)
+        return;
+
+    cache.get().lru.erase(it->second.lru_position);
+    cache.get().entries.erase(it);
+
+}
+
+// Builds the program and creates the kernel
+static hpx::opencl::kernel
+build_kernel(hpx::opencl::device device, std::string source,
+             std::string kernel_name, std::string build_options,
+             kernel_cache_key key, std::size_t build_id)
+{
+
+    try
+    {
+        hpx::opencl::program program =
+                            device.create_program_with_source(source);
+        program.build(build_options);
+
+        return program.get_kernel_pool(kernel_name,
+                                       hpx::get_os_thread_count());
+    }
+    catch(...)
+    {
+        // The next request builds again
+        remove_failed_build(key, build_id);
+        throw;
+    }
+
+}
+
+///////////////////////////////////////////////////
+/// Implementations
+///
+
+hpx::lcos::shared_future<hpx::opencl::kernel>
+hpx::opencl::get_cached_kernel(hpx::opencl::device device,
+                               std::string const& source,
+                               std::string const& kernel_name,
+                               std::string const& build_options)
+{
+
+    BOOST_ASSERT(device.get_gid());
+
+    std::string key_string = build_options;
+    key_string.push_back('\0');
+    key_string += kernel_name;
+    key_string.push_back('\0');
+    key_string += source;
+    kernel_cache_key key(device.get_gid().get_gid(), key_string);
+
+    static_kernel_cache_lock_type cache_lock;
+    boost::lock_guard<spinlock> lock(cache_lock.get());
+
+    // Register the shutdown hook to empty the cache before shutdown
+    if(kernel_cache_shutdown_hook_initialized == false)
+    {
+        hpx::get_runtime_ptr()->add_pre_shutdown_function(&clear_kernel_cache);
+        kernel_cache_shutdown_hook_initialized = true;
+    }
+
+    static_kernel_cache_type cache;
+    std::map<kernel_cache_key, kernel_cache_entry>::iterator it =
+                                                cache.get().entries.find(key);
+    if(it != cache.get().entries.end())
+    {
+        // Mark as most recently used
+        cache.get().lru.splice(cache.get().lru.end(), cache.get().lru,
+                               it->second.lru_position);
+        return it->second.kernel;
+    }
+
+    // Make room, kernels that are in use stay alive through their clients
+    while(cache.get().entries.size() >= KERNEL_CACHE_CAPACITY)
+    {
+        cache.get().entries.erase(cache.get().lru.front());
+        cache.get().lru.pop_front();
+    }
+
+    // Build asynchronously, concurrent requests for the same kernel
+    // wait for the same build
+    kernel_cache_entry entry;
+    entry.build_id = cache.get().next_build_id++;
+    entry.kernel = hpx::async(&build_kernel, device, source, kernel_name,
+                              build_options, key, entry.build_id);
+    entry.lru_position = cache.get().lru.insert(cache.get().lru.end(), key);
+    cache.get().entries.insert(std::make_pair(key, entry));
+
+    return entry.kernel;
+
+}
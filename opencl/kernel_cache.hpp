@@ -0,0 +1,55 @@
+// Copyright (c)    2014 Martin Stumpf
+//
+// Distributed under the Boost Software License, Version 1.0. (See accompanying
+// file LICENSE_1_0.txt or copy at http://www.boost.org/LICENSE_1_0.txt)
+
+#pragma once
+#ifndef HPX_OPENCL_KERNEL_CACHE_HPP_
+#define HPX_OPENCL_KERNEL_CACHE_HPP_
+
+#include "export_definitions.hpp"
+
+#include <hpx/config.hpp>
+#include <hpx/hpx.hpp>
+#include <hpx/lcos/future.hpp>
+
+#include <string>
+
+#include "fwd_declarations.hpp"
+
+////////////////////////////////////////////////////////////////
+namespace hpx { namespace opencl{
+
+    /**
+     *  @brief Returns a kernel built from generated source code
+     *
+     *  The program gets built only once per device, source and build
+     *  options. All later calls return the same kernel, so generated
+     *  kernels don't get recompiled for every use.
+     *
+     *  The kernel is a kernel pool, it can be used by multiple threads
+     *  at once via \ref kernel::enqueue_launch.
+     *
+     *  The cache holds a limited number of kernels and drops the least
+     *  recently used ones, so values that change from call to call
+     *  should be kernel arguments instead of part of the source.
+     *  Failed builds don't get cached, the next call builds again.
+     *  The cache gets cleared on hpx::finalize().
+     *
+     *  @param device           The device to build the kernel for.
+     *  @param source           The source code of the program.
+     *  @param kernel_name      The name of the kernel function.
+     *  @param build_options    The build options of the program.
+     *  @return                 A future to the kernel, triggers as soon
+     *                          as the program is built.
+     */
+    HPX_OPENCL_EXPORT
+    hpx::lcos::shared_future<hpx::opencl::kernel>
+    get_cached_kernel(hpx::opencl::device device,
+                      std::string const& source,
+                      std::string const& kernel_name,
+                      std::string const& build_options = "");
+
+}}
+
+#endif
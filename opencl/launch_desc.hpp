@@ -0,0 +1,188 @@
+// Copyright (c)    2014 Martin Stumpf
+//
+// Distributed under the Boost Software License, Version 1.0. (See accompanying
+// file LICENSE_1_0.txt or copy at http://www.boost.org/LICENSE_1_0.txt)
+
+#pragma once
+#ifndef HPX_OPENCL_LAUNCH_DESC_HPP_
+#define HPX_OPENCL_LAUNCH_DESC_HPP_
+
+#include <hpx/hpx.hpp>
+#include <hpx/config.hpp>
+
+#include <CL/cl.h>
+
+#include <boost/serialization/vector.hpp>
+#include <boost/serialization/utility.hpp>
+
+#include <vector>
+#include <utility>
+
+#include "work_size.hpp"
+#include "buffer.hpp"
+#include "typed_buffer.hpp"
+
+namespace hpx {
+namespace opencl {
+
+    ////////////////////////
+    /// @brief Description of a single kernel launch.
+    ///
+    /// A list of launch descriptions can be submitted at once via
+    /// \ref kernel::enqueue_bulk, a single one via
+    /// \ref kernel::enqueue_launch.
+    ///
+    /// Example:
+    /// \code{.cpp}
+    ///     std::vector<hpx::opencl::launch_desc> launches;
+    ///     for(size_t i = 0; i < 16; i++)
+    ///     {
+    ///         hpx::opencl::work_size<1> dim;
+    ///         dim[0].offset = i * 1024;
+    ///         dim[0].size = 1024;
+    ///
+    ///         hpx::opencl::launch_desc launch(dim);
+    ///
+    ///         // Arguments can be changed from launch to launch.
+    ///         // They stay set for all following launches.
+    ///         launch.set_arg(0, output_buffers[i]);
+    ///
+    ///         launches.push_back(launch);
+    ///     }
+    ///
+    ///     event all_done = kernel.enqueue_bulk(launches).get();
+    /// \endcode
+    ///
+    struct launch_desc
+    {
+        public:
+            // Empty constructor, necessary for serialization
+            launch_desc() : work_dim(0) {}
+
+            /**
+             *  @brief Creates a launch description from pointers
+             *
+             *  The arguments are the same as in \ref kernel::enqueue.
+             */
+            launch_desc(cl_uint work_dim_,
+                        const size_t *global_work_offset_,
+                        const size_t *global_work_size_,
+                        const size_t *local_work_size_)
+              : work_dim(work_dim_)
+            {
+                if(global_work_offset_ != NULL)
+                    global_work_offset.assign(global_work_offset_,
+                                              global_work_offset_ + work_dim);
+                if(global_work_size_ != NULL)
+                    global_work_size.assign(global_work_size_,
+                                            global_work_size_ + work_dim);
+                if(local_work_size_ != NULL)
+                    local_work_size.assign(local_work_size_,
+                                           local_work_size_ + work_dim);
+            }
+
+            /**
+             *  @brief Creates a launch description from a \ref work_size
+             */
+            template <size_t DIM>
+            explicit launch_desc(hpx::opencl::work_size<DIM> dim)
+              : work_dim(DIM)
+            {
+                bool has_local_size = false;
+                for(size_t i = 0; i < DIM; i++)
+                {
+                    global_work_offset.push_back(dim[i].offset);
+                    global_work_size.push_back(dim[i].size);
+                    local_work_size.push_back(dim[i].local_size);
+                    if(dim[i].local_size != 0)
+                        has_local_size = true;
+                }
+
+                // local_work_size == NULL if all dimensions are 0
+                if(!has_local_size)
+                    local_work_size.clear();
+            }
+
+            /**
+             *  @brief Sets a kernel argument before this launch
+             *
+             *  Within \ref kernel::enqueue_bulk, the argument stays set for
+             *  all following launches.
+             *
+             *  @param arg_index    The argument index to which the buffer will
+             *                      be connected.
+             *  @param arg          The \ref buffer that will be connected.
+             */
+            void set_arg(cl_uint arg_index, hpx::opencl::buffer arg)
+            {
+                args.push_back(std::make_pair(arg_index, arg.get_gid()));
+            }
+
+            /**
+             *  @brief Sets a \ref typed_buffer as kernel argument before
+             *         this launch
+             *
+             *  Within \ref kernel::enqueue_bulk, the argument stays set for
+             *  all following launches.
+             *
+             *  @param arg_index    The argument index to which the buffer will
+             *                      be connected.
+             *  @param arg          The \ref typed_buffer that will be
+             *                      connected.
+             */
+            template <typename T>
+            void set_arg(cl_uint arg_index,
+                         hpx::opencl::typed_buffer<T> const& arg)
+            {
+                set_arg(arg_index, arg.get_buffer());
+            }
+
+            /**
+             *  @brief Sets a scalar kernel argument before this launch
+             *
+             *  Within \ref kernel::enqueue_bulk, the argument stays set for
+             *  all following launches.
+             *
+             *  @param arg_index    The argument index.
+             *  @param value        The value, gets copied bytewise.
+             */
+            template <typename T>
+            void set_arg_value(cl_uint arg_index, T const& value)
+            {
+                const char* bytes = reinterpret_cast<const char*>(&value);
+                value_args.push_back(std::make_pair(arg_index,
+                                std::vector<char>(bytes, bytes + sizeof(T))));
+            }
+
+        public:
+            // The dimensions of the launch.
+            // Empty vectors will be treated as NULL.
+            cl_uint work_dim;
+            std::vector<size_t> global_work_offset;
+            std::vector<size_t> global_work_size;
+            std::vector<size_t> local_work_size;
+
+            // The buffer arguments that get set before the launch
+            std::vector<std::pair<cl_uint, hpx::naming::id_type>> args;
+
+            // The scalar arguments that get set before the launch
+            std::vector<std::pair<cl_uint, std::vector<char>>> value_args;
+
+        private:
+            friend class boost::serialization::access;
+
+            template <typename Archive>
+            void serialize(Archive & ar, unsigned int version)
+            {
+                ar & work_dim;
+                ar & global_work_offset;
+                ar & global_work_size;
+                ar & local_work_size;
+                ar & args;
+                ar & value_args;
+            }
+    };
+
+}}
+
+#endif
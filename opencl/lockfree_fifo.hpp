@@ -0,0 +1,367 @@
+// Copyright (c)    2014 Martin Stumpf
+//
+// Distributed under the Boost Software License, Version 1.0. (See accompanying
+// file LICENSE_1_0.txt or copy at http://www.boost.org/LICENSE_1_0.txt)
+
+#pragma once
+#ifndef HPX_OPENCL_LOCKFREE_FIFO_HPP_
+#define HPX_OPENCL_LOCKFREE_FIFO_HPP_
+
+#include <hpx/hpx.hpp>
+#include <hpx/config.hpp>
+#include <hpx/lcos/local/spinlock.hpp>
+#include <hpx/lcos/local/condition_variable.hpp>
+
+#include <boost/atomic.hpp>
+#include <boost/scoped_array.hpp>
+#include <boost/cstdint.hpp>
+
+namespace hpx {
+namespace opencl {
+
+    ////////////////////////
+    /// @brief A bounded, lock-free multi-producer-multi-consumer queue.
+    ///
+    /// push and pop don't take any lock as long as the queue is neither
+    /// full nor empty. Only if they have to wait, they fall back to a
+    /// condition variable, so waiting threads don't burn cpu time.
+    ///
+    /// T needs to be default constructible and assignable.
+    /// Popped slots get reset to T(), so no references
+    /// (e.g. boost::shared_ptr) are kept alive by the queue.
+    ///
+    template <typename T>
+    class lockfree_fifo
+    {
+
+        typedef hpx::lcos::local::spinlock lock_type;
+        typedef hpx::lcos::local::condition_variable cond_type;
+
+        public:
+            /**
+             *  @brief Creates an empty queue
+             *
+             *  @param capacity     The maximal number of items.
+             *                      Gets rounded up to a power of two.
+             */
+            lockfree_fifo(std::size_t capacity = 1024);
+
+            ~lockfree_fifo();
+
+            /**
+             *  @brief Adds an item
+             *
+             *  Blocks if the queue is full.
+             *  Throws if \ref finish was already called.
+             */
+            void push(const T & item);
+
+            /**
+             *  @brief Takes an item
+             *
+             *  Blocks if the queue is empty.
+             *
+             *  @return False if the queue is empty and finished.
+             */
+            bool pop(T* item);
+
+            /**
+             *  @brief Tries to add an item without blocking
+             *
+             *  @return False if the queue is full.
+             */
+            bool try_push(const T & item);
+
+            /**
+             *  @brief Tries to take an item without blocking
+             *
+             *  @return False if the queue is empty.
+             */
+            bool try_pop(T* item);
+
+            /**
+             *  @brief Signals the end of the input
+             *
+             *  All waiting consumers return as soon as the queue is empty.
+             */
+            void finish();
+
+            /**
+             *  @brief Returns the capacity of the queue
+             */
+            std::size_t capacity() const;
+
+        private:
+            // wakes up waiting threads, if any
+            void notify_consumer();
+            void notify_producer();
+
+        private:
+            // A single slot of the ring.
+            // The sequence number tells whether the slot is ready to
+            // be written or to be read in the current round.
+            struct cell
+            {
+                boost::atomic<std::size_t> sequence;
+                T data;
+            };
+
+            static const std::size_t cache_line_size = 64;
+
+            char pad0[cache_line_size];
+            boost::scoped_array<cell> buffer;
+            std::size_t buffer_mask;
+            char pad1[cache_line_size];
+            boost::atomic<std::size_t> enqueue_pos;
+            char pad2[cache_line_size];
+            boost::atomic<std::size_t> dequeue_pos;
+            char pad3[cache_line_size];
+
+            // Blocking, only used if the queue is full or empty
+            lock_type wait_lock;
+            cond_type not_empty;
+            cond_type not_full;
+            boost::atomic<std::size_t> waiting_consumers;
+            boost::atomic<std::size_t> waiting_producers;
+
+            boost::atomic<bool> finished;
+
+    };
+
+
+    template <typename T>
+    lockfree_fifo<T>::lockfree_fifo(std::size_t capacity_)
+      : enqueue_pos(0), dequeue_pos(0),
+        waiting_consumers(0), waiting_producers(0), finished(false)
+    {
+
+        // round up to power of two
+        std::size_t size = 2;
+        while(size < capacity_)
+            size *= 2;
+
+        buffer.reset(new cell[size]);
+        buffer_mask = size - 1;
+
+        for(std::size_t i = 0; i < size; i++)
+            buffer[i].sequence.store(i, boost::memory_order_relaxed);
+
+    }
+
+    template <typename T>
+    lockfree_fifo<T>::~lockfree_fifo()
+    {
+        finish();
+    }
+
+    template <typename T>
+    std::size_t
+    lockfree_fifo<T>::capacity() const
+    {
+        return buffer_mask + 1;
+    }
+
+    template <typename T>
+    bool
+    lockfree_fifo<T>::try_push(const T & item)
+    {
+
+        cell* c;
+        std::size_t pos = enqueue_pos.load(boost::memory_order_relaxed);
+        while(true)
+        {
+            c = &buffer[pos & buffer_mask];
+            std::size_t seq = c->sequence.load(boost::memory_order_acquire);
+            boost::intptr_t diff = (boost::intptr_t)seq - (boost::intptr_t)pos;
+
+            if(diff == 0)
+            {
+                // the slot is free, try to claim it
+                if(enqueue_pos.compare_exchange_weak(pos, pos + 1,
+                                             boost::memory_order_relaxed))
+                    break;
+            }
+            else if(diff < 0)
+            {
+                // full
+                return false;
+            }
+            else
+            {
+                // another producer was faster
+                pos = enqueue_pos.load(boost::memory_order_relaxed);
+            }
+        }
+
+        // write and publish
+        c->data = item;
+        c->sequence.store(pos + 1, boost::memory_order_release);
+
+        return true;
+
+    }
+
+    template <typename T>
+    bool
+    lockfree_fifo<T>::try_pop(T* item)
+    {
+
+        cell* c;
+        std::size_t pos = dequeue_pos.load(boost::memory_order_relaxed);
+        while(true)
+        {
+            c = &buffer[pos & buffer_mask];
+            std::size_t seq = c->sequence.load(boost::memory_order_acquire);
+            boost::intptr_t diff = (boost::intptr_t)seq
+                                 - (boost::intptr_t)(pos + 1);
+
+            if(diff == 0)
+            {
+                // the slot is filled, try to claim it
+                if(dequeue_pos.compare_exchange_weak(pos, pos + 1,
+                                             boost::memory_order_relaxed))
+                    break;
+            }
+            else if(diff < 0)
+            {
+                // empty
+                return false;
+            }
+            else
+            {
+                // another consumer was faster
+                pos = dequeue_pos.load(boost::memory_order_relaxed);
+            }
+        }
+
+        // read, reset and release the slot for the next round
+        *item = c->data;
+        c->data = T();
+        c->sequence.store(pos + buffer_mask + 1, boost::memory_order_release);
+
+        return true;
+
+    }
+
+    template <typename T>
+    void
+    lockfree_fifo<T>::notify_consumer()
+    {
+
+        // pairs with the fence in pop
+        boost::atomic_thread_fence(boost::memory_order_seq_cst);
+        if(waiting_consumers.load() == 0)
+            return;
+
+        boost::lock_guard<lock_type> lock(wait_lock);
+        not_empty.notify_one();
+
+    }
+
+    template <typename T>
+    void
+    lockfree_fifo<T>::notify_producer()
+    {
+
+        // pairs with the fence in push
+        boost::atomic_thread_fence(boost::memory_order_seq_cst);
+        if(waiting_producers.load() == 0)
+            return;
+
+        boost::lock_guard<lock_type> lock(wait_lock);
+        not_full.notify_one();
+
+    }
+
+    template <typename T>
+    void
+    lockfree_fifo<T>::push(const T & item)
+    {
+
+        // check wether fifo is already in finished state
+        if(finished)
+        {
+            HPX_THROW_EXCEPTION(hpx::invalid_status, "lockfree_fifo::push()",
+                                "lockfree_fifo::finish() already called!");
+        }
+
+        // slow path, wait for free space
+        if(!try_push(item))
+        {
+            boost::lock_guard<lock_type> lock(wait_lock);
+
+            waiting_producers++;
+            boost::atomic_thread_fence(boost::memory_order_seq_cst);
+
+            while(!try_push(item))
+            {
+                if(finished)
+                {
+                    waiting_producers--;
+                    HPX_THROW_EXCEPTION(hpx::invalid_status,
+                                "lockfree_fifo::push()",
+                                "lockfree_fifo::finish() already called!");
+                }
+
+                not_full.wait(wait_lock);
+            }
+
+            waiting_producers--;
+        }
+
+        // signal waiting threads that new item is available
+        notify_consumer();
+
+    }
+
+    template <typename T>
+    bool
+    lockfree_fifo<T>::pop(T* item)
+    {
+
+        // slow path, wait for items
+        if(!try_pop(item))
+        {
+            boost::lock_guard<lock_type> lock(wait_lock);
+
+            waiting_consumers++;
+            boost::atomic_thread_fence(boost::memory_order_seq_cst);
+
+            while(!try_pop(item))
+            {
+                if(finished)
+                {
+                    waiting_consumers--;
+                    return false;
+                }
+
+                not_empty.wait(wait_lock);
+            }
+
+            waiting_consumers--;
+        }
+
+        // signal waiting threads that space is available
+        notify_producer();
+
+        return true;
+
+    }
+
+    template <typename T>
+    void
+    lockfree_fifo<T>::finish()
+    {
+
+        boost::lock_guard<lock_type> lock(wait_lock);
+
+        finished = true;
+
+        not_empty.notify_all();
+        not_full.notify_all();
+
+    }
+
+}}
+
+#endif
@@ -0,0 +1,138 @@
+// Copyright (c)    2014 Martin Stumpf
+//
+// Distributed under the Boost Software License, Version 1.0. (See accompanying
+// file LICENSE_1_0.txt or copy at http://www.boost.org/LICENSE_1_0.txt)
+
+#include "partitioned_buffer.hpp"
+
+#include <algorithm>
+#include <cmath>
+#include <utility>
+
+///////////////////////////////////////////////////
+/// Local functions
+///
+
+// Sorts by the fractional part, descending
+static bool
+larger_remainder(std::pair<double, size_t> const& a,
+                 std::pair<double, size_t> const& b)
+{
+    return a.first > b.first;
+}
+
+
+///////////////////////////////////////////////////
+/// Implementations
+///
+
+std::vector<size_t>
+hpx::opencl::detail::partition_block(size_t size, size_t num_parts)
+{
+
+    std::vector<size_t> counts(num_parts, 0);
+    for(size_t i = 0; i < num_parts; i++)
+    {
+        counts[i] = size / num_parts + ((i < size % num_parts) ? 1 : 0);
+    }
+
+    return counts;
+
+}
+
+std::vector<size_t>
+hpx::opencl::detail::partition_weighted(size_t size,
+                                        std::vector<double> const& weights)
+{
+
+    double total = 0.0;
+    for(size_t i = 0; i < weights.size(); i++)
+    {
+        if(weights[i] < 0.0)
+        {
+            HPX_THROW_EXCEPTION(hpx::bad_parameter,
+                                "partition_weighted()",
+                                "Weights must not be negative!");
+        }
+        total += weights[i];
+    }
+
+    if(!(total > 0.0))
+    {
+        HPX_THROW_EXCEPTION(hpx::bad_parameter,
+                            "partition_weighted()",
+                            "At least one weight must be positive!");
+    }
+
+    // Round down, remember the remainders
+    std::vector<size_t> counts(weights.size(), 0);
+    std::vector<std::pair<double, size_t> > remainders;
+    size_t assigned = 0;
+    for(size_t i = 0; i < weights.size(); i++)
+    {
+        double exact = size * (weights[i] / total);
+        counts[i] = std::min(size - assigned, (size_t)std::floor(exact));
+        assigned += counts[i];
+        remainders.push_back(std::make_pair(exact - counts[i], i));
+    }
+
+    // Distribute the rest by the largest remainders
+    std::stable_sort(remainders.begin(), remainders.end(), larger_remainder);
+    for(size_t i = 0; assigned < size; i = (i + 1) % remainders.size())
+    {
+        if(weights[remainders[i].second] > 0.0)
+        {
+            counts[remainders[i].second]++;
+            assigned++;
+        }
+    }
+
+    return counts;
+
+}
+
+std::vector<hpx::opencl::event>
+hpx::opencl::detail::segment_dependencies(
+                            std::vector<hpx::opencl::event> const& events,
+                            size_t segment)
+{
+
+    if(events.empty())
+        return std::vector<hpx::opencl::event>();
+
+    BOOST_ASSERT(segment < events.size());
+    return std::vector<hpx::opencl::event>(1, events[segment]);
+
+}
+
+std::vector<hpx::opencl::event>
+hpx::opencl::detail::get_segment_events(hpx::lcos::future<std::vector<
+                    hpx::lcos::future<hpx::opencl::event> > > events_future)
+{
+
+    std::vector<hpx::lcos::future<hpx::opencl::event> > futures =
+                                                        events_future.get();
+
+    std::vector<hpx::opencl::event> events;
+    events.reserve(futures.size());
+    for(size_t i = 0; i < futures.size(); i++)
+    {
+        events.push_back(futures[i].get());
+    }
+
+    return events;
+
+}
+
+void
+hpx::opencl::detail::check_segment_reads(hpx::lcos::future<std::vector<
+                    hpx::lcos::future<void> > > reads_future)
+{
+
+    std::vector<hpx::lcos::future<void> > reads = reads_future.get();
+    for(size_t i = 0; i < reads.size(); i++)
+    {
+        reads[i].get();
+    }
+
+}
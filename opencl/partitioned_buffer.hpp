@@ -0,0 +1,405 @@
+// Copyright (c)    2014 Martin Stumpf
+//
+// Distributed under the Boost Software License, Version 1.0. (See accompanying
+// file LICENSE_1_0.txt or copy at http://www.boost.org/LICENSE_1_0.txt)
+
+#pragma once
+#ifndef HPX_OPENCL_PARTITIONED_BUFFER_HPP_
+#define HPX_OPENCL_PARTITIONED_BUFFER_HPP_
+
+#include "export_definitions.hpp"
+
+#include <hpx/hpx.hpp>
+#include <hpx/config.hpp>
+#include <hpx/lcos/future.hpp>
+#include <hpx/lcos/when_all.hpp>
+#include <hpx/util/serialize_buffer.hpp>
+
+#include <CL/cl.h>
+
+#include <vector>
+
+#include "buffer.hpp"
+#include "device.hpp"
+#include "event.hpp"
+#include "halo_exchange.hpp"
+#include "typed_buffer.hpp"
+
+namespace hpx {
+namespace opencl {
+
+    namespace detail
+    {
+        // The number of elements of every part, as equal as possible
+        HPX_OPENCL_EXPORT std::vector<size_t>
+        partition_block(size_t size, size_t num_parts);
+
+        // The number of elements of every part, proportional to the weights
+        HPX_OPENCL_EXPORT std::vector<size_t>
+        partition_weighted(size_t size, std::vector<double> const& weights);
+
+        // The dependencies of one segment, events is empty or holds
+        // one event per segment
+        HPX_OPENCL_EXPORT std::vector<hpx::opencl::event>
+        segment_dependencies(std::vector<hpx::opencl::event> const& events,
+                             size_t segment);
+
+        // Collects the event of every segment
+        HPX_OPENCL_EXPORT std::vector<hpx::opencl::event>
+        get_segment_events(hpx::lcos::future<std::vector<
+                    hpx::lcos::future<hpx::opencl::event> > > events_future);
+
+        // Rethrows the exceptions of the segment reads
+        HPX_OPENCL_EXPORT void
+        check_segment_reads(hpx::lcos::future<std::vector<
+                    hpx::lcos::future<void> > > reads_future);
+    }
+
+    //////////////////////////////////////
+    /// @brief An array of elements of type T, spread over multiple devices.
+    ///
+    /// The elements get split into contiguous segments, one per device.
+    /// Every segment is a \ref typed_buffer that holds its owned elements,
+    /// surrounded by a halo of halo_width() elements on each side:
+    ///
+    ///     [ left halo | owned elements | right halo ]
+    ///
+    /// The owned element with the global index g lives at
+    /// halo_width() + g - segment.first within the buffer of its segment.
+    /// The halos get filled with the elements of the neighbouring segments
+    /// by \ref exchange_halos.
+    ///
+    /// All enqueue functions take and return one \ref event per segment,
+    /// an empty list of dependencies means no dependencies.
+    ///
+    /// Example:
+    /// \code{.cpp}
+    ///     std::vector<hpx::opencl::device> devices =
+    ///         hpx::opencl::get_all_devices(CL_DEVICE_TYPE_GPU,
+    ///                                      "OpenCL 1.1").get();
+    ///
+    ///     hpx::opencl::partitioned_buffer<float> buf(devices,
+    ///                                                CL_MEM_READ_WRITE,
+    ///                                                size);
+    ///
+    ///     std::vector<hpx::opencl::event> written =
+    ///                                 buf.enqueue_write(input.data()).get();
+    ///     std::vector<hpx::opencl::event> computed =
+    ///                     buf.for_each_segment(&run_segment, written).get();
+    ///     buf.enqueue_read_to(output.data(), computed).get();
+    /// \endcode
+    ///
+    template <typename T>
+    class partitioned_buffer
+    {
+
+        public:
+            typedef T value_type;
+
+            /// @brief The part of the elements that lives on one device
+            struct segment
+            {
+                hpx::opencl::device device;
+                hpx::opencl::typed_buffer<T> buffer;
+
+                // The global index of the first owned element
+                size_t first;
+
+                // The number of owned elements
+                size_t count;
+            };
+
+            // Empty constructor, necessary for hpx purposes
+            partitioned_buffer()
+              : num_elements(0), halo(0)
+            {}
+
+            /**
+             *  @brief Splits the elements into equal segments
+             *
+             *  @param devices      The devices, e.g. from
+             *                      \ref get_all_devices.
+             *  @param flags        The flags of the segment buffers, see
+             *                      \ref device::create_buffer.
+             *  @param size         The number of elements.
+             *  @param halo_width   The number of halo elements on each
+             *                      side of a segment.
+             */
+            partitioned_buffer(std::vector<hpx::opencl::device> const& devices,
+                               cl_mem_flags flags, size_t size,
+                               size_t halo_width = 0)
+              : num_elements(size), halo(halo_width)
+            {
+                create_segments(devices,
+                                detail::partition_block(size, devices.size()),
+                                flags);
+            }
+
+            /**
+             *  @brief Splits the elements proportional to weights
+             *
+             *  Useful for devices of different speed, e.g. weighted by
+             *  their compute units.
+             *
+             *  @param devices      The devices.
+             *  @param weights      One non-negative weight per device.
+             *  @param flags        The flags of the segment buffers.
+             *  @param size         The number of elements.
+             *  @param halo_width   The number of halo elements on each
+             *                      side of a segment.
+             */
+            partitioned_buffer(std::vector<hpx::opencl::device> const& devices,
+                               std::vector<double> const& weights,
+                               cl_mem_flags flags, size_t size,
+                               size_t halo_width = 0)
+              : num_elements(size), halo(halo_width)
+            {
+                if(weights.size() != devices.size())
+                {
+                    HPX_THROW_EXCEPTION(hpx::bad_parameter,
+                                        "partitioned_buffer()",
+                                        "Need one weight per device!");
+                }
+
+                create_segments(devices,
+                                detail::partition_weighted(size, weights),
+                                flags);
+            }
+
+            /**
+             *  @brief The total number of owned elements
+             */
+            size_t size() const
+            {
+                return num_elements;
+            }
+
+            /**
+             *  @brief The number of halo elements on each side of a segment
+             */
+            size_t halo_width() const
+            {
+                return halo;
+            }
+
+            size_t num_segments() const
+            {
+                return segments.size();
+            }
+
+            segment const& get_segment(size_t i) const
+            {
+                BOOST_ASSERT(i < segments.size());
+                return segments[i];
+            }
+
+            std::vector<segment> const& get_segments() const
+            {
+                return segments;
+            }
+
+            /**
+             *  @brief Scatters host data to the segments
+             *
+             *  Only the owned elements get written, see \ref exchange_halos.
+             *
+             *  @param data     All size() elements, needs to stay valid
+             *                  until the writes completed.
+             *  @param events   Optional, one event per segment to wait for.
+             *  @return         One \ref event per segment.
+             */
+            hpx::lcos::future<std::vector<hpx::opencl::event> >
+            enqueue_write(const T* data,
+                          std::vector<hpx::opencl::event> const& events =
+                                    std::vector<hpx::opencl::event>()) const
+            {
+                std::vector<hpx::lcos::future<hpx::opencl::event> > writes;
+                writes.reserve(segments.size());
+                for(size_t i = 0; i < segments.size(); i++)
+                {
+                    segment const& seg = segments[i];
+                    writes.push_back(seg.buffer.enqueue_write(
+                                halo, seg.count, data + seg.first,
+                                detail::segment_dependencies(events, i)));
+                }
+
+                return hpx::when_all(writes).then(
+                            hpx::util::bind(&detail::get_segment_events,
+                                            hpx::util::placeholders::_1));
+            }
+
+            /**
+             *  @brief Gathers the owned elements of all segments
+             *
+             *  @param dst      The destination of size() elements, needs
+             *                  to stay valid until the returned future
+             *                  triggered.
+             *  @param events   Optional, one event per segment to wait for.
+             *  @return         A future that triggers as soon as all data
+             *                  arrived in dst.
+             */
+            hpx::lcos::future<void>
+            enqueue_read_to(T* dst,
+                            std::vector<hpx::opencl::event> const& events =
+                                    std::vector<hpx::opencl::event>()) const
+            {
+                std::vector<hpx::lcos::future<void> > reads;
+                reads.reserve(segments.size());
+                for(size_t i = 0; i < segments.size(); i++)
+                {
+                    segment const& seg = segments[i];
+                    reads.push_back(seg.buffer.enqueue_read_to(
+                                halo, seg.count, dst + seg.first,
+                                detail::segment_dependencies(events, i)));
+                }
+
+                return hpx::when_all(reads).then(
+                            hpx::util::bind(&detail::check_segment_reads,
+                                            hpx::util::placeholders::_1));
+            }
+
+            /**
+             *  @brief Gathers the owned elements of all segments
+             *
+             *  @param events   Optional, one event per segment to wait for.
+             *  @return         All size() elements.
+             */
+            hpx::lcos::future<hpx::util::serialize_buffer<T> >
+            enqueue_read(std::vector<hpx::opencl::event> const& events =
+                                    std::vector<hpx::opencl::event>()) const
+            {
+                hpx::util::serialize_buffer<T> data(
+                        new T[num_elements], num_elements,
+                        hpx::util::serialize_buffer<T>::init_mode::take);
+
+                return enqueue_read_to(data.data(), events).then(
+                        hpx::util::bind(&partitioned_buffer::read_callback,
+                                        data,
+                                        hpx::util::placeholders::_1));
+            }
+
+            /**
+             *  @brief Runs a function on every segment
+             *
+             *  Used to launch segment local kernels.
+             *
+             *  @param f        Gets called as f(i, dependencies) for every
+             *                  segment i and returns a
+             *                  hpx::lcos::future<hpx::opencl::event>.
+             *                  The dependencies are the ones of segment i.
+             *  @param events   Optional, one event per segment to wait for.
+             *  @return         One \ref event per segment.
+             */
+            template <typename F>
+            hpx::lcos::future<std::vector<hpx::opencl::event> >
+            for_each_segment(F f,
+                             std::vector<hpx::opencl::event> const& events =
+                                    std::vector<hpx::opencl::event>()) const
+            {
+                std::vector<hpx::lcos::future<hpx::opencl::event> > launches;
+                launches.reserve(segments.size());
+                for(size_t i = 0; i < segments.size(); i++)
+                {
+                    launches.push_back(
+                            f(i, detail::segment_dependencies(events, i)));
+                }
+
+                return hpx::when_all(launches).then(
+                            hpx::util::bind(&detail::get_segment_events,
+                                            hpx::util::placeholders::_1));
+            }
+
+            /**
+             *  @brief Fills the halos with the elements of the neighbours
+             *
+             *  The left halo of a segment receives the last owned elements
+             *  of the previous segment, the right halo the first owned
+             *  elements of the next one. The outer halos of the first and
+             *  the last segment stay untouched. The copies are done by a
+             *  \ref halo_exchange that gets set up with the segments.
+             *
+             *  @param events   Optional, one event per segment to wait for.
+             *  @return         One \ref event per segment that triggers as
+             *                  soon as its halos are filled and its owned
+             *                  elements got sent to the neighbours.
+             */
+            hpx::lcos::future<std::vector<hpx::opencl::event> >
+            exchange_halos(std::vector<hpx::opencl::event> const& events =
+                                    std::vector<hpx::opencl::event>()) const
+            {
+                return halos.run(events);
+            }
+
+        private:
+            void create_segments(std::vector<hpx::opencl::device> const& devices,
+                                 std::vector<size_t> const& counts,
+                                 cl_mem_flags flags)
+            {
+                size_t first = 0;
+                for(size_t i = 0; i < devices.size(); i++)
+                {
+                    // OpenCL does not allow empty buffers
+                    if(counts[i] == 0)
+                        continue;
+
+                    // The halos are filled from the owned elements
+                    if(counts[i] < halo)
+                    {
+                        HPX_THROW_EXCEPTION(hpx::bad_parameter,
+                            "partitioned_buffer()",
+                            "Segments need at least halo_width elements!");
+                    }
+
+                    segment seg;
+                    seg.device = devices[i];
+                    seg.buffer = create_typed_buffer<T>(devices[i], flags,
+                                                        counts[i] + 2 * halo);
+                    seg.first = first;
+                    seg.count = counts[i];
+                    segments.push_back(seg);
+                    halos.add_tile(seg.device, seg.buffer);
+
+                    first += counts[i];
+                }
+
+                if(halo == 0)
+                    return;
+
+                for(size_t i = 0; i + 1 < segments.size(); i++)
+                {
+                    size_t count = segments[i].count;
+
+                    // The last owned elements of i to the left halo of i + 1
+                    halos.add_region(i, count * sizeof(T),
+                                     i + 1, 0,
+                                     halo * sizeof(T));
+
+                    // The first owned elements of i + 1 to the right halo
+                    // of i
+                    halos.add_region(i + 1, halo * sizeof(T),
+                                     i, (halo + count) * sizeof(T),
+                                     halo * sizeof(T));
+                }
+            }
+
+            static hpx::util::serialize_buffer<T>
+            read_callback(hpx::util::serialize_buffer<T> data,
+                          hpx::lcos::future<void> read_future)
+            {
+                // Rethrows OpenCL errors
+                read_future.get();
+
+                return data;
+            }
+
+        private:
+            std::vector<segment> segments;
+            hpx::opencl::halo_exchange halos;
+            size_t num_elements;
+            size_t halo;
+
+    };
+
+}}
+
+#endif
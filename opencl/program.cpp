@@ -73,3 +73,18 @@ program::create_kernel(std::string kernel_name) const
 
 }
 
+hpx::opencl::kernel
+program::get_kernel_pool(std::string kernel_name, size_t pool_size) const
+{
+
+    BOOST_ASSERT(this->get_gid());
+
+    // Create new kernel object server with a pre-filled pool
+    hpx::lcos::future<hpx::naming::id_type>
+    kernel_server = hpx::components::new_colocated<hpx::opencl::server::kernel>
+                    (get_gid(), get_gid(), kernel_name, pool_size);
+
+    return hpx::opencl::kernel(std::move(kernel_server));
+
+}
+
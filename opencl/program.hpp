@@ -107,6 +107,28 @@ namespace opencl {
             hpx::opencl::kernel
             create_kernel(std::string kernel_name) const;
 
+            /**
+             *  @brief Creates a kernel with a pool of OpenCL kernel objects.
+             *
+             *  OpenCL stores kernel arguments inside of the kernel object,
+             *  so concurrent launches with different arguments need
+             *  different kernel objects.
+             *  The returned kernel keeps a pool of kernel objects that gets
+             *  used by \ref kernel::enqueue_launch and
+             *  \ref kernel::enqueue_bulk, so one kernel can be shared by
+             *  multiple workers.
+             *
+             *  The pool grows on demand, pool_size only determines the
+             *  number of kernel objects that get created upfront.
+             *
+             *  @param kernel_name  The name of the kernel to be created
+             *  @param pool_size    The initial size of the pool, usually the
+             *                      number of concurrent users
+             *  @return             A kernel object.
+             */
+            hpx::opencl::kernel
+            get_kernel_pool(std::string kernel_name, size_t pool_size) const;
+
     };
 
 }}
@@ -14,13 +14,22 @@
 
 #include "../tools.hpp"
 #include "device.hpp"
+#include "hpx_cl_interop.hpp"
 #include "../event.hpp"
 #include "../buffer.hpp"
 #include "../device.hpp"
 
+#include <boost/scoped_ptr.hpp>
+#include <boost/foreach.hpp>
+
+#include <algorithm>
+
 using hpx::opencl::server::buffer;
 using namespace hpx::opencl::server;
 
+// The chunk size of streamed migrations
+#define MIGRATION_CHUNK_SIZE (4 * 1024 * 1024)
+
 CL_FORBID_EMPTY_CONSTRUCTOR(buffer);
 
 
@@ -32,21 +41,19 @@ buffer::buffer(hpx::naming::id_type device_id, cl_mem_flags flags, size_t size)
     this->parent_device = hpx::get_ptr
                           <hpx::opencl::server::device>(parent_device_id).get();
     this->device_mem = NULL;
-
-    // Retrieve the context from parent class
-    cl_context context = parent_device->get_context();
-
-    // The opencl error variable
-    cl_int err;
+    this->mem_size = size;
+    this->managed = parent_device->is_memory_managed();
 
     // Modify the cl_mem_flags
     cl_mem_flags modified_flags = flags &! (CL_MEM_USE_HOST_PTR
                                             | CL_MEM_ALLOC_HOST_PTR
                                             | CL_MEM_COPY_HOST_PTR);
+    this->mem_flags = modified_flags;
     
-    // Create the Context
-    device_mem = clCreateBuffer(context, modified_flags, size, NULL, &err);
-    cl_ensure(err, "clCreateBuffer()");
+    // The memory gets created on first use
+    this->allocated = false;
+    this->relocated = false;
+    this->pending_events_prune_size = 16;
 
 };
 
@@ -61,22 +68,22 @@ buffer::buffer(hpx::naming::id_type device_id, cl_mem_flags flags, size_t size,
     this->parent_device = hpx::get_ptr
                           <hpx::opencl::server::device>(parent_device_id).get();
     this->device_mem = NULL;
-
-    // Retrieve the context from parent class
-    cl_context context = parent_device->get_context();
-
-    // The opencl error variable
-    cl_int err;
+    this->mem_size = size;
+    this->managed = parent_device->is_memory_managed();
 
     // Modify the cl_mem_flags
     cl_mem_flags modified_flags = flags &! (CL_MEM_USE_HOST_PTR
                                             | CL_MEM_ALLOC_HOST_PTR);
+    this->mem_flags = modified_flags;
     modified_flags = modified_flags | CL_MEM_COPY_HOST_PTR; 
 
-    // Create the Context
-    device_mem = clCreateBuffer(context, modified_flags, size,
-                                          const_cast<char*>(data.data()), &err);
-    cl_ensure(err, "clCreateBuffer()");
+    // Create the memory, managed memory might evict other buffers
+    device_mem = parent_device->allocate_buffer_mem(modified_flags, size,
+                                              const_cast<char*>(data.data()),
+                                              managed ? this : NULL);
+    this->allocated = true;
+    this->relocated = false;
+    this->pending_events_prune_size = 16;
 
 };
 
@@ -85,6 +92,15 @@ buffer::buffer(hpx::naming::id_type device_id, cl_mem_flags flags, size_t size,
 
 buffer::~buffer()
 {
+    if(managed)
+    {
+        // Stop the device from evicting this buffer and wait for an
+        // eviction that is already running
+        parent_device->unregister_buffer(this);
+        boost::lock_guard<hpx::lcos::local::mutex> lock(residency_mutex);
+    }
+    release_pending_events();
+
     // Release the device memory
     if(device_mem)
     {
@@ -98,22 +114,241 @@ size_t
 buffer::size()
 {
 
-    size_t size;
+    // The memory might be evicted, no query possible
+    return mem_size;
+
+}
+
+buffer::resident_lock::resident_lock(buffer & parent_,
+                                     const void* initial_data)
+  : parent(parent_), initialized(false)
+{
+
+    // Every buffer can get migrated, so the lock is needed even if the
+    // memory is neither managed nor lazily created
+    parent.residency_mutex.lock();
+
+    try
+    {
+        initialized = parent.make_resident(initial_data);
+    }
+    catch(...)
+    {
+        parent.residency_mutex.unlock();
+        throw;
+    }
+
+}
+
+buffer::resident_lock::~resident_lock()
+{
+
+    parent.residency_mutex.unlock();
+
+}
+
+bool
+buffer::resident_lock::used_initial_data() const
+{
+
+    return initialized;
+
+}
+
+bool
+buffer::is_managed()
+{
+
+    return managed;
+
+}
+
+bool
+buffer::is_allocated()
+{
+
+    return allocated.load();
+
+}
+
+bool
+buffer::is_relocated()
+{
+
+    return relocated.load();
+
+}
+
+bool
+buffer::try_lock_residency()
+{
+
+    return residency_mutex.try_lock();
+
+}
+
+void
+buffer::unlock_residency()
+{
+
+    residency_mutex.unlock();
+
+}
+
+bool
+buffer::make_resident(const void* initial_data)
+{
+
+    // Mark as most recently used
+    if(device_mem != NULL)
+    {
+        if(managed)
+            parent_device->touch_buffer(this);
+        return false;
+    }
+
+    buffer* owner = managed ? this : NULL;
+    bool used_initial_data = false;
+
+    // Managed memory might evict other buffers
+    if(host_copy)
+    {
+        // Re-create the memory with the content from the host
+        device_mem = parent_device->allocate_buffer_mem(
+                                        mem_flags | CL_MEM_COPY_HOST_PTR,
+                                        mem_size, host_copy->data(), owner);
+        host_copy.reset();
+    }
+    else if(initial_data != NULL)
+    {
+        // First use is a full write, copy the data during creation
+        device_mem = parent_device->allocate_buffer_mem(
+                                        mem_flags | CL_MEM_COPY_HOST_PTR,
+                                        mem_size,
+                                        const_cast<void*>(initial_data),
+                                        owner);
+        used_initial_data = true;
+    }
+    else
+    {
+        // First use
+        device_mem = parent_device->allocate_buffer_mem(mem_flags, mem_size,
+                                                        NULL, owner);
+    }
+
+    allocated = true;
+    return used_initial_data;
+
+}
+
+void
+buffer::evict()
+{
+
+    BOOST_ASSERT(device_mem != NULL);
+
     cl_int err;
 
-    // Query size
-    err = clGetMemObjectInfo(device_mem, CL_MEM_SIZE, sizeof(size_t), &size,
-                                                                          NULL);
-    cl_ensure(err, "clGetMemObjectInfo()");
+    // Get the command queue
+    cl_command_queue command_queue = parent_device->get_read_command_queue();
+
+    // Only wait for the commands that use this buffer, the rest of the
+    // device keeps running
+    cl_event* wait_list_ptr = NULL;
+    if(!pending_events.empty())
+    {
+        wait_list_ptr = pending_events.data();
+    }
+
+    // Read the content
+    boost::shared_ptr<std::vector<char>> data =
+                                boost::make_shared<std::vector<char>>(mem_size);
+    cl_event read_event;
+    err = ::clEnqueueReadBuffer(command_queue, device_mem, CL_FALSE, 0,
+                                mem_size, data->data(),
+                                (cl_uint)pending_events.size(), wait_list_ptr,
+                                &read_event);
+    cl_ensure(err, "clEnqueueReadBuffer()");
+
+    // Suspends this hpx thread until the content arrived.
+    // The future holds its own reference to the cl_event.
+    hpx::lcos::future<void> read_future =
+                    hpx::opencl::server::future_from_cl_event(read_event);
+    err = clReleaseEvent(read_event);
+    cl_ensure(err, "clReleaseEvent()");
+    read_future.get();
+
+    // Everything that used the memory is done
+    release_pending_events();
 
-    return size;
+    // Release the device memory
+    host_copy = data;
+    parent_device->schedule_cl_mem_deletion(device_mem);
+    device_mem = NULL;
 
 }
 
-// Read Buffer
-hpx::opencl::event
-buffer::read(size_t offset, size_t size,
-                            std::vector<hpx::opencl::event> events)
+void
+buffer::track_event(cl_event event)
+{
+
+    // Other buffers never get evicted
+    if(!managed)
+        return;
+
+    cl_int err;
+
+    // Drop completed commands, grow the limit if most are still running
+    if(pending_events.size() >= pending_events_prune_size)
+    {
+        std::vector<cl_event>::iterator it = pending_events.begin();
+        while(it != pending_events.end())
+        {
+            cl_int status;
+            err = clGetEventInfo(*it, CL_EVENT_COMMAND_EXECUTION_STATUS,
+                                 sizeof(cl_int), &status, NULL);
+            cl_ensure(err, "clGetEventInfo()");
+
+            // Negative values are errors, the command won't run any more
+            if(status == CL_COMPLETE || status < 0)
+            {
+                err = clReleaseEvent(*it);
+                cl_ensure(err, "clReleaseEvent()");
+                it = pending_events.erase(it);
+            }
+            else
+            {
+                it++;
+            }
+        }
+        pending_events_prune_size = 2 * pending_events.size() + 16;
+    }
+
+    err = clRetainEvent(event);
+    cl_ensure(err, "clRetainEvent()");
+    pending_events.push_back(event);
+
+}
+
+void
+buffer::release_pending_events()
+{
+
+    BOOST_FOREACH(cl_event event, pending_events)
+    {
+        cl_int err = clReleaseEvent(event);
+        cl_ensure(err, "clReleaseEvent()");
+    }
+    pending_events.clear();
+    pending_events_prune_size = 16;
+
+}
+
+// Enqueues a read to the given host memory
+cl_event
+buffer::enqueue_read_impl(resident_lock const& resident,
+                          size_t offset, size_t size, void* dst,
+                          std::vector<hpx::opencl::event> & events)
 {
     cl_int err;
     cl_event returnEvent;
@@ -131,37 +366,97 @@ buffer::read(size_t offset, size_t size,
         cl_events_list_ptr = cl_events_list.data();
     }
 
-    // Create the buffer
-    boost::shared_ptr<std::vector<char>> buffer = 
-                                    boost::make_shared<std::vector<char>>(size);
-
     // Read the buffer
     err = ::clEnqueueReadBuffer(command_queue, device_mem, CL_FALSE, offset,
-                              size, (void*)(buffer->data()), (cl_uint)events.size(),
+                              size, dst, (cl_uint)events.size(),
                               cl_events_list_ptr, &returnEvent);
     cl_ensure(err, "clEnqueueReadBuffer()");
 
-    // Send buffer to device class
-    parent_device->put_event_data(returnEvent, buffer);
-    
-    // Return the event
-    return hpx::opencl::event(
-           hpx::components::new_<hpx::opencl::server::event>(
-                                hpx::find_here(),
-                                parent_device_id,
-                                (clx_event) returnEvent
-                            ));
+    // Count the transfer as outstanding work of the device
+    parent_device->track_pending_command(returnEvent);
+    track_event(returnEvent);
 
+    return returnEvent;
 }
 
-hpx::opencl::event
-buffer::write(size_t offset, hpx::util::serialize_buffer<char> data,
-                             std::vector<hpx::opencl::event> events)
+// Enqueues a strided read to the given host memory
+cl_event
+buffer::enqueue_read_rect_impl(resident_lock const& resident,
+                               size_t offset, size_t row_size,
+                               size_t num_rows, size_t buffer_row_pitch,
+                               void* dst, size_t dst_row_pitch,
+                               std::vector<hpx::opencl::event> & events)
 {
+    cl_int err;
+    cl_event returnEvent;
+
+    // Get the command queue
+    cl_command_queue command_queue = parent_device->get_read_command_queue();
     
+    
+    // Get the cl_event dependency list
+    std::vector<cl_event> cl_events_list = hpx::opencl::event::
+                                                    get_cl_events(events);
+    cl_event* cl_events_list_ptr = NULL;
+    if(!cl_events_list.empty())
+    {
+        cl_events_list_ptr = cl_events_list.data();
+    }
+
+    // The offset is the x-coordinate of the origin, in bytes
+    size_t buffer_origin[3] = {offset, 0, 0};
+    size_t host_origin[3] = {0, 0, 0};
+    size_t region[3] = {row_size, num_rows, 1};
+
+    // Read the buffer
+    err = ::clEnqueueReadBufferRect(command_queue, device_mem, CL_FALSE,
+                                    buffer_origin, host_origin, region,
+                                    buffer_row_pitch, 0,
+                                    dst_row_pitch, 0,
+                                    dst, (cl_uint)events.size(),
+                                    cl_events_list_ptr, &returnEvent);
+    cl_ensure(err, "clEnqueueReadBufferRect()");
+
+    // Count the transfer as outstanding work of the device
+    parent_device->track_pending_command(returnEvent);
+    track_event(returnEvent);
+
+    return returnEvent;
+}
+
+// Enqueues a write from the given host memory
+const void*
+buffer::first_write_data(size_t offset, size_t size, const void* src,
+                         std::vector<hpx::opencl::event> const& events)
+{
+    // Only a full write can replace the initialization of the memory
+    if(offset == 0 && size == mem_size && events.empty())
+        return src;
+
+    return NULL;
+}
+
+// Enqueues a write from the given host memory
+cl_event
+buffer::enqueue_write_impl(resident_lock const& resident,
+                           size_t offset, size_t size, const void* src,
+                           std::vector<hpx::opencl::event> & events)
+{
     cl_int err;
     cl_event returnEvent;
 
+    // A full write as first use got done by the creation of the memory
+    if(resident.used_initial_data())
+    {
+        // The data is on the device already
+        returnEvent = clCreateUserEvent(parent_device->get_context(), &err);
+        cl_ensure(err, "clCreateUserEvent()");
+        err = clSetUserEventStatus(returnEvent, CL_COMPLETE);
+        cl_ensure(err, "clSetUserEventStatus()");
+
+        return returnEvent;
+    }
+
     // Get the command queue
     cl_command_queue command_queue = parent_device->get_write_command_queue();
     
@@ -177,10 +472,60 @@ buffer::write(size_t offset, hpx::util::serialize_buffer<char> data,
 
     // Write to the buffer
     err = ::clEnqueueWriteBuffer(command_queue, device_mem, CL_FALSE, offset,
-                                 data.size(), data.data(), (cl_uint)events.size(),
+                                 size, src, (cl_uint)events.size(),
                                  cl_events_list_ptr, &returnEvent);
     cl_ensure(err, "clEnqueueWriteBuffer()");
 
+    // Count the transfer as outstanding work of the device
+    parent_device->track_pending_command(returnEvent);
+    track_event(returnEvent);
+
+    return returnEvent;
+}
+
+// Read Buffer
+hpx::opencl::event
+buffer::read(size_t offset, size_t size,
+                            std::vector<hpx::opencl::event> events)
+{
+
+    // Create the buffer
+    boost::shared_ptr<std::vector<char>> buffer = 
+                                    boost::make_shared<std::vector<char>>(size);
+
+    // Keep the memory in place until the event got created
+    resident_lock resident(*this);
+
+    // Read the buffer
+    cl_event returnEvent = enqueue_read_impl(resident, offset, size,
+                                             (void*)(buffer->data()), events);
+
+    // Send buffer to device class
+    parent_device->put_event_data(returnEvent, buffer);
+    
+    // Return the event
+    return hpx::opencl::event(
+           hpx::components::new_<hpx::opencl::server::event>(
+                                hpx::find_here(),
+                                parent_device_id,
+                                (clx_event) returnEvent
+                            ));
+
+}
+
+hpx::opencl::event
+buffer::write(size_t offset, hpx::util::serialize_buffer<char> data,
+                             std::vector<hpx::opencl::event> events)
+{
+    
+    // Keep the memory in place until the event got created
+    resident_lock resident(*this, first_write_data(offset, data.size(),
+                                                   data.data(), events));
+
+    // Write to the buffer
+    cl_event returnEvent = enqueue_write_impl(resident, offset, data.size(),
+                                              data.data(), events);
+
     // Register the input data to prevent deallocation
     parent_device->put_event_const_data(returnEvent, data);
     
@@ -194,12 +539,140 @@ buffer::write(size_t offset, hpx::util::serialize_buffer<char> data,
 
 }
 
+// Keeps the read data alive until the read completed, then returns it
+static boost::shared_ptr<std::vector<char>>
+read_local_callback(boost::shared_ptr<std::vector<char>> data,
+                    hpx::lcos::future<void> read_future)
+{
+    // Rethrows OpenCL errors
+    read_future.get();
+
+    return data;
+}
+
+// Keeps the written data alive until the write completed
+static void
+write_local_callback(hpx::util::serialize_buffer<char> data,
+                     hpx::lcos::future<void> write_future)
+{
+    // Rethrows OpenCL errors
+    write_future.get();
+}
+
+hpx::lcos::future<boost::shared_ptr<std::vector<char>>>
+buffer::read_local(size_t offset, size_t size)
+{
+
+    // Create the buffer
+    boost::shared_ptr<std::vector<char>> buffer = 
+                                    boost::make_shared<std::vector<char>>(size);
+
+    // Read the buffer
+    std::vector<hpx::opencl::event> events(0);
+    cl_event returnEvent;
+    {
+        resident_lock resident(*this);
+        returnEvent = enqueue_read_impl(resident, offset, size,
+                                        (void*)(buffer->data()), events);
+    }
+
+    // Convert to future, the future holds its own reference to the cl_event
+    hpx::lcos::future<void> read_future =
+                                 hpx::opencl::server::future_from_cl_event(
+                                                                   returnEvent);
+    cl_int err = clReleaseEvent(returnEvent);
+    cl_ensure(err, "clReleaseEvent()");
+
+    return read_future.then(hpx::util::bind(&read_local_callback, buffer,
+                                            util::placeholders::_1));
+
+}
+
+hpx::lcos::future<void>
+buffer::write_local(size_t offset, hpx::util::serialize_buffer<char> data)
+{
+
+    // Write to the buffer
+    std::vector<hpx::opencl::event> events(0);
+    cl_event returnEvent;
+    {
+        resident_lock resident(*this, first_write_data(offset, data.size(),
+                                                       data.data(), events));
+        returnEvent = enqueue_write_impl(resident, offset, data.size(),
+                                         data.data(), events);
+    }
+
+    // Convert to future, the future holds its own reference to the cl_event
+    hpx::lcos::future<void> write_future =
+                                 hpx::opencl::server::future_from_cl_event(
+                                                                   returnEvent);
+    cl_int err = clReleaseEvent(returnEvent);
+    cl_ensure(err, "clReleaseEvent()");
+
+    return write_future.then(hpx::util::bind(&write_local_callback, data,
+                                             util::placeholders::_1));
+
+}
+
+hpx::lcos::future<void>
+buffer::read_to_local(size_t offset, size_t size, void* dst,
+                      std::vector<hpx::opencl::event> events)
+{
+
+    // Read directly to the destination
+    cl_event returnEvent;
+    {
+        resident_lock resident(*this);
+        returnEvent = enqueue_read_impl(resident, offset, size, dst, events);
+    }
+
+    // Convert to future, the future holds its own reference to the cl_event
+    hpx::lcos::future<void> read_future =
+                                 hpx::opencl::server::future_from_cl_event(
+                                                                   returnEvent);
+    cl_int err = clReleaseEvent(returnEvent);
+    cl_ensure(err, "clReleaseEvent()");
+
+    return read_future;
+
+}
+
+hpx::lcos::future<void>
+buffer::read_rect_to_local(size_t offset, size_t row_size, size_t num_rows,
+                           size_t buffer_row_pitch, void* dst,
+                           size_t dst_row_pitch,
+                           std::vector<hpx::opencl::event> events)
+{
+
+    // Read directly to the destination
+    cl_event returnEvent;
+    {
+        resident_lock resident(*this);
+        returnEvent = enqueue_read_rect_impl(resident, offset, row_size,
+                                             num_rows, buffer_row_pitch, dst,
+                                             dst_row_pitch, events);
+    }
+
+    // Convert to future, the future holds its own reference to the cl_event
+    hpx::lcos::future<void> read_future =
+                                 hpx::opencl::server::future_from_cl_event(
+                                                                   returnEvent);
+    cl_int err = clReleaseEvent(returnEvent);
+    cl_ensure(err, "clReleaseEvent()");
+
+    return read_future;
+
+}
+
 #ifdef CL_VERSION_1_2
 hpx::opencl::event
 buffer::fill(hpx::util::serialize_buffer<char> pattern, size_t offset,
              size_t size, std::vector<hpx::opencl::event> events)
 {
     
+    // Keep managed memory on the device until the command got enqueued
+    resident_lock resident(*this);
+
     cl_int err;
     cl_event returnEvent;
 
@@ -220,6 +693,8 @@ buffer::fill(hpx::util::serialize_buffer<char> pattern, size_t offset,
                                 pattern.size(), offset, size,
                                 (cl_uint)events.size(), cl_events_list_ptr,
                                 &returnEvent);
+    cl_ensure(err, "clEnqueueFillBuffer()");
+    track_event(returnEvent);
 
     // Register the input data to prevent deallocation
     parent_device->put_event_const_data(returnEvent, pattern);
@@ -236,7 +711,7 @@ buffer::fill(hpx::util::serialize_buffer<char> pattern, size_t offset,
 #endif
 
 // Bruteforce copy, needed for copy between different machines
-cl_event
+hpx::opencl::event
 buffer::copy_bruteforce(hpx::naming::id_type & src_buffer,
                         const size_t & src_offset,
                         const size_t & dst_offset,
@@ -257,27 +732,36 @@ buffer::copy_bruteforce(hpx::naming::id_type & src_buffer,
         hpx::lcos::future<boost::shared_ptr<std::vector<char>>>
             data_future = read_event.get_data();
 
-        // Get the command queue
-        cl_command_queue command_queue = parent_device->get_write_command_queue();
-
         // Wait for data transmit to finish
         boost::shared_ptr<std::vector<char>> data = data_future.get();
 
+        // Keep the memory in place until the event got created
+        resident_lock resident(*this);
+
+        // Get the command queue
+        cl_command_queue command_queue = parent_device->get_write_command_queue();
+
         // write to dst buffer
         err = ::clEnqueueWriteBuffer(command_queue, device_mem, CL_FALSE,
                                      dst_offset, size, data->data(), 0, NULL,
                                      &returnEvent);
         cl_ensure(err, "clEnqueueWriteBuffer()");
+        track_event(returnEvent);
         
         // store the data on device as event data to prevent deallocation
         parent_device->put_event_data(returnEvent, data);
 
         // return the event
-        return returnEvent;
+        return hpx::opencl::event(
+               hpx::components::new_<hpx::opencl::server::event>(
+                                    hpx::find_here(),
+                                    parent_device_id,
+                                    (clx_event) returnEvent
+                                ));
 }
 
 // Local copy, same process but different context
-cl_event
+hpx::opencl::event
 buffer::copy_local(boost::shared_ptr<hpx::opencl::server::buffer> src,
                    const size_t & src_offset,
                    const size_t & dst_offset,
@@ -300,29 +784,38 @@ buffer::copy_local(boost::shared_ptr<hpx::opencl::server::buffer> src,
         boost::shared_ptr<std::vector<char>> copy_buffer = 
                                     boost::make_shared<std::vector<char>>(size);
         
-        // get the read command queue
-        cl_command_queue src_command_queue =
-                                   src->parent_device->get_read_command_queue();
-
         // Read into buffer
-        cl_event read_event_;
-        err = ::clEnqueueReadBuffer(src_command_queue, src->device_mem,
-                                    CL_FALSE, src_offset, size,
-                                    (void*)(copy_buffer->data()),
-                                    (cl_uint)events.size(),
-                                    cl_events_list_ptr, &read_event_);
-        cl_ensure(err, "clEnqueueReadBuffer()");
+        hpx::lcos::future<void> read_future;
+        {
+            resident_lock src_resident(*src);
 
-        // Create hpx::opencl::event from cl_event
-        hpx::opencl::event read_event(
-               hpx::components::new_<hpx::opencl::server::event>(
-                                    hpx::find_here(),
-                                    src->parent_device_id,
-                                    (clx_event) read_event_
-                                ));
+            // get the read command queue
+            cl_command_queue src_command_queue =
+                                   src->parent_device->get_read_command_queue();
+
+            cl_event read_event_;
+            err = ::clEnqueueReadBuffer(src_command_queue, src->device_mem,
+                                        CL_FALSE, src_offset, size,
+                                        (void*)(copy_buffer->data()),
+                                        (cl_uint)events.size(),
+                                        cl_events_list_ptr, &read_event_);
+            cl_ensure(err, "clEnqueueReadBuffer()");
+            src->track_event(read_event_);
+
+            // Create hpx::opencl::event from cl_event
+            hpx::opencl::event read_event(
+                   hpx::components::new_<hpx::opencl::server::event>(
+                                        hpx::find_here(),
+                                        src->parent_device_id,
+                                        (clx_event) read_event_
+                                    ));
+
+            // Create future from event
+            read_future = read_event.get_future();
+        }
 
-        // Create future from event
-        hpx::lcos::future<void> read_future = read_event.get_future();
+        // Keep the memory in place until the event got created
+        resident_lock resident(*this);
 
         // Create device client of dst
         hpx::opencl::device dst_device(
@@ -346,16 +839,22 @@ buffer::copy_local(boost::shared_ptr<hpx::opencl::server::buffer> src,
                                      1, &write_start_event,
                                      &returnEvent);
         cl_ensure(err, "clEnqueueWriteBuffer()");
+        track_event(returnEvent);
         
         // Send buffer to device class to prevent deallocation
         parent_device->put_event_data(returnEvent, copy_buffer);
  
         // return the event
-        return returnEvent;
+        return hpx::opencl::event(
+               hpx::components::new_<hpx::opencl::server::event>(
+                                    hpx::find_here(),
+                                    parent_device_id,
+                                    (clx_event) returnEvent
+                                ));
 }
 
 // Direct copy, buffers are on the same context
-cl_event
+hpx::opencl::event
 buffer::copy_direct(boost::shared_ptr<hpx::opencl::server::buffer> src,
                     const size_t & src_offset,
                     const size_t & dst_offset,
@@ -374,6 +873,15 @@ buffer::copy_direct(boost::shared_ptr<hpx::opencl::server::buffer> src,
             cl_events_list_ptr = cl_events_list.data();
         }
 
+        // Keep both buffers in place until the event got created.
+        // Lock in address order to avoid deadlocks.
+        buffer* first = (std::min)(this, src.get());
+        buffer* second = (std::max)(this, src.get());
+        resident_lock first_resident(*first);
+        boost::scoped_ptr<resident_lock> second_resident;
+        if(second != first)
+            second_resident.reset(new resident_lock(*second));
+
         // get command queue
         cl_command_queue command_queue = 
                                        parent_device->get_write_command_queue();
@@ -384,9 +892,17 @@ buffer::copy_direct(boost::shared_ptr<hpx::opencl::server::buffer> src,
                                     (cl_uint)events.size(),
                                     cl_events_list_ptr, &returnEvent);
         cl_ensure(err, "clEnqueueCopyBuffer()");
+        track_event(returnEvent);
+        if(src.get() != this)
+            src->track_event(returnEvent);
        
-        // return the evetn
-        return returnEvent;
+        // return the event
+        return hpx::opencl::event(
+               hpx::components::new_<hpx::opencl::server::event>(
+                                    hpx::find_here(),
+                                    parent_device_id,
+                                    (clx_event) returnEvent
+                                ));
 }
 
 
@@ -401,9 +917,6 @@ buffer::copy(hpx::naming::id_type src_buffer, std::vector<size_t> dimensions,
     size_t dst_offset = dimensions[1];
     size_t size = dimensions[2];
 
-    // Initialize
-    cl_event returnEvent;
-
     // Get buffer locations
     hpx::naming::id_type src_location;
     hpx::naming::id_type dst_location;
@@ -420,32 +933,234 @@ buffer::copy(hpx::naming::id_type src_buffer, std::vector<size_t> dimensions,
     if(src_location != dst_location)
     {
         // Data is on different machines/processes, brute force copy.
-        returnEvent = copy_bruteforce(src_buffer, src_offset, dst_offset,
-                                      size, events);
+        return copy_bruteforce(src_buffer, src_offset, dst_offset, size,
+                               events);
     }
-    else
+
+    // Data is on the same machine and process.
+    boost::shared_ptr<hpx::opencl::server::buffer> src = 
+                hpx::get_ptr<hpx::opencl::server::buffer>(src_buffer).get();
+    cl_context src_context = src->parent_device->get_context();
+    cl_context dst_context = this->parent_device->get_context();
+
+    if(src_context != dst_context)
     {
-        // Data is on the same machine and process.
-        boost::shared_ptr<hpx::opencl::server::buffer> src = 
-                    hpx::get_ptr<hpx::opencl::server::buffer>(src_buffer).get();
-        cl_context src_context = src->parent_device->get_context();
-        cl_context dst_context = this->parent_device->get_context();
+        // Data is on the same process, but on different contexts
+        return copy_local(src, src_offset, dst_offset, size, events);
+    }
 
-        if(src_context != dst_context)
+    // Data is on the same context, perform direct copy
+    return copy_direct(src, src_offset, dst_offset, size, events);
+
+}
+
+
+// Native migration, the target device shares the context
+cl_event
+buffer::migrate_native(boost::shared_ptr<device> target,
+                       std::vector<hpx::opencl::event> & events)
+{
+        cl_int err;
+        cl_event returnEvent;
+
+        // Get the cl_event dependency list
+        std::vector<cl_event> cl_events_list = hpx::opencl::event::
+                                                        get_cl_events(events);
+        cl_event* cl_events_list_ptr = NULL;
+        if(!cl_events_list.empty())
         {
-            // Data is on the same process, but on different contexts
-            returnEvent = copy_local(src, src_offset, dst_offset, size, events);
+            cl_events_list_ptr = cl_events_list.data();
         }
-        else
+
+        cl_command_queue command_queue = target->get_write_command_queue();
+
+#ifdef CL_VERSION_1_2
+        // Move the memory to the target device
+        err = ::clEnqueueMigrateMemObjects(command_queue, 1, &device_mem, 0,
+                                           (cl_uint)events.size(),
+                                           cl_events_list_ptr, &returnEvent);
+        cl_ensure(err, "clEnqueueMigrateMemObjects()");
+#else
+        // The memory is usable by all devices of the context,
+        // only wait for the dependencies
+        if(!cl_events_list.empty())
+        {
+            err = ::clEnqueueWaitForEvents(command_queue,
+                                           (cl_uint)events.size(),
+                                           cl_events_list_ptr);
+            cl_ensure(err, "clEnqueueWaitForEvents()");
+        }
+        err = ::clEnqueueMarker(command_queue, &returnEvent);
+        cl_ensure(err, "clEnqueueMarker()");
+#endif
+
+        return returnEvent;
+}
+
+// Streams the data to new memory on the target device.
+// All chunks get read at once, every chunk gets written as soon as it
+// arrived, so the transfers in both directions overlap.
+cl_event
+buffer::migrate_streamed(boost::shared_ptr<device> target,
+                         cl_mem target_mem,
+                         std::vector<hpx::opencl::event> & events)
+{
+        cl_int err;
+
+        size_t total_size = size();
+
+        // Get the cl_event dependency list
+        std::vector<cl_event> cl_events_list = hpx::opencl::event::
+                                                        get_cl_events(events);
+        cl_event* cl_events_list_ptr = NULL;
+        if(!cl_events_list.empty())
+        {
+            cl_events_list_ptr = cl_events_list.data();
+        }
+
+        // The host memory all chunks pass through
+        boost::shared_ptr<std::vector<char>> staging_buffer =
+                            boost::make_shared<std::vector<char>>(total_size);
+
+        // Read all chunks
+        cl_command_queue src_command_queue =
+                                       parent_device->get_read_command_queue();
+        std::vector<hpx::lcos::future<void>> read_futures;
+        for(size_t offset = 0; offset < total_size;
+                                            offset += MIGRATION_CHUNK_SIZE)
         {
-            // Data is on the same context, perform direct copy
-            returnEvent = copy_direct(src, src_offset, dst_offset, size, events);
+            size_t chunk_size = std::min<size_t>(MIGRATION_CHUNK_SIZE,
+                                                 total_size - offset);
+
+            cl_event read_event;
+            err = ::clEnqueueReadBuffer(src_command_queue, device_mem,
+                                        CL_FALSE, offset, chunk_size,
+                                        staging_buffer->data() + offset,
+                                        (cl_uint)events.size(),
+                                        cl_events_list_ptr, &read_event);
+            cl_ensure(err, "clEnqueueReadBuffer()");
+
+            // The future holds its own reference to the cl_event
+            read_futures.push_back(
+                    hpx::opencl::server::future_from_cl_event(read_event));
+            err = clReleaseEvent(read_event);
+            cl_ensure(err, "clReleaseEvent()");
         }
 
+        // Write every chunk after its read, in order
+        cl_command_queue dst_command_queue =
+                                       target->get_write_command_queue();
+        cl_event last_write_event = NULL;
+        for(size_t i = 0; i < read_futures.size(); i++)
+        {
+            size_t offset = i * MIGRATION_CHUNK_SIZE;
+            size_t chunk_size = std::min<size_t>(MIGRATION_CHUNK_SIZE,
+                                                 total_size - offset);
+
+            // Suspends this hpx thread until the chunk arrived
+            read_futures[i].get();
+
+            cl_event write_event;
+            err = ::clEnqueueWriteBuffer(dst_command_queue, target_mem,
+                                         CL_FALSE, offset, chunk_size,
+                                         staging_buffer->data() + offset,
+                                         last_write_event ? 1 : 0,
+                                         last_write_event ? &last_write_event
+                                                          : NULL,
+                                         &write_event);
+            cl_ensure(err, "clEnqueueWriteBuffer()");
+
+            // The writes are chained, so the last one finishes last
+            if(last_write_event)
+            {
+                err = clReleaseEvent(last_write_event);
+                cl_ensure(err, "clReleaseEvent()");
+            }
+            last_write_event = write_event;
+        }
+
+        // Send buffer to device class to prevent deallocation
+        target->put_event_data(last_write_event, staging_buffer);
+
+        return last_write_event;
+}
+
+hpx::opencl::event
+buffer::migrate(hpx::naming::id_type device_id,
+                std::vector<hpx::opencl::event> events)
+{
+
+    // The component can't move, migrate_remote creates a new one
+    if(!hpx::opencl::is_local(device_id))
+    {
+        HPX_THROW_EXCEPTION(hpx::bad_parameter,
+                            "buffer::migrate()",
+                            "Target device is on a different locality!");
     }
-        
-    
-     // Return the event
+
+    boost::shared_ptr<hpx::opencl::server::device> target =
+                    hpx::get_ptr<hpx::opencl::server::device>(device_id).get();
+
+    // Wait for running commands of this buffer, block new ones
+    resident_lock resident(*this);
+    bool target_managed = target->is_memory_managed();
+
+    cl_event returnEvent;
+    if(target->get_context() == parent_device->get_context())
+    {
+        // Same context, the memory object stays the same
+        returnEvent = migrate_native(target, events);
+
+        // The memory now counts for the target device
+        if(managed)
+            parent_device->unregister_buffer(this);
+        if(target_managed)
+            target->register_buffer(this);
+    }
+    else
+    {
+        cl_int err;
+
+        // Create the new memory with the flags of the old one
+        cl_mem_flags flags;
+        err = clGetMemObjectInfo(device_mem, CL_MEM_FLAGS,
+                                 sizeof(cl_mem_flags), &flags, NULL);
+        cl_ensure(err, "clGetMemObjectInfo()");
+        flags = flags & ~(CL_MEM_USE_HOST_PTR
+                          | CL_MEM_ALLOC_HOST_PTR
+                          | CL_MEM_COPY_HOST_PTR);
+
+        cl_mem target_mem = target->allocate_buffer_mem(flags, size(), NULL,
+                                                target_managed ? this : NULL);
+
+        returnEvent = migrate_streamed(target, target_mem, events);
+
+        // All reads of the old memory finished, the recorded commands
+        // belong to the old context
+        release_pending_events();
+
+        // Kernels that got this buffer as argument still know the old
+        // memory, they have to look it up on launch from now on
+        relocated = true;
+
+        // All reads finished, the old memory is not needed any more
+        if(managed)
+            parent_device->unregister_buffer(this);
+        parent_device->schedule_cl_mem_deletion(device_mem);
+        device_mem = target_mem;
+    }
+
+    // The buffer might get evicted from the target device from now on
+    managed = target_managed;
+
+    // From now on, all commands run on the target device
+    parent_device = target;
+    parent_device_id = device_id;
+
+    // Evicting from the target device has to wait for the migration
+    track_event(returnEvent);
+
+    // Return the event
     return hpx::opencl::event(
            hpx::components::new_<hpx::opencl::server::event>(
                                 hpx::find_here(),
@@ -455,6 +1170,41 @@ buffer::copy(hpx::naming::id_type src_buffer, std::vector<size_t> dimensions,
 
 }
 
+// Creates a copy of this buffer on the locality of the target device.
+// Every chunk is a copy of its own, the target pulls all of them at once,
+// so reading, sending and writing of different chunks overlap.
+hpx::naming::id_type
+buffer::migrate_remote(hpx::naming::id_type device_id,
+                       std::vector<hpx::opencl::event> events)
+{
+
+    // The memory gets created by the first chunk
+    hpx::opencl::buffer target_buffer(
+                hpx::components::new_<hpx::opencl::server::buffer>(
+                                hpx::get_colocation_id(device_id).get(),
+                                device_id, mem_flags, mem_size));
+
+    hpx::opencl::buffer src(hpx::lcos::make_ready_future(get_gid()));
+
+    std::vector<hpx::lcos::future<hpx::opencl::event>> copies;
+    for(size_t offset = 0; offset < mem_size; offset += MIGRATION_CHUNK_SIZE)
+    {
+        size_t chunk_size = std::min<size_t>(MIGRATION_CHUNK_SIZE,
+                                             mem_size - offset);
+        copies.push_back(target_buffer.enqueue_copy(src, offset, offset,
+                                                    chunk_size, events));
+    }
+
+    // Return once all data arrived, this buffer has to stay alive until then
+    for(size_t i = 0; i < copies.size(); i++)
+    {
+        copies[i].get().await();
+    }
+
+    return target_buffer.get_gid();
+
+}
+
 
 cl_mem
 buffer::get_cl_mem()
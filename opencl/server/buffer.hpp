@@ -12,10 +12,13 @@
 #include <hpx/config.hpp>
 #include <hpx/include/components.hpp>
 #include <hpx/util/serialize_buffer.hpp>
+#include <hpx/lcos/local/mutex.hpp>
 
 #include <CL/cl.h>
 
 #include <boost/shared_ptr.hpp>
+#include <boost/noncopyable.hpp>
+#include <boost/atomic.hpp>
 #include <vector>
 
 #include "../fwd_declarations.hpp"
@@ -41,8 +44,77 @@ namespace hpx { namespace opencl{ namespace server{
         ///////////////////////////////////////////////////
         /// Local functions
         /// 
+
+        // Keeps the memory of the buffer in place while in scope,
+        // migrations and evictions wait for it.
+        // Moves the buffer back to the device if it got evicted and
+        // creates the memory on first use.
+        class resident_lock
+          : boost::noncopyable
+        {
+        public:
+            // If the memory gets created for the first time and
+            // initial_data is given, the whole buffer gets initialized
+            // with it.
+            explicit resident_lock(buffer & parent,
+                                   const void* initial_data = NULL);
+            ~resident_lock();
+
+            // Whether the memory got initialized with initial_data
+            bool used_initial_data() const;
+
+        private:
+            buffer & parent;
+            bool initialized;
+        };
+
+        // The memory of managed, relocated or not yet allocated buffers is
+        // only valid while a resident_lock is held
         cl_mem get_cl_mem();
 
+        // Whether the buffer can get evicted to the host
+        bool is_managed();
+
+        // Whether the device memory got created already
+        bool is_allocated();
+
+        // Whether a migration replaced the memory. Kernels have to look up
+        // the memory of such buffers on every launch.
+        bool is_relocated();
+
+        // Used by the device to evict buffers that are not in use.
+        // try_lock_residency doesn't suspend.
+        bool try_lock_residency();
+        void unlock_residency();
+
+        // Moves the content to the host and releases the device memory.
+        // Only waits for the commands recorded with track_event.
+        // The residency lock needs to be held.
+        void evict();
+
+        // Records a command that uses the memory of a managed buffer,
+        // evict waits for it. The residency lock needs to be held.
+        void track_event(cl_event event);
+
+        // Component-less versions of read and write.
+        // The returned futures trigger as soon as the OpenCL command
+        // completed, no event component gets created.
+        hpx::lcos::future<boost::shared_ptr<std::vector<char>>>
+        read_local(size_t offset, size_t size);
+        hpx::lcos::future<void>
+        write_local(size_t offset, hpx::util::serialize_buffer<char> data);
+
+        // Component-less reads directly into caller owned host memory.
+        // dst needs to stay valid until the returned future triggered.
+        hpx::lcos::future<void>
+        read_to_local(size_t offset, size_t size, void* dst,
+                      std::vector<hpx::opencl::event> events);
+        hpx::lcos::future<void>
+        read_rect_to_local(size_t offset, size_t row_size, size_t num_rows,
+                           size_t buffer_row_pitch, void* dst,
+                           size_t dst_row_pitch,
+                           std::vector<hpx::opencl::event> events);
+
         ///////////////////////////////////////////////////
         /// Exposed functionality of this component
         ///
@@ -60,12 +132,18 @@ namespace hpx { namespace opencl{ namespace server{
         hpx::opencl::event copy(hpx::naming::id_type src_buffer, 
                                 std::vector<size_t> dimensions,
                                 std::vector<hpx::opencl::event> events);
+        hpx::opencl::event migrate(hpx::naming::id_type device_id,
+                                   std::vector<hpx::opencl::event> events);
+        hpx::naming::id_type migrate_remote(hpx::naming::id_type device_id,
+                                   std::vector<hpx::opencl::event> events);
 
     //[
     HPX_DEFINE_COMPONENT_ACTION(buffer, size);
     HPX_DEFINE_COMPONENT_ACTION(buffer, read);
     HPX_DEFINE_COMPONENT_ACTION(buffer, write);
     HPX_DEFINE_COMPONENT_ACTION(buffer, copy);
+    HPX_DEFINE_COMPONENT_ACTION(buffer, migrate);
+    HPX_DEFINE_COMPONENT_ACTION(buffer, migrate_remote);
 #ifdef CL_VERSION_1_2
     HPX_DEFINE_COMPONENT_ACTION(buffer, fill);
 #endif
@@ -75,27 +153,75 @@ namespace hpx { namespace opencl{ namespace server{
         /// Private Member Functions
         ///
 
+        // The enqueue functions need the resident_lock to be held, the
+        // caller keeps it until it is done with parent_device.
+
+        // Enqueues a read to the given host memory
+        cl_event enqueue_read_impl(resident_lock const& resident,
+                                   size_t offset, size_t size, void* dst,
+                                   std::vector<hpx::opencl::event> & events);
+
+        // Enqueues a strided read of num_rows rows to the given host memory
+        cl_event enqueue_read_rect_impl(resident_lock const& resident,
+                                        size_t offset, size_t row_size,
+                                        size_t num_rows,
+                                        size_t buffer_row_pitch, void* dst,
+                                        size_t dst_row_pitch,
+                                    std::vector<hpx::opencl::event> & events);
+
+        // Enqueues a write from the given host memory.
+        // The lock needs to get created with first_write_data.
+        cl_event enqueue_write_impl(resident_lock const& resident,
+                                    size_t offset, size_t size,
+                                    const void* src,
+                                    std::vector<hpx::opencl::event> & events);
+
+        // The data to create the memory with if the write is the first use
+        // and covers the whole buffer, NULL otherwise
+        const void* first_write_data(size_t offset, size_t size,
+                                     const void* src,
+                              std::vector<hpx::opencl::event> const& events);
+
         // Bruteforce copy, needed for copy between different machines
-        cl_event copy_bruteforce(hpx::naming::id_type & src_buffer,
+        hpx::opencl::event copy_bruteforce(hpx::naming::id_type & src_buffer,
                                  const size_t & src_offset,
                                  const size_t & dst_offset,
                                  const size_t & size,
                                  std::vector<hpx::opencl::event> & events);
 
         // Local copy, buffers are on the same machine but in different contexts
-        cl_event copy_local(boost::shared_ptr<hpx::opencl::server::buffer>,
+        hpx::opencl::event copy_local(
+                            boost::shared_ptr<hpx::opencl::server::buffer>,
                             const size_t & src_offset,
                             const size_t & dst_offset,
                             const size_t & size,
                             std::vector<hpx::opencl::event> & events);
 
         // Direct copy, buffers are on the same context
-        cl_event copy_direct(boost::shared_ptr<hpx::opencl::server::buffer>,
+        hpx::opencl::event copy_direct(
+                             boost::shared_ptr<hpx::opencl::server::buffer>,
                              const size_t & src_offset,
                              const size_t & dst_offset,
                              const size_t & size,
                              std::vector<hpx::opencl::event> & events);
 
+        // Native migration, the target device shares the context
+        cl_event migrate_native(boost::shared_ptr<device> target,
+                                std::vector<hpx::opencl::event> & events);
+
+        // Streams the data to new memory on the target device
+        cl_event migrate_streamed(boost::shared_ptr<device> target,
+                                  cl_mem target_mem,
+                                  std::vector<hpx::opencl::event> & events);
+
+        // Moves an evicted buffer back to the device, or creates the
+        // memory on first use. Returns whether initial_data got used.
+        // The residency lock needs to be held.
+        bool make_resident(const void* initial_data);
+
+        // Releases the events recorded with track_event
+        void release_pending_events();
+
 
 
     private:
@@ -105,6 +231,29 @@ namespace hpx { namespace opencl{ namespace server{
         cl_mem device_mem;
         hpx::naming::id_type parent_device_id;
 
+        // The size and the flags, needed to re-create evicted memory
+        size_t mem_size;
+        cl_mem_flags mem_flags;
+
+        // Managed memory, see device::enable_managed_memory.
+        // While evicted, device_mem is NULL and the content is on the host.
+        bool managed;
+        boost::shared_ptr<std::vector<char>> host_copy;
+        hpx::lcos::local::mutex residency_mutex;
+
+        // The commands that might still use the memory of a managed buffer,
+        // guarded by residency_mutex. Completed ones get dropped once the
+        // list reaches pending_events_prune_size.
+        std::vector<cl_event> pending_events;
+        std::size_t pending_events_prune_size;
+
+        // Set once the device memory got created, buffers without
+        // initial data get created on first use
+        boost::atomic<bool> allocated;
+
+        // Set once a migration replaced the memory
+        boost::atomic<bool> relocated;
+
     };
 
 
@@ -124,6 +273,12 @@ HPX_REGISTER_ACTION_DECLARATION(
 HPX_REGISTER_ACTION_DECLARATION(
         hpx::opencl::server::buffer::copy_action,
         opencl_buffer_copy_action);
+HPX_REGISTER_ACTION_DECLARATION(
+        hpx::opencl::server::buffer::migrate_action,
+        opencl_buffer_migrate_action);
+HPX_REGISTER_ACTION_DECLARATION(
+        hpx::opencl::server::buffer::migrate_remote_action,
+        opencl_buffer_migrate_remote_action);
 #ifdef CL_VERSION_1_2
 HPX_REGISTER_ACTION_DECLARATION(
         hpx::opencl::server::buffer::fill_action,
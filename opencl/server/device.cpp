@@ -17,6 +17,7 @@
 
 //#include <hpx/include/components.hpp>
 #include <hpx/include/runtime.hpp>
+#include <hpx/util/high_resolution_timer.hpp>
 
 using namespace hpx::opencl::server;
 
@@ -24,6 +25,9 @@ CL_FORBID_EMPTY_CONSTRUCTOR(device);
 
 // Constructor
 device::device(clx_device_id _device_id, bool enable_profiling)
+  : pending_events_tracked(false), pending_events_prune_size(64),
+    measured_bandwidth(0.0), memory_managed(false),
+    memory_limit(0), memory_in_use(0)
 {
     this->device_id = (cl_device_id)_device_id;
     
@@ -47,11 +51,12 @@ device::device(clx_device_id _device_id, bool enable_profiling)
                               &err);
     cl_ensure(err, "clCreateContext()");
 
+    // Query all static properties
+    init_properties();
+
     // Get supported device queue properties
-    std::vector<char> supported_queue_properties_data = 
-                                    get_device_info(CL_DEVICE_QUEUE_PROPERTIES);
     cl_command_queue_properties supported_queue_properties =
-        *((cl_command_queue_properties *)(supported_queue_properties_data.data()));
+                                                   properties.queue_properties;
 
     // Initialize command queue properties
     cl_command_queue_properties command_queue_properties = 0;
@@ -84,6 +89,15 @@ device::~device()
     {
         err = clFinish(command_queue);
         cl_ensure_nothrow(err, "clFinish()");
+
+        // All commands are finished, release their events
+        BOOST_FOREACH(cl_event event, pending_events)
+        {
+            err = clReleaseEvent(event);
+            cl_ensure_nothrow(err, "clReleaseEvent()");
+        }
+        pending_events.clear();
+
         err = clReleaseCommandQueue(command_queue);
         cl_ensure_nothrow(err, "clReleaseCommandQueue()");
         command_queue = NULL; 
@@ -130,6 +144,257 @@ device::get_work_command_queue()
     return command_queue;
 }
 
+hpx::opencl::device_properties const&
+device::get_properties()
+{
+    return properties;
+}
+
+void
+device::track_pending_command(cl_event event)
+{
+
+    // Nobody asked for the count yet
+    if(!pending_events_tracked.load(boost::memory_order_relaxed))
+        return;
+
+    cl_int err;
+    err = clRetainEvent(event);
+    cl_ensure(err, "clRetainEvent()");
+
+    boost::lock_guard<spinlock_type> lock(pending_events_mutex);
+    pending_events.push_back(event);
+
+    // Keep the list short if the count doesn't get queried
+    if(pending_events.size() >= pending_events_prune_size)
+    {
+        prune_pending_events_nolock();
+        pending_events_prune_size = 2 * pending_events.size() + 64;
+    }
+
+}
+
+void
+device::prune_pending_events_nolock()
+{
+
+    std::vector<cl_event>::iterator kept = pending_events.begin();
+    BOOST_FOREACH(cl_event event, pending_events)
+    {
+        cl_int status;
+        cl_int err = clGetEventInfo(event, CL_EVENT_COMMAND_EXECUTION_STATUS,
+                                    sizeof(status), &status, NULL);
+
+        // Errors and aborted commands don't count as pending either
+        if(err != CL_SUCCESS || status == CL_COMPLETE || status < 0)
+        {
+            err = clReleaseEvent(event);
+            cl_ensure_nothrow(err, "clReleaseEvent()");
+            continue;
+        }
+
+        *kept++ = event;
+    }
+    pending_events.erase(kept, pending_events.end());
+
+}
+
+// Reads a typed value from the raw info data
+template <typename T>
+static T
+info_value(std::map<cl_uint, std::vector<char>> const& info, cl_uint info_type)
+{
+    std::map<cl_uint, std::vector<char>>::const_iterator it =
+                                                        info.find(info_type);
+    if(it == info.end() || it->second.size() < sizeof(T))
+        return T();
+
+    return *((const T*)(it->second.data()));
+}
+
+// Reads a string from the raw info data
+static std::string
+info_string(std::map<cl_uint, std::vector<char>> const& info,
+            cl_uint info_type)
+{
+    std::map<cl_uint, std::vector<char>>::const_iterator it =
+                                                        info.find(info_type);
+    if(it == info.end() || it->second.empty())
+        return std::string();
+
+    // Cut away the trailing zero
+    return std::string(it->second.data());
+}
+
+void
+device::init_properties()
+{
+
+    // All static device info types of OpenCL 1.1
+    static const cl_device_info device_info_types[] = {
+        CL_DEVICE_TYPE,
+        CL_DEVICE_VENDOR_ID,
+        CL_DEVICE_MAX_COMPUTE_UNITS,
+        CL_DEVICE_MAX_WORK_ITEM_DIMENSIONS,
+        CL_DEVICE_MAX_WORK_ITEM_SIZES,
+        CL_DEVICE_MAX_WORK_GROUP_SIZE,
+        CL_DEVICE_PREFERRED_VECTOR_WIDTH_CHAR,
+        CL_DEVICE_PREFERRED_VECTOR_WIDTH_SHORT,
+        CL_DEVICE_PREFERRED_VECTOR_WIDTH_INT,
+        CL_DEVICE_PREFERRED_VECTOR_WIDTH_LONG,
+        CL_DEVICE_PREFERRED_VECTOR_WIDTH_FLOAT,
+        CL_DEVICE_PREFERRED_VECTOR_WIDTH_DOUBLE,
+        CL_DEVICE_PREFERRED_VECTOR_WIDTH_HALF,
+        CL_DEVICE_NATIVE_VECTOR_WIDTH_CHAR,
+        CL_DEVICE_NATIVE_VECTOR_WIDTH_SHORT,
+        CL_DEVICE_NATIVE_VECTOR_WIDTH_INT,
+        CL_DEVICE_NATIVE_VECTOR_WIDTH_LONG,
+        CL_DEVICE_NATIVE_VECTOR_WIDTH_FLOAT,
+        CL_DEVICE_NATIVE_VECTOR_WIDTH_DOUBLE,
+        CL_DEVICE_NATIVE_VECTOR_WIDTH_HALF,
+        CL_DEVICE_MAX_CLOCK_FREQUENCY,
+        CL_DEVICE_ADDRESS_BITS,
+        CL_DEVICE_MAX_MEM_ALLOC_SIZE,
+        CL_DEVICE_IMAGE_SUPPORT,
+        CL_DEVICE_MAX_READ_IMAGE_ARGS,
+        CL_DEVICE_MAX_WRITE_IMAGE_ARGS,
+        CL_DEVICE_IMAGE2D_MAX_WIDTH,
+        CL_DEVICE_IMAGE2D_MAX_HEIGHT,
+        CL_DEVICE_IMAGE3D_MAX_WIDTH,
+        CL_DEVICE_IMAGE3D_MAX_HEIGHT,
+        CL_DEVICE_IMAGE3D_MAX_DEPTH,
+        CL_DEVICE_MAX_SAMPLERS,
+        CL_DEVICE_MAX_PARAMETER_SIZE,
+        CL_DEVICE_MEM_BASE_ADDR_ALIGN,
+        CL_DEVICE_MIN_DATA_TYPE_ALIGN_SIZE,
+        CL_DEVICE_SINGLE_FP_CONFIG,
+        CL_DEVICE_GLOBAL_MEM_CACHE_TYPE,
+        CL_DEVICE_GLOBAL_MEM_CACHELINE_SIZE,
+        CL_DEVICE_GLOBAL_MEM_CACHE_SIZE,
+        CL_DEVICE_GLOBAL_MEM_SIZE,
+        CL_DEVICE_MAX_CONSTANT_BUFFER_SIZE,
+        CL_DEVICE_MAX_CONSTANT_ARGS,
+        CL_DEVICE_LOCAL_MEM_TYPE,
+        CL_DEVICE_LOCAL_MEM_SIZE,
+        CL_DEVICE_ERROR_CORRECTION_SUPPORT,
+        CL_DEVICE_HOST_UNIFIED_MEMORY,
+        CL_DEVICE_PROFILING_TIMER_RESOLUTION,
+        CL_DEVICE_ENDIAN_LITTLE,
+        CL_DEVICE_AVAILABLE,
+        CL_DEVICE_COMPILER_AVAILABLE,
+        CL_DEVICE_EXECUTION_CAPABILITIES,
+        CL_DEVICE_QUEUE_PROPERTIES,
+        CL_DEVICE_NAME,
+        CL_DEVICE_VENDOR,
+        CL_DRIVER_VERSION,
+        CL_DEVICE_PROFILE,
+        CL_DEVICE_VERSION,
+        CL_DEVICE_OPENCL_C_VERSION,
+        CL_DEVICE_EXTENSIONS,
+        CL_DEVICE_PLATFORM
+    };
+
+    // All platform info types of OpenCL 1.1
+    static const cl_platform_info platform_info_types[] = {
+        CL_PLATFORM_PROFILE,
+        CL_PLATFORM_VERSION,
+        CL_PLATFORM_NAME,
+        CL_PLATFORM_VENDOR,
+        CL_PLATFORM_EXTENSIONS
+    };
+
+    // Query the raw data.
+    // Not every device supports every info type (e.g. OpenCL 1.0 devices),
+    // unsupported ones just don't get cached.
+    BOOST_FOREACH(cl_device_info info_type, device_info_types)
+    {
+        try {
+            properties.device_info[info_type] = query_device_info(info_type);
+        } catch (hpx::exception const&) {}
+    }
+    BOOST_FOREACH(cl_platform_info info_type, platform_info_types)
+    {
+        try {
+            properties.platform_info[info_type] =
+                                              query_platform_info(info_type);
+        } catch (hpx::exception const&) {}
+    }
+
+    // Extract the typed values
+    std::map<cl_uint, std::vector<char>> const& dinfo = properties.device_info;
+    properties.type = info_value<cl_device_type>(dinfo, CL_DEVICE_TYPE);
+    properties.name = info_string(dinfo, CL_DEVICE_NAME);
+    properties.vendor = info_string(dinfo, CL_DEVICE_VENDOR);
+    properties.version = info_string(dinfo, CL_DEVICE_VERSION);
+    properties.driver_version = info_string(dinfo, CL_DRIVER_VERSION);
+    properties.profile = info_string(dinfo, CL_DEVICE_PROFILE);
+    properties.extensions = info_string(dinfo, CL_DEVICE_EXTENSIONS);
+
+    std::vector<int> version =
+                        hpx::opencl::parse_version_string(properties.version);
+    properties.version_major = version[0];
+    properties.version_minor = version[1];
+
+    properties.max_compute_units =
+                    info_value<cl_uint>(dinfo, CL_DEVICE_MAX_COMPUTE_UNITS);
+    properties.max_clock_frequency =
+                    info_value<cl_uint>(dinfo, CL_DEVICE_MAX_CLOCK_FREQUENCY);
+    properties.max_work_group_size =
+                    info_value<size_t>(dinfo, CL_DEVICE_MAX_WORK_GROUP_SIZE);
+    std::map<cl_uint, std::vector<char>>::const_iterator sizes_it =
+                                    dinfo.find(CL_DEVICE_MAX_WORK_ITEM_SIZES);
+    if(sizes_it != dinfo.end())
+    {
+        const size_t* sizes_ptr = (const size_t*)(sizes_it->second.data());
+        properties.max_work_item_sizes.assign(sizes_ptr,
+                        sizes_ptr + sizes_it->second.size() / sizeof(size_t));
+    }
+
+    properties.global_mem_size =
+                    info_value<cl_ulong>(dinfo, CL_DEVICE_GLOBAL_MEM_SIZE);
+    properties.global_mem_cache_size =
+                    info_value<cl_ulong>(dinfo, CL_DEVICE_GLOBAL_MEM_CACHE_SIZE);
+    properties.local_mem_size =
+                    info_value<cl_ulong>(dinfo, CL_DEVICE_LOCAL_MEM_SIZE);
+    properties.max_mem_alloc_size =
+                    info_value<cl_ulong>(dinfo, CL_DEVICE_MAX_MEM_ALLOC_SIZE);
+    properties.max_constant_buffer_size =
+               info_value<cl_ulong>(dinfo, CL_DEVICE_MAX_CONSTANT_BUFFER_SIZE);
+
+#ifdef CL_VERSION_2_0
+    // Shared virtual memory needs OpenCL 2.0, older devices don't know the
+    // info type
+    if(hpx::opencl::is_version_supported(properties.version_major,
+                                         properties.version_minor,
+                          hpx::opencl::parse_version_string("OpenCL 2.0")))
+    {
+        try {
+            properties.device_info[CL_DEVICE_SVM_CAPABILITIES] =
+                               query_device_info(CL_DEVICE_SVM_CAPABILITIES);
+        } catch (hpx::exception const&) {}
+        properties.svm_capabilities =
+                info_value<cl_device_svm_capabilities>(dinfo,
+                                                CL_DEVICE_SVM_CAPABILITIES);
+    }
+#endif
+
+    properties.queue_properties =
+      info_value<cl_command_queue_properties>(dinfo, CL_DEVICE_QUEUE_PROPERTIES);
+    properties.available = info_value<cl_bool>(dinfo, CL_DEVICE_AVAILABLE);
+    properties.host_unified_memory =
+                    info_value<cl_bool>(dinfo, CL_DEVICE_HOST_UNIFIED_MEMORY);
+
+    std::map<cl_uint, std::vector<char>> const& pinfo =
+                                                    properties.platform_info;
+    properties.platform_name = info_string(pinfo, CL_PLATFORM_NAME);
+    properties.platform_vendor = info_string(pinfo, CL_PLATFORM_VENDOR);
+    properties.platform_version = info_string(pinfo, CL_PLATFORM_VERSION);
+    properties.platform_profile = info_string(pinfo, CL_PLATFORM_PROFILE);
+    properties.platform_extensions = info_string(pinfo,
+                                                 CL_PLATFORM_EXTENSIONS);
+
+}
+
 void
 device::put_event_data(cl_event ev, boost::shared_ptr<std::vector<char>> mem)
 {
@@ -265,6 +530,50 @@ device::create_user_event()
 
 }
 
+hpx::opencl::event
+device::enqueue_marker(std::vector<hpx::opencl::event> events)
+{
+
+    cl_int err;
+    cl_event returnEvent;
+
+    // Get the cl_event dependency list
+    std::vector<cl_event> cl_events_list = hpx::opencl::event::
+                                                    get_cl_events(events);
+    cl_event* cl_events_list_ptr = NULL;
+    if(!cl_events_list.empty())
+    {
+        cl_events_list_ptr = cl_events_list.data();
+    }
+
+#ifdef CL_VERSION_1_2
+    err = ::clEnqueueMarkerWithWaitList(command_queue,
+                                        (cl_uint)events.size(),
+                                        cl_events_list_ptr, &returnEvent);
+    cl_ensure(err, "clEnqueueMarkerWithWaitList()");
+#else
+    // Without a wait list, the marker waits for all previous commands
+    if(!cl_events_list.empty())
+    {
+        err = ::clEnqueueWaitForEvents(command_queue,
+                                       (cl_uint)events.size(),
+                                       cl_events_list_ptr);
+        cl_ensure(err, "clEnqueueWaitForEvents()");
+    }
+    err = ::clEnqueueMarker(command_queue, &returnEvent);
+    cl_ensure(err, "clEnqueueMarker()");
+#endif
+
+    // Return the event
+    return hpx::opencl::event(
+           hpx::components::new_<hpx::opencl::server::event>(
+                                hpx::find_here(),
+                                get_gid(),
+                                (clx_event) returnEvent
+                            ));
+
+}
+
 
 void
 device::trigger_user_event(cl_event event)
@@ -395,6 +704,20 @@ event_callback(cl_event clevent, cl_int event_command_exec_status, void* args_)
 
 std::vector<char>
 device::get_device_info(cl_device_info info_type)
+{
+
+    // Serve from cache if possible
+    std::map<cl_uint, std::vector<char>>::const_iterator it =
+                                        properties.device_info.find(info_type);
+    if(it != properties.device_info.end())
+        return it->second;
+
+    return query_device_info(info_type);
+
+}
+
+std::vector<char>
+device::query_device_info(cl_device_info info_type)
 {
     
     // Declairing the cl error code variable
@@ -418,6 +741,20 @@ device::get_device_info(cl_device_info info_type)
 
 std::vector<char>
 device::get_platform_info(cl_platform_info info_type)
+{
+
+    // Serve from cache if possible
+    std::map<cl_uint, std::vector<char>>::const_iterator it =
+                                      properties.platform_info.find(info_type);
+    if(it != properties.platform_info.end())
+        return it->second;
+
+    return query_platform_info(info_type);
+
+}
+
+std::vector<char>
+device::query_platform_info(cl_platform_info info_type)
 {
     
     // Declairing the cl error code variable
@@ -438,6 +775,506 @@ device::get_platform_info(cl_platform_info info_type)
 
 }
 
+hpx::opencl::device_properties
+device::get_device_properties()
+{
+
+    return properties;
+
+}
+
+std::size_t
+device::get_pending_commands()
+{
+
+    // Count from now on
+    pending_events_tracked = true;
+
+    boost::lock_guard<spinlock_type> lock(pending_events_mutex);
+    prune_pending_events_nolock();
+    return pending_events.size();
+
+}
+
+double
+device::time_transfer(cl_command_queue queue, cl_mem mem, bool write,
+                      size_t size, void* host_data)
+{
+
+    cl_int err;
+    cl_event event;
+
+    hpx::util::high_resolution_timer timer;
+    if(write)
+        err = clEnqueueWriteBuffer(queue, mem, CL_FALSE, 0, size, host_data,
+                                   0, NULL, &event);
+    else
+        err = clEnqueueReadBuffer(queue, mem, CL_FALSE, 0, size, host_data,
+                                  0, NULL, &event);
+    cl_ensure(err, "clEnqueueReadBuffer()");
+
+    // Suspend instead of blocking the worker thread in the driver
+    try {
+        err = clFlush(queue);
+        cl_ensure(err, "clFlush()");
+        hpx::opencl::server::future_from_cl_event(event).get();
+    } catch (...) {
+        clReleaseEvent(event);
+        throw;
+    }
+    double elapsed = timer.elapsed();
+
+    // Prefer the device timestamps, they don't include the scheduling
+    cl_ulong start = 0, end = 0;
+    err = clGetEventProfilingInfo(event, CL_PROFILING_COMMAND_START,
+                                  sizeof(start), &start, NULL);
+    if(err == CL_SUCCESS)
+        err = clGetEventProfilingInfo(event, CL_PROFILING_COMMAND_END,
+                                      sizeof(end), &end, NULL);
+    if(err == CL_SUCCESS && end > start)
+        elapsed = (end - start) * 1e-9;
+
+    err = clReleaseEvent(event);
+    cl_ensure(err, "clReleaseEvent()");
+
+    return elapsed;
+
+}
+
+double
+device::measure_bandwidth()
+{
+
+    // Only measure once
+    boost::lock_guard<mutex_type> lock(measured_bandwidth_mutex);
+    if(measured_bandwidth > 0.0)
+        return measured_bandwidth;
+
+    // Size of the transfer, 16 MB or less if the device can't allocate that
+    size_t size = 16 * 1024 * 1024;
+    if(properties.max_mem_alloc_size > 0 && properties.max_mem_alloc_size < size)
+        size = (size_t)properties.max_mem_alloc_size;
+
+    cl_int err;
+
+    // A separate queue, so the measurement doesn't stall other commands
+    cl_command_queue_properties queue_properties = 0;
+    if(properties.queue_properties & CL_QUEUE_PROFILING_ENABLE)
+        queue_properties |= CL_QUEUE_PROFILING_ENABLE;
+    cl_command_queue queue = clCreateCommandQueue(context, device_id,
+                                                  queue_properties, &err);
+    cl_ensure(err, "clCreateCommandQueue()");
+
+    // Create a temporary buffer
+    cl_mem mem = clCreateBuffer(context, CL_MEM_READ_WRITE, size, NULL, &err);
+    if(err != CL_SUCCESS)
+    {
+        clReleaseCommandQueue(queue);
+        cl_ensure(err, "clCreateBuffer()");
+    }
+
+    std::vector<char> host_data(size);
+
+    double elapsed = 0.0;
+    try {
+        // Warm up, the first transfer usually includes the allocation
+        time_transfer(queue, mem, true, size, host_data.data());
+
+        // Measure one write and one read
+        elapsed += time_transfer(queue, mem, true, size, host_data.data());
+        elapsed += time_transfer(queue, mem, false, size, host_data.data());
+    } catch (...) {
+        clReleaseMemObject(mem);
+        clReleaseCommandQueue(queue);
+        throw;
+    }
+
+    // Release the buffer and the queue
+    err = clReleaseMemObject(mem);
+    cl_ensure(err, "clReleaseMemObject()");
+    err = clReleaseCommandQueue(queue);
+    cl_ensure(err, "clReleaseCommandQueue()");
+
+    // Protect against timer resolution issues
+    if(elapsed <= 0.0)
+        elapsed = 1e-9;
+
+    measured_bandwidth = 2.0 * size / elapsed;
+    return measured_bandwidth;
+
+}
+
+
+void
+device::enable_managed_memory(std::size_t limit)
+{
+
+    boost::lock_guard<spinlock_type> lock(resident_buffers_mutex);
+
+    memory_limit = limit;
+    if(memory_limit == 0)
+        memory_limit = (std::size_t)properties.global_mem_size;
+
+    memory_managed = true;
+
+}
+
+std::size_t
+device::get_managed_memory_usage()
+{
+
+    boost::lock_guard<spinlock_type> lock(resident_buffers_mutex);
+    return memory_in_use;
+
+}
+
+bool
+device::is_memory_managed()
+{
+
+    return memory_managed.load();
+
+}
+
+cl_mem
+device::allocate_buffer_mem(cl_mem_flags flags, size_t size, void* host_ptr,
+                            buffer* owner)
+{
+
+    cl_int err;
+    cl_mem mem;
+
+    // Unmanaged memory
+    if(owner == NULL)
+    {
+        mem = clCreateBuffer(context, flags, size, host_ptr, &err);
+        cl_ensure(err, "clCreateBuffer()");
+        return mem;
+    }
+
+    // Reserve the memory, evict until it fits into the limit.
+    // Many implementations only allocate on first use, so the limit
+    // needs to be enforced here.
+    {
+        boost::lock_guard<spinlock_type> lock(resident_buffers_mutex);
+        memory_in_use += size;
+    }
+
+    // Undo the reservation if eviction or allocation fails
+    try
+    {
+        for(;;)
+        {
+            {
+                boost::lock_guard<spinlock_type> lock(resident_buffers_mutex);
+                if(memory_in_use <= memory_limit)
+                    break;
+            }
+
+            // If nothing can be evicted, let OpenCL decide
+            if(!evict_least_recently_used(owner))
+                break;
+        }
+
+        // The device may still run out of memory, e.g. because of other
+        // allocations
+        for(;;)
+        {
+            mem = clCreateBuffer(context, flags, size, host_ptr, &err);
+            if(err == CL_SUCCESS)
+                break;
+
+            if((err == CL_MEM_OBJECT_ALLOCATION_FAILURE
+                                        || err == CL_OUT_OF_RESOURCES)
+               && evict_least_recently_used(owner))
+                continue;
+
+            cl_ensure(err, "clCreateBuffer()");
+        }
+    }
+    catch(...)
+    {
+        boost::lock_guard<spinlock_type> lock(resident_buffers_mutex);
+        memory_in_use -= size;
+        throw;
+    }
+
+    // The new memory is the most recently used one
+    {
+        boost::lock_guard<spinlock_type> lock(resident_buffers_mutex);
+        resident_buffers.push_back(owner);
+        resident_buffer_index[owner] = --resident_buffers.end();
+    }
+
+    return mem;
+
+}
+
+void
+device::touch_buffer(buffer* owner)
+{
+
+    boost::lock_guard<spinlock_type> lock(resident_buffers_mutex);
+
+    std::map<buffer*, std::list<buffer*>::iterator>::iterator it =
+                                            resident_buffer_index.find(owner);
+    if(it == resident_buffer_index.end())
+        return;
+
+    // Move to the end of the list
+    resident_buffers.splice(resident_buffers.end(), resident_buffers,
+                            it->second);
+
+}
+
+void
+device::register_buffer(buffer* owner)
+{
+
+    boost::lock_guard<spinlock_type> lock(resident_buffers_mutex);
+
+    if(resident_buffer_index.count(owner) > 0)
+        return;
+
+    memory_in_use += owner->size();
+    resident_buffers.push_back(owner);
+    resident_buffer_index[owner] = --resident_buffers.end();
+
+}
+
+void
+device::unregister_buffer(buffer* owner)
+{
+
+    boost::lock_guard<spinlock_type> lock(resident_buffers_mutex);
+
+    std::map<buffer*, std::list<buffer*>::iterator>::iterator it =
+                                            resident_buffer_index.find(owner);
+    if(it == resident_buffer_index.end())
+        return;
+
+    memory_in_use -= owner->size();
+    resident_buffers.erase(it->second);
+    resident_buffer_index.erase(it);
+
+}
+
+bool
+device::evict_least_recently_used(buffer* requester)
+{
+
+    // Take the least recently used buffer that is not in use
+    buffer* victim = NULL;
+    {
+        boost::lock_guard<spinlock_type> lock(resident_buffers_mutex);
+
+        std::list<buffer*>::iterator it;
+        for(it = resident_buffers.begin(); it != resident_buffers.end(); it++)
+        {
+            if(*it == requester)
+                continue;
+
+            // Doesn't suspend, buffers in use get skipped
+            if(!(*it)->try_lock_residency())
+                continue;
+
+            victim = *it;
+            resident_buffer_index.erase(victim);
+            resident_buffers.erase(it);
+            break;
+        }
+    }
+
+    if(victim == NULL)
+        return false;
+
+    // Move the content to the host
+    try
+    {
+        victim->evict();
+    }
+    catch(...)
+    {
+        // The buffer is still resident
+        {
+            boost::lock_guard<spinlock_type> lock(resident_buffers_mutex);
+            resident_buffers.push_front(victim);
+            resident_buffer_index[victim] = resident_buffers.begin();
+        }
+        victim->unlock_residency();
+        throw;
+    }
+
+    {
+        boost::lock_guard<spinlock_type> lock(resident_buffers_mutex);
+        memory_in_use -= victim->size();
+    }
+    victim->unlock_residency();
+
+    return true;
+
+}
+
+#ifdef CL_VERSION_2_0
+bool
+device::is_svm_fine_grain()
+{
+
+    return (properties.svm_capabilities & CL_DEVICE_SVM_FINE_GRAIN_BUFFER)
+                                                                        != 0;
+
+}
+
+void*
+device::svm_alloc(size_t size, size_t alignment)
+{
+
+    if(properties.svm_capabilities == 0)
+    {
+        HPX_THROW_EXCEPTION(hpx::bad_parameter,
+                            "device::svm_alloc()",
+                            "Device does not support shared virtual memory!");
+    }
+
+    // Fine-grain memory can be accessed without mapping
+    cl_svm_mem_flags flags = CL_MEM_READ_WRITE;
+    if(is_svm_fine_grain())
+        flags |= CL_MEM_SVM_FINE_GRAIN_BUFFER;
+
+    void* ptr = ::clSVMAlloc(context, flags, size, (cl_uint)alignment);
+    if(ptr == NULL)
+    {
+        HPX_THROW_EXCEPTION(hpx::out_of_memory,
+                            "device::svm_alloc()",
+                            "clSVMAlloc() failed!");
+    }
+
+    return ptr;
+
+}
+
+void
+device::svm_free(void* ptr)
+{
+
+    cl_int err;
+
+    // Kernels might still use the memory. The queue might be out of order,
+    // so a marker collects all commands enqueued so far. Unlike a barrier,
+    // it doesn't hold back commands enqueued later.
+    cl_event marker_event;
+    err = ::clEnqueueMarkerWithWaitList(command_queue, 0, NULL,
+                                        &marker_event);
+    cl_ensure(err, "clEnqueueMarkerWithWaitList()");
+
+    // Frees the memory as soon as they are done
+    cl_event free_event;
+    err = ::clEnqueueSVMFree(command_queue, 1, &ptr, NULL, NULL,
+                             1, &marker_event, &free_event);
+    cl_ensure(err, "clEnqueueSVMFree()");
+
+    err = clReleaseEvent(marker_event);
+    cl_ensure(err, "clReleaseEvent()");
+
+    // Count the command as outstanding work of the device
+    track_pending_command(free_event);
+    err = clReleaseEvent(free_event);
+    cl_ensure(err, "clReleaseEvent()");
+
+}
+
+hpx::opencl::event
+device::enqueue_svm_map(void* ptr, size_t size, cl_map_flags flags,
+                        std::vector<hpx::opencl::event> events)
+{
+
+    cl_int err;
+    cl_event returnEvent;
+
+    // Get the cl_event dependency list
+    std::vector<cl_event> cl_events_list = hpx::opencl::event::
+                                                    get_cl_events(events);
+    cl_event* cl_events_list_ptr = NULL;
+    if(!cl_events_list.empty())
+    {
+        cl_events_list_ptr = cl_events_list.data();
+    }
+
+    if(is_svm_fine_grain())
+    {
+        // The host can always access fine-grain memory,
+        // only wait for the dependencies
+        err = ::clEnqueueMarkerWithWaitList(command_queue,
+                                            (cl_uint)events.size(),
+                                            cl_events_list_ptr, &returnEvent);
+        cl_ensure(err, "clEnqueueMarkerWithWaitList()");
+    }
+    else
+    {
+        err = ::clEnqueueSVMMap(command_queue, CL_FALSE, flags, ptr, size,
+                                (cl_uint)events.size(), cl_events_list_ptr,
+                                &returnEvent);
+        cl_ensure(err, "clEnqueueSVMMap()");
+    }
+
+    // Count the command as outstanding work of the device
+    track_pending_command(returnEvent);
+
+    // Return the event
+    return hpx::opencl::event(
+           hpx::components::new_<hpx::opencl::server::event>(
+                                hpx::find_here(),
+                                get_gid(),
+                                (clx_event) returnEvent
+                            ));
+
+}
+
+hpx::opencl::event
+device::enqueue_svm_unmap(void* ptr, std::vector<hpx::opencl::event> events)
+{
+
+    cl_int err;
+    cl_event returnEvent;
+
+    // Get the cl_event dependency list
+    std::vector<cl_event> cl_events_list = hpx::opencl::event::
+                                                    get_cl_events(events);
+    cl_event* cl_events_list_ptr = NULL;
+    if(!cl_events_list.empty())
+    {
+        cl_events_list_ptr = cl_events_list.data();
+    }
+
+    if(is_svm_fine_grain())
+    {
+        // Nothing to unmap, only wait for the dependencies
+        err = ::clEnqueueMarkerWithWaitList(command_queue,
+                                            (cl_uint)events.size(),
+                                            cl_events_list_ptr, &returnEvent);
+        cl_ensure(err, "clEnqueueMarkerWithWaitList()");
+    }
+    else
+    {
+        err = ::clEnqueueSVMUnmap(command_queue, ptr, (cl_uint)events.size(),
+                                  cl_events_list_ptr, &returnEvent);
+        cl_ensure(err, "clEnqueueSVMUnmap()");
+    }
+
+    // Count the command as outstanding work of the device
+    track_pending_command(returnEvent);
+
+    // Return the event
+    return hpx::opencl::event(
+           hpx::components::new_<hpx::opencl::server::event>(
+                                hpx::find_here(),
+                                get_gid(),
+                                (clx_event) returnEvent
+                            ));
+
+}
+#endif
+
 
 void
 device::wait_for_event(cl_event clevent)
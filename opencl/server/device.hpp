@@ -18,13 +18,17 @@
 
 #include <hpx/runtime/components/server/managed_component_base.hpp>
 
+#include <boost/atomic.hpp>
+
 #include <queue>
 #include <map>
+#include <list>
 
 #include <CL/cl.h>
 
 #include "../fwd_declarations.hpp"
 #include "../event.hpp"
+#include "../device_properties.hpp"
 
 // ! This component header may NOT include other component headers !
 // (To avoid recurcive includes)
@@ -56,6 +60,9 @@ namespace hpx { namespace opencl{ namespace server{
         cl_command_queue get_write_command_queue();
         cl_command_queue get_work_command_queue();
 
+        // Returns the cached static properties of the device
+        hpx::opencl::device_properties const& get_properties();
+
         // Registers a read buffer
         void put_event_data(cl_event, boost::shared_ptr<std::vector<char>>);
 
@@ -82,6 +89,50 @@ namespace hpx { namespace opencl{ namespace server{
 
         // triggers an event previously generated with create_user_event()
         void trigger_user_event(cl_event event);
+
+        // Counts the command as pending until the event completes.
+        // Used by the device selection to estimate the load of the device.
+        // Does nothing until the count got queried for the first time.
+        void track_pending_command(cl_event event);
+
+        // Whether buffers created from now on get managed,
+        // see enable_managed_memory
+        bool is_memory_managed();
+
+        // Creates the memory of a buffer.
+        // If owner is given, the memory is managed: it counts against the
+        // memory limit and least recently used buffers get evicted to the
+        // host if the limit or the device memory is exhausted.
+        cl_mem allocate_buffer_mem(cl_mem_flags flags, size_t size,
+                                   void* host_ptr, buffer* owner);
+
+        // Marks a managed buffer as most recently used
+        void touch_buffer(buffer* owner);
+
+        // Adds managed memory that got created elsewhere
+        void register_buffer(buffer* owner);
+
+        // Removes a buffer from the managed memory, if it is resident
+        void unregister_buffer(buffer* owner);
+
+#ifdef CL_VERSION_2_0
+        // Shared virtual memory, see svm_allocator.
+        // Uses fine-grain buffers if the device supports them.
+        bool is_svm_fine_grain();
+        void* svm_alloc(size_t size, size_t alignment);
+
+        // Doesn't block, the memory gets freed once all commands enqueued
+        // on this device so far completed
+        void svm_free(void* ptr);
+
+        // Coarse-grain memory needs to be mapped for host access.
+        // For fine-grain memory, these only wait for the events.
+        hpx::opencl::event
+        enqueue_svm_map(void* ptr, size_t size, cl_map_flags flags,
+                        std::vector<hpx::opencl::event> events);
+        hpx::opencl::event
+        enqueue_svm_unmap(void* ptr, std::vector<hpx::opencl::event> events);
+#endif
         
 
 
@@ -92,25 +143,71 @@ namespace hpx { namespace opencl{ namespace server{
         // creates an opencl event that can be triggered by the user
         hpx::opencl::event create_user_event();
 
+        // enqueues a marker that completes once all events completed.
+        // the events need to be events of this device.
+        hpx::opencl::event enqueue_marker(
+                                    std::vector<hpx::opencl::event> events);
+
         // returns device specific information
         std::vector<char> get_device_info(cl_device_info info_type);
         
         // returns platform specific information
         std::vector<char> get_platform_info(cl_platform_info info_type);
 
+        // returns all static device and platform properties
+        hpx::opencl::device_properties get_device_properties();
+
+        // returns the number of enqueued, but not yet finished commands.
+        // Commands get counted from the first call on.
+        std::size_t get_pending_commands();
+
+        // returns the host-device bandwidth in bytes per second.
+        // measured on the first call, cached afterwards
+        double measure_bandwidth();
+
+        // Enables managed memory for all buffers created from now on.
+        // A memory_limit of 0 uses the global memory size of the device.
+        void enable_managed_memory(std::size_t memory_limit);
+
+        // returns the size of the resident managed buffers, in bytes
+        std::size_t get_managed_memory_usage();
+
 
     HPX_DEFINE_COMPONENT_ACTION(device, create_user_event);
+    HPX_DEFINE_COMPONENT_ACTION(device, enqueue_marker);
     HPX_DEFINE_COMPONENT_ACTION(device, get_device_info);
     HPX_DEFINE_COMPONENT_ACTION(device, get_platform_info);
+    HPX_DEFINE_COMPONENT_ACTION(device, get_device_properties);
+    HPX_DEFINE_COMPONENT_ACTION(device, get_pending_commands);
+    HPX_DEFINE_COMPONENT_ACTION(device, measure_bandwidth);
+    HPX_DEFINE_COMPONENT_ACTION(device, enable_managed_memory);
+    HPX_DEFINE_COMPONENT_ACTION(device, get_managed_memory_usage);
 
     private:
         ///////////////////////////////////////////////
         // Private Member Functions
         //
         
+        // Queries all static device and platform properties
+        void init_properties();
+
+        // Queries device info from OpenCL, bypassing the cache
+        std::vector<char> query_device_info(cl_device_info info_type);
+
+        // Queries platform info from OpenCL, bypassing the cache
+        std::vector<char> query_platform_info(cl_platform_info info_type);
+
         // Error Callback
         static void CL_CALLBACK error_callback(const char*, const void*,
                                                size_t, void*);
+
+        // Releases the tracked events that have completed.
+        // pending_events_mutex needs to be locked.
+        void prune_pending_events_nolock();
+
+        // Times one transfer on the profiling queue
+        double time_transfer(cl_command_queue queue, cl_mem mem, bool write,
+                             size_t size, void* host_data);
         // Try to delete buffers
         void try_delete_cl_mem();
         // same as above, but doesn't lock user_events_mutex internally.
@@ -125,6 +222,10 @@ namespace hpx { namespace opencl{ namespace server{
         // cleans up all the possible leftover user events an cl_mems
         void cleanup_user_events();
 
+        // Moves the least recently used buffer, except for requester, to the
+        // host. Returns false if no buffer could be evicted.
+        bool evict_least_recently_used(buffer* requester);
+
 
     private:
         ///////////////////////////////////////////////
@@ -135,6 +236,10 @@ namespace hpx { namespace opencl{ namespace server{
         cl_context          context;
         cl_command_queue    command_queue;
 
+        // The cached static properties.
+        // Never modified after construction, no lock needed.
+        hpx::opencl::device_properties properties;
+
         // lock typedefs
         typedef hpx::lcos::local::mutex mutex_type;
         typedef hpx::lcos::local::spinlock spinlock_type;
@@ -159,11 +264,30 @@ namespace hpx { namespace opencl{ namespace server{
         std::queue<cl_mem> pending_cl_mem_deletions; 
         spinlock_type pending_cl_mem_deletions_mutex;
 
+        // The events of the enqueued commands, pruned when they completed
+        boost::atomic<bool> pending_events_tracked;
+        std::vector<cl_event> pending_events;
+        std::size_t pending_events_prune_size;
+        spinlock_type pending_events_mutex;
+
+        // The measured bandwidth, 0 if not measured yet
+        double measured_bandwidth;
+        mutex_type measured_bandwidth_mutex;
+
         // List of waiting events with respective mutexes
         std::map<cl_event, boost::shared_ptr<hpx::lcos::local::event>>
                                                             cl_event_waitlist;
         spinlock_type cl_event_waitlist_mutex;
 
+        // Managed memory.
+        // The resident managed buffers, least recently used first.
+        boost::atomic<bool> memory_managed;
+        std::size_t memory_limit;
+        std::size_t memory_in_use;
+        std::list<buffer*> resident_buffers;
+        std::map<buffer*, std::list<buffer*>::iterator> resident_buffer_index;
+        spinlock_type resident_buffers_mutex;
+
     };
 }}}
 
@@ -171,12 +295,30 @@ namespace hpx { namespace opencl{ namespace server{
 HPX_REGISTER_ACTION_DECLARATION(
         hpx::opencl::server::device::create_user_event_action,
         opencl_device_create_user_event_action);
+HPX_REGISTER_ACTION_DECLARATION(
+        hpx::opencl::server::device::enqueue_marker_action,
+        opencl_device_enqueue_marker_action);
 HPX_REGISTER_ACTION_DECLARATION(
         hpx::opencl::server::device::get_device_info_action,
         opencl_device_get_device_info_action);
 HPX_REGISTER_ACTION_DECLARATION(
         hpx::opencl::server::device::get_platform_info_action,
         opencl_device_get_platform_info_action);
+HPX_REGISTER_ACTION_DECLARATION(
+        hpx::opencl::server::device::get_device_properties_action,
+        opencl_device_get_device_properties_action);
+HPX_REGISTER_ACTION_DECLARATION(
+        hpx::opencl::server::device::get_pending_commands_action,
+        opencl_device_get_pending_commands_action);
+HPX_REGISTER_ACTION_DECLARATION(
+        hpx::opencl::server::device::measure_bandwidth_action,
+        opencl_device_measure_bandwidth_action);
+HPX_REGISTER_ACTION_DECLARATION(
+        hpx::opencl::server::device::enable_managed_memory_action,
+        opencl_device_enable_managed_memory_action);
+HPX_REGISTER_ACTION_DECLARATION(
+        hpx::opencl::server::device::get_managed_memory_usage_action,
+        opencl_device_get_managed_memory_usage_action);
 //]
 
 
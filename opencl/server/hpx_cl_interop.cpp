@@ -5,27 +5,27 @@
 
 #include "hpx_cl_interop.hpp"
 
+#include "../tools.hpp"
+
 #include <hpx/runtime.hpp>
 #include <hpx/lcos/local/event.hpp>
+#include <hpx/lcos/local/promise.hpp>
 
 #include <boost/atomic.hpp>
+#include <boost/scoped_ptr.hpp>
 
 // This is the number of an OpenCL thread.
 // It gets increased with every OpenCL call, to prevent name collisions
 static boost::atomic<std::size_t> opencl_thread_num(0);
 
-// This function triggers an hpx::lcos::local::event from an external thread
-void
-hpx::opencl::server::trigger_event_from_external(hpx::runtime * rt,
-                                                hpx::lcos::local::event * event)
+// Registers the current OS thread with hpx, if it isn't an hpx thread already
+static void
+register_external_thread(hpx::runtime * rt)
 {
 
     // If we are on an hpx thread we don't need any special treatment
     if(rt->get_thread_name() != "<unknown>")
-    {
-        event->set();
         return;
-    }
 
     // if we're on an OS thread, register it temporarily.
     // add the thread id to its name, as there could potentially
@@ -36,9 +36,6 @@ hpx::opencl::server::trigger_event_from_external(hpx::runtime * rt,
                         false);
     //BOOST_ASSERT(succeeded);
 
-    // trigger the event lock
-    event->set();
-
     // unregister the thread from hpx as we don't have any control over it
     // any more. ever. (probably)
     // /* this line is currently commented out.
@@ -51,3 +48,92 @@ hpx::opencl::server::trigger_event_from_external(hpx::runtime * rt,
     //rt->unregister_thread();
 
 }
+
+// This function triggers an hpx::lcos::local::event from an external thread
+void
+hpx::opencl::server::trigger_event_from_external(hpx::runtime * rt,
+                                                hpx::lcos::local::event * event)
+{
+
+    // Make sure we are allowed to touch hpx objects
+    register_external_thread(rt);
+
+    // trigger the event lock
+    event->set();
+
+}
+
+
+// The shared state of a future created by future_from_cl_event.
+// Gets deleted by the OpenCL callback.
+struct cl_event_future_data
+{
+    hpx::runtime * rt;
+    cl_event event;
+    hpx::lcos::local::promise<void> promise;
+};
+
+static void CL_CALLBACK
+future_from_cl_event_callback(cl_event event, cl_int exec_status,
+                              void* user_data)
+{
+
+    boost::scoped_ptr<cl_event_future_data>
+    data(static_cast<cl_event_future_data*>(user_data));
+
+    // Make sure we are allowed to touch hpx objects
+    register_external_thread(data->rt);
+
+    // Release our reference to the cl_event
+    cl_int err = clReleaseEvent(data->event);
+    cl_ensure_nothrow(err, "clReleaseEvent()");
+
+    // A negative status means the command got terminated abnormally
+    if(exec_status < 0)
+    {
+        try {
+            cl_ensure(exec_status, "future_from_cl_event()");
+        } catch (...) {
+            data->promise.set_exception(boost::current_exception());
+        }
+        return;
+    }
+
+    // Trigger the future
+    data->promise.set_value();
+
+}
+
+hpx::lcos::future<void>
+hpx::opencl::server::future_from_cl_event(cl_event event)
+{
+
+    cl_int err;
+
+    // Create the shared state. Ownership goes to the callback.
+    cl_event_future_data * data = new cl_event_future_data();
+    data->rt = hpx::get_runtime_ptr();
+    data->event = event;
+    hpx::lcos::future<void> result = data->promise.get_future();
+
+    // Keep the cl_event alive until the callback fired
+    err = clRetainEvent(event);
+    if(err != CL_SUCCESS)
+    {
+        delete data;
+        cl_ensure(err, "clRetainEvent()");
+    }
+
+    // Register the callback
+    err = clSetEventCallback(event, CL_COMPLETE,
+                             &future_from_cl_event_callback, data);
+    if(err != CL_SUCCESS)
+    {
+        clReleaseEvent(event);
+        delete data;
+        cl_ensure(err, "clSetEventCallback()");
+    }
+
+    return result;
+
+}
@@ -3,10 +3,15 @@
 // Distributed under the Boost Software License, Version 1.0. (See accompanying
 // file LICENSE_1_0.txt or copy at http://www.boost.org/LICENSE_1_0.txt)
 
+#pragma once
+
 #include <hpx/hpx.hpp>
 #include <hpx/config.hpp>
 #include <hpx/runtime.hpp>
 #include <hpx/lcos/local/event.hpp>
+#include <hpx/lcos/future.hpp>
+
+#include <CL/cl.h>
 
 namespace hpx { namespace opencl { namespace server {
 
@@ -14,5 +19,12 @@ namespace hpx { namespace opencl { namespace server {
 void trigger_event_from_external(hpx::runtime * rt,
                                  hpx::lcos::local::event * event);
 
+// This function creates a future that triggers as soon as the given cl_event
+// has completed.
+// The future holds its own reference to the cl_event, the caller may release
+// its reference right away.
+// This is a purely local object, no component gets created.
+hpx::lcos::future<void> future_from_cl_event(cl_event event);
+
 
 }}}
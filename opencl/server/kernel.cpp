@@ -11,9 +11,18 @@
 #include "device.hpp"
 #include "../buffer.hpp"
 #include "buffer.hpp"
+#include "hpx_cl_interop.hpp"
 
 #include <string>
 #include <sstream>
+#include <algorithm>
+#include <iterator>
+#include <cmath>
+#include <limits>
+
+#include <boost/foreach.hpp>
+#include <hpx/util/high_resolution_timer.hpp>
+#include <boost/thread/locks.hpp>
 
 #include <CL/cl.h>
 
@@ -22,10 +31,109 @@ using namespace hpx::opencl::server;
 
 CL_FORBID_EMPTY_CONSTRUCTOR(kernel);
 
+// Keeps the buffers of managed arguments on the device while in scope
+class resident_args
+{
+public:
+    typedef std::map<cl_uint, boost::shared_ptr<hpx::opencl::server::buffer>>
+                                                                args_type;
+
+    explicit resident_args(args_type const& args_)
+      : args(args_)
+    {
+
+        // Lock every buffer once, in address order to avoid deadlocks
+        std::vector<hpx::opencl::server::buffer*> buffers;
+        typedef std::pair<const cl_uint,
+                          boost::shared_ptr<hpx::opencl::server::buffer>>
+                                                                arg_type;
+        BOOST_FOREACH(arg_type const& arg, args)
+        {
+            buffers.push_back(arg.second.get());
+        }
+        std::sort(buffers.begin(), buffers.end());
+        buffers.erase(std::unique(buffers.begin(), buffers.end()),
+                      buffers.end());
+
+        locks.reserve(buffers.size());
+        BOOST_FOREACH(hpx::opencl::server::buffer* buffer, buffers)
+        {
+            locks.push_back(boost::make_shared<
+                        hpx::opencl::server::buffer::resident_lock>(
+                                                        boost::ref(*buffer)));
+        }
+
+    }
+
+    // Sets the current memory of the buffers
+    void set_args(cl_kernel instance)
+    {
+
+        typedef std::pair<const cl_uint,
+                          boost::shared_ptr<hpx::opencl::server::buffer>>
+                                                                arg_type;
+        BOOST_FOREACH(arg_type const& arg, args)
+        {
+            cl_mem mem_id = arg.second->get_cl_mem();
+            cl_int err = clSetKernelArg(instance, arg.first, sizeof(cl_mem),
+                                        &mem_id);
+            cl_ensure(err, "clSetKernelArg()");
+        }
+
+    }
+
+    // Records the launch, evicting the buffers waits for it
+    void track_event(cl_event event)
+    {
+
+        typedef std::pair<const cl_uint,
+                          boost::shared_ptr<hpx::opencl::server::buffer>>
+                                                                arg_type;
+        BOOST_FOREACH(arg_type const& arg, args)
+        {
+            arg.second->track_event(event);
+        }
+
+    }
+
+private:
+    args_type args;
+    std::vector<boost::shared_ptr<hpx::opencl::server::buffer::resident_lock>>
+                                                                locks;
+};
+
 
 kernel::kernel(hpx::naming::id_type program_id, std::string kernel_name)
+{
+
+    init(program_id, kernel_name);
+
+}
+
+kernel::kernel(hpx::naming::id_type program_id, std::string kernel_name,
+               size_t pool_size)
+{
+
+    init(program_id, kernel_name);
+
+    // Pre-fill the kernel pool
+    kernel_pool.reserve(pool_size);
+    for(size_t i = 0; i < pool_size; i++)
+    {
+        kernel_pool.push_back(pooled_instance(create_instance(),
+                                              std::set<cl_uint>()));
+    }
+
+}
+
+void
+kernel::init(hpx::naming::id_type program_id, std::string kernel_name_)
 {
     this->kernel_id = NULL;
+    this->kernel_name = kernel_name_;
+    this->work_group_limits_initialized = false;
+    this->kernel_work_group_size = 0;
+    this->preferred_work_group_size_multiple = 1;
     this->parent_program_id = program_id;
     this->parent_program = hpx::get_ptr
                          <hpx::opencl::server::program>(parent_program_id).get();
@@ -33,11 +141,8 @@ kernel::kernel(hpx::naming::id_type program_id, std::string kernel_name)
     this->parent_device = hpx::get_ptr
                           <hpx::opencl::server::device>(parent_device_id).get();
 
-    // initialize the cl_program object
-    cl_int err;
-    kernel_id = clCreateKernel(parent_program->get_cl_program(),
-                               kernel_name.c_str(), &err);
-    cl_ensure(err, "clCreateKernel()");
+    // initialize the cl_kernel object
+    kernel_id = create_instance();
                               
 }
 
@@ -45,7 +150,7 @@ kernel::~kernel()
 {
     cl_int err;
 
-    // release the cl_program object
+    // release the cl_kernel object
     if(kernel_id)
     {
         err = clReleaseKernel(kernel_id);
@@ -53,30 +158,643 @@ kernel::~kernel()
         kernel_id = NULL;
     }
 
+    // release the pooled cl_kernel objects
+    BOOST_FOREACH(pooled_instance & instance, kernel_pool)
+    {
+        err = clReleaseKernel(instance.first);
+        cl_ensure_nothrow(err, "clReleaseKernel()");
+    }
+    kernel_pool.clear();
+
+}
+
+cl_kernel
+kernel::create_instance()
+{
+
+    cl_int err;
+    cl_kernel instance = clCreateKernel(parent_program->get_cl_program(),
+                                        kernel_name.c_str(), &err);
+    cl_ensure(err, "clCreateKernel()");
+
+    return instance;
+
+}
+
+// Whether all arguments that a pooled instance still holds from its last
+// launch get overwritten, either by acquire_instance or by the next launch
+static bool
+overwrites_stale_args(std::set<cl_uint> const& stale_args,
+                      std::set<cl_uint> const& set_args,
+                      std::set<cl_uint> const& launch_args)
+{
+
+    BOOST_FOREACH(cl_uint arg_index, stale_args)
+    {
+        if(set_args.count(arg_index) == 0 && launch_args.count(arg_index) == 0)
+            return false;
+    }
+
+    return true;
+
+}
+
+cl_kernel
+kernel::acquire_instance(
+                std::map<cl_uint, boost::shared_ptr<buffer>> & managed_args,
+                std::set<cl_uint> const& launch_args)
+{
+
+    // Copy the arguments set via set_arg
+    std::map<cl_uint, cl_mem> args;
+#ifdef CL_VERSION_2_0
+    std::map<cl_uint, void*> svm_args;
+#endif
+    std::set<cl_uint> set_args;
+    {
+        boost::lock_guard<lock_type> lock(kernel_lock);
+        update_args_locked();
+        args = kernel_args;
+        managed_args = kernel_managed_args;
+#ifdef CL_VERSION_2_0
+        svm_args = kernel_svm_args;
+#endif
+        set_args = get_set_args_locked();
+    }
+
+    // Take an idle instance from the pool.
+    // Its leftover launch arguments must not leak into this launch, an
+    // instance that would keep any of them gets replaced by a new one.
+    cl_kernel instance = NULL;
+    cl_kernel replaced_instance = NULL;
+    std::set<cl_uint> stale_args;
+    {
+        boost::lock_guard<lock_type> lock(kernel_pool_lock);
+        for(size_t i = kernel_pool.size(); i > 0; i--)
+        {
+            if(overwrites_stale_args(kernel_pool[i - 1].second, set_args,
+                                     launch_args))
+            {
+                instance = kernel_pool[i - 1].first;
+                stale_args.swap(kernel_pool[i - 1].second);
+                kernel_pool.erase(kernel_pool.begin() + (i - 1));
+                break;
+            }
+        }
+        if(instance == NULL && !kernel_pool.empty())
+        {
+            replaced_instance = kernel_pool.back().first;
+            kernel_pool.pop_back();
+        }
+    }
+
+    if(replaced_instance != NULL)
+    {
+        cl_int err = clReleaseKernel(replaced_instance);
+        cl_ensure(err, "clReleaseKernel()");
+    }
+
+    // Grow the pool if necessary
+    if(instance == NULL)
+        instance = create_instance();
+
+    // Set the copied arguments
+    typedef std::pair<const cl_uint, cl_mem> arg_type;
+    BOOST_FOREACH(arg_type & arg, args)
+    {
+        cl_int err = clSetKernelArg(instance, arg.first, sizeof(cl_mem),
+                                    &arg.second);
+        if(err != CL_SUCCESS)
+        {
+            release_instance(instance, stale_args);
+            cl_ensure(err, "clSetKernelArg()");
+        }
+    }
+#ifdef CL_VERSION_2_0
+    typedef std::pair<const cl_uint, void*> svm_arg_type;
+    BOOST_FOREACH(svm_arg_type & arg, svm_args)
+    {
+        cl_int err = clSetKernelArgSVMPointer(instance, arg.first,
+                                              arg.second);
+        if(err != CL_SUCCESS)
+        {
+            release_instance(instance, stale_args);
+            cl_ensure(err, "clSetKernelArgSVMPointer()");
+        }
+    }
+#endif
+
+    return instance;
+
+}
+
+void
+kernel::release_instance(cl_kernel instance,
+                         std::set<cl_uint> const& launch_args)
+{
+
+    // The arguments set via set_arg get set again by acquire_instance,
+    // the others keep the values of the last launch
+    std::set<cl_uint> stale_args;
+    {
+        boost::lock_guard<lock_type> lock(kernel_lock);
+        std::set<cl_uint> set_args = get_set_args_locked();
+        std::set_difference(launch_args.begin(), launch_args.end(),
+                            set_args.begin(), set_args.end(),
+                            std::inserter(stale_args, stale_args.end()));
+    }
+
+    boost::lock_guard<lock_type> lock(kernel_pool_lock);
+    kernel_pool.push_back(pooled_instance(instance, stale_args));
+
+}
+
+std::set<cl_uint>
+kernel::get_launch_args(hpx::opencl::launch_desc const& launch)
+{
+
+    std::set<cl_uint> launch_args;
+
+    typedef std::pair<cl_uint, hpx::naming::id_type> arg_type;
+    BOOST_FOREACH(arg_type const& arg, launch.args)
+    {
+        launch_args.insert(arg.first);
+    }
+    typedef std::pair<cl_uint, std::vector<char>> value_arg_type;
+    BOOST_FOREACH(value_arg_type const& arg, launch.value_args)
+    {
+        launch_args.insert(arg.first);
+    }
+
+    return launch_args;
+
 }
 
 void
 kernel::set_arg(cl_uint arg_index, hpx::opencl::buffer arg)
 {
     
-    // Get local pointer to buffer
+    // Get local pointer to buffer.
+    // Might suspend, so it has to happen before taking kernel_lock.
     boost::shared_ptr<hpx::opencl::server::buffer>
-    buffer_local = hpx::get_ptr<hpx::opencl::server::buffer>(arg.get_gid())
-                                                                         .get();
+    buffer_local = hpx::get_ptr<hpx::opencl::server::buffer>(
+                                                        arg.get_gid()).get();
+
+    boost::lock_guard<lock_type> lock(kernel_lock);
+
+    cl_mem mem_id = set_arg_impl(kernel_id, arg_index, buffer_local,
+                                 kernel_managed_args);
+
+    // Remember the argument for the pooled instances
+    kernel_args[arg_index] = mem_id;
+    if(mem_id != NULL)
+        kernel_arg_buffers[arg_index] = buffer_local;
+    else
+        kernel_arg_buffers.erase(arg_index);
+#ifdef CL_VERSION_2_0
+    kernel_svm_args.erase(arg_index);
+#endif
+
+}
+
+#ifdef CL_VERSION_2_0
+void
+kernel::set_arg_svm(cl_uint arg_index, intptr_t ptr)
+{
+
+    boost::lock_guard<lock_type> lock(kernel_lock);
+
+    cl_int err;
+    err = clSetKernelArgSVMPointer(kernel_id, arg_index, (void*)ptr);
+    cl_ensure(err, "clSetKernelArgSVMPointer()");
+
+    // Remember the argument for the pooled instances
+    kernel_svm_args[arg_index] = (void*)ptr;
+    kernel_args.erase(arg_index);
+    kernel_arg_buffers.erase(arg_index);
+    kernel_managed_args.erase(arg_index);
+
+}
+#endif
+
+cl_mem
+kernel::set_arg_impl(cl_kernel instance, cl_uint arg_index,
+                     boost::shared_ptr<buffer> const& buffer_local,
+                     std::map<cl_uint, boost::shared_ptr<buffer>> &
+                                                                managed_args)
+{
+
+    // Managed memory might not be resident now, lazily created memory
+    // might not exist yet and relocated memory might get replaced again,
+    // they get set on launch
+    if(buffer_local->is_managed() || !buffer_local->is_allocated()
+       || buffer_local->is_relocated())
+    {
+        managed_args[arg_index] = buffer_local;
+        return NULL;
+    }
+    managed_args.erase(arg_index);
 
     // Get cl_mem
     cl_mem mem_id = buffer_local->get_cl_mem();
 
     // Set the argument
     cl_int err;
-    err = clSetKernelArg(kernel_id, arg_index, sizeof(cl_mem), &mem_id);
+    err = clSetKernelArg(instance, arg_index, sizeof(cl_mem), &mem_id);
     cl_ensure(err, "clSetKernelArg()");
 
+    return mem_id;
+
 }
 
-hpx::opencl::event
-kernel::enqueue(cl_uint work_dim, std::vector<std::vector<size_t>> args,
-                                  std::vector<hpx::opencl::event> events)
+std::set<cl_uint>
+kernel::get_set_args_locked()
+{
+
+    std::set<cl_uint> set_args;
+
+    typedef std::pair<const cl_uint, cl_mem> arg_type;
+    BOOST_FOREACH(arg_type & arg, kernel_args)
+    {
+        set_args.insert(arg.first);
+    }
+    typedef std::pair<const cl_uint, boost::shared_ptr<buffer>>
+                                                            managed_arg_type;
+    BOOST_FOREACH(managed_arg_type & arg, kernel_managed_args)
+    {
+        set_args.insert(arg.first);
+    }
+#ifdef CL_VERSION_2_0
+    typedef std::pair<const cl_uint, void*> svm_arg_type;
+    BOOST_FOREACH(svm_arg_type & arg, kernel_svm_args)
+    {
+        set_args.insert(arg.first);
+    }
+#endif
+
+    return set_args;
+
+}
+
+std::map<cl_uint, boost::shared_ptr<hpx::opencl::server::buffer>>
+kernel::get_managed_args()
+{
+
+    boost::lock_guard<lock_type> lock(kernel_lock);
+
+    update_args_locked();
+
+    return kernel_managed_args;
+
+}
+
+void
+kernel::update_args_locked()
+{
+
+    // A migration replaced the memory, look it up on every launch now
+    std::map<cl_uint, boost::shared_ptr<buffer>>::iterator it =
+                                                    kernel_arg_buffers.begin();
+    while(it != kernel_arg_buffers.end())
+    {
+        if(it->second->is_relocated())
+        {
+            kernel_managed_args[it->first] = it->second;
+            kernel_args[it->first] = NULL;
+            kernel_arg_buffers.erase(it++);
+        }
+        else
+        {
+            ++it;
+        }
+    }
+
+    // The memory of unmanaged buffers stays in place once it got created,
+    // no need to look it up on every launch
+    it = kernel_managed_args.begin();
+    while(it != kernel_managed_args.end())
+    {
+        cl_uint arg_index = it->first;
+        boost::shared_ptr<buffer> buffer_local = it->second;
+        ++it;
+
+        if(buffer_local->is_managed() || !buffer_local->is_allocated()
+           || buffer_local->is_relocated())
+            continue;
+
+        // Erases the argument from kernel_managed_args
+        cl_mem mem_id = set_arg_impl(kernel_id, arg_index, buffer_local,
+                                     kernel_managed_args);
+        kernel_args[arg_index] = mem_id;
+        if(mem_id != NULL)
+            kernel_arg_buffers[arg_index] = buffer_local;
+    }
+
+}
+
+void
+kernel::init_work_group_limits()
+{
+
+    if(work_group_limits_initialized)
+        return;
+
+    cl_int err;
+    cl_device_id device_id = parent_device->get_device_id();
+
+    // Query the kernel limits
+    err = clGetKernelWorkGroupInfo(kernel_id, device_id,
+                                   CL_KERNEL_WORK_GROUP_SIZE,
+                                   sizeof(size_t), &kernel_work_group_size,
+                                   NULL);
+    cl_ensure(err, "clGetKernelWorkGroupInfo()");
+    err = clGetKernelWorkGroupInfo(kernel_id, device_id,
+                                   CL_KERNEL_PREFERRED_WORK_GROUP_SIZE_MULTIPLE,
+                                   sizeof(size_t),
+                                   &preferred_work_group_size_multiple, NULL);
+    cl_ensure(err, "clGetKernelWorkGroupInfo()");
+    if(preferred_work_group_size_multiple == 0)
+        preferred_work_group_size_multiple = 1;
+
+    // The device limits are cached in the device
+    max_work_item_sizes = parent_device->get_properties().max_work_item_sizes;
+
+    work_group_limits_initialized = true;
+
+}
+
+size_t
+kernel::get_work_group_size()
+{
+
+    boost::lock_guard<lock_type> lock(local_size_cache_lock);
+    init_work_group_limits();
+
+    return kernel_work_group_size;
+
+}
+
+// Returns the largest divisor of n that is not bigger than max.
+// Prefers multiples of preferred_multiple.
+static size_t
+largest_divisor(size_t n, size_t max, size_t preferred_multiple)
+{
+
+    if(max > n) max = n;
+
+    // Try multiples of preferred_multiple first
+    for(size_t l = max - max % preferred_multiple; l > 0;
+                                                    l -= preferred_multiple)
+    {
+        if(n % l == 0)
+            return l;
+    }
+
+    // Take any divisor
+    for(size_t l = max; l > 1; l--)
+    {
+        if(n % l == 0)
+            return l;
+    }
+
+    return 1;
+
+}
+
+// Whether the local size of a dimension gets computed.
+// A local size of 0 can't be left to OpenCL for single dimensions, so it
+// gets computed as well.
+static bool
+is_auto_dimension(std::vector<size_t> const& requested_local_size, size_t i)
+{
+
+    return requested_local_size.empty()
+        || requested_local_size[i] == hpx::opencl::auto_local_size
+        || requested_local_size[i] == 0;
+
+}
+
+std::vector<size_t>
+kernel::compute_local_size(std::vector<size_t> const& global_work_size,
+                           std::vector<size_t> const& requested_local_size)
+{
+
+    size_t work_dim = global_work_size.size();
+    if(work_dim == 0 || work_dim > max_work_item_sizes.size())
+        return std::vector<size_t>();
+
+    // Keep the explicit dimensions, the others share the rest of the
+    // work group
+    std::vector<size_t> local_work_size(work_dim, 1);
+    size_t budget = kernel_work_group_size;
+    size_t explicit_total = 1;
+    size_t num_auto_dims = 0;
+    for(size_t i = 0; i < work_dim; i++)
+    {
+        if(global_work_size[i] == 0)
+            return std::vector<size_t>();
+
+        if(is_auto_dimension(requested_local_size, i))
+        {
+            num_auto_dims++;
+            continue;
+        }
+
+        local_work_size[i] = requested_local_size[i];
+        explicit_total *= requested_local_size[i];
+    }
+    if(explicit_total > budget)
+    {
+        HPX_THROW_EXCEPTION(hpx::bad_parameter,
+                            "kernel::compute_local_size()",
+                            "The explicit local work sizes exceed the work "
+                            "group size of the kernel!");
+    }
+    budget /= explicit_total;
+
+    size_t total = 1;
+    size_t remaining_dims = num_auto_dims;
+    for(size_t i = 0; i < work_dim; i++)
+    {
+        if(!is_auto_dimension(requested_local_size, i))
+            continue;
+
+        // Distribute the remaining budget evenly over the remaining dims
+        size_t target = budget;
+        if(remaining_dims > 1)
+            target = static_cast<size_t>(
+                   std::pow(static_cast<double>(budget),
+                            1.0 / static_cast<double>(remaining_dims)) + 0.5);
+        remaining_dims--;
+
+        // The first dimension is the one adjacent in memory,
+        // it should get at least the preferred multiple
+        if(i == 0 && target < preferred_work_group_size_multiple)
+            target = (std::min)(preferred_work_group_size_multiple, budget);
+        target = (std::min)(target, max_work_item_sizes[i]);
+        if(target == 0) target = 1;
+
+        size_t chosen = largest_divisor(global_work_size[i], target,
+                                i == 0 ? preferred_work_group_size_multiple
+                                       : 1);
+
+        local_work_size[i] = chosen;
+        budget /= chosen;
+        total *= chosen;
+    }
+
+    // Let the OpenCL runtime decide if we didn't find anything useful,
+    // unless some dimensions are fixed
+    if(total == 1 && num_auto_dims == work_dim)
+        return std::vector<size_t>();
+
+    return local_work_size;
+
+}
+
+void
+kernel::resolve_local_size(cl_uint work_dim,
+                           std::vector<size_t> const& global_work_size,
+                           std::vector<size_t> & local_work_size)
+{
+
+    // Check whether auto_local_size got requested
+    size_t num_auto_dims = std::count(local_work_size.begin(),
+                                      local_work_size.end(),
+                                      hpx::opencl::auto_local_size);
+    if(num_auto_dims == 0)
+        return;
+
+    // auto_local_size needs a global work size
+    if(global_work_size.size() != work_dim
+       || local_work_size.size() != work_dim)
+    {
+        local_work_size.clear();
+        return;
+    }
+
+    boost::lock_guard<lock_type> lock(local_size_cache_lock);
+
+    // Explicit dimensions get kept, only the others get computed.
+    // The cache and autotune only cover launches without explicit ones.
+    if(num_auto_dims != work_dim)
+    {
+        init_work_group_limits();
+        local_work_size = compute_local_size(global_work_size,
+                                             local_work_size);
+        return;
+    }
+
+    // Look up the cache
+    std::map<std::vector<size_t>, std::vector<size_t>>::iterator it =
+                                       local_size_cache.find(global_work_size);
+    if(it != local_size_cache.end())
+    {
+        local_work_size = it->second;
+        return;
+    }
+
+    // Compute new local work size
+    init_work_group_limits();
+    local_work_size = compute_local_size(global_work_size);
+
+    // Don't let the cache grow without bounds
+    if(local_size_cache.size() >= 1024)
+        local_size_cache.clear();
+    local_size_cache.insert(std::make_pair(global_work_size, local_work_size));
+
+}
+
+void
+kernel::enqueue_launch_impl(instance_guard & instance,
+                            hpx::opencl::launch_desc & launch,
+                            std::vector<cl_event> & wait_list,
+                            cl_event * return_event)
+{
+
+    // Fetch command queue
+    cl_command_queue command_queue = parent_device->get_work_command_queue();
+
+    // Set the arguments of this launch.
+    // Remember them, they stay set on the instance.
+    typedef std::pair<cl_uint, hpx::naming::id_type> arg_type;
+    BOOST_FOREACH(arg_type & arg, launch.args)
+    {
+        instance.launch_args.insert(arg.first);
+        set_arg_impl(instance.instance, arg.first,
+                     hpx::get_ptr<hpx::opencl::server::buffer>(
+                                                        arg.second).get(),
+                     instance.managed_args);
+    }
+    typedef std::pair<cl_uint, std::vector<char>> value_arg_type;
+    BOOST_FOREACH(value_arg_type & arg, launch.value_args)
+    {
+        instance.launch_args.insert(arg.first);
+        cl_int err = clSetKernelArg(instance.instance, arg.first,
+                                    arg.second.size(), arg.second.data());
+        cl_ensure(err, "clSetKernelArg()");
+    }
+
+    // Keep managed memory on the device until the kernel got enqueued
+    resident_args resident(instance.managed_args);
+    resident.set_args(instance.instance);
+
+    // Choose local work size if requested
+    cl_uint work_dim = launch.work_dim;
+    resolve_local_size(work_dim, launch.global_work_size,
+                                 launch.local_work_size);
+
+    // Convert vectors to pointers
+    size_t* global_work_offset = NULL;
+    size_t* global_work_size   = NULL;
+    size_t* local_work_size    = NULL;
+    if(launch.global_work_offset.size() == work_dim)
+        global_work_offset = launch.global_work_offset.data(); 
+    if(launch.global_work_size.size() == work_dim)
+        global_work_size   = launch.global_work_size.data(); 
+    if(launch.local_work_size.size() == work_dim)
+        local_work_size    = launch.local_work_size.data(); 
+
+    // Get the cl_event dependency list
+    cl_event* wait_list_ptr = NULL;
+    if(!wait_list.empty())
+    {
+        wait_list_ptr = wait_list.data();
+    }
+
+    // Enqueue the kernel.
+    // The arguments get copied by OpenCL, the instance can be reused
+    // right after this call.
+    cl_int err;
+    cl_event launch_event;
+    err = clEnqueueNDRangeKernel(command_queue, instance.instance, work_dim,
+                                 global_work_offset,
+                                 global_work_size,
+                                 local_work_size,
+                                 (cl_uint)wait_list.size(),
+                                 wait_list_ptr,
+                                 &launch_event);
+    cl_ensure(err, "clEnqueueNDRangeKernel()");
+
+    // Count the launch as outstanding work of the device
+    parent_device->track_pending_command(launch_event);
+    resident.track_event(launch_event);
+
+    if(return_event != NULL)
+    {
+        *return_event = launch_event;
+    }
+    else
+    {
+        err = clReleaseEvent(launch_event);
+        cl_ensure(err, "clReleaseEvent()");
+    }
+
+}
+
+cl_event
+kernel::enqueue_impl(cl_uint work_dim, std::vector<std::vector<size_t>> & args,
+                                       std::vector<hpx::opencl::event> & events)
 {
 
     // Ensure correctness of input data
@@ -84,6 +802,9 @@ kernel::enqueue(cl_uint work_dim, std::vector<std::vector<size_t>> args,
 
     // Fetch command queue
     cl_command_queue command_queue = parent_device->get_work_command_queue();
+
+    // Choose local work size if requested
+    resolve_local_size(work_dim, args[1], args[2]);
     
     // Convert vectors to pointers
     size_t* global_work_offset = NULL;
@@ -102,9 +823,15 @@ kernel::enqueue(cl_uint work_dim, std::vector<std::vector<size_t>> args,
         cl_events_list_ptr = cl_events_list.data();
     }
 
+    // Keep managed memory on the device until the kernel got enqueued.
+    // Locking might suspend, so it has to happen before taking kernel_lock.
+    resident_args resident(get_managed_args());
+
     // Enqueue the kernel
     cl_int err;
     cl_event returnEvent;
+    boost::lock_guard<lock_type> lock(kernel_lock);
+    resident.set_args(kernel_id);
     err = clEnqueueNDRangeKernel(command_queue, kernel_id, work_dim,
                                  global_work_offset,
                                  global_work_size,
@@ -114,6 +841,22 @@ kernel::enqueue(cl_uint work_dim, std::vector<std::vector<size_t>> args,
                                  &returnEvent);
     cl_ensure(err, "clEnqueueNDRangeKernel()");
 
+    // Count the launch as outstanding work of the device
+    parent_device->track_pending_command(returnEvent);
+    resident.track_event(returnEvent);
+
+    return returnEvent;
+
+}
+
+hpx::opencl::event
+kernel::enqueue(cl_uint work_dim, std::vector<std::vector<size_t>> args,
+                                  std::vector<hpx::opencl::event> events)
+{
+
+    // Enqueue the kernel
+    cl_event returnEvent = enqueue_impl(work_dim, args, events);
+
     // Return the event
     return hpx::opencl::event(
                hpx::components::new_<hpx::opencl::server::event>(
@@ -124,7 +867,238 @@ kernel::enqueue(cl_uint work_dim, std::vector<std::vector<size_t>> args,
 
 }
 
+hpx::lcos::future<void>
+kernel::enqueue_local(cl_uint work_dim, std::vector<std::vector<size_t>> args)
+{
 
+    // Enqueue the kernel
+    std::vector<hpx::opencl::event> events(0);
+    cl_event returnEvent = enqueue_impl(work_dim, args, events);
 
+    // Convert to future, the future holds its own reference to the cl_event
+    hpx::lcos::future<void> result = 
+                   hpx::opencl::server::future_from_cl_event(returnEvent);
+    cl_int err = clReleaseEvent(returnEvent);
+    cl_ensure(err, "clReleaseEvent()");
 
+    return result;
+
+}
 
+std::vector<hpx::opencl::event>
+kernel::enqueue_bulk(std::vector<hpx::opencl::launch_desc> launches,
+                     std::vector<hpx::opencl::event> events,
+                     bool per_launch_events)
+{
+
+    // Fetch command queue
+    cl_command_queue command_queue = parent_device->get_work_command_queue();
+
+    // Get the cl_event dependency list
+    std::vector<cl_event> cl_events_list = hpx::opencl::event::
+                                                    get_cl_events(events);
+
+    // The per-launch cl_events
+    std::vector<cl_event> launch_events;
+    if(per_launch_events)
+        launch_events.reserve(launches.size());
+
+    cl_int err;
+    cl_event markerEvent;
+    {
+        // The arguments of the launches only affect our own instance
+        instance_guard instance(*this, launches.empty() ?
+                                           std::set<cl_uint>() :
+                                           get_launch_args(launches.front()));
+
+        BOOST_FOREACH(hpx::opencl::launch_desc & launch, launches)
+        {
+
+            // Enqueue the kernel.
+            // Only create an event if the caller wants it.
+            cl_event launchEvent;
+            enqueue_launch_impl(instance, launch, cl_events_list,
+                                per_launch_events ? &launchEvent : NULL);
+
+            if(per_launch_events)
+                launch_events.push_back(launchEvent);
+
+        }
+
+        // The marker completes as soon as all launches completed
+        err = clEnqueueMarker(command_queue, &markerEvent);
+        cl_ensure(err, "clEnqueueMarker()");
+    }
+
+    // Create the event components
+    std::vector<hpx::opencl::event> result;
+    result.reserve(launch_events.size() + 1);
+    result.push_back(hpx::opencl::event(
+               hpx::components::new_<hpx::opencl::server::event>(
+                                hpx::find_here(),
+                                parent_device_id,
+                                (clx_event) markerEvent
+                            )));
+    BOOST_FOREACH(cl_event & launchEvent, launch_events)
+    {
+        result.push_back(hpx::opencl::event(
+               hpx::components::new_<hpx::opencl::server::event>(
+                                hpx::find_here(),
+                                parent_device_id,
+                                (clx_event) launchEvent
+                            )));
+    }
+
+    return result;
+
+}
+
+hpx::opencl::event
+kernel::enqueue_launch(hpx::opencl::launch_desc launch,
+                       std::vector<hpx::opencl::event> events)
+{
+
+    // Get the cl_event dependency list
+    std::vector<cl_event> cl_events_list = hpx::opencl::event::
+                                                    get_cl_events(events);
+
+    // Enqueue the kernel on a pooled instance
+    cl_event returnEvent;
+    {
+        instance_guard instance(*this, get_launch_args(launch));
+
+        enqueue_launch_impl(instance, launch, cl_events_list, &returnEvent);
+    }
+
+    // Return the event
+    return hpx::opencl::event(
+               hpx::components::new_<hpx::opencl::server::event>(
+                                hpx::find_here(),
+                                parent_device_id,
+                                (clx_event) returnEvent
+                            ));
+
+}
+
+// Generates all local work sizes with power-of-two dimensions that divide
+// the global work size and respect the work group limits
+static void
+generate_local_sizes(std::vector<size_t> const& global_work_size,
+                     std::vector<size_t> const& max_work_item_sizes,
+                     size_t max_work_group_size,
+                     std::vector<size_t> & current,
+                     std::vector<std::vector<size_t>> & candidates)
+{
+
+    size_t dim = current.size();
+    if(dim == global_work_size.size())
+    {
+        candidates.push_back(current);
+        return;
+    }
+
+    size_t current_total = 1;
+    BOOST_FOREACH(size_t l, current)
+    {
+        current_total *= l;
+    }
+
+    for(size_t l = 1; l <= max_work_item_sizes[dim]
+                      && l * current_total <= max_work_group_size; l *= 2)
+    {
+        if(global_work_size[dim] % l != 0)
+            break;
+
+        current.push_back(l);
+        generate_local_sizes(global_work_size, max_work_item_sizes,
+                             max_work_group_size, current, candidates);
+        current.pop_back();
+    }
+
+}
+
+std::vector<size_t>
+kernel::autotune(cl_uint work_dim, std::vector<std::vector<size_t>> args)
+{
+
+    // Ensure correctness of input data
+    BOOST_ASSERT(args.size() == 3);
+    std::vector<size_t> & global_work_size = args[1];
+    if(global_work_size.size() != work_dim)
+    {
+        HPX_THROW_EXCEPTION(hpx::bad_parameter, "kernel::autotune()",
+                            "autotune needs a global work size!");
+    }
+
+    // Generate the candidates
+    std::vector<std::vector<size_t>> candidates;
+    {
+        boost::lock_guard<lock_type> lock(local_size_cache_lock);
+        init_work_group_limits();
+        if(work_dim > max_work_item_sizes.size())
+        {
+            HPX_THROW_EXCEPTION(hpx::bad_parameter, "kernel::autotune()",
+                                "work_dim exceeds the device limits!");
+        }
+
+        // NULL, and the heuristic choice
+        candidates.push_back(std::vector<size_t>());
+        candidates.push_back(compute_local_size(global_work_size));
+
+        std::vector<size_t> current;
+        generate_local_sizes(global_work_size, max_work_item_sizes,
+                             kernel_work_group_size, current, candidates);
+    }
+
+    // Time all candidates
+    static const size_t num_runs = 3;
+    std::vector<size_t> best_local_size;
+    double best_time = std::numeric_limits<double>::max();
+    {
+        instance_guard instance(*this);
+
+        BOOST_FOREACH(std::vector<size_t> & candidate, candidates)
+        {
+            hpx::opencl::launch_desc launch;
+            launch.work_dim = work_dim;
+            launch.global_work_offset = args[0];
+            launch.global_work_size = global_work_size;
+            launch.local_work_size = candidate;
+
+            std::vector<cl_event> wait_list;
+            double time = 0.0;
+            
+            // The first run is a warm-up run
+            for(size_t run = 0; run <= num_runs; run++)
+            {
+                hpx::util::high_resolution_timer timer;
+
+                cl_event run_event;
+                enqueue_launch_impl(instance, launch, wait_list, &run_event);
+                hpx::lcos::future<void> run_future =
+                        hpx::opencl::server::future_from_cl_event(run_event);
+                cl_int err = clReleaseEvent(run_event);
+                cl_ensure(err, "clReleaseEvent()");
+                run_future.get();
+
+                if(run > 0)
+                    time += timer.elapsed();
+            }
+
+            if(time < best_time)
+            {
+                best_time = time;
+                best_local_size = candidate;
+            }
+        }
+    }
+
+    // Remember the result for auto_local_size
+    {
+        boost::lock_guard<lock_type> lock(local_size_cache_lock);
+        local_size_cache[global_work_size] = best_local_size;
+    }
+
+    return best_local_size;
+
+}
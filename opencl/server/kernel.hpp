@@ -10,11 +10,18 @@
 #include <hpx/hpx.hpp>
 #include <hpx/config.hpp>
 #include <hpx/include/components.hpp>
+#include <hpx/lcos/local/spinlock.hpp>
 
 #include <CL/cl.h>
 
+#include <map>
+#include <set>
+#include <string>
+#include <vector>
+
 #include "../fwd_declarations.hpp"
 #include "../event.hpp"
+#include "../launch_desc.hpp"
 
 ////////////////////////////////////////////////////////////////
 namespace hpx { namespace opencl{ namespace server{
@@ -30,8 +37,19 @@ namespace hpx { namespace opencl{ namespace server{
         // Constructor
         kernel();
         kernel(hpx::naming::id_type program_id, std::string kernel_name);
+        kernel(hpx::naming::id_type program_id, std::string kernel_name,
+               size_t pool_size);
         ~kernel();
 
+        //////////////////////////////////////////////////
+        /// Local functions
+        ///
+
+        // Component-less version of enqueue.
+        // The returned future triggers as soon as the kernel finished,
+        // no event component gets created.
+        hpx::lcos::future<void>
+        enqueue_local(cl_uint work_dim, std::vector<std::vector<size_t>> args);
 
         //////////////////////////////////////////////////
         /// Exposed functionality of this component
@@ -40,14 +58,51 @@ namespace hpx { namespace opencl{ namespace server{
         // Sets an argument of the kernel
         void set_arg(cl_uint arg_index, hpx::opencl::buffer arg);
 
+#ifdef CL_VERSION_2_0
+        // Sets a shared virtual memory pointer as argument of the kernel.
+        // Only valid within the process that allocated the memory.
+        void set_arg_svm(cl_uint arg_index, intptr_t ptr);
+#endif
+
         // Runs the kernel
         hpx::opencl::event
         enqueue(cl_uint work_dim, std::vector<std::vector<size_t>> args,
                                   std::vector<hpx::opencl::event> events);
 
+        // Runs the kernel multiple times.
+        // The first returned event triggers when all launches completed,
+        // followed by one event per launch if per_launch_events is set.
+        std::vector<hpx::opencl::event>
+        enqueue_bulk(std::vector<hpx::opencl::launch_desc> launches,
+                     std::vector<hpx::opencl::event> events,
+                     bool per_launch_events);
+
+        // Runs the kernel with its own set of arguments.
+        // Uses a pooled cl_kernel instance, the arguments set via set_arg
+        // are not modified.
+        hpx::opencl::event
+        enqueue_launch(hpx::opencl::launch_desc launch,
+                       std::vector<hpx::opencl::event> events);
+
+        // Runs the kernel with different local work sizes and caches the
+        // fastest one for auto_local_size. Returns the chosen local size.
+        std::vector<size_t>
+        autotune(cl_uint work_dim, std::vector<std::vector<size_t>> args);
+
+        // Returns the maximum work group size the kernel can be launched
+        // with, CL_KERNEL_WORK_GROUP_SIZE
+        size_t get_work_group_size();
+
     //[opencl_management_action_types
     HPX_DEFINE_COMPONENT_ACTION(kernel, set_arg);
+#ifdef CL_VERSION_2_0
+    HPX_DEFINE_COMPONENT_ACTION(kernel, set_arg_svm);
+#endif
     HPX_DEFINE_COMPONENT_ACTION(kernel, enqueue);
+    HPX_DEFINE_COMPONENT_ACTION(kernel, enqueue_bulk);
+    HPX_DEFINE_COMPONENT_ACTION(kernel, enqueue_launch);
+    HPX_DEFINE_COMPONENT_ACTION(kernel, autotune);
+    HPX_DEFINE_COMPONENT_ACTION(kernel, get_work_group_size);
     //]
 
     private:
@@ -55,6 +110,105 @@ namespace hpx { namespace opencl{ namespace server{
         // Private Member Functions
         //
 
+        // Initializes the kernel, called by the constructors
+        void init(hpx::naming::id_type program_id, std::string kernel_name);
+
+        // Creates a new cl_kernel instance
+        cl_kernel create_instance();
+
+        // Takes a cl_kernel instance from the pool, with all arguments
+        // set that got set via set_arg. The managed arguments only get
+        // copied to managed_args, they need to be set on launch.
+        // launch_args are the indices the first launch on the instance
+        // sets, only those may still hold arguments of an earlier launch.
+        cl_kernel acquire_instance(
+                std::map<cl_uint, boost::shared_ptr<buffer>> & managed_args,
+                std::set<cl_uint> const& launch_args);
+
+        // Returns a cl_kernel instance to the pool.
+        // launch_args are the indices the launches on the instance set.
+        void release_instance(cl_kernel instance,
+                              std::set<cl_uint> const& launch_args);
+
+        // Returns the indices of the arguments of the launch
+        static std::set<cl_uint>
+        get_launch_args(hpx::opencl::launch_desc const& launch);
+
+        // Holds a cl_kernel instance from the pool while in scope
+        struct instance_guard
+        {
+            instance_guard(kernel & parent_,
+                           std::set<cl_uint> const& first_launch_args =
+                                                        std::set<cl_uint>())
+              : parent(parent_),
+                instance(parent_.acquire_instance(managed_args,
+                                                  first_launch_args))
+            {}
+            ~instance_guard()
+            {
+                parent.release_instance(instance, launch_args);
+            }
+
+            kernel & parent;
+            std::map<cl_uint, boost::shared_ptr<buffer>> managed_args;
+            // the indices that launches set on the instance
+            std::set<cl_uint> launch_args;
+            cl_kernel instance;
+        };
+
+        // Sets a kernel argument, returns the cl_mem of the buffer.
+        // Managed and not yet allocated buffers only get remembered in
+        // managed_args, they get set once they are resident.
+        // Doesn't suspend, so it may be called with kernel_lock held.
+        cl_mem set_arg_impl(cl_kernel instance, cl_uint arg_index,
+                            boost::shared_ptr<buffer> const& buffer_local,
+                            std::map<cl_uint, boost::shared_ptr<buffer>> &
+                                                                managed_args);
+
+        // Returns a copy of the managed buffers set via set_arg.
+        // Calls update_args_locked first.
+        std::map<cl_uint, boost::shared_ptr<buffer>> get_managed_args();
+
+        // Returns the indices of all arguments set via set_arg.
+        // Needs kernel_lock.
+        std::set<cl_uint> get_set_args_locked();
+
+        // Buffers that got relocated since set_arg become managed,
+        // unmanaged buffers that got allocated since set_arg become plain
+        // arguments of kernel_id. Needs kernel_lock.
+        void update_args_locked();
+
+        // Queries the work group limits of kernel and device, once
+        void init_work_group_limits();
+
+        // Computes a local work size from the work group limits.
+        // Dimensions of requested_local_size other than auto_local_size
+        // are kept, the others share the rest of the work group.
+        // Returns an empty vector if no valid local work size exists.
+        std::vector<size_t>
+        compute_local_size(std::vector<size_t> const& global_work_size,
+                           std::vector<size_t> const& requested_local_size =
+                                                        std::vector<size_t>());
+
+        // Replaces auto_local_size with an actual local work size,
+        // explicit dimensions of the same launch are kept
+        void resolve_local_size(cl_uint work_dim,
+                                std::vector<size_t> const& global_work_size,
+                                std::vector<size_t> & local_work_size);
+
+        // Enqueues a single launch on the instance of the guard.
+        // The arguments of the launch stay set for all following launches
+        // on the same guard.
+        void enqueue_launch_impl(instance_guard & instance,
+                                 hpx::opencl::launch_desc & launch,
+                                 std::vector<cl_event> & wait_list,
+                                 cl_event * return_event);
+
+        // Enqueues the kernel, returns the cl_event
+        cl_event enqueue_impl(cl_uint work_dim,
+                              std::vector<std::vector<size_t>> & args,
+                              std::vector<hpx::opencl::event> & events);
+
     private:
         ///////////////////////////////////////////////
         // Private Member Variables
@@ -64,9 +218,51 @@ namespace hpx { namespace opencl{ namespace server{
         boost::shared_ptr<device>  parent_device;
         hpx::naming::id_type       parent_device_id;
 
-        // the cl_kernel object
+        // the name of the kernel
+        std::string kernel_name;
+
+        // the cl_kernel object, holds the arguments set via set_arg
         cl_kernel kernel_id;
 
+        // the arguments set via set_arg
+        std::map<cl_uint, cl_mem> kernel_args;
+
+        // the buffers behind kernel_args, a migration might replace
+        // their memory
+        std::map<cl_uint, boost::shared_ptr<buffer>> kernel_arg_buffers;
+
+        // the arguments set via set_arg whose memory can get evicted or
+        // is not allocated yet. They get set again on every launch.
+        std::map<cl_uint, boost::shared_ptr<buffer>> kernel_managed_args;
+
+#ifdef CL_VERSION_2_0
+        // the shared virtual memory arguments set via set_arg_svm
+        std::map<cl_uint, void*> kernel_svm_args;
+#endif
+
+        // Protects kernel_id and the arguments
+        typedef hpx::lcos::local::spinlock lock_type;
+        lock_type kernel_lock;
+
+        // Idle cl_kernel instances.
+        // Arguments are stored per instance, so concurrent launches with
+        // different arguments need different instances.
+        // Every instance comes with the indices that still hold arguments
+        // of its last launch, as acquire_instance doesn't overwrite them.
+        typedef std::pair<cl_kernel, std::set<cl_uint>> pooled_instance;
+        std::vector<pooled_instance> kernel_pool;
+        lock_type kernel_pool_lock;
+
+        // The work group limits, used for auto_local_size
+        bool work_group_limits_initialized;
+        size_t kernel_work_group_size;
+        size_t preferred_work_group_size_multiple;
+        std::vector<size_t> max_work_item_sizes;
+
+        // The chosen local work sizes, by global work size
+        std::map<std::vector<size_t>, std::vector<size_t>> local_size_cache;
+        lock_type local_size_cache_lock;
+
     };
 }}}
 
@@ -74,9 +270,26 @@ namespace hpx { namespace opencl{ namespace server{
 HPX_REGISTER_ACTION_DECLARATION(
         hpx::opencl::server::kernel::set_arg_action,
         opencl_kernel_set_arg_action);
+#ifdef CL_VERSION_2_0
+HPX_REGISTER_ACTION_DECLARATION(
+        hpx::opencl::server::kernel::set_arg_svm_action,
+        opencl_kernel_set_arg_svm_action);
+#endif
 HPX_REGISTER_ACTION_DECLARATION(
         hpx::opencl::server::kernel::enqueue_action,
         opencl_kernel_enqueue_action);
+HPX_REGISTER_ACTION_DECLARATION(
+        hpx::opencl::server::kernel::enqueue_bulk_action,
+        opencl_kernel_enqueue_bulk_action);
+HPX_REGISTER_ACTION_DECLARATION(
+        hpx::opencl::server::kernel::enqueue_launch_action,
+        opencl_kernel_enqueue_launch_action);
+HPX_REGISTER_ACTION_DECLARATION(
+        hpx::opencl::server::kernel::autotune_action,
+        opencl_kernel_autotune_action);
+HPX_REGISTER_ACTION_DECLARATION(
+        hpx::opencl::server::kernel::get_work_group_size_action,
+        opencl_kernel_get_work_group_size_action);
 //]
 
 
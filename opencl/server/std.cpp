@@ -8,7 +8,8 @@
 #include "../tools.hpp"
 #include "../device.hpp"
 
-#include <hpx/lcos/local/spinlock.hpp>
+#include <hpx/lcos/local/mutex.hpp>
+#include <hpx/lcos/when_all.hpp>
 #include <hpx/util/static.hpp>
 #include <hpx/runtime.hpp>
 
@@ -19,7 +20,7 @@
 /// STATIC STUFF
 ///
 
-using hpx::lcos::local::spinlock;
+using hpx::lcos::local::mutex;
 
 // serves as a unique tag to get the device 
 struct global_device_list_tag {};
@@ -31,14 +32,18 @@ static bool device_shutdown_hook_initialized = false;
 
 // This defines a static device list type.
 // Generating instances of this type will always give the same list.
+// Every device is stored together with its properties, so filtering
+// does not need to query the devices.
 typedef
-hpx::util::static_<std::vector<hpx::opencl::device>,
+hpx::util::static_<std::vector<hpx::opencl::device_with_properties>,
                    global_device_list_tag>  static_device_list_type;
 
 // This defines a static device list lock type.
 // Generating instances of this type will always give the same lock.
+// This is a mutex instead of a spinlock, as the initialization has to wait
+// for the device components to get created.
 typedef
-hpx::util::static_<spinlock,
+hpx::util::static_<mutex,
                    global_device_list_tag>  static_device_list_lock_type;
 
 // The shutdown hook for clearing the device list on hpx::finalize()
@@ -47,7 +52,7 @@ static void clear_device_list()
 
     // Lock the list
     static_device_list_lock_type device_lock;
-    boost::lock_guard<spinlock> lock(device_lock.get());
+    boost::lock_guard<mutex> lock(device_lock.get());
 
     // get static device list
     static_device_list_type devices;
@@ -63,53 +68,9 @@ static void clear_device_list()
 ///
 HPX_REGISTER_PLAIN_ACTION(hpx::opencl::server::get_devices_action,
                           opencl_get_devices_action);
-
-///////////////////////////////////////////////////
-/// Local functions
-///
-static std::vector<int> 
-parse_version_string(std::string version_str)
-{
-
-    try{
-       
-        // Make sure the version string starts with "OpenCL "
-        BOOST_ASSERT(version_str.compare(0, 7, "OpenCL ") == 0);
-
-        // Cut away the "OpenCL " in front of the version string
-        version_str = version_str.substr(7);
-    
-        // Cut away everything behind the version number
-        version_str = version_str.substr(0, version_str.find(" "));
-        
-        // Get major version string
-        std::string version_str_major = 
-                           version_str.substr(0, version_str.find("."));
-
-        // Get minor version string
-        std::string version_str_minor = 
-                           version_str.substr(version_str_major.size() + 1);
-
-        // create output vector
-        std::vector<int> version_numbers(2);
-
-        // Parse version number
-        version_numbers[0] = ::atoi(version_str_major.c_str());
-        version_numbers[1] = ::atoi(version_str_minor.c_str());
-
-        // Return the parsed version number
-        return version_numbers;
-
-    } catch (const std::exception &) {
-        hpx::cerr << "Error while parsing OpenCL Version!" << hpx::endl;
-        std::vector<int> version_numbers(2);
-        version_numbers[0] = -1;
-        version_numbers[1] = 0;
-        return version_numbers;
-    }
-
-}
-
+HPX_REGISTER_PLAIN_ACTION(
+                    hpx::opencl::server::get_devices_with_properties_action,
+                    opencl_get_devices_with_properties_action);
 
 ///////////////////////////////////////////////////
 /// Implementations
@@ -122,7 +83,7 @@ ensure_device_components_initialization()
 
     // Lock the list
     static_device_list_lock_type device_lock;
-    boost::lock_guard<spinlock> lock(device_lock.get());
+    boost::lock_guard<mutex> lock(device_lock.get());
 
     // get static device list
     static_device_list_type devices;
@@ -154,6 +115,14 @@ ensure_device_components_initialization()
     err = clGetPlatformIDs(num_platforms, platforms.data(), NULL);
     cl_ensure(err, "clGetPlatformIDs()");
 
+    // The device clients and their property queries.
+    // All devices get created in parallel, the expensive part
+    // (context creation, property queries) runs concurrently in the
+    // device constructors.
+    std::vector<hpx::opencl::device> device_clients;
+    std::vector<hpx::lcos::future<hpx::opencl::device_properties>>
+                                                            property_futures;
+
     // Search on every platform
     BOOST_FOREACH(
         const std::vector<cl_platform_id>::value_type& platform, platforms)
@@ -197,7 +166,8 @@ ensure_device_components_initialization()
                                        version_string_arr.end());
 
             // Parse
-            std::vector<int> version = parse_version_string(version_string);
+            std::vector<int> version =
+                      hpx::opencl::parse_version_string(version_string);
 
             // only allow machines with version 1.1 or higher
             if(version[0] < 1) continue;
@@ -205,73 +175,91 @@ ensure_device_components_initialization()
 
         #endif //HPXCL_ALLOW_OPENCL_1_0_DEVICES
 
-            // Create a new device client 
+            // Create a new device client, don't wait for the creation
             hpx::opencl::device device_client(
                 hpx::components::new_<hpx::opencl::server::device>(
                             hpx::find_here(),
                             (hpx::opencl::server::clx_device_id)device
                                                     ));
 
-            // Add device to list of valid devices
-            devices.get().push_back(device_client);
+            device_clients.push_back(device_client);
         }
     }
 
+    // Query the properties.
+    // This has to happen after all creations got started, as it waits
+    // for the device to get created.
+    BOOST_FOREACH( const hpx::opencl::device & device_client, device_clients )
+    {
+        property_futures.push_back(device_client.get_device_properties());
+    }
+
+    // Wait for all devices to get created
+    std::vector<hpx::lcos::future<hpx::opencl::device_properties>>
+    ready_property_futures = hpx::when_all(property_futures).get();
+
+    // Add devices to list of valid devices
+    for(size_t i = 0; i < device_clients.size(); i++)
+    {
+        devices.get().push_back(
+            hpx::opencl::device_with_properties(device_clients[i],
+                                                ready_property_futures[i].get()));
+    }
+
     device_list_initialized = true;
 
 }
-    
 
-std::vector<hpx::opencl::device>
-hpx::opencl::server::get_devices(cl_device_type type,
-                                 std::string min_cl_version)
+// Checks whether a device fulfills the given requirements
+static bool
+device_is_suitable(hpx::opencl::device_properties const& properties,
+                   cl_device_type type,
+                   std::vector<int> const& required_version)
+{
+
+    // Check if device supports required version
+    if(!hpx::opencl::is_version_supported(properties.version_major,
+                                          properties.version_minor,
+                                          required_version))
+        return false;
+
+    // Check for requested device type
+    if(!(properties.type & type)) return false;
+
+    return true;
+
+}
+
+std::vector<hpx::opencl::device_with_properties>
+hpx::opencl::server::get_devices_with_properties(cl_device_type type,
+                                                 std::string min_cl_version)
 {
 
     // Parse required OpenCL version
-    std::vector<int> required_version = parse_version_string(min_cl_version);
+    std::vector<int> required_version =
+                          hpx::opencl::parse_version_string(min_cl_version);
 
     // Create the list of device clients
     ensure_device_components_initialization();
 
     // Lock the list
     static_device_list_lock_type device_lock;
-    boost::lock_guard<spinlock> lock(device_lock.get());
+    boost::lock_guard<mutex> lock(device_lock.get());
 
     // get static device list
     static_device_list_type devices;
 
-    // Generate a list of suitable devices
-    std::vector<hpx::opencl::device> suitable_devices;
-    BOOST_FOREACH( const std::vector<hpx::opencl::device>::value_type& device,
-                   devices.get())
+    // Generate a list of suitable devices.
+    // Only uses the cached properties, so no device queries are necessary.
+    std::vector<hpx::opencl::device_with_properties> suitable_devices;
+    BOOST_FOREACH(
+        const std::vector<hpx::opencl::device_with_properties>::value_type&
+            device,
+        devices.get())
     {
-        // Get device OpenCL version
-        std::vector<char> cl_version_string_vec =
-                                device.get_device_info(CL_DEVICE_VERSION).get();
-
-        // Make String out of char array
-        std::string cl_version_string (cl_version_string_vec.begin(),
-                                       cl_version_string_vec.end());
-    
-        // Parse OpenCL version
-        std::vector<int> device_cl_version = 
-                                        parse_version_string(cl_version_string);
-
-        // Check if device supports required version
-        if(device_cl_version[0] < required_version[0]) continue;
-        if(device_cl_version[0] == required_version[0])
-        {
-            if(device_cl_version[1] < required_version[1]) continue;
-        }
-
-        // Check for requested device type
-        std::vector<char> device_type_string = 
-                                   device.get_device_info(CL_DEVICE_TYPE).get();
-        cl_device_type device_type = *((cl_device_type*)
-                                                   (device_type_string.data()));
-        if(!(device_type & type)) continue;
+        if(!device_is_suitable(device.second, type, required_version))
+            continue;
 
-        // TODO filter devices
         suitable_devices.push_back(device);
     }
 
@@ -280,5 +268,30 @@ hpx::opencl::server::get_devices(cl_device_type type,
 
 }
 
+std::vector<hpx::opencl::device>
+hpx::opencl::server::get_devices(cl_device_type type,
+                                 std::string min_cl_version)
+{
+
+    // Filter the devices
+    std::vector<hpx::opencl::device_with_properties> suitable_devices =
+                    get_devices_with_properties(type, min_cl_version);
+
+    // Strip the properties
+    std::vector<hpx::opencl::device> result;
+    result.reserve(suitable_devices.size());
+    BOOST_FOREACH(
+        const std::vector<hpx::opencl::device_with_properties>::value_type&
+            device,
+        suitable_devices)
+    {
+        result.push_back(device.first);
+    }
+
+    // Return the devices found
+    return result;
+
+}
+
 
 
@@ -15,8 +15,10 @@
 #include <hpx/include/actions.hpp>
 
 #include <boost/serialization/vector.hpp>
+#include <boost/serialization/utility.hpp>
 
 #include "../fwd_declarations.hpp"
+#include "../device_properties.hpp"
 
 ////////////////////////////////////////////////////////////////
 namespace hpx { namespace opencl{ namespace server{
@@ -30,14 +32,22 @@ namespace hpx { namespace opencl{ namespace server{
     std::vector<hpx::opencl::device>
     get_devices(cl_device_type, std::string cl_version);
 
+    // Returns the IDs and properties of all devices on current host
+    std::vector<hpx::opencl::device_with_properties>
+    get_devices_with_properties(cl_device_type, std::string cl_version);
+
     //[opencl_management_action_types
     HPX_DEFINE_PLAIN_ACTION(get_devices, get_devices_action);
+    HPX_DEFINE_PLAIN_ACTION(get_devices_with_properties,
+                            get_devices_with_properties_action);
     //]
 
 }}}
 
 
 HPX_REGISTER_PLAIN_ACTION_DECLARATION(hpx::opencl::server::get_devices_action);
+HPX_REGISTER_PLAIN_ACTION_DECLARATION(
+                    hpx::opencl::server::get_devices_with_properties_action);
 
 
 #endif
@@ -9,6 +9,9 @@
 
 #include <hpx/lcos/when_all.hpp>
 
+#include <algorithm>
+#include <cmath>
+
 hpx::lcos::future<std::vector<hpx::opencl::device>>
 hpx::opencl::get_devices( hpx::naming::id_type node_id,
                           cl_device_type device_type,
@@ -20,9 +23,57 @@ hpx::opencl::get_devices( hpx::naming::id_type node_id,
 
 }
 
-hpx::lcos::future<std::vector<hpx::opencl::device>>
-hpx::opencl::get_all_devices( cl_device_type device_type,
-                              std::string required_cl_version)
+hpx::lcos::future<std::vector<hpx::opencl::device_with_properties>>
+hpx::opencl::get_devices_with_properties( hpx::naming::id_type node_id,
+                                          cl_device_type device_type,
+                                          std::string required_cl_version)
+{
+
+    typedef hpx::opencl::server::get_devices_with_properties_action action;
+    return async<action>(node_id, device_type, required_cl_version);
+
+}
+
+// Joins the device lists of all localities to one list
+template <typename T>
+static std::vector<T>
+join_locality_lists(
+    hpx::lcos::future< std::vector<
+        hpx::lcos::future< std::vector< T > >
+    > > parent_future)
+{
+
+    // initialize the result list
+    std::vector< T > devices;
+
+    // get vector from parent future
+    std::vector< hpx::lcos::future< std::vector< T > > >
+    locality_device_futures = parent_future.get();
+
+    // for each future, take devices out and join in one list
+    BOOST_FOREACH( hpx::lcos::future<std::vector<T>> & locality_device_future,
+                   locality_device_futures)
+    {
+
+        // wait for device query to finish
+        std::vector<T> locality_devices = locality_device_future.get();
+
+        // add all devices to device list
+        devices.insert(devices.end(), locality_devices.begin(),
+                                      locality_devices.end());
+
+    }
+
+    return devices;
+
+}
+
+// Runs a device query on all localities at once and gathers the results.
+// The discovery and the filtering run in parallel on the owning localities.
+template <typename Action, typename T>
+static hpx::lcos::future<std::vector<T>>
+query_all_localities( cl_device_type device_type,
+                      std::string required_cl_version )
 {
 
     // get all HPX localities
@@ -30,75 +81,157 @@ hpx::opencl::get_all_devices( cl_device_type device_type,
                                         hpx::find_all_localities();
 
     // query all devices
-    std::vector<hpx::lcos::future<std::vector<hpx::opencl::device>>>
-    locality_device_futures;
+    std::vector<hpx::lcos::future<std::vector<T>>> locality_device_futures;
     BOOST_FOREACH(hpx::naming::id_type & locality, localities)
     {
 
-        // get all devices on locality
-        hpx::lcos::future<std::vector<hpx::opencl::device>>
-        locality_device_future = hpx::opencl::get_devices(locality,
-                                                         device_type,
-                                                         required_cl_version);
-
         // add locality device future to list of futures
-        locality_device_futures.push_back(std::move(locality_device_future));
+        locality_device_futures.push_back(
+                hpx::async<Action>(locality, device_type, required_cl_version));
 
     }
  
     // combine futures
     hpx::lcos::future< std::vector<
-        hpx::lcos::future< std::vector< hpx::opencl::device > >
+        hpx::lcos::future< std::vector< T > >
     > > combined_locality_device_future =
                             hpx::when_all(locality_device_futures);
 
-    // create result future
-    hpx::lcos::future< std::vector< hpx::opencl::device >> result_future =
-        combined_locality_device_future.then( hpx::util::bind(
-             
-            // define combining function inline
-            [] (
-                hpx::lcos::future< std::vector<
-                    hpx::lcos::future< std::vector< hpx::opencl::device > >
-                > > parent_future
-            ) -> std::vector< hpx::opencl::device >
-            {
-                
-                // initialize the result list
-                std::vector< hpx::opencl::device > devices;
-
-                // get vector from parent future
-                std::vector< hpx::lcos::future<
-                        std::vector< hpx::opencl::device > 
-                > > locality_device_futures = parent_future.get();
-
-                // for each future, take devices out and join in one list
-                BOOST_FOREACH(
-                    hpx::lcos::future<std::vector<hpx::opencl::device>> &
-                    locality_device_future,
-                    locality_device_futures)
-                {
-            
-                    // wait for device query to finish
-                    std::vector<hpx::opencl::device> locality_devices = 
-                                                   locality_device_future.get();
-            
-                    // add all devices to device list
-                    devices.insert(devices.end(), locality_devices.begin(),
-                                                  locality_devices.end());
-            
-                }
-
-                return devices;
- 
-            },
+    // return the future to the joined device list
+    return combined_locality_device_future.then(
+                hpx::util::bind(&join_locality_lists<T>,
+                                hpx::util::placeholders::_1));
+
+}
 
-            hpx::util::placeholders::_1
+hpx::lcos::future<std::vector<hpx::opencl::device>>
+hpx::opencl::get_all_devices( cl_device_type device_type,
+                              std::string required_cl_version)
+{
 
-        ));
+    return query_all_localities<hpx::opencl::server::get_devices_action,
+                                hpx::opencl::device>(device_type,
+                                                     required_cl_version);
+
+}
+
+hpx::lcos::future<std::vector<hpx::opencl::device_with_properties>>
+hpx::opencl::get_all_devices_with_properties( cl_device_type device_type,
+                                              std::string required_cl_version)
+{
+
+    return query_all_localities<
+                    hpx::opencl::server::get_devices_with_properties_action,
+                    hpx::opencl::device_with_properties>(device_type,
+                                                         required_cl_version);
+
+}
+
+// Sorts the ranking descending, keeps the original order on equal scores
+static bool
+compare_device_scores(std::pair<double, std::size_t> const& lhs,
+                      std::pair<double, std::size_t> const& rhs)
+{
+    return lhs.first > rhs.first;
+}
+
+// Ranks the devices according to the criteria
+static std::vector<hpx::opencl::device>
+rank_devices(hpx::opencl::device_selection_criteria criteria,
+             hpx::lcos::future<std::vector<hpx::opencl::device_with_properties>>
+                 devices_future)
+{
+
+    std::vector<hpx::opencl::device_with_properties> all_devices =
+                                                        devices_future.get();
+
+    // Filter by the static requirements
+    std::vector<hpx::opencl::device_with_properties> devices;
+    BOOST_FOREACH(hpx::opencl::device_with_properties const& device,
+                  all_devices)
+    {
+        if(device.second.global_mem_size < criteria.min_global_mem_size)
+            continue;
+        if(!device.second.available)
+            continue;
+        devices.push_back(device);
+    }
+
+    // Query the dynamic data of all devices in parallel
+    std::vector<hpx::lcos::future<hpx::naming::id_type>> locality_futures;
+    std::vector<hpx::lcos::future<std::size_t>> load_futures;
+    std::vector<hpx::lcos::future<double>> bandwidth_futures;
+    BOOST_FOREACH(hpx::opencl::device_with_properties const& device, devices)
+    {
+        locality_futures.push_back(
+                        hpx::get_colocation_id(device.first.get_gid()));
+        if(criteria.consider_load)
+            load_futures.push_back(device.first.get_pending_commands());
+        if(criteria.consider_bandwidth)
+            bandwidth_futures.push_back(device.first.measure_bandwidth());
+    }
+
+    // Calculate the scores
+    hpx::naming::id_type here = hpx::find_here();
+    std::vector<std::pair<double, std::size_t>> scores;
+    for(std::size_t i = 0; i < devices.size(); i++)
+    {
+        hpx::opencl::device_properties const& props = devices[i].second;
+
+        // The raw compute power
+        double score = (double)props.max_compute_units
+                     * (double)std::max<cl_uint>(props.max_clock_frequency, 1);
+
+        // More memory allows bigger work packages
+        double mem_gb = (double)props.global_mem_size / (1024.0*1024.0*1024.0);
+        score *= 1.0 + std::log(1.0 + mem_gb) / std::log(2.0);
+
+        // Faster transfers
+        if(criteria.consider_bandwidth)
+        {
+            double bandwidth_gb = bandwidth_futures[i].get()
+                                                    / (1024.0*1024.0*1024.0);
+            score *= 1.0 + std::log(1.0 + bandwidth_gb) / std::log(2.0);
+        }
+
+        // Busy devices
+        if(criteria.consider_load)
+            score /= 1.0 + (double)load_futures[i].get();
+
+        // Local devices
+        if(locality_futures[i].get() == here)
+            score *= criteria.local_preference;
+
+        scores.push_back(std::make_pair(score, i));
+    }
+
+    // Sort
+    std::stable_sort(scores.begin(), scores.end(), &compare_device_scores);
+
+    // Generate the result list
+    std::size_t num_devices = scores.size();
+    if(criteria.max_devices > 0 && criteria.max_devices < num_devices)
+        num_devices = criteria.max_devices;
+
+    std::vector<hpx::opencl::device> result;
+    for(std::size_t i = 0; i < num_devices; i++)
+    {
+        result.push_back(devices[scores[i].second].first);
+    }
+
+    return result;
+
+}
+
+hpx::lcos::future<std::vector<hpx::opencl::device>>
+hpx::opencl::select_devices(
+                    hpx::opencl::device_selection_criteria const& criteria)
+{
 
-    // return the future to the device list
-    return result_future;
+    return get_all_devices_with_properties(criteria.device_type,
+                                           criteria.required_cl_version).then(
+                hpx::util::bind(&rank_devices, criteria,
+                                hpx::util::placeholders::_1));
 
 }
 
@@ -19,12 +19,51 @@
 #include <CL/cl.h>
 
 #include <vector>
+#include <string>
 
 #include "fwd_declarations.hpp"
 
 ////////////////////////////////////////////////////////////////
 namespace hpx { namespace opencl{
 
+    ////////////////////////
+    /// @brief The requirements and ranking options for \ref select_devices.
+    ///
+    struct device_selection_criteria
+    {
+        device_selection_criteria()
+          : device_type(CL_DEVICE_TYPE_ALL),
+            required_cl_version("OpenCL 1.1"),
+            min_global_mem_size(0),
+            max_devices(0),
+            consider_bandwidth(false),
+            consider_load(true),
+            local_preference(2.0)
+        {}
+
+        // The device type, according to OpenCL standard
+        cl_device_type device_type;
+
+        // The minimal OpenCL version, e.g. "OpenCL 1.1"
+        std::string required_cl_version;
+
+        // Devices with less global memory get ignored
+        cl_ulong min_global_mem_size;
+
+        // The maximal number of returned devices, 0 for all
+        std::size_t max_devices;
+
+        // Measure the host-device bandwidth and include it in the ranking.
+        // The measurement is done once per device and cached afterwards.
+        bool consider_bandwidth;
+
+        // Penalize devices with many outstanding commands
+        bool consider_load;
+
+        // Ranking factor for devices on the calling locality
+        double local_preference;
+    };
+
     /**
      * @brief Fetches a list of accelerator devices present on target node.
      *
@@ -77,6 +116,73 @@ namespace hpx { namespace opencl{
     get_all_devices( cl_device_type device_type,
                      std::string required_cl_version );
 
+    /**
+     * @brief Fetches a list of accelerator devices present on target node,
+     *        together with their properties.
+     *
+     * Same as \ref get_devices, but also returns the cached
+     * \ref device_properties of every device, so no further queries are
+     * needed to choose between them.
+     *
+     * @param node_id             The ID of the target node
+     * @param device_type         The device type, see \ref get_devices.
+     * @param required_cl_version The minimal OpenCL version,
+     *                            see \ref get_devices.
+     * @return A list of suitable OpenCL devices on target node
+     */
+    HPX_OPENCL_EXPORT
+    hpx::lcos::future<std::vector<device_with_properties>>
+    get_devices_with_properties( hpx::naming::id_type node_id,
+                                 cl_device_type device_type,
+                                 std::string required_cl_version );
+
+    /**
+     * @brief Fetches a list of all accelerator devices present in the current
+     *        hpx environment, together with their properties.
+     *
+     * Same as \ref get_all_devices, but also returns the cached
+     * \ref device_properties of every device.<BR>
+     * All localities get queried in parallel and the results get gathered
+     * in a single step.
+     *
+     * @param device_type         The device type, see \ref get_devices.
+     * @param required_cl_version The minimal OpenCL version,
+     *                            see \ref get_devices.
+     * @return A list of suitable OpenCL devices
+     */
+    HPX_OPENCL_EXPORT
+    hpx::lcos::future<std::vector<device_with_properties>>
+    get_all_devices_with_properties( cl_device_type device_type,
+                                     std::string required_cl_version );
+
+    /**
+     * @brief Fetches a ranked list of all suitable accelerator devices
+     *        present in the current hpx environment.
+     *
+     * The devices get ranked by their compute units, clock frequency,
+     * global memory, optionally measured bandwidth and their current
+     * number of outstanding commands. Devices on the calling locality
+     * get preferred.
+     *
+     * Example:
+     * \code{.cpp}
+     *     hpx::opencl::device_selection_criteria criteria;
+     *     criteria.device_type = CL_DEVICE_TYPE_GPU;
+     *     criteria.max_devices = 2;
+     *
+     *     // the two fastest gpus
+     *     std::vector<hpx::opencl::device> devices =
+     *                          hpx::opencl::select_devices(criteria).get();
+     * \endcode
+     *
+     * @param criteria            The requirements and ranking options.
+     * @return A list of suitable OpenCL devices, the fastest first
+     */
+    HPX_OPENCL_EXPORT
+    hpx::lcos::future<std::vector<device>>
+    select_devices( device_selection_criteria const& criteria =
+                                            device_selection_criteria() );
+
 }}
 
 
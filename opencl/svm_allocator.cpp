@@ -0,0 +1,84 @@
+// Copyright (c)    2014 Martin Stumpf
+//
+// Distributed under the Boost Software License, Version 1.0. (See accompanying
+// file LICENSE_1_0.txt or copy at http://www.boost.org/LICENSE_1_0.txt)
+
+#include "svm_allocator.hpp"
+
+#include <hpx/runtime/get_ptr.hpp>
+
+#include "tools.hpp"
+
+#ifdef CL_VERSION_2_0
+
+typedef boost::shared_ptr<hpx::opencl::server::device> device_ptr;
+
+///////////////////////////////////////////////////
+/// Implementations
+///
+
+device_ptr
+hpx::opencl::detail::get_svm_device(hpx::opencl::device const& device)
+{
+
+    BOOST_ASSERT(device.get_gid());
+
+    // The pointers are only valid within this process
+    if(!hpx::opencl::is_local(device.get_gid()))
+    {
+        HPX_THROW_EXCEPTION(hpx::bad_parameter,
+                            "svm_allocator()",
+                            "Device needs to be on this locality!");
+    }
+
+    return hpx::get_ptr<hpx::opencl::server::device>(device.get_gid()).get();
+
+}
+
+void*
+hpx::opencl::detail::svm_alloc(device_ptr device, size_t size,
+                               size_t alignment)
+{
+
+    return device->svm_alloc(size, alignment);
+
+}
+
+void
+hpx::opencl::detail::svm_free(device_ptr device, void* ptr)
+{
+
+    device->svm_free(ptr);
+
+}
+
+bool
+hpx::opencl::detail::svm_is_fine_grain(device_ptr device)
+{
+
+    return device->is_svm_fine_grain();
+
+}
+
+hpx::lcos::future<hpx::opencl::event>
+hpx::opencl::detail::svm_map(device_ptr device, void* ptr, size_t size,
+                             cl_map_flags flags,
+                             std::vector<hpx::opencl::event> const& events)
+{
+
+    return hpx::lcos::make_ready_future(
+                    device->enqueue_svm_map(ptr, size, flags, events));
+
+}
+
+hpx::lcos::future<hpx::opencl::event>
+hpx::opencl::detail::svm_unmap(device_ptr device, void* ptr,
+                               std::vector<hpx::opencl::event> const& events)
+{
+
+    return hpx::lcos::make_ready_future(
+                    device->enqueue_svm_unmap(ptr, events));
+
+}
+
+#endif
@@ -0,0 +1,213 @@
+// Copyright (c)    2014 Martin Stumpf
+//
+// Distributed under the Boost Software License, Version 1.0. (See accompanying
+// file LICENSE_1_0.txt or copy at http://www.boost.org/LICENSE_1_0.txt)
+
+#pragma once
+#ifndef HPX_OPENCL_SVM_ALLOCATOR_HPP_
+#define HPX_OPENCL_SVM_ALLOCATOR_HPP_
+
+#include "export_definitions.hpp"
+
+#include <hpx/hpx.hpp>
+#include <hpx/config.hpp>
+#include <hpx/lcos/future.hpp>
+
+#include <CL/cl.h>
+
+#include <boost/shared_ptr.hpp>
+
+#include <vector>
+
+#include "device.hpp"
+#include "event.hpp"
+
+#ifdef CL_VERSION_2_0
+
+namespace hpx {
+namespace opencl {
+
+    namespace detail
+    {
+        // The server of a device on this locality
+        HPX_OPENCL_EXPORT boost::shared_ptr<hpx::opencl::server::device>
+        get_svm_device(hpx::opencl::device const& device);
+
+        HPX_OPENCL_EXPORT void*
+        svm_alloc(boost::shared_ptr<hpx::opencl::server::device> device,
+                  size_t size, size_t alignment);
+
+        HPX_OPENCL_EXPORT void
+        svm_free(boost::shared_ptr<hpx::opencl::server::device> device,
+                 void* ptr);
+
+        HPX_OPENCL_EXPORT bool
+        svm_is_fine_grain(boost::shared_ptr<hpx::opencl::server::device>
+                                                                    device);
+
+        HPX_OPENCL_EXPORT hpx::lcos::future<hpx::opencl::event>
+        svm_map(boost::shared_ptr<hpx::opencl::server::device> device,
+                void* ptr, size_t size, cl_map_flags flags,
+                std::vector<hpx::opencl::event> const& events);
+
+        HPX_OPENCL_EXPORT hpx::lcos::future<hpx::opencl::event>
+        svm_unmap(boost::shared_ptr<hpx::opencl::server::device> device,
+                  void* ptr, std::vector<hpx::opencl::event> const& events);
+    }
+
+    //////////////////////////////////////
+    /// @brief An allocator for OpenCL 2.0 shared virtual memory.
+    ///
+    /// The memory can be passed to kernels via \ref kernel::set_arg_svm
+    /// without copying it into a \ref buffer.
+    ///
+    /// Fine-grain memory gets used if CL_DEVICE_SVM_CAPABILITIES of the
+    /// device allow it, and can then be accessed by the host at any time.
+    /// Coarse-grain memory needs to be mapped before the host accesses it
+    /// and unmapped before a kernel uses it again.
+    ///
+    /// SVM pointers are only valid within one process, so the device has
+    /// to be on the current locality.
+    ///
+    /// Example:
+    /// \code{.cpp}
+    ///     hpx::opencl::svm_allocator<int> alloc(device);
+    ///     int* data = alloc.allocate(size);
+    ///
+    ///     alloc.map(data, size, CL_MAP_WRITE).get().await();
+    ///     fill(data, size);
+    ///     hpx::opencl::event unmapped = alloc.unmap(data).get();
+    ///
+    ///     kernel.set_arg_svm(0, data);
+    ///     hpx::opencl::event done = kernel.enqueue(dim, unmapped).get();
+    ///
+    ///     alloc.map(data, size, CL_MAP_READ, done).get().await();
+    /// \endcode
+    ///
+    template<typename T>
+    class svm_allocator
+    {
+        public:
+            typedef T value_type;
+
+            /**
+             *  @brief Creates an allocator for a device
+             *
+             *  @param device   A device on this locality that supports
+             *                  shared virtual memory.
+             */
+            explicit svm_allocator(hpx::opencl::device const& device)
+                : device_server(detail::get_svm_device(device))
+            {}
+
+            template<typename U>
+            svm_allocator(svm_allocator<U> const& other)
+                : device_server(other.get_device_server())
+            {}
+
+            /**
+             *  @brief Allocates memory for n elements of type T
+             */
+            T* allocate(size_t n)
+            {
+                return static_cast<T*>(detail::svm_alloc(device_server,
+                                                         n * sizeof(T),
+                                                         alignof(T)));
+            }
+
+            /**
+             *  @brief Frees memory from \ref allocate
+             *
+             *  Doesn't block. The memory gets freed once all commands
+             *  that were enqueued on the device before completed, so
+             *  kernels that still use it are safe.<BR>
+             *  Commands of other devices are not waited for, they need
+             *  to be done before the call.
+             */
+            void deallocate(T* p, size_t)
+            {
+                detail::svm_free(device_server, p);
+            }
+
+            /**
+             *  @brief Whether the memory is fine-grain
+             *
+             *  Fine-grain memory does not need \ref map and \ref unmap.
+             */
+            bool is_fine_grain() const
+            {
+                return detail::svm_is_fine_grain(device_server);
+            }
+
+            /**
+             *  @brief Makes memory accessible to the host
+             *
+             *  For fine-grain memory, only waits for the events.
+             *
+             *  @param p        Memory from \ref allocate.
+             *  @param n        The number of elements to map.
+             *  @param flags    CL_MAP_READ and/or CL_MAP_WRITE.
+             *  @param events   The events to wait for.
+             *  @return         An event that triggers when the host may
+             *                  access the memory.
+             */
+            hpx::lcos::future<hpx::opencl::event>
+            map(T* p, size_t n, cl_map_flags flags = CL_MAP_READ|CL_MAP_WRITE,
+                std::vector<hpx::opencl::event> const& events =
+                                    std::vector<hpx::opencl::event>()) const
+            {
+                return detail::svm_map(device_server, p, n * sizeof(T),
+                                       flags, events);
+            }
+
+            hpx::lcos::future<hpx::opencl::event>
+            map(T* p, size_t n, cl_map_flags flags,
+                hpx::opencl::event const& event) const
+            {
+                return map(p, n, flags,
+                           std::vector<hpx::opencl::event>(1, event));
+            }
+
+            /**
+             *  @brief Gives mapped memory back to the device
+             *
+             *  @param p        Memory from \ref map.
+             *  @param events   The events to wait for.
+             *  @return         An event that triggers when kernels may
+             *                  access the memory.
+             */
+            hpx::lcos::future<hpx::opencl::event>
+            unmap(T* p, std::vector<hpx::opencl::event> const& events =
+                                    std::vector<hpx::opencl::event>()) const
+            {
+                return detail::svm_unmap(device_server, p, events);
+            }
+
+            boost::shared_ptr<hpx::opencl::server::device>
+            get_device_server() const
+            {
+                return device_server;
+            }
+
+        private:
+            boost::shared_ptr<hpx::opencl::server::device> device_server;
+
+    };
+
+    template<typename T, typename U>
+    bool operator==(svm_allocator<T> const& a, svm_allocator<U> const& b)
+    {
+        return a.get_device_server() == b.get_device_server();
+    }
+
+    template<typename T, typename U>
+    bool operator!=(svm_allocator<T> const& a, svm_allocator<U> const& b)
+    {
+        return !(a == b);
+    }
+
+}}
+
+#endif
+
+#endif
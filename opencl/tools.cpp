@@ -80,4 +80,68 @@ const char* cl_err_to_str(cl_int errCode)
 }
 
 
+std::vector<int>
+parse_version_string(std::string version_str)
+{
+
+    try{
+       
+        // Make sure the version string starts with "OpenCL "
+        BOOST_ASSERT(version_str.compare(0, 7, "OpenCL ") == 0);
+
+        // Cut away the "OpenCL " in front of the version string
+        version_str = version_str.substr(7);
+    
+        // Cut away everything behind the version number
+        version_str = version_str.substr(0, version_str.find(" "));
+        
+        // Get major version string
+        std::string version_str_major = 
+                           version_str.substr(0, version_str.find("."));
+
+        // Get minor version string
+        std::string version_str_minor = 
+                           version_str.substr(version_str_major.size() + 1);
+
+        // create output vector
+        std::vector<int> version_numbers(2);
+
+        // Parse version number
+        version_numbers[0] = ::atoi(version_str_major.c_str());
+        version_numbers[1] = ::atoi(version_str_minor.c_str());
+
+        // Return the parsed version number
+        return version_numbers;
+
+    } catch (const std::exception &) {
+        hpx::cerr << "Error while parsing OpenCL Version!" << hpx::endl;
+        std::vector<int> version_numbers(2);
+        version_numbers[0] = -1;
+        version_numbers[1] = 0;
+        return version_numbers;
+    }
+
+}
+
+bool is_version_supported(int version_major, int version_minor,
+                          std::vector<int> const& required_version)
+{
+    if(version_major < required_version[0]) return false;
+    if(version_major == required_version[0])
+    {
+        if(version_minor < required_version[1]) return false;
+    }
+
+    return true;
+}
+
+bool is_local(hpx::naming::id_type const& id)
+{
+    // Components don't migrate, so the locality that created the
+    // component is the one it lives on. No AGAS round trip needed.
+    return hpx::naming::get_locality_id_from_gid(id.get_gid())
+                                                == hpx::get_locality_id();
+}
+
+
 }}
@@ -9,6 +9,8 @@
 
 #include <CL/cl.h>
 #include <sstream>
+#include <string>
+#include <vector>
 
 #include <hpx/hpx.hpp>
 #include <hpx/config.hpp>
@@ -60,6 +62,18 @@ namespace hpx { namespace opencl {
     // Translates CL errorcode to descriptive string
     const char* cl_err_to_str(cl_int errCode);
 
+    // Parses an OpenCL version string ("OpenCL <major>.<minor> ...").
+    // Returns {major, minor}, major is -1 if the string is not parsable.
+    std::vector<int> parse_version_string(std::string version_str);
+
+    // Checks whether a parsed version is at least the required version
+    bool is_version_supported(int version_major, int version_minor,
+                              std::vector<int> const& required_version);
+
+    // Checks whether a component lives on the current locality.
+    // Doesn't block, the locality is encoded in the gid of the component.
+    bool is_local(hpx::naming::id_type const& id);
+
 }}
 
 #endif//HPX_OPENCL_TOOLS_HPP_
@@ -0,0 +1,370 @@
+// Copyright (c)    2014 Martin Stumpf
+//
+// Distributed under the Boost Software License, Version 1.0. (See accompanying
+// file LICENSE_1_0.txt or copy at http://www.boost.org/LICENSE_1_0.txt)
+
+#pragma once
+#ifndef HPX_OPENCL_TYPED_BUFFER_HPP_
+#define HPX_OPENCL_TYPED_BUFFER_HPP_
+
+#include <hpx/hpx.hpp>
+#include <hpx/config.hpp>
+#include <hpx/lcos/future.hpp>
+#include <hpx/util/serialize_buffer.hpp>
+
+#include <CL/cl.h>
+
+#include <algorithm>
+#include <iterator>
+#include <vector>
+
+#include "buffer.hpp"
+#include "device.hpp"
+#include "event.hpp"
+
+namespace hpx {
+namespace opencl {
+
+    //////////////////////////////////////
+    /// @brief Device memory of elements of type T.
+    ///
+    /// A thin wrapper around \ref buffer. Offsets and sizes are given in
+    /// elements, data gets passed as T, and reads return
+    /// hpx::util::serialize_buffer<T>.
+    ///
+    /// Converts implicitly to \ref buffer, e.g. for kernel arguments.
+    ///
+    /// Example:
+    /// \code{.cpp}
+    ///     hpx::opencl::typed_buffer<float> buf =
+    ///         hpx::opencl::create_typed_buffer<float>(device,
+    ///                                                 CL_MEM_READ_WRITE, 1024);
+    ///
+    ///     buf.enqueue_write(0, input.size(), input.data()).get().await();
+    ///     kernel.set_arg(0, buf);
+    ///
+    ///     hpx::util::serialize_buffer<float> result =
+    ///                                    buf.enqueue_read(0, 1024).get();
+    /// \endcode
+    ///
+    template <typename T>
+    class typed_buffer
+    {
+
+        public:
+            typedef T value_type;
+
+            // Empty constructor, necessary for hpx purposes
+            typed_buffer(){}
+
+            /**
+             *  @brief Wraps an untyped buffer
+             */
+            explicit typed_buffer(hpx::opencl::buffer buffer_)
+              : buffer(buffer_)
+            {}
+
+            /**
+             *  @brief Returns the untyped buffer
+             */
+            hpx::opencl::buffer get_buffer() const
+            {
+                return buffer;
+            }
+
+            operator hpx::opencl::buffer() const
+            {
+                return buffer;
+            }
+
+            /**
+             *  @brief Get the number of elements of the buffer
+             */
+            hpx::lcos::future<size_t>
+            size() const
+            {
+                return buffer.size().then(
+                            hpx::util::bind(&typed_buffer::size_callback,
+                                            hpx::util::placeholders::_1));
+            }
+
+            /**
+             *  @name Writes elements to the buffer
+             *
+             *  Same as \ref buffer::enqueue_write, data needs to stay valid
+             *  until the write completed.
+             *
+             *  @param offset   The index of the first element to write.
+             *  @param count    The number of elements.
+             *  @param data     The elements.
+             *  @param events   Optional, the events to wait for. All types
+             *                  of \ref buffer::enqueue_write are accepted.
+             *  @return         An \ref event that triggers upon completion.
+             */
+            //@{
+            hpx::lcos::future<hpx::opencl::event>
+            enqueue_write(size_t offset, size_t count, const T* data) const
+            {
+                return buffer.enqueue_write(offset * sizeof(T),
+                                            count * sizeof(T), data);
+            }
+
+            template <typename Events>
+            hpx::lcos::future<hpx::opencl::event>
+            enqueue_write(size_t offset, size_t count, const T* data,
+                          Events events) const
+            {
+                return buffer.enqueue_write(offset * sizeof(T),
+                                            count * sizeof(T), data, events);
+            }
+            //@}
+
+            /**
+             *  @name Writes a range of values to the buffer
+             *
+             *  The values get packed into a temporary array of T first,
+             *  so the range may be non-contiguous and of a different type
+             *  that converts to T. The range needs to stay valid only
+             *  until this function returned.
+             *
+             *  @param offset   The index of the first element to write.
+             *  @param first    The begin of the range.
+             *  @param last     The end of the range.
+             *  @param events   Optional, the events to wait for.
+             *  @return         An \ref event that triggers upon completion.
+             */
+            //@{
+            template <typename Iterator>
+            hpx::lcos::future<hpx::opencl::event>
+            enqueue_write_range(size_t offset, Iterator first,
+                                Iterator last) const
+            {
+                return enqueue_write_range(offset, first, last,
+                                        std::vector<hpx::opencl::event>());
+            }
+
+            template <typename Iterator, typename Events>
+            hpx::lcos::future<hpx::opencl::event>
+            enqueue_write_range(size_t offset, Iterator first, Iterator last,
+                                Events events) const
+            {
+                size_t count = std::distance(first, last);
+                hpx::util::serialize_buffer<T> packed = allocate(count);
+                std::copy(first, last, packed.data());
+
+                return buffer.enqueue_write(offset * sizeof(T),
+                                            count * sizeof(T), packed.data(),
+                                            events)
+                    .then(hpx::util::bind(
+                            &typed_buffer::packed_write_callback,
+                            packed,
+                            hpx::util::placeholders::_1));
+            }
+            //@}
+
+            /**
+             *  @name Reads elements from the buffer
+             *
+             *  If the buffer lives on the current locality, the device
+             *  writes directly to the returned array.
+             *
+             *  @param offset   The index of the first element to read.
+             *  @param count    The number of elements.
+             *  @param events   Optional, the events to wait for. An \ref event
+             *                  or any type of \ref buffer::enqueue_read_to.
+             *  @return         The elements.
+             */
+            //@{
+            hpx::lcos::future<hpx::util::serialize_buffer<T> >
+            enqueue_read(size_t offset, size_t count) const
+            {
+                return enqueue_read(offset, count,
+                                    std::vector<hpx::opencl::event>());
+            }
+
+            template <typename Events>
+            hpx::lcos::future<hpx::util::serialize_buffer<T> >
+            enqueue_read(size_t offset, size_t count, Events events) const
+            {
+                hpx::util::serialize_buffer<T> data = allocate(count);
+
+                return buffer.enqueue_read_to(offset * sizeof(T),
+                                              count * sizeof(T), data.data(),
+                                              events)
+                    .then(hpx::util::bind(&typed_buffer::read_callback,
+                                          data,
+                                          hpx::util::placeholders::_1));
+            }
+
+            hpx::lcos::future<hpx::util::serialize_buffer<T> >
+            enqueue_read(size_t offset, size_t count,
+                         hpx::opencl::event event) const
+            {
+                return enqueue_read(offset, count,
+                                    std::vector<hpx::opencl::event>(1, event));
+            }
+            //@}
+
+            /**
+             *  @name Reads elements from the buffer into host memory
+             *
+             *  Same as \ref buffer::enqueue_read_to.
+             *
+             *  @param offset   The index of the first element to read.
+             *  @param count    The number of elements.
+             *  @param dst      The destination, needs to stay valid until
+             *                  the returned future triggered.
+             *  @param events   Optional, the events to wait for.
+             *  @return         A future that triggers as soon as the data
+             *                  arrived in dst.
+             */
+            //@{
+            hpx::lcos::future<void>
+            enqueue_read_to(size_t offset, size_t count, T* dst) const
+            {
+                return buffer.enqueue_read_to(offset * sizeof(T),
+                                              count * sizeof(T), dst);
+            }
+
+            template <typename Events>
+            hpx::lcos::future<void>
+            enqueue_read_to(size_t offset, size_t count, T* dst,
+                            Events events) const
+            {
+                return buffer.enqueue_read_to(offset * sizeof(T),
+                                              count * sizeof(T), dst, events);
+            }
+
+            hpx::lcos::future<void>
+            enqueue_read_to(size_t offset, size_t count, T* dst,
+                            hpx::opencl::event event) const
+            {
+                return enqueue_read_to(offset, count, dst,
+                                    std::vector<hpx::opencl::event>(1, event));
+            }
+            //@}
+
+            /**
+             *  @name Copies elements from another buffer of the same type
+             *
+             *  @param src          The source buffer.
+             *  @param src_offset   The index of the first element to copy.
+             *  @param dst_offset   The index of the first element in this
+             *                      buffer.
+             *  @param count        The number of elements.
+             *  @param events       Optional, the events to wait for.
+             *  @return             An \ref event that triggers upon
+             *                      completion.
+             */
+            //@{
+            hpx::lcos::future<hpx::opencl::event>
+            enqueue_copy(typed_buffer<T> src, size_t src_offset,
+                         size_t dst_offset, size_t count) const
+            {
+                return buffer.enqueue_copy(src.get_buffer(),
+                                           src_offset * sizeof(T),
+                                           dst_offset * sizeof(T),
+                                           count * sizeof(T));
+            }
+
+            template <typename Events>
+            hpx::lcos::future<hpx::opencl::event>
+            enqueue_copy(typed_buffer<T> src, size_t src_offset,
+                         size_t dst_offset, size_t count, Events events) const
+            {
+                return buffer.enqueue_copy(src.get_buffer(),
+                                           src_offset * sizeof(T),
+                                           dst_offset * sizeof(T),
+                                           count * sizeof(T), events);
+            }
+            //@}
+
+        private:
+            // An array of T that gets deleted with the last copy
+            static hpx::util::serialize_buffer<T> allocate(size_t count)
+            {
+                return hpx::util::serialize_buffer<T>(new T[count], count,
+                            hpx::util::serialize_buffer<T>::init_mode::take);
+            }
+
+            static size_t size_callback(hpx::lcos::future<size_t> bytes)
+            {
+                return bytes.get() / sizeof(T);
+            }
+
+            static hpx::util::serialize_buffer<T>
+            read_callback(hpx::util::serialize_buffer<T> data,
+                          hpx::lcos::future<void> read_future)
+            {
+                // Rethrows OpenCL errors
+                read_future.get();
+
+                return data;
+            }
+
+            // Keeps the packed data alive until the write completed
+            static void
+            release_packed_callback(hpx::util::serialize_buffer<T>,
+                                    hpx::lcos::future<void>)
+            {
+            }
+
+            static hpx::opencl::event
+            packed_write_callback(hpx::util::serialize_buffer<T> data,
+                             hpx::lcos::future<hpx::opencl::event> write_event)
+            {
+                hpx::opencl::event event = write_event.get();
+
+                event.get_future().then(
+                        hpx::util::bind(&typed_buffer::release_packed_callback,
+                                        data,
+                                        hpx::util::placeholders::_1));
+
+                return event;
+            }
+
+        private:
+            hpx::opencl::buffer buffer;
+
+    };
+
+    /**
+     *  @brief Creates a typed buffer
+     *
+     *  @tparam T       The element type.
+     *  @param device   The device.
+     *  @param flags    The flags, see \ref device::create_buffer.
+     *  @param count    The number of elements.
+     */
+    template <typename T>
+    typed_buffer<T>
+    create_typed_buffer(hpx::opencl::device device, cl_mem_flags flags,
+                        size_t count)
+    {
+        return typed_buffer<T>(device.create_buffer(flags, count * sizeof(T)));
+    }
+
+    /**
+     *  @brief Creates a typed buffer and initializes it
+     *
+     *  The data needs to stay valid until the buffer got created, see
+     *  \ref device::create_buffer.
+     *
+     *  @tparam T       The element type.
+     *  @param device   The device.
+     *  @param flags    The flags, see \ref device::create_buffer.
+     *  @param count    The number of elements.
+     *  @param data     The initial elements.
+     */
+    template <typename T>
+    typed_buffer<T>
+    create_typed_buffer(hpx::opencl::device device, cl_mem_flags flags,
+                        size_t count, const T* data)
+    {
+        return typed_buffer<T>(device.create_buffer(flags, count * sizeof(T),
+                                                    data));
+    }
+
+}}
+
+#endif
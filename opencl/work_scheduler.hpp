@@ -0,0 +1,501 @@
+// Copyright (c)    2014 Martin Stumpf
+//
+// Distributed under the Boost Software License, Version 1.0. (See accompanying
+// file LICENSE_1_0.txt or copy at http://www.boost.org/LICENSE_1_0.txt)
+
+#pragma once
+#ifndef HPX_OPENCL_WORK_SCHEDULER_HPP_
+#define HPX_OPENCL_WORK_SCHEDULER_HPP_
+
+#include <hpx/hpx.hpp>
+#include <hpx/config.hpp>
+#include <hpx/lcos/local/spinlock.hpp>
+#include <hpx/lcos/local/condition_variable.hpp>
+#include <hpx/util/high_resolution_clock.hpp>
+
+#include <boost/atomic.hpp>
+#include <boost/shared_ptr.hpp>
+#include <boost/make_shared.hpp>
+
+#include <deque>
+#include <vector>
+
+namespace hpx {
+namespace opencl {
+
+    ////////////////////////
+    /// @brief A work stealing scheduler for distributing work items
+    ///        between devices.
+    ///
+    /// Every worker (usually one per device) owns a work deque.
+    /// New work gets added to the worker with the lowest estimated finishing
+    /// time. Idle workers steal from the other workers, workers on the same
+    /// locality first. The amount of stolen work is proportional to the
+    /// measured throughput of thief and victim, so fast and slow devices
+    /// finish at the same time.
+    ///
+    /// Example:
+    /// \code{.cpp}
+    ///     hpx::opencl::work_scheduler<workload> scheduler;
+    ///
+    ///     // one worker per device
+    ///     std::size_t worker_id = scheduler.add_worker(
+    ///                         hpx::get_colocation_id(device.get_gid()).get());
+    ///
+    ///     // worker loop
+    ///     workload item;
+    ///     while(scheduler.request(worker_id, &item))
+    ///     {
+    ///         compute(item);
+    ///         scheduler.work_done(worker_id);
+    ///     }
+    /// \endcode
+    ///
+    template <typename T>
+    class work_scheduler
+    {
+
+        typedef hpx::lcos::local::spinlock lock_type;
+        typedef hpx::lcos::local::condition_variable cond_type;
+
+        public:
+            /**
+             *  @brief Creates an empty scheduler
+             *
+             *  @param max_workers  The maximal number of workers.
+             */
+            work_scheduler(std::size_t max_workers = 256);
+
+            ~work_scheduler();
+
+            /**
+             *  @brief Registers a new worker
+             *
+             *  Can be called while the scheduler is running.
+             *
+             *  @param locality     The locality of the worker's device.
+             *                      Used for locality-first stealing.
+             *  @return The id of the worker.
+             */
+            std::size_t add_worker(hpx::naming::id_type locality);
+
+            /**
+             *  @brief Adds a work item
+             *
+             *  The item gets queued at the worker with the lowest
+             *  estimated finishing time.
+             *
+             *  Calling this function after finish() will lead to
+             *  undefined behaviour.
+             *
+             *  @param item     The work item
+             */
+            void add_work(const T & item);
+
+            /**
+             *  @brief Retrieves a work item for a worker
+             *
+             *  Takes work from the worker's own deque. If it is empty,
+             *  steals work from other workers. Blocks if no work is
+             *  available.
+             *
+             *  @param worker   The id of the requesting worker
+             *  @param item     Returns the work item
+             *  @return False on end of work
+             */
+            bool request(std::size_t worker, T* item);
+
+            /**
+             *  @brief Reports a finished work item
+             *
+             *  Used to measure the throughput of the worker.
+             *
+             *  @param worker   The id of the worker
+             */
+            void work_done(std::size_t worker);
+
+            /**
+             *  @brief Signals that no more work will be added
+             *
+             *  All blocked requests return false as soon as all queues
+             *  are empty.
+             */
+            void finish();
+
+            /**
+             *  @brief Returns the measured throughput of a worker
+             *
+             *  @param worker   The id of the worker
+             *  @return         Finished work items per second,
+             *                  0 if nothing is finished yet.
+             */
+            double get_throughput(std::size_t worker);
+
+        private:
+            // The per-worker state
+            struct worker_queue
+            {
+                worker_queue(hpx::naming::id_type locality_)
+                  : locality(locality_), size(0), completed(0), start_time(0)
+                {}
+
+                hpx::naming::id_type locality;
+
+                std::deque<T> items;
+                lock_type lock;
+
+                // approximate size of items, readable without lock
+                boost::atomic<std::size_t> size;
+
+                // throughput measurement
+                boost::atomic<std::size_t> completed;
+                boost::atomic<boost::uint64_t> start_time;
+            };
+            typedef boost::shared_ptr<worker_queue> worker_queue_ptr;
+
+        private:
+            // Returns the throughput of a worker. Unmeasured workers
+            // get the default throughput.
+            double estimated_throughput(std::size_t worker,
+                                        double default_throughput);
+
+            // The mean throughput of all measured workers, 1 if none
+            double mean_throughput(std::size_t num_workers_);
+
+            // Takes the first item of the worker's deque
+            bool pop_local(worker_queue & queue, T* item);
+
+            // Steals a chunk of work from another worker
+            bool steal(std::size_t worker, T* item);
+
+            // Moves a chunk from the back of the victim to the thief
+            bool steal_from(std::size_t thief, std::size_t victim, T* item);
+
+        private:
+            // Fixed-size worker list, so it can be read without lock.
+            // Only the first num_workers entries are valid.
+            std::vector<worker_queue_ptr> workers;
+            boost::atomic<std::size_t> num_workers;
+            lock_type add_worker_lock;
+
+            // Number of items in all queues
+            boost::atomic<std::size_t> total_items;
+
+            // Sleeping workers, only used if no work is available
+            lock_type sleep_lock;
+            cond_type sleep_cond;
+            std::size_t num_sleeping;
+
+            boost::atomic<bool> finished;
+
+    };
+
+
+    template <typename T>
+    work_scheduler<T>::work_scheduler(std::size_t max_workers)
+      : workers(max_workers), num_workers(0), total_items(0),
+        num_sleeping(0), finished(false)
+    {}
+
+    template <typename T>
+    work_scheduler<T>::~work_scheduler()
+    {
+        finish();
+    }
+
+    template <typename T>
+    std::size_t
+    work_scheduler<T>::add_worker(hpx::naming::id_type locality)
+    {
+
+        boost::lock_guard<lock_type> lock(add_worker_lock);
+
+        std::size_t id = num_workers.load();
+        if(id >= workers.size())
+        {
+            HPX_THROW_EXCEPTION(hpx::bad_parameter,
+                                "work_scheduler::add_worker()",
+                                "Maximal number of workers reached!");
+        }
+
+        // Publish the new worker
+        workers[id] = boost::make_shared<worker_queue>(locality);
+        num_workers.store(id + 1, boost::memory_order_release);
+
+        return id;
+
+    }
+
+    template <typename T>
+    double
+    work_scheduler<T>::get_throughput(std::size_t worker)
+    {
+
+        worker_queue & queue = *workers[worker];
+
+        boost::uint64_t start = queue.start_time.load();
+        std::size_t completed = queue.completed.load();
+        if(start == 0 || completed == 0)
+            return 0.0;
+
+        boost::uint64_t now = hpx::util::high_resolution_clock::now();
+        if(now <= start)
+            return 0.0;
+
+        return completed * 1e9 / (double)(now - start);
+
+    }
+
+    template <typename T>
+    double
+    work_scheduler<T>::estimated_throughput(std::size_t worker,
+                                            double default_throughput)
+    {
+
+        double throughput = get_throughput(worker);
+        if(throughput <= 0.0)
+            return default_throughput;
+        return throughput;
+
+    }
+
+    template <typename T>
+    double
+    work_scheduler<T>::mean_throughput(std::size_t num_workers_)
+    {
+
+        double sum = 0.0;
+        std::size_t num_measured = 0;
+        for(std::size_t i = 0; i < num_workers_; i++)
+        {
+            double throughput = get_throughput(i);
+            if(throughput <= 0.0)
+                continue;
+            sum += throughput;
+            num_measured++;
+        }
+
+        if(num_measured == 0)
+            return 1.0;
+
+        return sum / num_measured;
+
+    }
+
+    template <typename T>
+    void
+    work_scheduler<T>::add_work(const T & item)
+    {
+
+        BOOST_ASSERT(!finished);
+
+        std::size_t num_workers_ = num_workers.load(boost::memory_order_acquire);
+        if(num_workers_ == 0)
+        {
+            HPX_THROW_EXCEPTION(hpx::invalid_status,
+                                "work_scheduler::add_work()",
+                                "No workers registered!");
+        }
+
+        // Find the worker with the lowest estimated finishing time
+        double default_throughput = mean_throughput(num_workers_);
+        std::size_t target = 0;
+        double target_time = 0.0;
+        for(std::size_t i = 0; i < num_workers_; i++)
+        {
+            double time = (workers[i]->size.load() + 1)
+                        / estimated_throughput(i, default_throughput);
+            if(i == 0 || time < target_time)
+            {
+                target = i;
+                target_time = time;
+            }
+        }
+
+        // Queue the item
+        {
+            worker_queue & queue = *workers[target];
+            boost::lock_guard<lock_type> lock(queue.lock);
+            queue.items.push_back(item);
+            queue.size++;
+        }
+        total_items++;
+
+        // Wake up a sleeping worker
+        boost::lock_guard<lock_type> lock(sleep_lock);
+        if(num_sleeping > 0)
+            sleep_cond.notify_one();
+
+    }
+
+    template <typename T>
+    bool
+    work_scheduler<T>::pop_local(worker_queue & queue, T* item)
+    {
+
+        boost::lock_guard<lock_type> lock(queue.lock);
+        if(queue.items.empty())
+            return false;
+
+        *item = queue.items.front();
+        queue.items.pop_front();
+        queue.size--;
+        return true;
+
+    }
+
+    template <typename T>
+    bool
+    work_scheduler<T>::steal_from(std::size_t thief, std::size_t victim,
+                                  T* item)
+    {
+
+        worker_queue & thief_queue = *workers[thief];
+        worker_queue & victim_queue = *workers[victim];
+
+        // Estimate the fair share of the thief
+        std::size_t num_workers_ = num_workers.load(boost::memory_order_acquire);
+        double default_throughput = mean_throughput(num_workers_);
+        double thief_throughput = estimated_throughput(thief,
+                                                       default_throughput);
+        double victim_throughput = estimated_throughput(victim,
+                                                        default_throughput);
+
+        std::vector<T> stolen;
+        {
+            boost::lock_guard<lock_type> lock(victim_queue.lock);
+            std::size_t victim_size = victim_queue.items.size();
+            if(victim_size == 0)
+                return false;
+
+            std::size_t chunk = (std::size_t)(victim_size * thief_throughput
+                                   / (thief_throughput + victim_throughput));
+            if(chunk < 1) chunk = 1;
+            if(chunk > victim_size) chunk = victim_size;
+
+            // Take from the back, the victim keeps working on the front
+            for(std::size_t i = 0; i < chunk; i++)
+            {
+                stolen.push_back(victim_queue.items.back());
+                victim_queue.items.pop_back();
+            }
+            victim_queue.size -= chunk;
+        }
+
+        // Keep the first item, queue the rest locally
+        *item = stolen.back();
+        stolen.pop_back();
+        if(!stolen.empty())
+        {
+            boost::lock_guard<lock_type> lock(thief_queue.lock);
+            thief_queue.items.insert(thief_queue.items.end(),
+                                     stolen.rbegin(), stolen.rend());
+            thief_queue.size += stolen.size();
+        }
+
+        return true;
+
+    }
+
+    template <typename T>
+    bool
+    work_scheduler<T>::steal(std::size_t worker, T* item)
+    {
+
+        std::size_t num_workers_ = num_workers.load(boost::memory_order_acquire);
+        hpx::naming::id_type const& locality = workers[worker]->locality;
+
+        // Two passes: workers on the same locality first, then all others
+        for(int pass = 0; pass < 2; pass++)
+        {
+            bool local_pass = (pass == 0);
+
+            // Try the fullest victim first
+            std::size_t victim = num_workers_;
+            std::size_t victim_size = 0;
+            for(std::size_t i = 0; i < num_workers_; i++)
+            {
+                if(i == worker) continue;
+                if((workers[i]->locality == locality) != local_pass) continue;
+
+                std::size_t size = workers[i]->size.load();
+                if(size > victim_size)
+                {
+                    victim = i;
+                    victim_size = size;
+                }
+            }
+
+            if(victim < num_workers_ && steal_from(worker, victim, item))
+                return true;
+        }
+
+        return false;
+
+    }
+
+    template <typename T>
+    bool
+    work_scheduler<T>::request(std::size_t worker, T* item)
+    {
+
+        worker_queue & queue = *workers[worker];
+
+        // Start the throughput measurement
+        if(queue.start_time.load() == 0)
+        {
+            boost::uint64_t expected = 0;
+            queue.start_time.compare_exchange_strong(expected,
+                                    hpx::util::high_resolution_clock::now());
+        }
+
+        while(true)
+        {
+
+            // Own work first, then steal
+            if(pop_local(queue, item) || steal(worker, item))
+            {
+                total_items--;
+                return true;
+            }
+
+            // Wait for new work
+            boost::lock_guard<lock_type> lock(sleep_lock);
+            if(total_items.load() > 0)
+                continue;
+            if(finished)
+                return false;
+
+            num_sleeping++;
+            sleep_cond.wait(sleep_lock);
+            num_sleeping--;
+
+        }
+
+    }
+
+    template <typename T>
+    void
+    work_scheduler<T>::work_done(std::size_t worker)
+    {
+
+        workers[worker]->completed++;
+
+    }
+
+    template <typename T>
+    void
+    work_scheduler<T>::finish()
+    {
+
+        boost::lock_guard<lock_type> lock(sleep_lock);
+
+        finished = true;
+
+        sleep_cond.notify_all();
+
+    }
+
+}}
+
+#endif
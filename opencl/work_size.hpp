@@ -0,0 +1,86 @@
+// Copyright (c)    2013 Martin Stumpf
+//
+// Distributed under the Boost Software License, Version 1.0. (See accompanying
+// file LICENSE_1_0.txt or copy at http://www.boost.org/LICENSE_1_0.txt)
+
+#pragma once
+#ifndef HPX_OPENCL_WORK_SIZE_HPP_
+#define HPX_OPENCL_WORK_SIZE_HPP_
+
+#include <cstddef>
+
+namespace hpx {
+namespace opencl {
+
+    ////////////////////////
+    /// @brief Automatic local work size.
+    ///
+    /// If the local_size of a \ref work_size dimension is set to this value,
+    /// the kernel chooses the local work size itself. The choice is based on
+    /// the work group limits of the kernel and the device, and gets cached
+    /// per global work size.
+    ///
+    /// Dimensions with an explicit local size keep it, the automatic ones
+    /// share what is left of the work group size of the kernel.
+    ///
+    /// Different from leaving the local size at 0, the chosen size is
+    /// guaranteed to be a multiple of the preferred work group size multiple
+    /// whenever the global work size allows it.
+    ///
+    /// @see kernel::autotune
+    ///
+    static const size_t auto_local_size = static_cast<size_t>(-1);
+
+    ////////////////////////
+    /// @brief Kernel execution dimensions.
+    ///
+    /// This structure offers an alternative way to set and reuse kernel 
+    /// execution dimensions.
+    /// 
+    /// Example:
+    /// \code{.cpp}
+    ///     // Create work_size object
+    ///     hpx::opencl::work_size<1> dim;                                           
+    ///
+    ///     // Set dimensions. 
+    ///     dim[0].offset = 0;                                                       
+    ///     dim[0].size = 2048; 
+    ///     
+    ///     // Set local work size.
+    ///     // This can be left out.
+    ///     // OpenCL will then automatically determine the best local work size.
+    ///     // With auto_local_size, hpxcl determines the local work size.
+    ///     dim[0].local_size = 64;
+    ///
+    ///     // Enqueue a kernel using the work_size object
+    ///     event kernel_event = kernel.enqueue(dim).get();
+    ///
+    /// \endcode
+    ///
+    template <size_t DIM>
+    struct work_size
+    {
+        private:
+        struct dimension
+        {
+            size_t offset;
+            size_t size;
+            size_t local_size;
+            dimension(){
+                offset = 0;
+                size = 0;
+                local_size = 0;
+            }
+        };
+        private:
+            // local_size be treated as NULL if all dimensions have local_size == 0
+            // dimensions with local_size == auto_local_size get their local
+            // size chosen automatically, the others keep theirs
+            dimension dims[DIM];
+        public:
+            dimension& operator[](size_t idx){ return dims[idx]; }
+    };
+
+}}
+
+#endif
@@ -0,0 +1,193 @@
+// Copyright (c)       2014 Martin Stumpf
+//
+// Distributed under the Boost Software License, Version 1.0. (See accompanying
+// file LICENSE_1_0.txt or copy at http://www.boost.org/LICENSE_1_0.txt)
+
+#include <hpx/hpx.hpp>
+#include <hpx/hpx_init.hpp>
+#include <hpx/include/iostreams.hpp>
+#include <hpx/lcos/when_all.hpp>
+#include <hpx/util/high_resolution_timer.hpp>
+
+#include "../../../opencl/lockfree_fifo.hpp"
+
+#include <queue>
+
+using boost::program_options::variables_map;
+using boost::program_options::options_description;
+using boost::program_options::value;
+
+
+/*
+ * Measures the throughput of the lock-free fifo under contention,
+ * compared to a spinlock + condition variable based fifo.
+ */
+
+
+// The reference implementation, a std::queue guarded by a spinlock
+template <typename T>
+class locked_fifo
+{
+
+    typedef hpx::lcos::local::spinlock lock_type;
+    typedef hpx::lcos::local::condition_variable cond_type;
+
+public:
+    locked_fifo() : finished(false) {}
+
+    void push(const T & item)
+    {
+        boost::lock_guard<lock_type> locallock(lock);
+        queue.push(item);
+        cond_var.notify_one();
+    }
+
+    bool pop(T* item)
+    {
+        boost::lock_guard<lock_type> locallock(lock);
+        while(queue.empty())
+        {
+            if(finished)
+                return false;
+            cond_var.wait(lock);
+        }
+        *item = queue.front();
+        queue.pop();
+        return true;
+    }
+
+    void finish()
+    {
+        boost::lock_guard<lock_type> locallock(lock);
+        finished = true;
+        cond_var.notify_all();
+    }
+
+private:
+    std::queue<T> queue;
+    lock_type     lock;
+    cond_type     cond_var;
+    bool          finished;
+
+};
+
+template <typename Fifo>
+static void producer(Fifo* queue, std::size_t num_items)
+{
+    for(std::size_t i = 0; i < num_items; i++)
+        queue->push(i);
+}
+
+template <typename Fifo>
+static std::size_t consumer(Fifo* queue)
+{
+    std::size_t item;
+    std::size_t num_items = 0;
+    while(queue->pop(&item))
+        num_items++;
+    return num_items;
+}
+
+// Runs the benchmark, returns the time in seconds.
+// Sets success to false if items got lost or duplicated.
+template <typename Fifo>
+static double run_benchmark(Fifo & queue, std::size_t num_producers,
+                            std::size_t num_consumers, std::size_t num_items,
+                            bool & success)
+{
+
+    hpx::util::high_resolution_timer timer;
+
+    // start consumers
+    std::vector<hpx::lcos::future<std::size_t>> consumers;
+    for(std::size_t i = 0; i < num_consumers; i++)
+        consumers.push_back(hpx::async(&consumer<Fifo>, &queue));
+
+    // start producers
+    std::vector<hpx::lcos::future<void>> producers;
+    for(std::size_t i = 0; i < num_producers; i++)
+        producers.push_back(hpx::async(&producer<Fifo>, &queue, num_items));
+
+    // wait for producers, then close the queue
+    hpx::when_all(producers).get();
+    queue.finish();
+
+    // wait for consumers
+    std::vector<hpx::lcos::future<std::size_t>> results =
+                                            hpx::when_all(consumers).get();
+
+    double time = timer.elapsed();
+
+    // verify
+    std::size_t num_received = 0;
+    BOOST_FOREACH(hpx::lcos::future<std::size_t> & result, results)
+        num_received += result.get();
+    if(num_received != num_items * num_producers)
+    {
+        hpx::cerr << "Error: received " << num_received << " of "
+                  << num_items * num_producers << " items!" << hpx::endl;
+        success = false;
+    }
+
+    return time;
+
+}
+
+int hpx_main(variables_map & vm)
+{
+
+    std::size_t num_producers = vm["producers"].as<std::size_t>();
+    std::size_t num_consumers = vm["consumers"].as<std::size_t>();
+    std::size_t num_items = vm["items"].as<std::size_t>();
+    std::size_t capacity = vm["capacity"].as<std::size_t>();
+
+    hpx::cout << "producers: " << num_producers
+              << ", consumers: " << num_consumers
+              << ", items per producer: " << num_items << hpx::endl;
+
+    bool success = true;
+
+    {
+        locked_fifo<std::size_t> queue;
+        double time = run_benchmark(queue, num_producers, num_consumers,
+                                    num_items, success);
+        hpx::cout << "locked fifo:   " << time * 1000.0 << " ms, "
+                  << num_producers * num_items / time << " items/s"
+                  << hpx::endl;
+    }
+
+    {
+        hpx::opencl::lockfree_fifo<std::size_t> queue(capacity);
+        double time = run_benchmark(queue, num_producers, num_consumers,
+                                    num_items, success);
+        hpx::cout << "lockfree fifo: " << time * 1000.0 << " ms, "
+                  << num_producers * num_items / time << " items/s"
+                  << hpx::endl;
+    }
+
+    hpx::finalize();
+    return success ? 0 : 1;
+
+}
+
+///////////////////////////////////////////////////////////////////////////////
+int main(int argc, char* argv[])
+{
+    // Configure application-specific options
+    options_description cmdline("Usage: " HPX_APPLICATION_STRING " [options]");
+    cmdline.add_options()
+        ( "producers"
+        , value<std::size_t>()->default_value(4)
+        , "the number of producing threads")
+        ( "consumers"
+        , value<std::size_t>()->default_value(4)
+        , "the number of consuming threads")
+        ( "items"
+        , value<std::size_t>()->default_value(100000)
+        , "the number of items per producer")
+        ( "capacity"
+        , value<std::size_t>()->default_value(1024)
+        , "the capacity of the lock-free fifo") ;
+
+    return hpx::init(cmdline, argc, argv);
+}
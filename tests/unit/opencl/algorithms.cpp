@@ -0,0 +1,154 @@
+// Copyright (c)       2014 Martin Stumpf
+//
+// Distributed under the Boost Software License, Version 1.0. (See accompanying
+// file LICENSE_1_0.txt or copy at http://www.boost.org/LICENSE_1_0.txt)
+
+
+#include "cl_tests.hpp"
+
+#include <algorithm>
+#include <limits>
+#include <vector>
+
+
+/*
+ * This file tests the device side algorithms.
+ */
+
+// big enough for a multi level scan on every device,
+// not a multiple of any work group size
+static const size_t NUM_ELEMENTS = 100003;
+
+// the algorithms work on a range in the middle of the buffer
+static const size_t FIRST = 5;
+
+template <typename T>
+static hpx::opencl::buffer
+create_buffer(hpx::opencl::device cldevice, std::vector<T> const& data)
+{
+    hpx::opencl::buffer buf = cldevice.create_buffer(CL_MEM_READ_WRITE,
+                                                     data.size() * sizeof(T));
+    buf.enqueue_write(0, data.size() * sizeof(T), data.data()).get().await();
+    return buf;
+}
+
+template <typename T>
+static std::vector<T>
+read_buffer(hpx::opencl::buffer buf, size_t size, hpx::opencl::event done)
+{
+    boost::shared_ptr<std::vector<char>> data =
+        buf.enqueue_read(0, size * sizeof(T), done).get().get_data().get();
+    const T* begin = reinterpret_cast<const T*>(data->data());
+    return std::vector<T>(begin, begin + size);
+}
+
+static void cl_test(hpx::opencl::device cldevice)
+{
+
+    // some integers, with negative ones and duplicates
+    std::vector<cl_int> data(FIRST + NUM_ELEMENTS + FIRST);
+    for(size_t i = 0; i < data.size(); i++)
+    {
+        data[i] = (cl_int)((i * 7919) % 10007) - 5000;
+    }
+    std::vector<cl_int>::iterator begin = data.begin() + FIRST;
+    std::vector<cl_int>::iterator end = begin + NUM_ELEMENTS;
+
+    hpx::opencl::buffer input = create_buffer(cldevice, data);
+
+    // reduce
+    {
+        cl_int sum = hpx::opencl::reduce<cl_int>(cldevice, input, FIRST,
+                                                 NUM_ELEMENTS).get();
+        cl_int expected = 0;
+        for(std::vector<cl_int>::iterator it = begin; it != end; it++)
+            expected += *it;
+        HPX_TEST_EQ(sum, expected);
+
+        cl_int max = hpx::opencl::reduce<cl_int>(cldevice, input, FIRST,
+                        NUM_ELEMENTS, hpx::opencl::maximum<cl_int>()).get();
+        HPX_TEST_EQ(max, *std::max_element(begin, end));
+
+        // an empty range gives the identity
+        cl_int empty = hpx::opencl::reduce<cl_int>(cldevice, input, 0, 0,
+                                        hpx::opencl::minimum<cl_int>()).get();
+        HPX_TEST_EQ(empty, std::numeric_limits<cl_int>::max());
+    }
+
+    // inclusive scan, to another buffer
+    {
+        hpx::opencl::buffer output = cldevice.create_buffer(CL_MEM_READ_WRITE,
+                                            NUM_ELEMENTS * sizeof(cl_int));
+        hpx::opencl::event done = hpx::opencl::inclusive_scan<cl_int>(
+                                cldevice, input, FIRST, NUM_ELEMENTS,
+                                output, 0).get();
+
+        std::vector<cl_int> result =
+                            read_buffer<cl_int>(output, NUM_ELEMENTS, done);
+        cl_int expected = 0;
+        for(size_t i = 0; i < NUM_ELEMENTS; i++)
+        {
+            expected += data[FIRST + i];
+            HPX_TEST_EQ(result[i], expected);
+        }
+    }
+
+    // exclusive scan, in place
+    {
+        hpx::opencl::buffer inout = create_buffer(cldevice, data);
+        hpx::opencl::event done = hpx::opencl::exclusive_scan<cl_int>(
+                                cldevice, inout, FIRST, NUM_ELEMENTS,
+                                inout, FIRST).get();
+
+        std::vector<cl_int> result =
+                            read_buffer<cl_int>(inout, data.size(), done);
+        cl_int expected = 0;
+        for(size_t i = 0; i < NUM_ELEMENTS; i++)
+        {
+            HPX_TEST_EQ(result[FIRST + i], expected);
+            expected += data[FIRST + i];
+        }
+
+        // the elements around the range are untouched
+        for(size_t i = 0; i < FIRST; i++)
+        {
+            HPX_TEST_EQ(result[i], data[i]);
+            HPX_TEST_EQ(result[FIRST + NUM_ELEMENTS + i],
+                        data[FIRST + NUM_ELEMENTS + i]);
+        }
+    }
+
+    // radix sort
+    {
+        hpx::opencl::buffer keys = create_buffer(cldevice, data);
+        hpx::opencl::event done = hpx::opencl::radix_sort<cl_int>(
+                                cldevice, keys, FIRST, NUM_ELEMENTS).get();
+
+        std::vector<cl_int> result =
+                            read_buffer<cl_int>(keys, data.size(), done);
+        std::vector<cl_int> expected = data;
+        std::sort(expected.begin() + FIRST,
+                  expected.begin() + FIRST + NUM_ELEMENTS);
+        for(size_t i = 0; i < data.size(); i++)
+        {
+            HPX_TEST_EQ(result[i], expected[i]);
+        }
+    }
+
+    // transform, to another type
+    {
+        hpx::opencl::buffer output = cldevice.create_buffer(CL_MEM_READ_WRITE,
+                                            NUM_ELEMENTS * sizeof(cl_float));
+        hpx::opencl::event done =
+            hpx::opencl::transform<cl_int, cl_float>(cldevice, input, FIRST,
+                                NUM_ELEMENTS, output, 0, "0.5f * x").get();
+
+        std::vector<cl_float> result =
+                            read_buffer<cl_float>(output, NUM_ELEMENTS, done);
+        for(size_t i = 0; i < NUM_ELEMENTS; i++)
+        {
+            HPX_TEST_EQ(result[i], 0.5f * data[FIRST + i]);
+        }
+    }
+
+}
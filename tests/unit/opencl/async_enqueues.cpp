@@ -0,0 +1,135 @@
+// Copyright (c)       2014 Martin Stumpf
+//
+// Distributed under the Boost Software License, Version 1.0. (See accompanying
+// file LICENSE_1_0.txt or copy at http://www.boost.org/LICENSE_1_0.txt)
+
+
+#include "cl_tests.hpp"
+
+#include <vector>
+
+
+/*
+ * This file tests the event-less enqueue_async-calls.
+ *
+ * This is done by asynchronously calculating (A+B)*(2*C),
+ * Dependency tree:
+ *
+ * write_A -|
+ *          |-> X = A+B -|
+ * write_B -|            |
+ *                       |-> Z = X * Y -> read_Z
+ * write_C ---> Y = 2*C -|
+ *
+ */
+
+static const int inputA[] = {  1,  5,  2,  4,  3};
+static const int inputB[] = {  3,  7,  4,  1,  4};
+static const int inputC[] = {  4,  9,  4,  7,  8};
+static const size_t DATASIZE = 5 * sizeof(int);
+
+static const char gpu_prog[] =
+"                                                                   \n"
+"   __kernel void add(__global int* out,__global int* in1,          \n"
+"                                       __global int* in2)          \n"
+"   {                                                               \n"
+"       size_t tid = get_global_id(0);                              \n"
+"       out[tid] = in1[tid] + in2[tid];                             \n"
+"   }                                                               \n"
+"                                                                   \n"
+"   __kernel void dbl(__global int* out,__global int* in)           \n"
+"   {                                                               \n"
+"       size_t tid = get_global_id(0);                              \n"
+"       out[tid] = 2 * in[tid];                                     \n"
+"   }                                                               \n"
+"                                                                   \n"
+"   __kernel void mul(__global int* out,__global int* in1,          \n"
+"                                       __global int* in2)          \n"
+"   {                                                               \n"
+"       size_t tid = get_global_id(0);                              \n"
+"       out[tid] = in1[tid] * in2[tid];                             \n"
+"   }                                                               \n"
+"                                                                   \n";
+
+
+static void cl_test(hpx::opencl::device cldevice)
+{
+    // Make your life easier.
+    typedef hpx::lcos::shared_future<void> future_void;
+
+    // Generate kernels
+    hpx::opencl::program prog = cldevice.create_program_with_source(gpu_prog);
+    prog.build();
+    hpx::opencl::kernel add_kernel = prog.create_kernel("add");
+    hpx::opencl::kernel dbl_kernel = prog.create_kernel("dbl");
+    hpx::opencl::kernel mul_kernel = prog.create_kernel("mul");
+
+    // Load buffers
+    hpx::opencl::buffer bufA = cldevice.create_buffer(CL_MEM_READ_WRITE,
+                                                            DATASIZE);
+    hpx::opencl::buffer bufB = cldevice.create_buffer(CL_MEM_READ_WRITE,
+                                                            DATASIZE);
+    hpx::opencl::buffer bufC = cldevice.create_buffer(CL_MEM_READ_WRITE,
+                                                            DATASIZE);
+    hpx::opencl::buffer bufX = cldevice.create_buffer(CL_MEM_READ_WRITE,
+                                                            DATASIZE);
+    hpx::opencl::buffer bufY = cldevice.create_buffer(CL_MEM_READ_WRITE,
+                                                            DATASIZE);
+    hpx::opencl::buffer bufZ = cldevice.create_buffer(CL_MEM_READ_WRITE,
+                                                            DATASIZE);
+
+    // set kernel args
+    add_kernel.set_arg(0, bufX);
+    add_kernel.set_arg(1, bufA);
+    add_kernel.set_arg(2, bufB);
+
+    dbl_kernel.set_arg(0, bufY);
+    dbl_kernel.set_arg(1, bufC);
+    
+    mul_kernel.set_arg(0, bufZ);
+    mul_kernel.set_arg(1, bufX);
+    mul_kernel.set_arg(2, bufY);
+
+    // Write to buffers
+    std::vector<future_void> initABfutures;
+    initABfutures.push_back(bufA.enqueue_write_async(0, DATASIZE, inputA));
+    initABfutures.push_back(bufB.enqueue_write_async(0, DATASIZE, inputB));
+    std::vector<future_void> initCfutures;
+    initCfutures.push_back(bufC.enqueue_write_async(0, DATASIZE, inputC));
+
+    // set up work size
+    hpx::opencl::work_size<1> dim;
+    dim[0].offset = 0;
+    dim[0].size = 5;
+
+    // run add and dbl kernels
+    std::vector<future_void> add_dbl_futures;
+    add_dbl_futures.push_back(add_kernel.enqueue_async(dim, initABfutures));
+    add_dbl_futures.push_back(dbl_kernel.enqueue_async(dim, initCfutures));
+
+    // run mul kernel
+    std::vector<future_void> mul_futures;
+    mul_futures.push_back(mul_kernel.enqueue_async(dim, add_dbl_futures));
+
+    // read from result buffer
+    boost::shared_ptr<std::vector<char>> chardata = 
+                bufZ.enqueue_read_async(0, DATASIZE, mul_futures).get();
+
+    // cast to int
+    int* data = (int*)(chardata->data());
+
+    for(size_t i = 0; i < 5; i++)
+    {
+        HPX_TEST_EQ(data[i], (inputA[i] + inputB[i]) * 2 * inputC[i]);
+    }
+
+    // the immediate versions need to work as well
+    bufA.enqueue_write_async(0, DATASIZE, inputC).get();
+    chardata = bufA.enqueue_read_async(0, DATASIZE).get();
+    data = (int*)(chardata->data());
+    for(size_t i = 0; i < 5; i++)
+    {
+        HPX_TEST_EQ(data[i], inputC[i]);
+    }
+
+}
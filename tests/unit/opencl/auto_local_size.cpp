@@ -0,0 +1,125 @@
+// Copyright (c)       2014 Martin Stumpf
+//
+// Distributed under the Boost Software License, Version 1.0. (See accompanying
+// file LICENSE_1_0.txt or copy at http://www.boost.org/LICENSE_1_0.txt)
+
+
+#include "cl_tests.hpp"
+
+
+/*
+ * This test is meant to verify the automatic local work size selection.
+ */
+
+
+static const char square_src[] = 
+"                                                                          \n"
+"   __kernel void square(__global int * val)                               \n"
+"   {                                                                      \n"
+"       size_t tid = get_global_id(0);                                     \n"
+"       val[tid] = val[tid]*val[tid];                                      \n"
+"   }                                                                      \n"
+"                                                                          \n"
+"   __kernel void set(__global int * val)                                  \n"
+"   {                                                                      \n"
+"       size_t tid = get_global_id(0);                                     \n"
+"       val[tid] = (int)tid;                                               \n"
+"   }                                                                      \n"
+"                                                                          \n"
+"   __kernel void local_size(__global int * val)                           \n"
+"   {                                                                      \n"
+"       size_t tid = get_global_id(1) * get_global_size(0)                 \n"
+"                  + get_global_id(0);                                     \n"
+"       val[tid] = (int)get_local_size(0);                                 \n"
+"   }                                                                      \n"
+"                                                                          \n";
+
+#define NUM_ELEMENTS ((size_t)1024)
+
+static void cl_test(hpx::opencl::device cldevice)
+{
+
+    std::vector<int> initdata(NUM_ELEMENTS);
+    for(size_t i = 0; i < NUM_ELEMENTS; i++)
+    {
+        initdata[i] = (int)(i % 100);
+    }
+
+    hpx::opencl::buffer buffer = cldevice.create_buffer(CL_MEM_READ_WRITE,
+                                               NUM_ELEMENTS * sizeof(int),
+                                               initdata.data());
+
+    // create program
+    hpx::opencl::program prog = cldevice.create_program_with_source(
+                                                                    square_src);
+
+    // build program
+    prog.build();
+
+    // create kernels
+    hpx::opencl::kernel square_kernel = prog.create_kernel("square");
+    hpx::opencl::kernel set_kernel = prog.create_kernel("set");
+    square_kernel.set_arg(0, buffer);
+    set_kernel.set_arg(0, buffer);
+
+    // create work_size with automatic local size.
+    // 1000 is not a power of two, to test the divisor selection.
+    hpx::opencl::work_size<1> dim;
+    dim[0].offset = 0;
+    dim[0].size = 1000;
+    dim[0].local_size = hpx::opencl::auto_local_size;
+
+    // run kernel twice, the second one uses the cached local size
+    square_kernel.enqueue(dim).get().await();
+    square_kernel.enqueue(dim).get().await();
+
+    // test if kernel executed successfully
+    boost::shared_ptr<std::vector<char>> out = buffer.enqueue_read(0,
+                    NUM_ELEMENTS * sizeof(int)).get().get_data().get();
+    int* data = (int*)out->data();
+    for(size_t i = 0; i < NUM_ELEMENTS; i++)
+    {
+        int val = (int)(i % 100);
+        if(i < 1000) val = val * val * val * val;
+        HPX_TEST_EQ(data[i], val);
+    }
+
+    // autotune the idempotent kernel
+    dim[0].size = NUM_ELEMENTS;
+    std::vector<size_t> local_size = set_kernel.autotune(dim).get();
+    HPX_TEST(local_size.size() == 0 || local_size.size() == 1);
+    if(local_size.size() == 1)
+        HPX_TEST_EQ(NUM_ELEMENTS % local_size[0], (size_t)0);
+
+    // run with the autotuned local size
+    dim[0].local_size = hpx::opencl::auto_local_size;
+    set_kernel.enqueue(dim).get().await();
+    out = buffer.enqueue_read(0,
+                    NUM_ELEMENTS * sizeof(int)).get().get_data().get();
+    data = (int*)out->data();
+    for(size_t i = 0; i < NUM_ELEMENTS; i++)
+    {
+        HPX_TEST_EQ(data[i], (int)i);
+    }
+
+    // an explicit dimension next to an automatic one is kept
+    hpx::opencl::kernel local_size_kernel = prog.create_kernel("local_size");
+    local_size_kernel.set_arg(0, buffer);
+
+    hpx::opencl::work_size<2> dim2;
+    dim2[0].offset = 0;
+    dim2[0].size = 32;
+    dim2[0].local_size = 2;
+    dim2[1].offset = 0;
+    dim2[1].size = NUM_ELEMENTS / 32;
+    dim2[1].local_size = hpx::opencl::auto_local_size;
+    local_size_kernel.enqueue(dim2).get().await();
+    out = buffer.enqueue_read(0,
+                    NUM_ELEMENTS * sizeof(int)).get().get_data().get();
+    data = (int*)out->data();
+    for(size_t i = 0; i < NUM_ELEMENTS; i++)
+    {
+        HPX_TEST_EQ(data[i], 2);
+    }
+
+}
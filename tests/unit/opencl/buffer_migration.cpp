@@ -0,0 +1,99 @@
+// Copyright (c)       2014 Martin Stumpf
+//
+// Distributed under the Boost Software License, Version 1.0. (See accompanying
+// file LICENSE_1_0.txt or copy at http://www.boost.org/LICENSE_1_0.txt)
+
+
+#include "cl_tests.hpp"
+
+#include <vector>
+
+
+/*
+ * This file tests the migration of buffers between devices.
+ * The buffer visits every local device and returns to the first one.
+ */
+
+static const size_t NUM_ELEMENTS = 1000;
+
+static void check_content(hpx::opencl::buffer buf, hpx::opencl::event done,
+                          std::vector<cl_int> const& expected)
+{
+    std::vector<cl_int> data(NUM_ELEMENTS);
+    buf.enqueue_read_to(0, NUM_ELEMENTS * sizeof(cl_int), data.data(),
+                        std::vector<hpx::opencl::event>(1, done)).get();
+    for(size_t i = 0; i < NUM_ELEMENTS; i++)
+    {
+        HPX_TEST_EQ(data[i], expected[i]);
+    }
+}
+
+static void cl_test(hpx::opencl::device cldevice)
+{
+
+    std::vector<cl_int> x(NUM_ELEMENTS);
+    for(size_t i = 0; i < NUM_ELEMENTS; i++)
+    {
+        x[i] = (cl_int)i;
+    }
+
+    hpx::opencl::buffer buf = cldevice.create_buffer(CL_MEM_READ_WRITE,
+                                      NUM_ELEMENTS * sizeof(cl_int), x.data());
+
+    std::vector<hpx::opencl::device> devices =
+                hpx::opencl::get_devices(hpx::find_here(),
+                                         CL_DEVICE_TYPE_ALL,
+                                         "OpenCL 1.1").get();
+    devices.push_back(cldevice);
+
+    hpx::opencl::event done = buf.migrate_to(cldevice).get();
+    check_content(buf, done, x);
+
+    for(size_t i = 0; i < devices.size(); i++)
+    {
+        done = buf.migrate_to(devices[i], done).get();
+        check_content(buf, done, x);
+
+        // the buffer is usable on the new device
+        x[i] = -x[i];
+        done = buf.enqueue_write(i * sizeof(cl_int), sizeof(cl_int),
+                                 &x[i], done).get();
+        check_content(buf, done, x);
+    }
+
+    HPX_TEST_EQ(buf.size().get(), NUM_ELEMENTS * sizeof(cl_int));
+
+    // on the same locality, move_to keeps the buffer
+    hpx::opencl::buffer moved = buf.move_to(cldevice).get();
+    HPX_TEST(moved.get_gid() == buf.get_gid());
+    hpx::opencl::event ready = cldevice.create_user_event().get();
+    ready.trigger();
+    check_content(moved, ready, x);
+
+    // on other localities, move_to creates a new buffer
+    std::vector<hpx::naming::id_type> localities = hpx::find_all_localities();
+    for(size_t i = 0; i < localities.size(); i++)
+    {
+        if(localities[i] == hpx::find_here())
+            continue;
+
+        std::vector<hpx::opencl::device> remote_devices =
+                hpx::opencl::get_devices(localities[i], CL_DEVICE_TYPE_ALL,
+                                         "OpenCL 1.1").get();
+        if(remote_devices.empty())
+            continue;
+
+        hpx::opencl::buffer remote = buf.move_to(remote_devices[0]).get();
+        HPX_TEST(remote.get_gid() != buf.get_gid());
+        HPX_TEST_EQ(remote.size().get(), NUM_ELEMENTS * sizeof(cl_int));
+
+        std::vector<cl_int> data(NUM_ELEMENTS);
+        remote.enqueue_read_to(0, NUM_ELEMENTS * sizeof(cl_int),
+                               data.data()).get();
+        for(size_t j = 0; j < NUM_ELEMENTS; j++)
+        {
+            HPX_TEST_EQ(data[j], x[j]);
+        }
+    }
+
+}
@@ -0,0 +1,127 @@
+// Copyright (c)       2014 Martin Stumpf
+//
+// Distributed under the Boost Software License, Version 1.0. (See accompanying
+// file LICENSE_1_0.txt or copy at http://www.boost.org/LICENSE_1_0.txt)
+
+
+#include "cl_tests.hpp"
+
+
+/*
+ * This test is meant to verify the bulk enqueue functionality.
+ */
+
+
+static const char fill_src[] = 
+"                                                                          \n"
+"   __kernel void fill(__global char * val)                                \n"
+"   {                                                                      \n"
+"       size_t tid = get_global_id(0);                                     \n"
+"       val[tid] = 'a' + (char)tid;                                        \n"
+"   }                                                                      \n"
+"                                                                          \n";
+
+static const char initdata[] = "0000000000";
+#define DATASIZE ((size_t)11)
+
+static const char refdata1[] = "abcdefghij";
+static const char refdata2[] = "ab00ef00ij";
+
+static void cl_test(hpx::opencl::device cldevice)
+{
+
+    hpx::opencl::buffer buffer1 = cldevice.create_buffer(CL_MEM_READ_WRITE,
+                                                               DATASIZE,
+                                                               initdata);
+    hpx::opencl::buffer buffer2 = cldevice.create_buffer(CL_MEM_READ_WRITE,
+                                                               DATASIZE,
+                                                               initdata);
+
+    // create program
+    hpx::opencl::program prog = cldevice.create_program_with_source(
+                                                                    fill_src);
+
+    // build program
+    prog.build();
+
+    // create kernel
+    hpx::opencl::kernel fill_kernel = prog.create_kernel("fill");
+
+    // create one launch per two characters
+    std::vector<hpx::opencl::launch_desc> launches;
+    for(size_t i = 0; i < 5; i++)
+    {
+        hpx::opencl::work_size<1> dim;
+        dim[0].offset = 2 * i;
+        dim[0].size = 2;
+
+        hpx::opencl::launch_desc launch(dim);
+        if(i == 0) launch.set_arg(0, buffer1);
+        launches.push_back(launch);
+    }
+
+    // run kernels, wait for the aggregate event
+    fill_kernel.enqueue_bulk(launches).get().await();
+
+    // test if kernels executed successfully
+    TEST_CL_BUFFER(buffer1, refdata1);
+
+    // alternate between the buffers, with per-launch events
+    for(size_t i = 0; i < 5; i++)
+    {
+        launches[i].args.clear();
+        launches[i].set_arg(0, (i % 2 == 0) ? buffer2 : buffer1);
+    }
+    std::vector<hpx::opencl::event> events =
+                 fill_kernel.enqueue_bulk_with_events(launches,
+                                     std::vector<hpx::opencl::event>()).get();
+    HPX_TEST_EQ(events.size(), launches.size() + 1);
+
+    // per-launch events have to trigger as well
+    for(size_t i = 1; i < events.size(); i++)
+    {
+        events[i].await();
+    }
+    events[0].await();
+
+    // test if kernels executed successfully
+    TEST_CL_BUFFER(buffer2, refdata2);
+
+    // mix buffers whose memory gets looked up on launch with plain ones
+    // on the same index, every argument stays set for the following
+    // launches
+    hpx::opencl::buffer buffer3 = cldevice.create_buffer(CL_MEM_READ_WRITE,
+                                                         DATASIZE,
+                                                         initdata);
+    hpx::opencl::buffer lazy1 = cldevice.create_buffer(CL_MEM_READ_WRITE,
+                                                       DATASIZE);
+    hpx::opencl::buffer lazy2 = cldevice.create_buffer(CL_MEM_READ_WRITE,
+                                                       DATASIZE);
+    fill_kernel.set_arg(0, lazy1);
+    for(size_t i = 0; i < 5; i++)
+    {
+        launches[i].args.clear();
+    }
+    launches[1].set_arg(0, buffer3);
+    launches[3].set_arg(0, lazy2);
+    fill_kernel.enqueue_bulk(launches).get().await();
+
+    // launches 1 and 2 wrote to the plain buffer
+    TEST_CL_BUFFER(buffer3, "00cdef0000");
+
+    // launch 0 wrote to the buffer set via set_arg, launches 3 and 4 to
+    // the one of launch 3. The rest of their memory is uninitialized.
+    boost::shared_ptr<std::vector<char>> data1 =
+                lazy1.enqueue_read(0, DATASIZE).get().get_data().get();
+    HPX_TEST_EQ((*data1)[0], 'a');
+    HPX_TEST_EQ((*data1)[1], 'b');
+    boost::shared_ptr<std::vector<char>> data2 =
+                lazy2.enqueue_read(0, DATASIZE).get().get_data().get();
+    for(size_t i = 6; i < 10; i++)
+    {
+        HPX_TEST_EQ((*data2)[i], refdata1[i]);
+    }
+
+}
+
+
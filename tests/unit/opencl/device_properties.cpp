@@ -0,0 +1,89 @@
+// Copyright (c)       2014 Martin Stumpf
+//
+// Distributed under the Boost Software License, Version 1.0. (See accompanying
+// file LICENSE_1_0.txt or copy at http://www.boost.org/LICENSE_1_0.txt)
+
+
+#include "cl_tests.hpp"
+
+
+/*
+ * This test is meant to verify the cached device properties.
+ */
+
+
+static void cl_test(hpx::opencl::device cldevice)
+{
+
+    hpx::opencl::device_properties props =
+                                        cldevice.get_device_properties().get();
+
+    // compare with the uncached string queries
+    HPX_TEST_EQ(props.name, cldevice.device_info_to_string(
+                                cldevice.get_device_info(CL_DEVICE_NAME)));
+    HPX_TEST_EQ(props.vendor, cldevice.device_info_to_string(
+                                cldevice.get_device_info(CL_DEVICE_VENDOR)));
+    HPX_TEST_EQ(props.version, cldevice.device_info_to_string(
+                                cldevice.get_device_info(CL_DEVICE_VERSION)));
+    HPX_TEST_EQ(props.platform_name, cldevice.device_info_to_string(
+                                cldevice.get_platform_info(CL_PLATFORM_NAME)));
+
+    // compare with a typed query
+    std::vector<char> compute_units =
+                    cldevice.get_device_info(CL_DEVICE_MAX_COMPUTE_UNITS).get();
+    HPX_TEST_EQ(props.max_compute_units,
+                *((cl_uint*)compute_units.data()));
+
+    // sanity checks
+    HPX_TEST(props.version_major >= 1);
+    HPX_TEST(props.max_compute_units > 0);
+    HPX_TEST(props.max_work_group_size > 0);
+    HPX_TEST(!props.max_work_item_sizes.empty());
+    HPX_TEST(props.global_mem_size > 0);
+
+    // the device list with properties must match the plain device list
+    std::vector<hpx::opencl::device> devices =
+            hpx::opencl::get_devices(hpx::find_here(), CL_DEVICE_TYPE_ALL,
+                                     "OpenCL 1.1").get();
+    std::vector<hpx::opencl::device_with_properties> devices_with_props =
+            hpx::opencl::get_devices_with_properties(hpx::find_here(),
+                                                     CL_DEVICE_TYPE_ALL,
+                                                     "OpenCL 1.1").get();
+    HPX_TEST_EQ(devices.size(), devices_with_props.size());
+    for(size_t i = 0; i < devices.size(); i++)
+    {
+        HPX_TEST(devices[i].get_gid() == devices_with_props[i].first.get_gid());
+        HPX_TEST(devices_with_props[i].second.type & CL_DEVICE_TYPE_ALL);
+    }
+
+    // the selection must contain the same devices
+    hpx::opencl::device_selection_criteria criteria;
+    criteria.consider_bandwidth = true;
+    std::vector<hpx::opencl::device> selected_devices =
+                                    hpx::opencl::select_devices(criteria).get();
+    HPX_TEST(selected_devices.size() >= devices.size());
+    HPX_TEST(cldevice.measure_bandwidth().get() > 0.0);
+
+    // a single selected device
+    criteria.max_devices = 1;
+    HPX_TEST_EQ(hpx::opencl::select_devices(criteria).get().size(),
+                (std::size_t)1);
+
+    // commands get counted from the first query on
+    cldevice.get_pending_commands().get();
+
+    // a write that waits for a user event is pending for sure
+    hpx::opencl::event user_event = cldevice.create_user_event().get();
+    hpx::opencl::buffer buffer = cldevice.create_buffer(CL_MEM_READ_WRITE, 4);
+    hpx::opencl::event write_event =
+                        buffer.enqueue_write(0, 1, "x", user_event).get();
+    HPX_TEST(cldevice.get_pending_commands().get() >= 1);
+
+    // completed commands are no longer pending
+    user_event.trigger();
+    write_event.await();
+    HPX_TEST_EQ(cldevice.get_pending_commands().get(), (std::size_t)0);
+
+}
+
+
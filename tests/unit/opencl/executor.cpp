@@ -0,0 +1,127 @@
+// Copyright (c)       2014 Martin Stumpf
+//
+// Distributed under the Boost Software License, Version 1.0. (See accompanying
+// file LICENSE_1_0.txt or copy at http://www.boost.org/LICENSE_1_0.txt)
+
+
+#include "cl_tests.hpp"
+
+#include <vector>
+
+
+/*
+ * This file tests the executor and the OpenCL execution policy.
+ */
+
+static const size_t NUM_ELEMENTS = 1000;
+
+static const char negate_src[] =
+"                                                                          \n"
+"   __kernel void negate(__global int* val)                                \n"
+"   {                                                                      \n"
+"       size_t i = get_global_id(0);                                       \n"
+"       val[i] = -val[i];                                                  \n"
+"   }                                                                      \n"
+"                                                                          \n";
+
+static std::vector<cl_int>
+read_ints(hpx::opencl::buffer buf, hpx::opencl::event done)
+{
+    boost::shared_ptr<std::vector<char>> data =
+        buf.enqueue_read(0, NUM_ELEMENTS * sizeof(cl_int), done).get()
+                                                        .get_data().get();
+    const cl_int* begin = reinterpret_cast<const cl_int*>(data->data());
+    return std::vector<cl_int>(begin, begin + NUM_ELEMENTS);
+}
+
+static void cl_test(hpx::opencl::device cldevice)
+{
+
+    hpx::opencl::executor exec(cldevice);
+
+    std::vector<cl_int> x(NUM_ELEMENTS);
+    for(size_t i = 0; i < NUM_ELEMENTS; i++)
+    {
+        x[i] = (cl_int)i;
+    }
+
+    hpx::opencl::buffer buf_x = cldevice.create_buffer(CL_MEM_READ_WRITE,
+                                      NUM_ELEMENTS * sizeof(cl_int), x.data());
+    hpx::opencl::buffer buf_y = cldevice.create_buffer(CL_MEM_READ_WRITE,
+                                      NUM_ELEMENTS * sizeof(cl_int));
+
+    // transform over the whole range
+    hpx::lcos::shared_future<hpx::opencl::event> squared =
+        hpx::opencl::transform<cl_int>(hpx::opencl::par.on(exec),
+                0, NUM_ELEMENTS, buf_y,
+                hpx::opencl::loop_body("x[i] * x[i]")
+                        .arg<cl_int>("x", buf_x));
+
+    // for_each over a part, after the transform
+    hpx::opencl::event added = hpx::opencl::for_each(
+                hpx::opencl::par.on(exec).after(squared),
+                10, 20,
+                hpx::opencl::loop_body("y[i] += x[i];")
+                        .arg<cl_int>("x", buf_x)
+                        .arg<cl_int>("y", buf_y)).get();
+
+    {
+        std::vector<cl_int> y = read_ints(buf_y, added);
+        for(size_t i = 0; i < NUM_ELEMENTS; i++)
+        {
+            cl_int expected = x[i] * x[i];
+            if(i >= 10 && i < 20)
+                expected += x[i];
+            HPX_TEST_EQ(y[i], expected);
+        }
+    }
+
+    // a registered kernel
+    {
+        hpx::opencl::program prog =
+                            cldevice.create_program_with_source(negate_src);
+        prog.build();
+        hpx::opencl::kernel negate_kernel = prog.create_kernel("negate");
+        negate_kernel.set_arg(0, buf_x);
+
+        hpx::opencl::event negated = hpx::opencl::for_each(
+                hpx::opencl::par.on(exec), 100, 200, negate_kernel).get();
+
+        std::vector<cl_int> result = read_ints(buf_x, negated);
+        for(size_t i = 0; i < NUM_ELEMENTS; i++)
+        {
+            HPX_TEST_EQ(result[i], (i >= 100 && i < 200) ? -x[i] : x[i]);
+        }
+    }
+
+    // an empty range does nothing
+    hpx::opencl::for_each(hpx::opencl::par.on(exec), 5, 5,
+                          hpx::opencl::loop_body("x[i] = 0;")
+                                .arg<cl_int>("x", buf_x)).get().await();
+
+    // an empty range still waits for its dependencies
+    {
+        hpx::opencl::event gate = cldevice.create_user_event().get();
+        hpx::lcos::shared_future<hpx::opencl::event> gate_future =
+                                        hpx::lcos::make_ready_future(gate);
+        hpx::opencl::event empty = hpx::opencl::for_each(
+                hpx::opencl::par.on(exec).after(gate_future), 5, 5,
+                hpx::opencl::loop_body("x[i] = 0;")
+                        .arg<cl_int>("x", buf_x)).get();
+        HPX_TEST(!empty.finished().get());
+        gate.trigger();
+        empty.await();
+        HPX_TEST(empty.finished().get());
+    }
+
+    // without executor
+    bool thrown = false;
+    try {
+        hpx::opencl::for_each(hpx::opencl::par, 0, 1,
+                              hpx::opencl::loop_body("")).get();
+    } catch (hpx::exception const&) {
+        thrown = true;
+    }
+    HPX_TEST(thrown);
+
+}
@@ -0,0 +1,130 @@
+// Copyright (c)       2014 Martin Stumpf
+//
+// Distributed under the Boost Software License, Version 1.0. (See accompanying
+// file LICENSE_1_0.txt or copy at http://www.boost.org/LICENSE_1_0.txt)
+
+
+#include "cl_tests.hpp"
+
+#include <algorithm>
+#include <cmath>
+#include <vector>
+
+
+/*
+ * This file tests the lazy expressions, that get evaluated
+ * with one generated kernel.
+ */
+
+// not a multiple of any sane work group size
+static const size_t NUM_ELEMENTS = 1000;
+
+static hpx::opencl::buffer
+create_input(hpx::opencl::device cldevice, std::vector<char> const& data)
+{
+    hpx::opencl::buffer buf = cldevice.create_buffer(CL_MEM_READ_ONLY,
+                                                     data.size());
+    buf.enqueue_write(0, data.size(), data.data()).get().await();
+    return buf;
+}
+
+template <typename T>
+static std::vector<char>
+to_bytes(std::vector<T> const& data)
+{
+    const char* begin = reinterpret_cast<const char*>(data.data());
+    return std::vector<char>(begin, begin + data.size() * sizeof(T));
+}
+
+template <typename T>
+static std::vector<T>
+read_result(hpx::opencl::buffer buf, hpx::opencl::event done)
+{
+    boost::shared_ptr<std::vector<char>> data =
+        buf.enqueue_read(0, NUM_ELEMENTS * sizeof(T), done).get()
+                                                    .get_data().get();
+    const T* begin = reinterpret_cast<const T*>(data->data());
+    return std::vector<T>(begin, begin + NUM_ELEMENTS);
+}
+
+static void cl_test(hpx::opencl::device cldevice)
+{
+
+    using hpx::opencl::lazy;
+
+    // integer arithmetic, checked exactly
+    {
+        std::vector<cl_int> a(NUM_ELEMENTS), b(NUM_ELEMENTS), c(NUM_ELEMENTS);
+        for(size_t i = 0; i < NUM_ELEMENTS; i++)
+        {
+            a[i] = (cl_int)i;
+            b[i] = 3 * (cl_int)i - 500;
+            c[i] = (cl_int)(i % 7) + 1;
+        }
+
+        hpx::opencl::buffer buf_a = create_input(cldevice, to_bytes(a));
+        hpx::opencl::buffer buf_b = create_input(cldevice, to_bytes(b));
+        hpx::opencl::buffer buf_c = create_input(cldevice, to_bytes(c));
+        hpx::opencl::buffer buf_z = cldevice.create_buffer(
+                                CL_MEM_WRITE_ONLY, NUM_ELEMENTS * sizeof(cl_int));
+
+        hpx::opencl::event done = hpx::opencl::evaluate(cldevice, buf_z,
+                NUM_ELEMENTS,
+                (lazy<cl_int>(buf_a) + lazy<cl_int>(buf_b)) * 3
+                        - -lazy<cl_int>(buf_a) / lazy<cl_int>(buf_c)).get();
+
+        std::vector<cl_int> z = read_result<cl_int>(buf_z, done);
+        for(size_t i = 0; i < NUM_ELEMENTS; i++)
+        {
+            HPX_TEST_EQ(z[i], (a[i] + b[i]) * 3 - (-a[i]) / c[i]);
+        }
+    }
+
+    // floating point functions, evaluated twice with different buffers
+    // and constants to hit the kernel cache
+    for(size_t run = 0; run < 2; run++)
+    {
+        std::vector<cl_float> a(NUM_ELEMENTS), b(NUM_ELEMENTS), c(NUM_ELEMENTS);
+        for(size_t i = 0; i < NUM_ELEMENTS; i++)
+        {
+            a[i] = 0.5f + (cl_float)((i + run) % 13);
+            b[i] = 0.001f * (cl_float)i;
+            c[i] = 1.0f + 0.25f * (cl_float)(i % 5);
+        }
+
+        hpx::opencl::buffer buf_a = create_input(cldevice, to_bytes(a));
+        hpx::opencl::buffer buf_b = create_input(cldevice, to_bytes(b));
+        hpx::opencl::buffer buf_c = create_input(cldevice, to_bytes(c));
+        hpx::opencl::buffer buf_z = cldevice.create_buffer(
+                            CL_MEM_WRITE_ONLY, NUM_ELEMENTS * sizeof(cl_float));
+        cl_float factor = 2.0f + (cl_float)run;
+
+        hpx::opencl::event done = hpx::opencl::evaluate(cldevice, buf_z,
+                NUM_ELEMENTS,
+                log((exp(lazy<cl_float>(buf_b)) + lazy<cl_float>(buf_a))
+                        * (factor * lazy<cl_float>(buf_c)))).get();
+
+        std::vector<cl_float> z = read_result<cl_float>(buf_z, done);
+        for(size_t i = 0; i < NUM_ELEMENTS; i++)
+        {
+            float expected = std::log((std::exp(b[i]) + a[i])
+                                                    * (factor * c[i]));
+            HPX_TEST(std::fabs(z[i] - expected)
+                        <= 1e-4f * std::max(1.0f, std::fabs(expected)));
+        }
+    }
+
+    // failed builds don't stay in the cache, every request builds again
+    for(size_t run = 0; run < 2; run++)
+    {
+        bool thrown = false;
+        try {
+            hpx::opencl::get_cached_kernel(cldevice, "not OpenCL C",
+                                           "hpx_opencl_broken").get();
+        } catch (hpx::exception const&) {
+            thrown = true;
+        }
+        HPX_TEST(thrown);
+    }
+
+}
@@ -0,0 +1,89 @@
+// Copyright (c)       2014 Martin Stumpf
+//
+// Distributed under the Boost Software License, Version 1.0. (See accompanying
+// file LICENSE_1_0.txt or copy at http://www.boost.org/LICENSE_1_0.txt)
+
+
+#include "cl_tests.hpp"
+
+#include <vector>
+
+
+/*
+ * This file tests the halo exchange between tiles.
+ */
+
+static const size_t TILE_SIZE = 64;
+static const size_t HALO_SIZE = 4;
+
+static std::vector<cl_int>
+read_tile(hpx::opencl::buffer buf, hpx::opencl::event done)
+{
+    std::vector<cl_int> data(TILE_SIZE);
+    buf.enqueue_read_to(0, TILE_SIZE * sizeof(cl_int), data.data(),
+                        std::vector<hpx::opencl::event>(1, done)).get();
+    return data;
+}
+
+static void cl_test(hpx::opencl::device cldevice)
+{
+
+    std::vector<cl_int> a(TILE_SIZE);
+    std::vector<cl_int> b(TILE_SIZE);
+    for(size_t i = 0; i < TILE_SIZE; i++)
+    {
+        a[i] = (cl_int)i;
+        b[i] = (cl_int)(1000 + i);
+    }
+
+    hpx::opencl::buffer buf_a = cldevice.create_buffer(CL_MEM_READ_WRITE,
+                                        TILE_SIZE * sizeof(cl_int), a.data());
+    hpx::opencl::buffer buf_b = cldevice.create_buffer(CL_MEM_READ_WRITE,
+                                        TILE_SIZE * sizeof(cl_int), b.data());
+
+    // a small chunk size, in case the tiles end up on different localities
+    hpx::opencl::halo_exchange exchange(3 * sizeof(cl_int));
+    size_t tile_a = exchange.add_tile(cldevice, buf_a);
+    size_t tile_b = exchange.add_tile(cldevice, buf_b);
+    HPX_TEST_EQ(exchange.num_tiles(), 2u);
+
+    // the last owned elements of a to the front of b and back
+    exchange.add_region(tile_a, (TILE_SIZE - 2 * HALO_SIZE) * sizeof(cl_int),
+                        tile_b, 0,
+                        HALO_SIZE * sizeof(cl_int));
+    exchange.add_region(tile_b, HALO_SIZE * sizeof(cl_int),
+                        tile_a, (TILE_SIZE - HALO_SIZE) * sizeof(cl_int),
+                        HALO_SIZE * sizeof(cl_int));
+    HPX_TEST_EQ(exchange.num_regions(), 2u);
+
+    // without dependencies
+    std::vector<hpx::opencl::event> events = exchange.run().get();
+    HPX_TEST_EQ(events.size(), 2u);
+
+    // a second iteration, after the first one
+    events = exchange.run(events).get();
+
+    std::vector<cl_int> result_a = read_tile(buf_a, events[tile_a]);
+    std::vector<cl_int> result_b = read_tile(buf_b, events[tile_b]);
+    for(size_t i = 0; i < TILE_SIZE; i++)
+    {
+        cl_int expected_a = a[i];
+        cl_int expected_b = b[i];
+        if(i >= TILE_SIZE - HALO_SIZE)
+            expected_a = b[i - (TILE_SIZE - 2 * HALO_SIZE)];
+        if(i < HALO_SIZE)
+            expected_b = a[i + TILE_SIZE - 2 * HALO_SIZE];
+        HPX_TEST_EQ(result_a[i], expected_a);
+        HPX_TEST_EQ(result_b[i], expected_b);
+    }
+
+    // unknown tiles
+    bool thrown = false;
+    try {
+        exchange.add_region(tile_a, 0, 5, 0, 1);
+    } catch (hpx::exception const&) {
+        thrown = true;
+    }
+    HPX_TEST(thrown);
+
+}
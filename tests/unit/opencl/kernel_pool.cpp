@@ -0,0 +1,129 @@
+// Copyright (c)       2014 Martin Stumpf
+//
+// Distributed under the Boost Software License, Version 1.0. (See accompanying
+// file LICENSE_1_0.txt or copy at http://www.boost.org/LICENSE_1_0.txt)
+
+
+#include "cl_tests.hpp"
+
+
+/*
+ * This test is meant to verify concurrent launches of a pooled kernel.
+ */
+
+
+static const char fill_src[] = 
+"                                                                          \n"
+"   __kernel void fill(__global char * val)                                \n"
+"   {                                                                      \n"
+"       size_t tid = get_global_id(0);                                     \n"
+"       val[tid] = 'a' + (char)tid;                                        \n"
+"   }                                                                      \n"
+"                                                                          \n"
+"   __kernel void copy(__global char * dst, __global const char * src)     \n"
+"   {                                                                      \n"
+"       size_t tid = get_global_id(0);                                     \n"
+"       dst[tid] = src[tid];                                               \n"
+"   }                                                                      \n"
+"                                                                          \n";
+
+static const char initdata[] = "0000000000";
+#define DATASIZE ((size_t)11)
+#define NUM_BUFFERS ((size_t)8)
+
+static const char refdata1[] = "abcdefghij";
+static const char refdata2[] = "abcde00000";
+
+static void cl_test(hpx::opencl::device cldevice)
+{
+
+    // create program
+    hpx::opencl::program prog = cldevice.create_program_with_source(
+                                                                    fill_src);
+
+    // build program
+    prog.build();
+
+    // create kernel with pool.
+    // less pooled instances than concurrent launches, to test the growing
+    hpx::opencl::kernel fill_kernel = prog.get_kernel_pool("fill",
+                                                           NUM_BUFFERS / 2);
+
+    // set an argument on the shared kernel
+    hpx::opencl::buffer shared_buffer = cldevice.create_buffer(
+                                                    CL_MEM_READ_WRITE,
+                                                    DATASIZE, initdata);
+    fill_kernel.set_arg(0, shared_buffer);
+
+    // launch concurrently with different arguments
+    std::vector<hpx::opencl::buffer> buffers;
+    std::vector<hpx::lcos::shared_future<hpx::opencl::event>> events;
+    for(size_t i = 0; i < NUM_BUFFERS; i++)
+    {
+        hpx::opencl::buffer buffer = cldevice.create_buffer(CL_MEM_READ_WRITE,
+                                                            DATASIZE,
+                                                            initdata);
+        buffers.push_back(buffer);
+
+        hpx::opencl::work_size<1> dim;
+        dim[0].offset = 0;
+        dim[0].size = DATASIZE - 1;
+
+        hpx::opencl::launch_desc launch(dim);
+        launch.set_arg(0, buffer);
+        events.push_back(fill_kernel.enqueue_launch(launch));
+    }
+
+    // wait for all launches
+    for(size_t i = 0; i < NUM_BUFFERS; i++)
+    {
+        events[i].get().await();
+    }
+
+    // test if kernels executed successfully
+    for(size_t i = 0; i < NUM_BUFFERS; i++)
+    {
+        TEST_CL_BUFFER(buffers[i], refdata1);
+    }
+
+    // the argument set via set_arg needs to be untouched
+    TEST_CL_BUFFER(shared_buffer, initdata);
+    hpx::opencl::work_size<1> dim;
+    dim[0].offset = 0;
+    dim[0].size = 5;
+    fill_kernel.enqueue(dim).get().await();
+    TEST_CL_BUFFER(shared_buffer, refdata2);
+
+    // an argument of an earlier launch must not leak into a launch on the
+    // same pooled instance that doesn't set it
+    hpx::opencl::kernel copy_kernel = prog.get_kernel_pool("copy", 1);
+    hpx::opencl::buffer src = cldevice.create_buffer(CL_MEM_READ_WRITE,
+                                                     DATASIZE, refdata1);
+    hpx::opencl::buffer dst1 = cldevice.create_buffer(CL_MEM_READ_WRITE,
+                                                      DATASIZE, initdata);
+    hpx::opencl::buffer dst2 = cldevice.create_buffer(CL_MEM_READ_WRITE,
+                                                      DATASIZE, initdata);
+    {
+        hpx::opencl::launch_desc launch(dim);
+        launch.set_arg(0, dst1);
+        launch.set_arg(1, src);
+        copy_kernel.enqueue_launch(launch).get().await();
+        TEST_CL_BUFFER(dst1, refdata2);
+    }
+    {
+        hpx::opencl::launch_desc launch(dim);
+        launch.set_arg(0, dst2);
+        bool failed = false;
+        try
+        {
+            copy_kernel.enqueue_launch(launch).get().await();
+        }
+        catch(hpx::exception const&)
+        {
+            failed = true;
+        }
+        HPX_TEST(failed);
+        TEST_CL_BUFFER(dst2, initdata);
+    }
+
+}
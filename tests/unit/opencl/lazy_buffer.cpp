@@ -0,0 +1,98 @@
+// Copyright (c)       2014 Martin Stumpf
+//
+// Distributed under the Boost Software License, Version 1.0. (See accompanying
+// file LICENSE_1_0.txt or copy at http://www.boost.org/LICENSE_1_0.txt)
+
+
+#include "cl_tests.hpp"
+
+
+/*
+ * This file tests buffers whose memory gets created on first use.
+ */
+
+static const char square_src[] =
+"                                                                          \n"
+"   __kernel void square(__global int * val)                               \n"
+"   {                                                                      \n"
+"       size_t tid = get_global_id(0);                                     \n"
+"       val[tid] = val[tid]*val[tid];                                      \n"
+"   }                                                                      \n"
+"                                                                          \n";
+
+static const char initdata[] = "Hello World!";
+static const char modifieddata[] = "Hello Wxrld!";
+#define DATASIZE ((size_t)13)
+
+static const cl_int intdata[] = {0, 1, 2, 3, 4, 5, 6, 7, 8, 9};
+static const cl_int squareddata[] = {0, 1, 4, 9, 16, 25, 36, 49, 64, 81};
+#define NUM_INTS ((size_t)10)
+
+static void cl_test(hpx::opencl::device cldevice)
+{
+
+    // The size is known before the memory exists
+    hpx::opencl::buffer unused = cldevice.create_buffer(CL_MEM_READ_WRITE,
+                                                        DATASIZE);
+    HPX_TEST_EQ(unused.size().get(), DATASIZE);
+
+    // First use is a full write
+    hpx::opencl::buffer full = cldevice.create_buffer(CL_MEM_READ_WRITE,
+                                                      DATASIZE);
+    full.enqueue_write(0, DATASIZE, initdata).get().await();
+    TEST_CL_BUFFER(full, initdata);
+
+    // Writes after the first one go to the existing memory
+    full.enqueue_write(7, 1, "x").get().await();
+    TEST_CL_BUFFER(full, modifieddata);
+
+    // First use is a partial write
+    hpx::opencl::buffer partial = cldevice.create_buffer(CL_MEM_READ_WRITE,
+                                                         DATASIZE);
+    partial.enqueue_write(0, 7, initdata).get().await();
+    partial.enqueue_write(7, DATASIZE - 7, initdata + 7).get().await();
+    TEST_CL_BUFFER(partial, initdata);
+
+    // First use is a copy
+    hpx::opencl::buffer copied = cldevice.create_buffer(CL_MEM_READ_WRITE,
+                                                        DATASIZE);
+    copied.enqueue_copy(full, 0, 0, DATASIZE).get().await();
+    TEST_CL_BUFFER(copied, modifieddata);
+
+    // First use is a kernel argument, gets written by the second kernel
+    hpx::opencl::program prog =
+                        cldevice.create_program_with_source(square_src);
+    prog.build();
+    hpx::opencl::kernel square_kernel = prog.create_kernel("square");
+
+    hpx::opencl::buffer ints = cldevice.create_buffer(CL_MEM_READ_WRITE,
+                                                      sizeof(intdata));
+    square_kernel.set_arg(0, ints);
+
+    hpx::opencl::work_size<1> dim;
+    dim[0].offset = 0;
+    dim[0].size = NUM_INTS;
+    square_kernel.enqueue(dim).get().await();
+
+    ints.enqueue_write(0, sizeof(intdata), intdata).get().await();
+    square_kernel.enqueue(dim).get().await();
+
+    std::vector<cl_int> result(NUM_INTS);
+    ints.enqueue_read_to(0, sizeof(intdata), result.data()).get();
+    for(size_t i = 0; i < NUM_INTS; i++)
+    {
+        HPX_TEST_EQ(result[i], squareddata[i]);
+    }
+
+    // The memory exists now, pooled instances get it as plain argument
+    ints.enqueue_write(0, sizeof(intdata), intdata).get().await();
+    hpx::opencl::launch_desc launch(dim);
+    square_kernel.enqueue_launch(launch).get().await();
+
+    ints.enqueue_read_to(0, sizeof(intdata), result.data()).get();
+    for(size_t i = 0; i < NUM_INTS; i++)
+    {
+        HPX_TEST_EQ(result[i], squareddata[i]);
+    }
+
+}
@@ -0,0 +1,234 @@
+// Copyright (c)       2014 Martin Stumpf
+//
+// Distributed under the Boost Software License, Version 1.0. (See accompanying
+// file LICENSE_1_0.txt or copy at http://www.boost.org/LICENSE_1_0.txt)
+
+#include <hpx/hpx.hpp>
+#include <hpx/hpx_init.hpp>
+#include <hpx/lcos/when_all.hpp>
+#include <hpx/util/lightweight_test.hpp>
+
+#include "../../../opencl/lockfree_fifo.hpp"
+
+#include <vector>
+
+using boost::program_options::variables_map;
+using boost::program_options::options_description;
+using boost::program_options::value;
+
+/*
+ * This test is meant to verify the lock-free fifo, no device is needed.
+ */
+
+#define NUM_PRODUCERS ((std::size_t)4)
+#define NUM_CONSUMERS ((std::size_t)4)
+#define NUM_ITEMS ((std::size_t)10000)
+
+// less capacity than items, so push has to wait for the consumers
+#define CAPACITY ((std::size_t)16)
+
+typedef hpx::opencl::lockfree_fifo<std::size_t> fifo_type;
+
+// the items of producer p are p * NUM_ITEMS + i
+static void producer(fifo_type* queue, std::size_t p)
+{
+    for(std::size_t i = 0; i < NUM_ITEMS; i++)
+        queue->push(p * NUM_ITEMS + i);
+}
+
+struct consumer_result
+{
+    std::size_t count;
+    std::size_t sum;
+    bool in_order;
+};
+
+// the items of every single producer have to arrive in order
+static consumer_result consumer(fifo_type* queue)
+{
+    consumer_result result = {0, 0, true};
+    std::vector<std::size_t> next_item(NUM_PRODUCERS, 0);
+
+    std::size_t item;
+    while(queue->pop(&item))
+    {
+        std::size_t p = item / NUM_ITEMS;
+        std::size_t i = item % NUM_ITEMS;
+        if(p >= NUM_PRODUCERS || i < next_item[p])
+            result.in_order = false;
+        else
+            next_item[p] = i + 1;
+
+        result.count++;
+        result.sum += item;
+    }
+
+    return result;
+}
+
+static void test_mpmc()
+{
+
+    fifo_type queue(CAPACITY);
+    HPX_TEST_EQ(queue.capacity(), CAPACITY);
+
+    std::vector<hpx::lcos::future<consumer_result>> consumers;
+    for(std::size_t i = 0; i < NUM_CONSUMERS; i++)
+        consumers.push_back(hpx::async(&consumer, &queue));
+
+    std::vector<hpx::lcos::future<void>> producers;
+    for(std::size_t p = 0; p < NUM_PRODUCERS; p++)
+        producers.push_back(hpx::async(&producer, &queue, p));
+
+    hpx::when_all(producers).get();
+    queue.finish();
+
+    std::vector<hpx::lcos::future<consumer_result>> results =
+                                            hpx::when_all(consumers).get();
+
+    std::size_t count = 0;
+    std::size_t sum = 0;
+    for(std::size_t i = 0; i < results.size(); i++)
+    {
+        consumer_result result = results[i].get();
+        HPX_TEST(result.in_order);
+        count += result.count;
+        sum += result.sum;
+    }
+
+    std::size_t total = NUM_PRODUCERS * NUM_ITEMS;
+    HPX_TEST_EQ(count, total);
+    HPX_TEST_EQ(sum, total * (total - 1) / 2);
+
+}
+
+static bool pop_item(fifo_type* queue, std::size_t* item)
+{
+    return queue->pop(item);
+}
+
+static void push_item(fifo_type* queue, std::size_t item)
+{
+    queue->push(item);
+}
+
+static void test_finish()
+{
+
+    // a blocked pop gets the next pushed item
+    {
+        fifo_type queue(CAPACITY);
+        std::size_t item = 0;
+        hpx::lcos::future<bool> popped = hpx::async(&pop_item, &queue, &item);
+        queue.push(42);
+        HPX_TEST(popped.get());
+        HPX_TEST_EQ(item, (std::size_t)42);
+    }
+
+    // a blocked pop returns false on finish
+    {
+        fifo_type queue(CAPACITY);
+        std::size_t item = 0;
+        hpx::lcos::future<bool> popped = hpx::async(&pop_item, &queue, &item);
+        queue.finish();
+        HPX_TEST(!popped.get());
+    }
+
+    // the items pushed before finish still get popped
+    {
+        fifo_type queue(CAPACITY);
+        queue.push(1);
+        queue.push(2);
+        queue.finish();
+
+        std::size_t item = 0;
+        HPX_TEST(queue.pop(&item));
+        HPX_TEST_EQ(item, (std::size_t)1);
+        HPX_TEST(queue.pop(&item));
+        HPX_TEST_EQ(item, (std::size_t)2);
+        HPX_TEST(!queue.pop(&item));
+    }
+
+    // a push blocked on a full queue continues once there is space
+    {
+        fifo_type queue(2);
+        HPX_TEST(queue.try_push(1));
+        HPX_TEST(queue.try_push(2));
+        HPX_TEST(!queue.try_push(3));
+
+        hpx::lcos::future<void> pushed = hpx::async(&push_item, &queue,
+                                                    (std::size_t)3);
+        std::size_t item = 0;
+        HPX_TEST(queue.pop(&item));
+        HPX_TEST_EQ(item, (std::size_t)1);
+        pushed.get();
+
+        HPX_TEST(queue.pop(&item));
+        HPX_TEST_EQ(item, (std::size_t)2);
+        HPX_TEST(queue.pop(&item));
+        HPX_TEST_EQ(item, (std::size_t)3);
+    }
+
+    // a push blocked on a full queue throws on finish
+    {
+        fifo_type queue(2);
+        queue.push(1);
+        queue.push(2);
+
+        hpx::lcos::future<void> pushed = hpx::async(&push_item, &queue,
+                                                    (std::size_t)3);
+        queue.finish();
+
+        bool thrown = false;
+        try
+        {
+            pushed.get();
+        }
+        catch(hpx::exception const& e)
+        {
+            thrown = (e.get_error() == hpx::invalid_status);
+        }
+        HPX_TEST(thrown);
+    }
+
+    // push after finish throws
+    {
+        fifo_type queue(CAPACITY);
+        queue.finish();
+
+        bool thrown = false;
+        try
+        {
+            queue.push(1);
+        }
+        catch(hpx::exception const& e)
+        {
+            thrown = (e.get_error() == hpx::invalid_status);
+        }
+        HPX_TEST(thrown);
+
+        std::size_t item = 0;
+        HPX_TEST(!queue.try_pop(&item));
+    }
+
+}
+
+int hpx_main(variables_map & vm)
+{
+    {
+        test_mpmc();
+        test_finish();
+    }
+
+    hpx::finalize();
+    return hpx::util::report_errors();
+}
+
+///////////////////////////////////////////////////////////////////////////////
+int main(int argc, char* argv[])
+{
+    // Configure application-specific options
+    options_description cmdline("Usage: " HPX_APPLICATION_STRING " [options]");
+
+    return hpx::init(cmdline, argc, argv);
+}
@@ -0,0 +1,89 @@
+// Copyright (c)       2014 Martin Stumpf
+//
+// Distributed under the Boost Software License, Version 1.0. (See accompanying
+// file LICENSE_1_0.txt or copy at http://www.boost.org/LICENSE_1_0.txt)
+
+
+#include "cl_tests.hpp"
+
+#include <vector>
+
+
+/*
+ * This file tests the managed memory of a device.
+ * More buffers get created than fit into the memory limit, so buffers get
+ * evicted to the host and moved back by kernels and reads.
+ */
+
+static const char increment_src[] =
+"                                                                          \n"
+"   __kernel void increment(__global int * val)                            \n"
+"   {                                                                      \n"
+"       size_t tid = get_global_id(0);                                     \n"
+"       val[tid] = val[tid] + 1;                                           \n"
+"   }                                                                      \n"
+"                                                                          \n";
+
+static const size_t NUM_ELEMENTS = 1024;
+static const size_t NUM_BUFFERS = 8;
+static const size_t BUFFER_SIZE = NUM_ELEMENTS * sizeof(cl_int);
+
+static void check_content(hpx::opencl::buffer buf, cl_int offset)
+{
+    std::vector<cl_int> data(NUM_ELEMENTS);
+    buf.enqueue_read_to(0, BUFFER_SIZE, data.data()).get();
+    for(size_t i = 0; i < NUM_ELEMENTS; i++)
+    {
+        HPX_TEST_EQ(data[i], (cl_int)i + offset);
+    }
+}
+
+static void cl_test(hpx::opencl::device cldevice)
+{
+
+    // Only three buffers fit
+    cldevice.enable_managed_memory(3 * BUFFER_SIZE).get();
+
+    // Every buffer has a different content
+    std::vector<hpx::opencl::buffer> buffers;
+    for(size_t b = 0; b < NUM_BUFFERS; b++)
+    {
+        std::vector<cl_int> x(NUM_ELEMENTS);
+        for(size_t i = 0; i < NUM_ELEMENTS; i++)
+        {
+            x[i] = (cl_int)(i + b * NUM_ELEMENTS);
+        }
+        buffers.push_back(cldevice.create_buffer(CL_MEM_READ_WRITE,
+                                                 BUFFER_SIZE, x.data()));
+        HPX_TEST(cldevice.get_managed_memory_usage().get() <= 3 * BUFFER_SIZE);
+    }
+
+    // Reads move evicted buffers back
+    for(size_t b = 0; b < NUM_BUFFERS; b++)
+    {
+        check_content(buffers[b], (cl_int)(b * NUM_ELEMENTS));
+        HPX_TEST(cldevice.get_managed_memory_usage().get() <= 3 * BUFFER_SIZE);
+    }
+
+    // Kernel arguments get moved back on launch
+    hpx::opencl::program prog =
+                        cldevice.create_program_with_source(increment_src);
+    prog.build();
+    hpx::opencl::kernel increment_kernel = prog.create_kernel("increment");
+
+    hpx::opencl::work_size<1> dim;
+    dim[0].offset = 0;
+    dim[0].size = NUM_ELEMENTS;
+
+    for(size_t b = 0; b < NUM_BUFFERS; b++)
+    {
+        increment_kernel.set_arg(0, buffers[b]);
+        increment_kernel.enqueue(dim).get().await();
+    }
+
+    for(size_t b = 0; b < NUM_BUFFERS; b++)
+    {
+        check_content(buffers[b], (cl_int)(b * NUM_ELEMENTS + 1));
+    }
+
+}
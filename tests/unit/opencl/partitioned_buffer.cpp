@@ -0,0 +1,140 @@
+// Copyright (c)       2014 Martin Stumpf
+//
+// Distributed under the Boost Software License, Version 1.0. (See accompanying
+// file LICENSE_1_0.txt or copy at http://www.boost.org/LICENSE_1_0.txt)
+
+
+#include "cl_tests.hpp"
+
+#include <vector>
+
+
+/*
+ * This file tests the partitioned buffer.
+ * The segments all live on the same device, as only one device is
+ * guaranteed to exist.
+ */
+
+static const size_t NUM_ELEMENTS = 1000;
+static const size_t NUM_SEGMENTS = 3;
+static const size_t HALO_WIDTH = 2;
+
+static hpx::opencl::partitioned_buffer<cl_int> partitioned;
+
+// Negates the owned elements of a segment
+static hpx::lcos::future<hpx::opencl::event>
+negate_segment(size_t i, std::vector<hpx::opencl::event> dependencies)
+{
+    hpx::opencl::partitioned_buffer<cl_int>::segment const& seg =
+                                                partitioned.get_segment(i);
+
+    std::vector<hpx::lcos::shared_future<hpx::opencl::event> > deps;
+    for(size_t j = 0; j < dependencies.size(); j++)
+    {
+        deps.push_back(hpx::lcos::make_ready_future(dependencies[j]));
+    }
+
+    hpx::opencl::executor exec(seg.device);
+    return hpx::opencl::for_each(
+                hpx::opencl::par.on(exec).after(deps),
+                HALO_WIDTH, HALO_WIDTH + seg.count,
+                hpx::opencl::loop_body("x[i] = -x[i];")
+                        .arg<cl_int>("x", seg.buffer));
+}
+
+static void cl_test(hpx::opencl::device cldevice)
+{
+
+    // partitioning
+    {
+        std::vector<size_t> counts =
+                            hpx::opencl::detail::partition_block(10, 3);
+        HPX_TEST_EQ(counts.size(), 3u);
+        HPX_TEST_EQ(counts[0], 4u);
+        HPX_TEST_EQ(counts[1], 3u);
+        HPX_TEST_EQ(counts[2], 3u);
+
+        std::vector<double> weights;
+        weights.push_back(1.0);
+        weights.push_back(0.0);
+        weights.push_back(3.0);
+        counts = hpx::opencl::detail::partition_weighted(10, weights);
+        HPX_TEST_EQ(counts[0] + counts[1] + counts[2], 10u);
+        HPX_TEST_EQ(counts[1], 0u);
+        HPX_TEST(counts[0] == 2u || counts[0] == 3u);
+    }
+
+    std::vector<cl_int> x(NUM_ELEMENTS);
+    for(size_t i = 0; i < NUM_ELEMENTS; i++)
+    {
+        x[i] = (cl_int)i;
+    }
+
+    std::vector<hpx::opencl::device> devices(NUM_SEGMENTS, cldevice);
+    partitioned = hpx::opencl::partitioned_buffer<cl_int>(
+                        devices, CL_MEM_READ_WRITE, NUM_ELEMENTS, HALO_WIDTH);
+
+    HPX_TEST_EQ(partitioned.size(), NUM_ELEMENTS);
+    HPX_TEST_EQ(partitioned.num_segments(), NUM_SEGMENTS);
+    {
+        size_t first = 0;
+        for(size_t i = 0; i < NUM_SEGMENTS; i++)
+        {
+            HPX_TEST_EQ(partitioned.get_segment(i).first, first);
+            first += partitioned.get_segment(i).count;
+        }
+        HPX_TEST_EQ(first, NUM_ELEMENTS);
+    }
+
+    // scatter, compute, exchange
+    std::vector<hpx::opencl::event> written =
+                                partitioned.enqueue_write(x.data()).get();
+    std::vector<hpx::opencl::event> negated =
+                partitioned.for_each_segment(&negate_segment, written).get();
+    std::vector<hpx::opencl::event> exchanged =
+                                partitioned.exchange_halos(negated).get();
+    HPX_TEST_EQ(exchanged.size(), NUM_SEGMENTS);
+
+    // gather
+    {
+        hpx::util::serialize_buffer<cl_int> result =
+                                partitioned.enqueue_read(exchanged).get();
+        HPX_TEST_EQ(result.size(), NUM_ELEMENTS);
+        for(size_t i = 0; i < NUM_ELEMENTS; i++)
+        {
+            HPX_TEST_EQ(result[i], -x[i]);
+        }
+    }
+
+    // the inner halos hold the neighbouring elements
+    for(size_t i = 0; i < NUM_SEGMENTS; i++)
+    {
+        hpx::opencl::partitioned_buffer<cl_int>::segment const& seg =
+                                                partitioned.get_segment(i);
+        hpx::util::serialize_buffer<cl_int> data =
+            seg.buffer.enqueue_read(0, seg.count + 2 * HALO_WIDTH,
+                                    exchanged[i]).get();
+
+        for(size_t j = 0; j < HALO_WIDTH; j++)
+        {
+            if(i > 0)
+                HPX_TEST_EQ(data[j], -x[seg.first - HALO_WIDTH + j]);
+            if(i + 1 < NUM_SEGMENTS)
+                HPX_TEST_EQ(data[HALO_WIDTH + seg.count + j],
+                            -x[seg.first + seg.count + j]);
+        }
+    }
+
+    // segments smaller than the halo
+    bool thrown = false;
+    try {
+        hpx::opencl::partitioned_buffer<cl_int>(devices, CL_MEM_READ_WRITE,
+                                                4, HALO_WIDTH);
+    } catch (hpx::exception const&) {
+        thrown = true;
+    }
+    HPX_TEST(thrown);
+
+    partitioned = hpx::opencl::partitioned_buffer<cl_int>();
+
+}
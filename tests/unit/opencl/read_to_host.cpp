@@ -0,0 +1,88 @@
+// Copyright (c)       2014 Martin Stumpf
+//
+// Distributed under the Boost Software License, Version 1.0. (See accompanying
+// file LICENSE_1_0.txt or copy at http://www.boost.org/LICENSE_1_0.txt)
+
+
+#include "cl_tests.hpp"
+
+#include <vector>
+
+
+/*
+ * This file tests the reads into existing host memory,
+ * enqueue_read_to and enqueue_read_rect_to.
+ */
+
+// a 4x6 matrix, stored row by row
+static const size_t NUM_ROWS = 4;
+static const size_t NUM_COLS = 6;
+static const char matrix[NUM_ROWS * NUM_COLS] = {
+     0,  1,  2,  3,  4,  5,
+    10, 11, 12, 13, 14, 15,
+    20, 21, 22, 23, 24, 25,
+    30, 31, 32, 33, 34, 35
+};
+
+// marks the host memory that must not get touched
+static const char UNTOUCHED = 99;
+
+
+static void cl_test(hpx::opencl::device cldevice)
+{
+
+    hpx::opencl::buffer buf = cldevice.create_buffer(CL_MEM_READ_WRITE,
+                                                     sizeof(matrix));
+
+    // write the matrix, the reads depend on the write event
+    hpx::lcos::shared_future<hpx::opencl::event> write_event =
+                                    buf.enqueue_write(0, sizeof(matrix), matrix);
+
+    // read everything
+    {
+        std::vector<char> dst(sizeof(matrix), UNTOUCHED);
+        buf.enqueue_read_to(0, sizeof(matrix), dst.data(), write_event).get();
+        for(size_t i = 0; i < sizeof(matrix); i++)
+        {
+            HPX_TEST_EQ(dst[i], matrix[i]);
+        }
+    }
+
+    // read a part
+    {
+        std::vector<char> dst(sizeof(matrix), UNTOUCHED);
+        buf.enqueue_read_to(NUM_COLS, NUM_COLS, dst.data(), write_event).get();
+        for(size_t i = 0; i < NUM_COLS; i++)
+        {
+            HPX_TEST_EQ(dst[i], matrix[NUM_COLS + i]);
+        }
+        HPX_TEST_EQ(dst[NUM_COLS], UNTOUCHED);
+    }
+
+    // read the 3x2 block at row 1, column 2 to the center of a 5x8 image
+    {
+        static const size_t DST_COLS = 8;
+        std::vector<char> dst(5 * DST_COLS, UNTOUCHED);
+        buf.enqueue_read_rect_to(1 * NUM_COLS + 2, 2, 3, NUM_COLS,
+                                 dst.data() + 1 * DST_COLS + 3, DST_COLS,
+                                 write_event).get();
+
+        for(size_t y = 0; y < 5; y++)
+        {
+            for(size_t x = 0; x < DST_COLS; x++)
+            {
+                if(y >= 1 && y < 4 && x >= 3 && x < 5)
+                {
+                    // same row, shifted by one column
+                    HPX_TEST_EQ(dst[y * DST_COLS + x],
+                                matrix[y * NUM_COLS + x - 1]);
+                }
+                else
+                {
+                    HPX_TEST_EQ(dst[y * DST_COLS + x], UNTOUCHED);
+                }
+            }
+        }
+    }
+
+}
@@ -0,0 +1,87 @@
+// Copyright (c)       2014 Martin Stumpf
+//
+// Distributed under the Boost Software License, Version 1.0. (See accompanying
+// file LICENSE_1_0.txt or copy at http://www.boost.org/LICENSE_1_0.txt)
+
+
+#include "cl_tests.hpp"
+
+#include <vector>
+
+
+/*
+ * This file tests shared virtual memory as kernel argument.
+ */
+
+static const char square_src[] =
+"                                                                          \n"
+"   __kernel void square(__global int * val)                               \n"
+"   {                                                                      \n"
+"       size_t tid = get_global_id(0);                                     \n"
+"       val[tid] = val[tid]*val[tid];                                      \n"
+"   }                                                                      \n"
+"                                                                          \n";
+
+static const size_t NUM_ELEMENTS = 1024;
+
+static void cl_test(hpx::opencl::device cldevice)
+{
+
+#ifdef CL_VERSION_2_0
+
+    // Only OpenCL 2.0 devices support SVM
+    if(cldevice.get_device_properties().get().svm_capabilities == 0)
+        return;
+
+    hpx::opencl::program prog =
+                        cldevice.create_program_with_source(square_src);
+    prog.build("-cl-std=CL2.0");
+    hpx::opencl::kernel square_kernel = prog.create_kernel("square");
+
+    hpx::opencl::work_size<1> dim;
+    dim[0].offset = 0;
+    dim[0].size = NUM_ELEMENTS;
+
+    hpx::opencl::svm_allocator<cl_int> alloc(cldevice);
+    cl_int* data = alloc.allocate(NUM_ELEMENTS);
+
+    // Fill on the host
+    alloc.map(data, NUM_ELEMENTS, CL_MAP_WRITE).get().await();
+    for(size_t i = 0; i < NUM_ELEMENTS; i++)
+    {
+        data[i] = (cl_int)i;
+    }
+    hpx::opencl::event unmapped = alloc.unmap(data).get();
+
+    // Square on the device
+    square_kernel.set_arg_svm(0, data);
+    hpx::opencl::event done = square_kernel.enqueue(dim, unmapped).get();
+
+    // Check on the host
+    alloc.map(data, NUM_ELEMENTS, CL_MAP_READ, done).get().await();
+    for(size_t i = 0; i < NUM_ELEMENTS; i++)
+    {
+        HPX_TEST_EQ(data[i], (cl_int)(i*i));
+    }
+    alloc.unmap(data).get().await();
+
+    alloc.deallocate(data, NUM_ELEMENTS);
+
+    // Fine-grain memory works with standard containers
+    if(alloc.is_fine_grain())
+    {
+        std::vector<cl_int, hpx::opencl::svm_allocator<cl_int> >
+                                        vec(NUM_ELEMENTS, 3, alloc);
+
+        square_kernel.set_arg_svm(0, vec.data());
+        square_kernel.enqueue(dim).get().await();
+
+        for(size_t i = 0; i < NUM_ELEMENTS; i++)
+        {
+            HPX_TEST_EQ(vec[i], 9);
+        }
+    }
+
+#endif
+
+}
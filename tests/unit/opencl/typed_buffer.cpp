@@ -0,0 +1,133 @@
+// Copyright (c)       2014 Martin Stumpf
+//
+// Distributed under the Boost Software License, Version 1.0. (See accompanying
+// file LICENSE_1_0.txt or copy at http://www.boost.org/LICENSE_1_0.txt)
+
+
+#include "cl_tests.hpp"
+
+#include <list>
+#include <vector>
+
+
+/*
+ * This file tests the typed buffer.
+ */
+
+static const size_t NUM_ELEMENTS = 1000;
+
+static const char square_src[] =
+"                                                                          \n"
+"   __kernel void square(__global float* val)                              \n"
+"   {                                                                      \n"
+"       size_t i = get_global_id(0);                                       \n"
+"       val[i] = val[i] * val[i];                                          \n"
+"   }                                                                      \n"
+"                                                                          \n";
+
+static void cl_test(hpx::opencl::device cldevice)
+{
+
+    std::vector<float> x(NUM_ELEMENTS);
+    for(size_t i = 0; i < NUM_ELEMENTS; i++)
+    {
+        x[i] = (float)i;
+    }
+
+    hpx::opencl::typed_buffer<float> buf_x =
+        hpx::opencl::create_typed_buffer<float>(cldevice, CL_MEM_READ_WRITE,
+                                                NUM_ELEMENTS, x.data());
+    hpx::opencl::typed_buffer<float> buf_y =
+        hpx::opencl::create_typed_buffer<float>(cldevice, CL_MEM_READ_WRITE,
+                                                NUM_ELEMENTS);
+
+    // size in elements
+    HPX_TEST_EQ(buf_x.size().get(), NUM_ELEMENTS);
+
+    // read back
+    {
+        hpx::util::serialize_buffer<float> data =
+                                    buf_x.enqueue_read(0, NUM_ELEMENTS).get();
+        HPX_TEST_EQ(data.size(), NUM_ELEMENTS);
+        for(size_t i = 0; i < NUM_ELEMENTS; i++)
+        {
+            HPX_TEST_EQ(data[i], x[i]);
+        }
+    }
+
+    // write with element offsets
+    hpx::opencl::event written =
+        buf_y.enqueue_write(0, NUM_ELEMENTS, x.data()).get();
+    hpx::opencl::event written_part =
+        buf_y.enqueue_write(10, 5, x.data(), written).get();
+
+    // write a converted, non-contiguous range
+    std::list<int> ints;
+    for(int i = 0; i < 5; i++)
+    {
+        ints.push_back(-i);
+    }
+    hpx::opencl::event written_range =
+        buf_y.enqueue_write_range(20, ints.begin(), ints.end(), written_part)
+                                                                        .get();
+
+    {
+        hpx::util::serialize_buffer<float> data =
+                    buf_y.enqueue_read(0, NUM_ELEMENTS, written_range).get();
+        for(size_t i = 0; i < NUM_ELEMENTS; i++)
+        {
+            float expected = x[i];
+            if(i >= 10 && i < 15)
+                expected = x[i - 10];
+            if(i >= 20 && i < 25)
+                expected = -(float)(i - 20);
+            HPX_TEST_EQ(data[i], expected);
+        }
+    }
+
+    // copy between typed buffers
+    hpx::opencl::event copied =
+        buf_x.enqueue_copy(buf_y, 20, 0, 5, written_range).get();
+
+    // as kernel argument
+    hpx::opencl::program prog = cldevice.create_program_with_source(square_src);
+    prog.build();
+    hpx::opencl::kernel square_kernel = prog.create_kernel("square");
+    square_kernel.set_arg(0, buf_x);
+
+    hpx::opencl::work_size<1> size;
+    size[0].offset = 0;
+    size[0].size = NUM_ELEMENTS;
+    hpx::opencl::event squared = square_kernel.enqueue(size, copied).get();
+
+    {
+        std::vector<float> result(NUM_ELEMENTS);
+        buf_x.enqueue_read_to(0, NUM_ELEMENTS, result.data(), squared).get();
+        for(size_t i = 0; i < NUM_ELEMENTS; i++)
+        {
+            float expected = (i < 5) ? -(float)i : x[i];
+            HPX_TEST_EQ(result[i], expected * expected);
+        }
+    }
+
+    // as argument of a single launch
+    hpx::opencl::launch_desc launch(size);
+    launch.set_arg(0, buf_y);
+    hpx::opencl::event squared_y =
+                        square_kernel.enqueue_launch(launch, squared).get();
+
+    {
+        std::vector<float> result(NUM_ELEMENTS);
+        buf_y.enqueue_read_to(0, NUM_ELEMENTS, result.data(), squared_y).get();
+        for(size_t i = 0; i < NUM_ELEMENTS; i++)
+        {
+            float expected = x[i];
+            if(i >= 10 && i < 15)
+                expected = x[i - 10];
+            if(i >= 20 && i < 25)
+                expected = -(float)(i - 20);
+            HPX_TEST_EQ(result[i], expected * expected);
+        }
+    }
+
+}
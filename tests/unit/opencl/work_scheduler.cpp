@@ -0,0 +1,91 @@
+// Copyright (c)       2014 Martin Stumpf
+//
+// Distributed under the Boost Software License, Version 1.0. (See accompanying
+// file LICENSE_1_0.txt or copy at http://www.boost.org/LICENSE_1_0.txt)
+
+
+#include "cl_tests.hpp"
+
+#include "../../../opencl/work_scheduler.hpp"
+
+
+/*
+ * This test is meant to verify the distribution and stealing of work items.
+ */
+
+
+#define NUM_ITEMS ((size_t)1000)
+
+typedef hpx::opencl::work_scheduler<size_t> scheduler_type;
+
+// Processes work items until the scheduler finishes.
+// Returns the sum of all processed items.
+static size_t worker_loop(scheduler_type* scheduler, size_t worker)
+{
+
+    size_t sum = 0;
+    size_t item;
+    while(scheduler->request(worker, &item))
+    {
+        sum += item;
+        scheduler->work_done(worker);
+    }
+
+    return sum;
+
+}
+
+static void cl_test(hpx::opencl::device cldevice)
+{
+
+    size_t expected_sum = NUM_ITEMS * (NUM_ITEMS - 1) / 2;
+
+    // two workers, both running
+    {
+        scheduler_type scheduler;
+        size_t worker0 = scheduler.add_worker(hpx::find_here());
+        size_t worker1 = scheduler.add_worker(hpx::find_here());
+
+        for(size_t i = 0; i < NUM_ITEMS; i++)
+            scheduler.add_work(i);
+        scheduler.finish();
+
+        hpx::lcos::future<size_t> sum0 =
+                            hpx::async(&worker_loop, &scheduler, worker0);
+        hpx::lcos::future<size_t> sum1 =
+                            hpx::async(&worker_loop, &scheduler, worker1);
+
+        HPX_TEST_EQ(sum0.get() + sum1.get(), expected_sum);
+    }
+
+    // two workers, only one running. has to steal everything.
+    {
+        scheduler_type scheduler;
+        size_t worker0 = scheduler.add_worker(hpx::find_here());
+        scheduler.add_worker(hpx::find_here());
+
+        for(size_t i = 0; i < NUM_ITEMS; i++)
+            scheduler.add_work(i);
+        scheduler.finish();
+
+        HPX_TEST_EQ(worker_loop(&scheduler, worker0), expected_sum);
+    }
+
+    // work arriving while the worker is waiting
+    {
+        scheduler_type scheduler;
+        size_t worker0 = scheduler.add_worker(hpx::find_here());
+
+        hpx::lcos::future<size_t> sum0 =
+                            hpx::async(&worker_loop, &scheduler, worker0);
+
+        for(size_t i = 0; i < NUM_ITEMS; i++)
+            scheduler.add_work(i);
+        scheduler.finish();
+
+        HPX_TEST_EQ(sum0.get(), expected_sum);
+    }
+
+}
+
+